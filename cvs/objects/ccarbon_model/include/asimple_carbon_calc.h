@@ -174,6 +174,25 @@ protected:
     //! expensive operations during calc.
     precalc_sigmoid_type precalc_sigmoid_diff;
     
+    // The same boiler plate to share the precalc cumulative soil carbon response
+    // between instances that have the same soil time scale
+    struct precalc_soil_response_helper {
+        precalc_soil_response_helper( const int aSoilTimeScale );
+        std::vector<double> mData;
+        
+        const double& operator[]( const size_t aPos ) const {
+            return mData[ aPos ];
+        }
+    };
+    using precalc_soil_response_type = boost::flyweights::flyweight<
+        boost::flyweights::key_value<int, precalc_soil_response_helper>,
+        boost::flyweights::no_tracking>;
+    
+    //! The fraction of a soil carbon change which has occurred by year offset
+    //! with the 0th element being zero.  This value gets precomputed whenever
+    //! the soil time scale is set to avoid computing exponentials during calc.
+    precalc_soil_response_type precalc_soil_response;
+    
     //! Flag to ensure historical emissions are only calculated a single time
     //! since they can not be reset.
     bool mHasCalculatedHistoricEmiss;
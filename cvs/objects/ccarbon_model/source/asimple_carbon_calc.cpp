@@ -59,7 +59,8 @@ ASimpleCarbonCalc::ASimpleCarbonCalc():
 mTotalEmissions( CarbonModelUtils::getStartYear(), CarbonModelUtils::getEndYear() ),
 mTotalEmissionsAbove( CarbonModelUtils::getStartYear(), CarbonModelUtils::getEndYear() ),
 mTotalEmissionsBelow( CarbonModelUtils::getStartYear(), CarbonModelUtils::getEndYear() ),
-mCarbonStock( scenario->getModeltime()->getStartYear(), CarbonModelUtils::getEndYear() )
+mCarbonStock( scenario->getModeltime()->getStartYear(), CarbonModelUtils::getEndYear() ),
+precalc_soil_response( static_cast<int>( CarbonModelUtils::getSoilTimeScale() ) )
 {
     int endYear = CarbonModelUtils::getEndYear();
     const Modeltime* modeltime = scenario->getModeltime();
@@ -161,20 +162,20 @@ double ASimpleCarbonCalc::calc( const int aPeriod, const int aEndYear, const Car
             prevCarbonBelow = currCarbonBelow;
         }
         
-        if( aCalcMode == eStoreResults ) {
-            // add current emissions to the total
-            for( year = prevModelYear + 1; year <= aEndYear; ++year ) {
-                mTotalEmissionsAbove[ year ] += currEmissionsAbove[ year ];
-                mTotalEmissionsBelow[ year ] += currEmissionsBelow[ year ];
-                mTotalEmissions[ year ] = mTotalEmissionsAbove[ year ] + mTotalEmissionsBelow[ year ];
-            }
-        }
-        else if( aCalcMode == eReverseCalc ) {
-            // back out the current emissions from the total
-            for( year = prevModelYear + 1; year <= aEndYear; ++year ) {
-                mTotalEmissionsAbove[ year ] -= currEmissionsAbove[ year ];
-                mTotalEmissionsBelow[ year ] -= currEmissionsBelow[ year ];
-                mTotalEmissions[ year ] = mTotalEmissionsAbove[ year ] + mTotalEmissionsBelow[ year ];
+        if( aCalcMode == eStoreResults || aCalcMode == eReverseCalc ) {
+            // add current emissions to the total or back them out when running in
+            // reverse, working over the contiguous year storage directly
+            const int numYears = aEndYear - prevModelYear;
+            const double sign = aCalcMode == eStoreResults ? 1.0 : -1.0;
+            const double* currAbove = &currEmissionsAbove[ prevModelYear + 1 ];
+            const double* currBelow = &currEmissionsBelow[ prevModelYear + 1 ];
+            double* totalAbove = &mTotalEmissionsAbove[ prevModelYear + 1 ];
+            double* totalBelow = &mTotalEmissionsBelow[ prevModelYear + 1 ];
+            double* total = &mTotalEmissions[ prevModelYear + 1 ];
+            for( int i = 0; i < numYears; ++i ) {
+                totalAbove[ i ] += sign * currAbove[ i ];
+                totalBelow[ i ] += sign * currBelow[ i ];
+                total[ i ] = totalAbove[ i ] + totalBelow[ i ];
             }
         }
         else if( aCalcMode == eReturnTotal ) {
@@ -281,17 +282,15 @@ void ASimpleCarbonCalc::calcBelowGroundCarbonEmission( const double aCarbonDiff,
     // Note also that the aCarbonDiff is passed here as previous carbon minus current carbon
     // so a positive difference means that emissions will occur and a negative means uptake.
     
-    const double halfLife = mSoilTimeScale / 10.0;
-    const double log2 = log( 2.0 );
-    const double lambda = log2 / halfLife;
-    int yearCounter = 0;
-    double cumStockDiff_t1, cumStockDiff_t2;
-    cumStockDiff_t1 = 0.0;
-    for( int currYear = aYear; currYear <= aEndYear; ++currYear ) {
-        yearCounter += 1;
-        cumStockDiff_t2 = aCarbonDiff * ( 1.0 - exp( -1.0 * lambda * yearCounter ) );
-        aEmissVector[ currYear ] += cumStockDiff_t2 - cumStockDiff_t1;
-        cumStockDiff_t1 = cumStockDiff_t2;
+    // The cumulative response has been precomputed for the soil time scale so
+    // this is just a convolution of the carbon difference with it.  Note the
+    // cumulative stock differences are differenced after scaling to match the
+    // results of accumulating them year by year.
+    const double* response = &precalc_soil_response.get()[ 0 ];
+    double* emiss = &aEmissVector[ aYear ];
+    const int numYears = aEndYear - aYear + 1;
+    for( int i = 0; i < numYears; ++i ) {
+        emiss[ i ] += aCarbonDiff * response[ i + 1 ] - aCarbonDiff * response[ i ];
     }
 }
 
@@ -315,10 +314,13 @@ void ASimpleCarbonCalc::calcSigmoidCurve( const double aCarbonDiff,
      */
     assert( getMatureAge() > 1 );
     
-    for( int currYear = aYear; currYear <= aEndYear; ++currYear ){
-        // To avoid expensive calculations the difference in the sigmoid curve
-        // has already been precomputed.
-        aEmissVector[ currYear ] += precalc_sigmoid_diff.get()[ currYear - aYear ] * aCarbonDiff;
+    // To avoid expensive calculations the difference in the sigmoid curve
+    // has already been precomputed.
+    const double* sigmoidDiff = &precalc_sigmoid_diff.get()[ 0 ];
+    double* emiss = &aEmissVector[ aYear ];
+    const int numYears = aEndYear - aYear + 1;
+    for( int i = 0; i < numYears; ++i ) {
+        emiss[ i ] += sigmoidDiff[ i ] * aCarbonDiff;
     }
 }
 
@@ -392,6 +394,20 @@ double ASimpleCarbonCalc::getAboveGroundCarbonSubsidyDiscountFactor( ){
 
 void ASimpleCarbonCalc::setSoilTimeScale( const int aTimeScale ) {
     mSoilTimeScale = aTimeScale;
+    precalc_soil_response = precalc_soil_response_type( mSoilTimeScale );
+}
+
+ASimpleCarbonCalc::precalc_soil_response_helper::precalc_soil_response_helper( const int aSoilTimeScale ):
+mData( CarbonModelUtils::getEndYear() - CarbonModelUtils::getStartYear() + 2, 0.0 )
+{
+    // Exponential response with a half-life of the soil time scale divided by ten.
+    // The first element is left at zero as no change has occurred yet.
+    const double halfLife = aSoilTimeScale / 10.0;
+    const double log2 = log( 2.0 );
+    const double lambda = log2 / halfLife;
+    for( size_t yearCounter = 1; yearCounter < mData.size(); ++yearCounter ) {
+        mData[ yearCounter ] = 1.0 - exp( -1.0 * lambda * yearCounter );
+    }
 }
 
 double ASimpleCarbonCalc::getAboveGroundCarbonStock( const int aYear ) const {
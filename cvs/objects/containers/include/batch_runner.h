@@ -50,6 +50,7 @@
 #include <xercesc/dom/DOMNode.hpp>
 #include "containers/include/iscenario_runner.h"
 class Timer;
+class BatchCSVOutputter;
 
 /*! 
  * \ingroup Objects
@@ -74,7 +75,10 @@ class Timer;
  *          
  *          The batch runner is turned on using the boolean configuration value
  *          "BatchMode". The name of the configuration file is determined by the
- *          file configuration value "BatchFileName".
+ *          file configuration value "BatchFileName". If the integer
+ *          configuration value "batch-fork-workers" is greater than one the
+ *          base input is parsed once and scenarios are run in up to that many
+ *          forked worker processes which share the parsed input.
  *
  *          <b>XML specification for BatchRunner</b>
  *          - XML name: \c BatchRunner
@@ -178,12 +182,26 @@ protected:
     //! The current scenario runner.
     IScenarioRunner* mInternalRunner;
 
+    //! File descriptor of the lock file used to serialize output between
+    //! forked worker processes, or -1 if scenarios are not run in workers.
+    int mOutputLockFD;
+
 	BatchRunner();
 	bool runSingleScenario( IScenarioRunner* aScenarioRunner,
                             const Component& aCurrComponent,
                             const int aSinglePeriod,
                             Timer& aTimer );
 
+    bool runForkedScenarios( const std::list<Component>& aScenarioSets,
+                             const int aNumWorkers,
+                             const int aSinglePeriod,
+                             Timer& aTimer,
+                             BatchCSVOutputter& aCSVOutputter );
+
+    void lockOutput();
+
+    void unlockOutput();
+
     bool XMLParseComponentSet( const xercesc::DOMNode* aNode );
 
     bool XMLParseRunnerSet( const xercesc::DOMNode* aNode );
@@ -0,0 +1,87 @@
+#ifndef _HASH_MAP_BENCHMARK_H_
+#define _HASH_MAP_BENCHMARK_H_
+#if defined(_MSC_VER_)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*! 
+* \file hash_map_benchmark.h
+* \ingroup objects
+* \brief The HashMapBenchmark class header file.
+*/
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class Marketplace;
+
+/*! \brief Micro-benchmark of HashMap inserts and lookups with the keys of a
+*          real run.
+* \details Rebuilds the region and good maps of the MarketLocator from the
+*          markets in the marketplace, once with HashMap and once with
+*          boost::unordered_map for comparison, and times searching them for
+*          the markets. Searches for goods which are not present are timed as
+*          well since the model frequently checks for markets which may not
+*          exist. A MarketLocator is also searched both by name and with hash
+*          codes computed once up front, as a caller which keeps them would. The benchmark is run at the end of Scenario::completeInit
+*          when the configuration flag benchmark-hash-map-lookups is set.
+*          Collision counts are printed by the HashMap destructor when
+*          TUNING_STATS is compiled on.
+*/
+class HashMapBenchmark {
+public:
+    static void run( const Marketplace* aMarketplace, std::ostream& aOut );
+private:
+    //! The number of times to search for every market.
+    static const int ITERATIONS = 1000;
+
+    template<class RegionMap, class GoodMap>
+    static long timeLookups( const std::vector<std::string>& aRegions,
+                             const std::vector<std::string>& aGoods,
+                             const std::vector<unsigned int>& aSearches,
+                             const std::vector<std::string>& aMissGoods,
+                             double& aInsertTime,
+                             double& aSearchTime );
+
+    static long timeLocatorLookups( const std::vector<std::string>& aRegions,
+                                    const std::vector<std::string>& aGoods,
+                                    const std::vector<unsigned int>& aSearches,
+                                    const std::vector<std::string>& aMissGoods,
+                                    double& aStringTime,
+                                    double& aHashedTime );
+};
+
+#endif // _HASH_MAP_BENCHMARK_H_
@@ -54,6 +54,9 @@
 class IActivity
 {
 public:
+    //! Constructor
+    IActivity():mCalcOrder( -1 ) { }
+
     //! Destructor
     virtual inline ~IActivity();
     
@@ -71,6 +74,36 @@ public:
      * \return A description of this activity.
      */
     virtual std::string getDescription() const = 0;
+
+    /*!
+     * \brief Get the name of the region this activity calculates.
+     * \return The region name or an empty string if the activity does not
+     *         belong to a region.
+     */
+    virtual std::string getRegionName() const = 0;
+
+    /*!
+     * \brief Get the position of this activity in the global calc ordering.
+     * \details This is set once when the global ordering is created so that
+     *          it can be looked up without a search during every calc.
+     * \return The position in the global ordering or -1 if the activity is
+     *         not part of it.
+     */
+    int getCalcOrder() const {
+        return mCalcOrder;
+    }
+
+    /*!
+     * \brief Set the position of this activity in the global calc ordering.
+     * \param aCalcOrder The position in the global ordering.
+     */
+    void setCalcOrder( const int aCalcOrder ) {
+        mCalcOrder = aCalcOrder;
+    }
+
+private:
+    //! The position of this activity in the global calc ordering.
+    int mCalcOrder;
 };
 
 /*!
@@ -92,6 +125,10 @@ class DummyActivity : public IActivity {
     virtual std::string getDescription() const {
         return "dummy-activity";
     }
+
+    virtual std::string getRegionName() const {
+        return "";
+    }
 };
 
 // Inline definitions.
@@ -48,6 +48,9 @@
 #include <iosfwd>
 
 class Tabs;
+namespace objects {
+    class Atom;
+}
 
 /*!
 * \ingroup Objects
@@ -201,6 +204,62 @@ public:
     */
     virtual bool hasValue( const std::string& aStringKey ) const = 0;
 
+    /*! \brief Get a boolean from the IInfo with a specified interned key.
+    * \details Behaves as the string keyed version but avoids hashing and
+    *          comparing strings when the IInfo has been flattened.
+    * \param aKey The interned key for which to search the IInfo object.
+    * \param aMustExist Whether the value should exist in the IInfo.
+    * \return The boolean associated with the key or false if it does not exist.
+    * \sa getKey
+    */
+    virtual bool getBoolean( const objects::Atom* aKey,
+                             const bool aMustExist ) const = 0;
+
+    /*! \brief Get an integer from the IInfo with a specified interned key.
+    * \param aKey The interned key for which to search the IInfo object.
+    * \param aMustExist Whether the value should exist in the IInfo.
+    * \return The integer associated with the key or zero if it does not exist.
+    * \sa getKey
+    */
+    virtual int getInteger( const objects::Atom* aKey,
+                            const bool aMustExist ) const = 0;
+
+    /*! \brief Get a double from the IInfo with a specified interned key.
+    * \param aKey The interned key for which to search the IInfo object.
+    * \param aMustExist Whether the value should exist in the IInfo.
+    * \return The double associated with the key or zero if it does not exist.
+    * \sa getKey
+    */
+    virtual double getDouble( const objects::Atom* aKey,
+                              const bool aMustExist ) const = 0;
+
+    /*! \brief Get a string from the IInfo with a specified interned key.
+    * \param aKey The interned key for which to search the IInfo object.
+    * \param aMustExist Whether the value should exist in the IInfo.
+    * \return The string(by reference) associated with the key or the empty
+    *         string if it does not exist.
+    * \sa getKey
+    */
+    virtual const std::string& getString( const objects::Atom* aKey,
+                                          const bool aMustExist ) const = 0;
+
+    /*! \brief Return whether a value exists in the IInfo for an interned key.
+    * \param aKey The interned key for which to search the IInfo object.
+    * \return Whether the key exists in the IInfo.
+    */
+    virtual bool hasValue( const objects::Atom* aKey ) const = 0;
+
+    /*! \brief Collapse the chain of ancestors into a single lookup table.
+    * \details After this call lookups by interned key find the value, whether
+    *          it is stored locally or in an ancestor, with a single hash
+    *          lookup on a precomputed hash code. Callers should flatten once
+    *          the IInfo and its ancestors have been filled in, typically at the
+    *          end of completeInit.
+    */
+    virtual void flatten() = 0;
+
+    static const objects::Atom* getKey( const std::string& aStringKey );
+
     /*! \brief Write the IInfo object to an output stream as XML.
     * \details Writes the set of keys and values to an output stream as XML.
     * \param aPeriod Model period for which to write debugging information.
@@ -47,12 +47,15 @@
 
 #include <string>
 #include <iosfwd>
+#include <vector>
+#include <atomic>
 #include <boost/any.hpp>
 #include <boost/noncopyable.hpp>
 #include "containers/include/iinfo.h"
 
 // Can't forward declare because operations are used in template functions.
 #include "util/base/include/hash_map.h"
+#include "util/base/include/atom.h"
 #include "util/base/include/xml_helper.h"
 #include "util/base/include/configuration.h"
 
@@ -102,6 +105,18 @@ public:
 
     bool hasValue( const std::string& aStringKey ) const;
 
+    bool getBoolean( const objects::Atom* aKey, const bool aMustExist ) const;
+
+    int getInteger( const objects::Atom* aKey, const bool aMustExist ) const;
+
+    double getDouble( const objects::Atom* aKey, const bool aMustExist ) const;
+
+    const std::string& getString( const objects::Atom* aKey, const bool aMustExist ) const;
+
+    bool hasValue( const objects::Atom* aKey ) const;
+
+    void flatten();
+
     void toDebugXML( const int aPeriod, Tabs* aTabs, std::ostream& aOut ) const;
 protected:
     Info( const IInfo* aParentInfo, const std::string& aOwnerName );
@@ -133,8 +148,20 @@ private:
 
     template<class T> const T& getItemValueLocal( const std::string& aStringKey, bool& aExists ) const;
 
+    template<class T> const T& getItemValueLocal( const std::string& aStringKey, const size_t aHashCode,
+                                                  bool& aExists ) const;
+
+    template<class T> const T& getItemValueChain( const std::string& aStringKey, const size_t aHashCode,
+                                                  bool& aExists, const IInfo*& aRemaining ) const;
+
+    template<class T> const T& getItemValueFlat( const objects::Atom* aKey, bool& aExists ) const;
+
+    bool hasValueChain( const std::string& aStringKey, const size_t aHashCode ) const;
+
     size_t getInitialSize() const;
 
+    bool isFlattenCurrent() const;
+
     void printItemNotFoundWarning( const std::string& aStringKey ) const;
 
     void printBadCastWarning( const std::string& aStringKey, bool aIsUpdate ) const;
@@ -161,6 +188,50 @@ private:
 
     //! A pointer to the parent of this Info object which can be null.
     const IInfo* mParentInfo;
+
+    //! mParentInfo if it is an Info, null otherwise.
+    const Info* mParentAsInfo;
+
+    /*!
+     * \brief Location of a value visible from this Info after flattening.
+     * \details The value lives in the map of mOwner, which may be this Info or
+     *          one of its ancestors. HashMap items are never moved or erased
+     *          and updates assign in place, so the pointer stays valid.
+     */
+    struct Slot {
+        //! The Info whose map holds the value, and whose lock guards it.
+        const Info* mOwner;
+
+        //! The stored value.
+        const ValueType* mValue;
+    };
+
+    //! Type of the flattened lookup table.
+    typedef HashMap<const objects::Atom*, Slot> SlotMap;
+
+    /*!
+     * \brief Flattened view of this Info and its ancestors keyed by Atom.
+     * \details Null until flatten is called. Guarded by mInfoMapMutex.
+     */
+    std::auto_ptr<SlotMap> mSlots;
+
+    /*!
+     * \brief The Infos flattened into mSlots and their mKeyGeneration at the
+     *        time.
+     * \details A new key in an ancestor may shadow the value a flattened child
+     *          points at. The table is only trusted while none of the Infos it
+     *          was built from has added a key since, otherwise lookups use the
+     *          string search until it is flattened again. Guarded by
+     *          mInfoMapMutex.
+     */
+    std::vector<std::pair<const Info*, unsigned long> > mSlotsGenerations;
+
+    /*!
+     * \brief Count of new keys added to this Info.
+     * \details Written under mInfoMapMutex but read by flattened descendants
+     *          without it.
+     */
+    std::atomic<unsigned long> mKeyGeneration;
 };
 
 /*! \brief Set a name and value for a piece of information related.
@@ -182,6 +253,8 @@ template<class T> bool Info::setItemValueLocal( const std::string& aStringKey,
     // to determine if the type of the existing and new types match. Search in
     // the parent to see if this new item will shadow a variable in the parent.
     const static bool debugChecking = Configuration::getInstance()->getBool( "debugChecking" );
+    // Hash the key once for both the debug search and the insert.
+    const size_t hashCode = mInfoMap->getHashCode( aStringKey );
     if( debugChecking ){
 #if GCAM_PARALLEL_ENABLED
         // obtain read lock
@@ -189,7 +262,7 @@ template<class T> bool Info::setItemValueLocal( const std::string& aStringKey,
         // the mParentInfo->hasValue calls
         tbb::queuing_rw_mutex::scoped_lock readlock(mInfoMapMutex,false);
 #endif
-        InfoMap::const_iterator curr = mInfoMap->find( aStringKey );
+        InfoMap::const_iterator curr = mInfoMap->find( aStringKey, hashCode );
         if( curr != mInfoMap->end() ){
             // Check that the types match.
             try {
@@ -200,7 +273,9 @@ template<class T> bool Info::setItemValueLocal( const std::string& aStringKey,
             }
         }
         // Check if the value exists in a parent info.
-        else if( mParentInfo && mParentInfo->hasValue( aStringKey ) ){
+        else if( mParentAsInfo ? mParentAsInfo->hasValueChain( aStringKey, hashCode )
+                               : mParentInfo && mParentInfo->hasValue( aStringKey ) )
+        {
             printShadowWarning( aStringKey );
         }
     }
@@ -210,7 +285,22 @@ template<class T> bool Info::setItemValueLocal( const std::string& aStringKey,
     tbb::queuing_rw_mutex::scoped_lock writelock(mInfoMapMutex, true);
 #endif
     // Add the value regardless of whether a warning was printed.
-    mInfoMap->insert( std::make_pair( aStringKey, std::make_pair( aType, boost::any( aValue ) ) ) );
+    std::pair<InfoMap::iterator, bool> inserted =
+        mInfoMap->insert( std::make_pair( aStringKey, std::make_pair( aType, boost::any( aValue ) ) ), hashCode );
+
+    if( inserted.second ){
+        const unsigned long prevGeneration = mKeyGeneration.fetch_add( 1 );
+        // A new local value shadows whatever the flattened table pointed at.
+        if( mSlots.get() ){
+            Slot slot = { this, &inserted.first->second };
+            mSlots->insert( std::make_pair( getKey( aStringKey ), slot ) );
+            // The table now includes the new key so if it was current for this
+            // Info it still is.
+            if( mSlotsGenerations.front().second == prevGeneration ){
+                mSlotsGenerations.front().second = prevGeneration + 1;
+            }
+        }
+    }
     return true;
 }
 
@@ -237,12 +327,37 @@ const T& Info::getItemValueLocal( const std::string& aStringKey,
     /*! \pre A valid key was passed. */
     assert( !aStringKey.empty() );
 
+    // Check for the value.
+    return getItemValueLocal<T>( aStringKey, mInfoMap->getHashCode( aStringKey ), aExists );
+}
+
+/*! \brief Get the value of an item given the precomputed hash code of its key.
+* \details Does not search the parents. The hash code must be the one
+*          InfoMap::getHashCode returns for the key, such as the hash code of
+*          the Atom for the key.
+* \param aStringKey The string key for which to find the value.
+* \param aHashCode The hash code of aStringKey.
+* \param aExists Return parameter to update with whether the item was found.
+* \return The value associated with the key if it exists, the default value
+*         otherwise.
+* \warning The same dangling reference caveat as the string only version
+*          applies.
+*/
+template<class T>
+const T& Info::getItemValueLocal( const std::string& aStringKey,
+                                  const size_t aHashCode,
+                                  bool& aExists ) const
+{
+    /*! \pre A valid key and its hash code were passed. */
+    assert( !aStringKey.empty() );
+    assert( aHashCode == mInfoMap->getHashCode( aStringKey ) );
+
 #if GCAM_PARALLEL_ENABLED
     // read lock for reading the map
     tbb::queuing_rw_mutex::scoped_lock readlock(mInfoMapMutex, false);
 #endif
     // Check for the value.
-    InfoMap::const_iterator curr = mInfoMap->find( aStringKey );
+    InfoMap::const_iterator curr = mInfoMap->find( aStringKey, aHashCode );
     if( curr != mInfoMap->end() ){
         aExists = true;
         // Attempt to set the return value to the found value. This requires
@@ -276,6 +391,85 @@ const T& Info::getItemValueLocal( const std::string& aStringKey,
     return defaultValue;
 }
 
+/*! \brief Get the value of an item through the flattened lookup table.
+* \details Does not search the parents or print warnings, the caller falls back
+*          to the string keyed search when the item is not found.
+* \param aKey The interned key for which to find the value.
+* \param aExists Return parameter to update with whether the item was found
+*        with the requested type.
+* \return The value associated with the key if it exists, the default value
+*         otherwise.
+* \warning The same dangling reference caveat as getItemValueLocal applies.
+*/
+template<class T>
+const T& Info::getItemValueFlat( const objects::Atom* aKey,
+                                 bool& aExists ) const
+{
+    /*! \pre A valid key was passed. */
+    assert( aKey );
+
+    aExists = false;
+    static const T defaultValue = T();
+    Slot slot = { 0, 0 };
+    {
+#if GCAM_PARALLEL_ENABLED
+        tbb::queuing_rw_mutex::scoped_lock readlock( mInfoMapMutex, false );
+#endif
+        if( !isFlattenCurrent() ){
+            return defaultValue;
+        }
+        SlotMap::const_iterator curr = mSlots->find( aKey );
+        if( curr == mSlots->end() ){
+            return defaultValue;
+        }
+        slot = curr->second;
+    }
+
+#if GCAM_PARALLEL_ENABLED
+    // The value may be updated in place by its owner.
+    tbb::queuing_rw_mutex::scoped_lock ownerlock( slot.mOwner->mInfoMapMutex, false );
+#endif
+    const T* valp = boost::any_cast<T>( &slot.mValue->second );
+    if( valp ){
+        aExists = true;
+        return *valp;
+    }
+    return defaultValue;
+}
+
+/*! \brief Search this Info and its Info ancestors for an item given the hash
+*          code of its key.
+* \details Searches in the same order as the parent chain of helpers, but the
+*          key is hashed only once for the whole chain rather than at each
+*          level. The walk stops at the first ancestor which is not an Info.
+* \param aStringKey The string key for which to find the value.
+* \param aHashCode The hash code of aStringKey, which may be the precomputed
+*        hash code of its Atom.
+* \param aExists Return parameter to update with whether the item was found.
+* \param aRemaining Return parameter set to the ancestor at which the search
+*        stopped without finding the item, through which the caller must
+*        continue, or null if there is none.
+* \return The value associated with the key if it exists, the default value
+*         otherwise.
+* \warning The same dangling reference caveat as getItemValueLocal applies.
+*/
+template<class T>
+const T& Info::getItemValueChain( const std::string& aStringKey,
+                                  const size_t aHashCode,
+                                  bool& aExists,
+                                  const IInfo*& aRemaining ) const
+{
+    const Info* curr = this;
+    while( true ){
+        const T& value = curr->getItemValueLocal<T>( aStringKey, aHashCode, aExists );
+        if( aExists || !curr->mParentAsInfo ){
+            aRemaining = aExists ? 0 : curr->mParentInfo;
+            return value;
+        }
+        curr = curr->mParentAsInfo;
+    }
+}
+
 /*!
  * \brief Print a single any type value to XML.
  * \param aValue Value stored as an any type.
@@ -0,0 +1,60 @@
+#ifndef _INFO_BENCHMARK_H_
+#define _INFO_BENCHMARK_H_
+#if defined(_MSC_VER_)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*! 
+* \file info_benchmark.h
+* \ingroup objects
+* \brief The InfoBenchmark class header file.
+*/
+
+#include <iosfwd>
+
+/*! \brief Micro-benchmark of IInfo lookups by string and by interned key.
+* \details Builds a region, sector, subsector and technology chain of IInfo
+*          objects populated with keys the model uses and times repeated
+*          lookups from the technology level through both the string keyed
+*          search and the flattened interned key search. The benchmark is run
+*          at the end of Scenario::completeInit when the configuration flag
+*          benchmark-info-lookups is set.
+*/
+class InfoBenchmark {
+public:
+    static void run( std::ostream& aOut );
+};
+
+#endif // _INFO_BENCHMARK_H_
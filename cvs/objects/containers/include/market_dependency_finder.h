@@ -96,6 +96,8 @@ public:
 
     const std::vector<IActivity*> getOrdering( const int aMarketNumber = -1 ) const;
 
+    void getMarketSetters( std::vector<std::vector<IActivity*> >& aMarketSetters ) const;
+
 #if GCAM_PARALLEL_ENABLED
     GcamFlowGraph* getFlowGraph( const int aMarketNumber = -1 );
 #endif
@@ -191,7 +193,7 @@ public:
     struct DependencyItem {
         DependencyItem( const std::string& aName, const std::string& aLocatedInRegion )
         :mName( aName ), mLocatedInRegion( aLocatedInRegion ), mIsSolved( false ),
-        mLinkedMarket( -1 ), mCanBreakCycle( true ), mHasSelfDependence( false ) {}
+        mLinkedMarket( -1 ), mLinkedDemandMarket( -1 ), mCanBreakCycle( true ), mHasSelfDependence( false ) {}
         ~DependencyItem();
         
         //! A name of a dependency which will correspond to a sector or resource, etc.
@@ -219,6 +221,10 @@ public:
         //! and this graph will be static through all model periods.
         int mLinkedMarket;
         
+        //! The market number of the trial demand market created for this item
+        //! if it was used to break a cycle, otherwise -1.
+        int mLinkedDemandMarket;
+        
         //! Whether this item can be used to break a cycle.
         bool mCanBreakCycle;
 
@@ -65,6 +65,8 @@ public:
     virtual void calc( const int aPeriod );
     
     virtual std::string getDescription() const;
+
+    virtual std::string getRegionName() const;
 private:
     //! The wrapped resource.
     AResource* mResource;
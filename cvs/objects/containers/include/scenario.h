@@ -177,6 +177,8 @@ protected:
         const int aPeriod ) const;
 
     void initSolvers();
+
+    void runBenchmarks();
 };
 
 #endif // _SCENARIO_H_
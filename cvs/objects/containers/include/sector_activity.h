@@ -72,6 +72,8 @@ public:
     void setDemands( const int aPeriod );
     
     std::string getDescription() const;
+
+    const std::string& getRegionName() const;
     
     IActivity* getSectorPriceActivity() const;
     
@@ -111,6 +113,8 @@ public:
     virtual void calc( const int aPeriod );
     
     virtual std::string getDescription() const;
+
+    virtual std::string getRegionName() const;
 private:
     SectorPriceActivity( boost::shared_ptr<SectorActivity> aSectorActivity );
     
@@ -134,6 +138,8 @@ public:
     virtual void calc( const int aPeriod );
     
     virtual std::string getDescription() const;
+
+    virtual std::string getRegionName() const;
 private:
     SectorDemandActivity( boost::shared_ptr<SectorActivity> aSectorActivity );
     
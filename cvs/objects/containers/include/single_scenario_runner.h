@@ -78,6 +78,10 @@ class XMLDBOutputter;
  *          printOutput is called after runScenarios to print output to any
  *          configured databases.
  *          
+ *          A BatchRunner which forks worker processes may call
+ *          parseSharedBaseScenario once before forking so that each worker
+ *          only parses the scenario components passed to setupScenarios.
+ *
  *          The getInternalScenarios functions only return a valid scenario
  *          after setupScenarios is called.
  *
@@ -112,9 +116,20 @@ public:
 
     XMLDBOutputter* getXMLDBOutputter() const;
 
+    static bool parseSharedBaseScenario();
+
+    static void clearSharedBaseScenario();
+
 protected:    
     SingleScenarioRunner();
     static const std::string& getXMLNameStatic();
+
+    static bool parseBaseInput( Scenario* aScenario, const int aMaxReadAhead );
+
+    //! A scenario with the base input and configured scenario components
+    //! already parsed which the next setupScenarios call will take over.
+    static std::auto_ptr<Scenario> sSharedBaseScenario;
+
     //! The scenario which will be run.
     std::auto_ptr<Scenario> mScenario;
 
@@ -110,6 +110,7 @@ public:
     std::map<std::string, const Curve*> getEmissionsPriceCurves( const std::string& ghgName ) const;
     CalcCounter* getCalcCounter() const;
     int getGlobalOrderingSize() const {return mGlobalOrdering.size();}
+    const std::vector<IActivity*>& getGlobalOrdering() const {return mGlobalOrdering;}
     
     const GlobalTechnologyDatabase* getGlobalTechnologyDatabase() const;
 
@@ -130,6 +131,10 @@ public:
      *         of GcamFlowGraph should be passed around as pointers or references.
      */
     GcamFlowGraph *getGlobalFlowGraph() {return mTBBGraphGlobal;}
+  protected:
+    void getSuppliesAndDemands( std::vector<double>& aValues ) const;
+    void setSuppliesAndDemands( const std::vector<double>& aValues );
+    void compareToSerialCalc( const int aPeriod, const std::vector<double>& aStartValues );
 #endif
 protected:
     //! The type of an iterator over the Region vector.
@@ -53,6 +53,21 @@
 #include "util/logger/include/ilogger.h"
 #include "containers/include/scenario.h"
 #include "reporting/include/batch_csv_outputter.h"
+#include "containers/include/single_scenario_runner.h"
+#include "util/base/include/util.h"
+#include "util/logger/include/logger_factory.h"
+#include "solution/util/include/jacobian_store.hpp"
+
+#if !defined( _WIN32 )
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
 
 using namespace std;
 using namespace xercesc;
@@ -65,7 +80,8 @@ typedef list<IScenarioRunner*>::iterator RunnerIterator;
  * \brief Constructor
  */
 BatchRunner::BatchRunner() :
-mInternalRunner( 0 ){ 
+mInternalRunner( 0 ),
+mOutputLockFD( -1 ){ 
 }
 
 //! Destructor
@@ -119,7 +135,7 @@ bool BatchRunner::runScenarios( const int aSinglePeriod,
     // The scenarios are created by determining all possible combinations of
     // file sets. The algorithm operates as follows:
     // 1) Set the current file set in each component to the initial position.
-    // 2) Run the scenario.
+    // 2) Add the scenario to the set of scenarios to run.
     // 3) Set the current component to the first.
     // 4) Increment the current file set in the current component.
     // 5a) If this is a valid position in the current component and go to 2.
@@ -135,8 +151,7 @@ bool BatchRunner::runScenarios( const int aSinglePeriod,
     // All generated scenarios are run with each scenario runner in the order in
     // which the scenario runners were read.
     bool shouldExit = false;
-    bool success = true;
-    BatchCSVOutputter csvOutputter;
+    list<Component> scenarioSets;
     while( !shouldExit ){
         // The data structure containing the current run.
         Component fileSetsToRun;
@@ -146,17 +161,7 @@ bool BatchRunner::runScenarios( const int aSinglePeriod,
             fileSetsToRun.mFileSets.push_back( *( currSet->mFileSetIterator ) );
             fileSetsToRun.mName += currSet->mFileSetIterator->mName;
         }
-
-        // Run it using each possible type of IScenarioRunner.
-        for( RunnerIterator runner = mScenarioRunners.begin(); runner != mScenarioRunners.end(); ++runner ){
-            bool scenarioSuccess = runSingleScenario( *runner, fileSetsToRun, aSinglePeriod, aTimer );
-            success &= scenarioSuccess;
-            (*runner)->getInternalScenario()->accept( &csvOutputter, -1 );
-            csvOutputter.writeDidScenarioSolve( scenarioSuccess );
-            // Clean up the current scenario runner before we move on to the next
-            // so that we do not accumulate a large amount of idle memory.
-            (*runner)->cleanup();
-        }
+        scenarioSets.push_back( fileSetsToRun );
 
         // Loop forward to find a position to increment.
         for( ComponentSet::iterator outPos = mComponentSet.begin(); outPos != mComponentSet.end(); ++outPos ){
@@ -175,7 +180,290 @@ bool BatchRunner::runScenarios( const int aSinglePeriod,
             }
         }
     }
+
+    BatchCSVOutputter csvOutputter;
+
+    // Run the scenarios in forked worker processes if requested.
+    const int numWorkers = Configuration::getInstance()->getInt( "batch-fork-workers", 1, false );
+    if( numWorkers > 1 ){
+        return runForkedScenarios( scenarioSets, numWorkers, aSinglePeriod, aTimer, csvOutputter );
+    }
+
+    bool success = true;
+    for( list<Component>::const_iterator fileSetsToRun = scenarioSets.begin(); fileSetsToRun != scenarioSets.end(); ++fileSetsToRun ){
+        // Run it using each possible type of IScenarioRunner.
+        for( RunnerIterator runner = mScenarioRunners.begin(); runner != mScenarioRunners.end(); ++runner ){
+            bool scenarioSuccess = runSingleScenario( *runner, *fileSetsToRun, aSinglePeriod, aTimer );
+            success &= scenarioSuccess;
+            (*runner)->getInternalScenario()->accept( &csvOutputter, -1 );
+            csvOutputter.writeDidScenarioSolve( scenarioSuccess );
+            // Clean up the current scenario runner before we move on to the next
+            // so that we do not accumulate a large amount of idle memory.
+            (*runner)->cleanup();
+        }
+    }
+    return success;
+}
+
+/*!
+ * \brief Run each scenario with each scenario runner in a forked worker
+ *        process.
+ * \details The base input file and the configured scenario components are
+ *          parsed once in this process before any workers are forked so that
+ *          the workers share the parsed data copy-on-write and each only parses
+ *          its own file sets. At most aNumWorkers workers run at once. Each
+ *          worker writes its batch CSV results to a temporary file which is
+ *          merged into aCSVOutputter in scenario order once the worker exits.
+ *          Writing to the XML database is serialized between workers with a
+ *          lock file. Each worker logs to its own log files, named with the
+ *          index of the worker inserted before the extension. If a solver warm
+ *          starts from the JacobianStore the first scenario is the reference
+ *          scenario and runs alone. Its Jacobians are loaded into this process
+ *          before any other worker is forked so that every other scenario warm
+ *          starts from the same Jacobians, and its results do not depend on
+ *          which workers happened to finish before it was forked, just as if
+ *          the scenarios were run sequentially. Only solvers configured in the
+ *          base input are seen here, one configured by a file set will not
+ *          share Jacobians between workers. The scenarios are run sequentially
+ *          in this process if processes can not be forked on this platform.
+ * \param aScenarioSets The file set combinations to run.
+ * \param aNumWorkers The maximum number of worker processes to run at once.
+ * \param aSinglePeriod The model period to run.
+ * \param aTimer The timer used to print out the amount of time spent performing
+ *        operations.
+ * \param aCSVOutputter The batch CSV outputter to merge results into.
+ * \return Whether all model runs solved successfully.
+ */
+bool BatchRunner::runForkedScenarios( const list<Component>& aScenarioSets,
+                                      const int aNumWorkers,
+                                      const int aSinglePeriod,
+                                      Timer& aTimer,
+                                      BatchCSVOutputter& aCSVOutputter )
+{
+    ILogger& mainLog = ILogger::getLogger( "main_log" );
+#if defined( _WIN32 )
+    mainLog.setLevel( ILogger::WARNING );
+    mainLog << "Forking batch workers is not supported on this platform, running scenarios sequentially." << endl;
+    bool success = true;
+    for( list<Component>::const_iterator fileSetsToRun = aScenarioSets.begin(); fileSetsToRun != aScenarioSets.end(); ++fileSetsToRun ){
+        for( RunnerIterator runner = mScenarioRunners.begin(); runner != mScenarioRunners.end(); ++runner ){
+            bool scenarioSuccess = runSingleScenario( *runner, *fileSetsToRun, aSinglePeriod, aTimer );
+            success &= scenarioSuccess;
+            (*runner)->getInternalScenario()->accept( &aCSVOutputter, -1 );
+            aCSVOutputter.writeDidScenarioSolve( scenarioSuccess );
+            (*runner)->cleanup();
+        }
+    }
     return success;
+#else
+    // Parse the shared part of the input once before forking.
+    mainLog.setLevel( ILogger::NOTICE );
+    mainLog << "Parsing the base input to share between " << aNumWorkers << " batch workers." << endl;
+    if( !SingleScenarioRunner::parseSharedBaseScenario() ){
+        mainLog.setLevel( ILogger::SEVERE );
+        mainLog << "Failed to parse the base input for the batch workers." << endl;
+        return false;
+    }
+
+    const string csvFileName = Configuration::getInstance()->getFile( "batchCSVOutputFile", "batch-csv-out.csv" );
+    const string lockFileName = csvFileName + ".lock";
+    mOutputLockFD = open( lockFileName.c_str(), O_CREAT | O_RDWR, 0644 );
+    if( mOutputLockFD < 0 ){
+        mainLog.setLevel( ILogger::WARNING );
+        mainLog << "Could not open the output lock file " << lockFileName << ": " << strerror( errno )
+                << ", writes to the XML database by the batch workers will not be serialized." << endl;
+    }
+
+    // The bookkeeping for each worker, in the order the scenarios would have
+    // been run sequentially.
+    struct ForkedRun {
+        pid_t mPID;
+        string mName;
+        string mCSVFileName;
+        string mJacobianFileName;
+        bool mIsFinished;
+        bool mSuccess;
+    };
+    vector<ForkedRun> forkedRuns;
+    typedef vector<ForkedRun>::iterator ForkedRunIterator;
+    size_t nextToMerge = 0;
+    int numRunning = 0;
+    bool success = true;
+    const bool shareJacobians = JacobianStore::getInstance().isEnabled();
+
+    list<Component>::const_iterator fileSetsToRun = aScenarioSets.begin();
+    RunnerIterator runner = mScenarioRunners.begin();
+    while( fileSetsToRun != aScenarioSets.end() || numRunning > 0 ){
+        // Hold off forking more workers until the reference scenario is done
+        // so that they all start from its Jacobians.
+        const bool isWaitingForReference = shareJacobians && nextToMerge == 0 && !forkedRuns.empty();
+        if( fileSetsToRun != aScenarioSets.end() && numRunning < aNumWorkers && !isWaitingForReference ){
+            ForkedRun newRun;
+            newRun.mName = fileSetsToRun->mName;
+            const string workerIndex = util::toString( forkedRuns.size() );
+            newRun.mCSVFileName = csvFileName + "." + workerIndex;
+            newRun.mJacobianFileName = shareJacobians && forkedRuns.empty() ? newRun.mCSVFileName + ".jacobians" : "";
+            newRun.mIsFinished = false;
+            newRun.mSuccess = false;
+
+            mainLog.setLevel( ILogger::NOTICE );
+            mainLog << "Scenario " << newRun.mName << " is logged to log files with ." << workerIndex
+                    << " before the extension." << endl;
+
+            // Make sure buffered output is not written by both processes.
+            cout.flush();
+            LoggerFactory::prepareFork();
+            newRun.mPID = fork();
+            if( newRun.mPID == 0 ){
+                // This is the worker process.
+                LoggerFactory::resumeAfterFork( workerIndex );
+                bool scenarioSuccess = runSingleScenario( *runner, *fileSetsToRun, aSinglePeriod, aTimer );
+                {
+                    BatchCSVOutputter workerCSVOutputter( newRun.mCSVFileName );
+                    (*runner)->getInternalScenario()->accept( &workerCSVOutputter, -1 );
+                    workerCSVOutputter.writeDidScenarioSolve( scenarioSuccess );
+                }
+                if( !newRun.mJacobianFileName.empty() ){
+                    ofstream jacobianFile( newRun.mJacobianFileName.c_str(), ios::binary );
+                    JacobianStore::getInstance().save( jacobianFile );
+                }
+                (*runner)->cleanup();
+                unlockOutput();
+                cout.flush();
+                // Skip static destructors and buffered output inherited from
+                // the parent process, so the loggers must be closed here.
+                LoggerFactory::cleanUp();
+                _exit( scenarioSuccess ? 0 : 1 );
+            }
+            LoggerFactory::resumeAfterFork( "" );
+            if( newRun.mPID < 0 ){
+                mainLog.setLevel( ILogger::SEVERE );
+                mainLog << "Failed to fork a batch worker for scenario " << newRun.mName << "." << endl;
+                mUnsolvedNames.push_back( newRun.mName );
+                success = false;
+            }
+            else {
+                forkedRuns.push_back( newRun );
+                ++numRunning;
+            }
+
+            // Move on to the next scenario runner and file set combination.
+            if( ++runner == mScenarioRunners.end() ){
+                runner = mScenarioRunners.begin();
+                ++fileSetsToRun;
+            }
+            continue;
+        }
+
+        // Wait for any worker to finish.
+        int status;
+        const pid_t finishedPID = wait( &status );
+        bool isWaitFailed = false;
+        if( finishedPID < 0 ){
+            if( errno == EINTR ){
+                continue;
+            }
+            // There are no child processes left so any worker we have not
+            // seen finish was lost.  Its results are merged below if it got
+            // as far as writing them.
+            mainLog.setLevel( ILogger::SEVERE );
+            mainLog << "Failed to wait for the batch workers: " << strerror( errno ) << "." << endl;
+            for( ForkedRunIterator currRun = forkedRuns.begin(); currRun != forkedRuns.end(); ++currRun ){
+                if( !currRun->mIsFinished ){
+                    currRun->mIsFinished = true;
+                    mUnsolvedNames.push_back( currRun->mName );
+                }
+            }
+            numRunning = 0;
+            success = false;
+            isWaitFailed = true;
+        }
+        for( ForkedRunIterator currRun = forkedRuns.begin(); currRun != forkedRuns.end(); ++currRun ){
+            if( currRun->mPID == finishedPID ){
+                currRun->mIsFinished = true;
+                currRun->mSuccess = WIFEXITED( status ) && WEXITSTATUS( status ) == 0;
+                --numRunning;
+                if( !currRun->mSuccess ){
+                    mUnsolvedNames.push_back( currRun->mName );
+                    success = false;
+                }
+                if( WIFSIGNALED( status ) ){
+                    mainLog.setLevel( ILogger::SEVERE );
+                    mainLog << "Batch worker for scenario " << currRun->mName
+                            << " was terminated by signal " << WTERMSIG( status ) << "." << endl;
+                }
+            }
+        }
+
+        // Merge the results of all finished workers which have no unfinished
+        // worker ahead of them so that results stay in scenario order.
+        while( nextToMerge < forkedRuns.size() && forkedRuns[ nextToMerge ].mIsFinished ){
+            aCSVOutputter.appendScenarioResults( forkedRuns[ nextToMerge ].mCSVFileName );
+            remove( forkedRuns[ nextToMerge ].mCSVFileName.c_str() );
+            if( !forkedRuns[ nextToMerge ].mJacobianFileName.empty() ){
+                {
+                    ifstream jacobianFile( forkedRuns[ nextToMerge ].mJacobianFileName.c_str(), ios::binary );
+                    if( !jacobianFile || !JacobianStore::getInstance().load( jacobianFile ) ){
+                        mainLog.setLevel( ILogger::WARNING );
+                        mainLog << "Could not read the Jacobians saved by the batch worker for the reference scenario "
+                                << forkedRuns[ nextToMerge ].mName << ", the other scenarios will not warm start from it." << endl;
+                    }
+                }
+                remove( forkedRuns[ nextToMerge ].mJacobianFileName.c_str() );
+            }
+            ++nextToMerge;
+        }
+        if( isWaitFailed ){
+            break;
+        }
+    }
+
+    if( mOutputLockFD >= 0 ){
+        close( mOutputLockFD );
+        mOutputLockFD = -1;
+        remove( lockFileName.c_str() );
+    }
+    SingleScenarioRunner::clearSharedBaseScenario();
+    return success;
+#endif
+}
+
+/*!
+ * \brief Acquire exclusive access to the model output if scenarios are run in
+ *        forked worker processes.
+ * \details The XML database does not support concurrent writers so each worker
+ *          holds this lock from when it starts printing output until its
+ *          scenario runner is cleaned up.
+ */
+void BatchRunner::lockOutput() {
+#if !defined( _WIN32 )
+    if( mOutputLockFD >= 0 ){
+        // Record locks are held per process so the descriptor inherited by
+        // each worker may be shared.
+        struct flock lock;
+        lock.l_type = F_WRLCK;
+        lock.l_whence = SEEK_SET;
+        lock.l_start = 0;
+        lock.l_len = 0;
+        fcntl( mOutputLockFD, F_SETLKW, &lock );
+    }
+#endif
+}
+
+/*!
+ * \brief Release the lock acquired by lockOutput.
+ */
+void BatchRunner::unlockOutput() {
+#if !defined( _WIN32 )
+    if( mOutputLockFD >= 0 ){
+        struct flock lock;
+        lock.l_type = F_UNLCK;
+        lock.l_whence = SEEK_SET;
+        lock.l_start = 0;
+        lock.l_len = 0;
+        fcntl( mOutputLockFD, F_SETLKW, &lock );
+    }
+#endif
 }
 
 void BatchRunner::printOutput( Timer& aTimer ) const {
@@ -255,10 +543,14 @@ bool BatchRunner::runSingleScenario( IScenarioRunner* aScenarioRunner,
     // Cleanup parser and associated memory now to save space while the scenario is running.
     XMLHelper<void>::cleanupParser();
 
-    // Run the scenario.
+    // Run the scenario. The first scenario run becomes the reference
+    // scenario the others warm start solutions from.
+    JacobianStore::getInstance().beginScenario();
     success = mInternalRunner->runScenarios( aSinglePeriod, false, aTimer );
+    JacobianStore::getInstance().endScenario();
     
     // Print the output.
+    lockOutput();
     mInternalRunner->printOutput( aTimer );
     
     // If the run failed, add to the list of failed runs. CHECK ME!
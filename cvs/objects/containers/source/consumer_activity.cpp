@@ -69,3 +69,7 @@ void ConsumerActivity::calc( const int aPeriod ) {
 string ConsumerActivity::getDescription() const {
     return mRegionName + " " + mConsumer->getName();
 }
+
+string ConsumerActivity::getRegionName() const {
+    return mRegionName;
+}
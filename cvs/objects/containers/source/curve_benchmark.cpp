@@ -0,0 +1,189 @@
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*! 
+* \file curve_benchmark.cpp
+* \ingroup objects
+* \brief CurveBenchmark class source file.
+*/
+
+#include "util/base/include/definitions.h"
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include "containers/include/curve_benchmark.h"
+#include "containers/include/scenario.h"
+#include "util/curves/include/point_set_curve.h"
+#include "util/curves/include/explicit_point_set.h"
+#include "util/curves/include/sorted_point_set.h"
+#include "util/curves/include/xy_data_point.h"
+#include "util/base/include/timer.h"
+#include "util/base/include/gcam_fusion.hpp"
+#include "util/base/include/gcam_data_containers.h"
+
+using namespace std;
+
+template<typename DataType>
+void CurveBenchmark::processData( DataType& aData ) {
+    // ignore
+}
+
+template<>
+void CurveBenchmark::processData<PointSetCurve*>( PointSetCurve*& aData ) {
+    if( aData ) {
+        mCurves.push_back( aData );
+    }
+}
+
+/*! \brief Run the benchmark and write the results.
+* \details Each curve is evaluated at evenly spaced prices up to its maximum
+*          tax, the same domain MACControl evaluates it over.  All three
+*          evaluations read the same points so the sums are compared as a
+*          check that the sorted point set agrees with the explicit one.
+* \param aScenario The scenario from which to collect the MAC curves.
+* \param aOut Stream to which to write the timings.
+*/
+void CurveBenchmark::run( Scenario* aScenario, ostream& aOut ) {
+    CurveBenchmark collector;
+    vector<FilterStep*> findMACSteps( 2, 0 );
+    findMACSteps[ 0 ] = new FilterStep( "" );
+    findMACSteps[ 1 ] = new FilterStep( "mac-reduction" );
+    GCAMFusion<CurveBenchmark, false, false, true> findMACCurves( collector, findMACSteps );
+    findMACCurves.startFilter( aScenario );
+
+    // clean up GCAMFusion related memory
+    for( auto filterStep : findMACSteps ) {
+        delete filterStep;
+    }
+
+    // Rebuild each curve with both types of point sets.  Curves with fewer
+    // than two points can not be interpolated and are skipped.
+    vector<PointSetCurve*> explicitCurves;
+    vector<PointSetCurve*> sortedCurves;
+    vector<const SortedPointSet*> sortedPoints;
+    for( size_t i = 0; i < collector.mCurves.size(); ++i ){
+        const PointSet::SortedPairVector pairs = collector.mCurves[ i ]->getSortedPairs();
+        if( pairs.size() < 2 ){
+            continue;
+        }
+        ExplicitPointSet* explicitSet = new ExplicitPointSet();
+        SortedPointSet* sortedSet = new SortedPointSet();
+        for( PointSet::SortedPairVector::const_iterator it = pairs.begin(); it != pairs.end(); ++it ){
+            explicitSet->addPoint( new XYDataPoint( it->first, it->second ) );
+            sortedSet->addPoint( new XYDataPoint( it->first, it->second ) );
+        }
+        explicitCurves.push_back( new PointSetCurve( explicitSet ) );
+        sortedCurves.push_back( new PointSetCurve( sortedSet ) );
+        sortedPoints.push_back( sortedSet );
+    }
+
+    if( explicitCurves.empty() ){
+        aOut << "Curve lookup benchmark: no MAC curves were found to evaluate." << endl;
+        return;
+    }
+
+    const int NUM_PRICES = 64;
+    vector<vector<double> > prices( explicitCurves.size(), vector<double>( NUM_PRICES ) );
+    for( size_t i = 0; i < explicitCurves.size(); ++i ){
+        const double maxTax = explicitCurves[ i ]->getMaxX();
+        for( int j = 0; j < NUM_PRICES; ++j ){
+            prices[ i ][ j ] = maxTax * j / ( NUM_PRICES - 1 );
+        }
+    }
+
+    // Scale the repetitions so the total work is roughly independent of the
+    // number of curves in the scenario.
+    const int TARGET_LOOKUPS = 10000000;
+    const int iterations = max( 1, TARGET_LOOKUPS / static_cast<int>( explicitCurves.size() * NUM_PRICES ) );
+    const double numLookups = static_cast<double>( iterations ) * explicitCurves.size() * NUM_PRICES;
+
+    Timer explicitTimer;
+    explicitTimer.start();
+    double explicitSum = 0;
+    for( int iter = 0; iter < iterations; ++iter ){
+        for( size_t i = 0; i < explicitCurves.size(); ++i ){
+            for( int j = 0; j < NUM_PRICES; ++j ){
+                explicitSum += explicitCurves[ i ]->getY( prices[ i ][ j ] );
+            }
+        }
+    }
+    explicitTimer.stop();
+
+    Timer sortedTimer;
+    sortedTimer.start();
+    double sortedSum = 0;
+    for( int iter = 0; iter < iterations; ++iter ){
+        for( size_t i = 0; i < sortedCurves.size(); ++i ){
+            for( int j = 0; j < NUM_PRICES; ++j ){
+                sortedSum += sortedCurves[ i ]->getY( prices[ i ][ j ] );
+            }
+        }
+    }
+    sortedTimer.stop();
+
+    Timer batchTimer;
+    batchTimer.start();
+    double batchSum = 0;
+    vector<double> batchY( NUM_PRICES );
+    for( int iter = 0; iter < iterations; ++iter ){
+        for( size_t i = 0; i < sortedPoints.size(); ++i ){
+            sortedPoints[ i ]->interpolateY( &prices[ i ][ 0 ], &batchY[ 0 ], NUM_PRICES );
+            for( int j = 0; j < NUM_PRICES; ++j ){
+                batchSum += batchY[ j ];
+            }
+        }
+    }
+    batchTimer.stop();
+
+    const double explicitTime = explicitTimer.getTotalTimeDifference();
+    const double sortedTime = sortedTimer.getTotalTimeDifference();
+    const double batchTime = batchTimer.getTotalTimeDifference();
+    aOut << "Curve lookup benchmark, " << numLookups << " lookups over "
+         << explicitCurves.size() << " MAC curves:" << endl;
+    aOut << "    explicit point set: " << explicitTime << " s, "
+         << explicitTime / numLookups * 1e9 << " ns per lookup." << endl;
+    aOut << "    sorted point set: " << sortedTime << " s, "
+         << sortedTime / numLookups * 1e9 << " ns per lookup." << endl;
+    aOut << "    sorted point set batched: " << batchTime << " s, "
+         << batchTime / numLookups * 1e9 << " ns per lookup." << endl;
+    if( explicitSum != sortedSum || explicitSum != batchSum ){
+        aOut << "    Lookups disagree: " << explicitSum << " from the explicit point set, "
+             << sortedSum << " from the sorted point set and "
+             << batchSum << " batched." << endl;
+    }
+
+    for( size_t i = 0; i < explicitCurves.size(); ++i ){
+        delete explicitCurves[ i ];
+        delete sortedCurves[ i ];
+    }
+}
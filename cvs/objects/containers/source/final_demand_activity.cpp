@@ -65,3 +65,7 @@ void FinalDemandActivity::calc( const int aPeriod ) {
 string FinalDemandActivity::getDescription() const {
     return mRegionName + " " + mFinalDemand->getName();
 }
+
+string FinalDemandActivity::getRegionName() const {
+    return mRegionName;
+}
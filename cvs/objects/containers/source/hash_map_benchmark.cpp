@@ -0,0 +1,245 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*! 
+* \file hash_map_benchmark.cpp
+* \ingroup objects
+* \brief HashMapBenchmark class source file.
+*/
+
+#include "util/base/include/definitions.h"
+#include <string>
+#include <vector>
+#include <iostream>
+#include <boost/unordered_map.hpp>
+#include <boost/shared_ptr.hpp>
+#include "containers/include/hash_map_benchmark.h"
+#include "util/base/include/hash_map.h"
+#include "util/base/include/atom.h"
+#include "util/base/include/timer.h"
+#include "marketplace/include/marketplace.h"
+#include "marketplace/include/market_container.h"
+#include "marketplace/include/market_locator.h"
+
+using namespace std;
+
+/*! \brief Time building and searching a two level region and good map with
+*          the given map type.
+* \details The maps are nested in the same way as the MarketLocator. Each
+*          search is for the region and good of a market followed by a search
+*          in the same region for a good which has no market.
+* \param aRegions The region of each market.
+* \param aGoods The good of each market.
+* \param aSearches The index of the region and good pair for each search.
+* \param aMissGoods A good which has no market in the region for each search.
+* \param aInsertTime Return parameter for the time spent building the maps.
+* \param aSearchTime Return parameter for the time spent searching.
+* \return The sum of the market numbers found which is used to check that the
+*         map types agree.
+*/
+template<class RegionMap, class GoodMap>
+long HashMapBenchmark::timeLookups( const vector<string>& aRegions,
+                                    const vector<string>& aGoods,
+                                    const vector<unsigned int>& aSearches,
+                                    const vector<string>& aMissGoods,
+                                    double& aInsertTime,
+                                    double& aSearchTime )
+{
+    Timer insertTimer;
+    insertTimer.start();
+    RegionMap regions;
+    for( unsigned int i = 0; i < aRegions.size(); ++i ){
+        typename RegionMap::iterator region = regions.find( aRegions[ i ] );
+        if( region == regions.end() ){
+            region = regions.insert( make_pair( aRegions[ i ], boost::shared_ptr<GoodMap>( new GoodMap() ) ) ).first;
+        }
+        region->second->insert( make_pair( aGoods[ i ], static_cast<int>( i ) ) );
+    }
+    insertTimer.stop();
+    aInsertTime = insertTimer.getTotalTimeDifference();
+
+    Timer searchTimer;
+    searchTimer.start();
+    long sum = 0;
+    for( int iter = 0; iter < ITERATIONS; ++iter ){
+        for( unsigned int i = 0; i < aSearches.size(); ++i ){
+            const unsigned int market = aSearches[ i ];
+            const GoodMap& goods = *regions.find( aRegions[ market ] )->second;
+            sum += goods.find( aGoods[ market ] )->second;
+            sum += goods.find( aMissGoods[ i ] ) == goods.end() ? 0 : 1;
+        }
+    }
+    searchTimer.stop();
+    aSearchTime = searchTimer.getTotalTimeDifference();
+    return sum;
+}
+
+/*! \brief Time searching a MarketLocator by name and with precomputed hash
+*          codes.
+* \details The hash codes of the names are computed before the timing starts,
+*          the same searches as timeLookups are then made once hashing the
+*          names on every search and once with the stored hash codes.
+* \param aRegions The region of each market.
+* \param aGoods The good of each market.
+* \param aSearches The index of the region and good pair for each search.
+* \param aMissGoods A good which has no market in the region for each search.
+* \param aStringTime Return parameter for the time spent searching by name.
+* \param aHashedTime Return parameter for the time spent searching with the
+*        precomputed hash codes.
+* \return The sum of the market numbers found by each method, which must agree.
+*/
+long HashMapBenchmark::timeLocatorLookups( const vector<string>& aRegions,
+                                           const vector<string>& aGoods,
+                                           const vector<unsigned int>& aSearches,
+                                           const vector<string>& aMissGoods,
+                                           double& aStringTime,
+                                           double& aHashedTime )
+{
+    MarketLocator locator;
+    vector<size_t> regionHashes( aRegions.size() );
+    vector<size_t> goodHashes( aGoods.size() );
+    for( unsigned int i = 0; i < aRegions.size(); ++i ){
+        locator.addMarket( aRegions[ i ], aRegions[ i ], aGoods[ i ], static_cast<int>( i ) );
+        regionHashes[ i ] = MarketLocator::getHashCode( aRegions[ i ] );
+        goodHashes[ i ] = MarketLocator::getHashCode( aGoods[ i ] );
+    }
+    vector<size_t> missHashes( aMissGoods.size() );
+    for( unsigned int i = 0; i < aMissGoods.size(); ++i ){
+        missHashes[ i ] = MarketLocator::getHashCode( aMissGoods[ i ] );
+    }
+
+    Timer stringTimer;
+    stringTimer.start();
+    long stringSum = 0;
+    for( int iter = 0; iter < ITERATIONS; ++iter ){
+        for( unsigned int i = 0; i < aSearches.size(); ++i ){
+            const unsigned int market = aSearches[ i ];
+            stringSum += locator.getMarketNumber( aRegions[ market ], aGoods[ market ] );
+            stringSum += locator.getMarketNumber( aRegions[ market ], aMissGoods[ i ] );
+        }
+    }
+    stringTimer.stop();
+    aStringTime = stringTimer.getTotalTimeDifference();
+
+    Timer hashedTimer;
+    hashedTimer.start();
+    long hashedSum = 0;
+    for( int iter = 0; iter < ITERATIONS; ++iter ){
+        for( unsigned int i = 0; i < aSearches.size(); ++i ){
+            const unsigned int market = aSearches[ i ];
+            hashedSum += locator.getMarketNumber( aRegions[ market ], regionHashes[ market ],
+                                                  aGoods[ market ], goodHashes[ market ] );
+            hashedSum += locator.getMarketNumber( aRegions[ market ], regionHashes[ market ],
+                                                  aMissGoods[ i ], missHashes[ i ] );
+        }
+    }
+    hashedTimer.stop();
+    aHashedTime = hashedTimer.getTotalTimeDifference();
+    return stringSum == hashedSum ? stringSum : -1;
+}
+
+/*! \brief Run the benchmark and write the results.
+* \details The region and good names are those of the markets in the
+*          marketplace, including each region contained in a multi-region
+*          market. Searches are made in a fixed pseudo-random order so the
+*          results do not depend on the order the markets were created in.
+* \param aMarketplace The marketplace from which to take the market names.
+* \param aOut Stream to which to write the timings.
+*/
+void HashMapBenchmark::run( const Marketplace* aMarketplace, ostream& aOut ) {
+    vector<string> regions;
+    vector<string> goods;
+    for( unsigned int i = 0; i < aMarketplace->mMarkets.size(); ++i ){
+        const MarketContainer* market = aMarketplace->mMarkets[ i ];
+        const vector<const objects::Atom*>& containedRegions = market->getContainedRegions();
+        for( unsigned int j = 0; j < containedRegions.size(); ++j ){
+            regions.push_back( containedRegions[ j ]->getID() );
+            goods.push_back( market->getGoodName() );
+        }
+    }
+    if( regions.empty() ){
+        aOut << "HashMap benchmark: no markets were found to replay." << endl;
+        return;
+    }
+
+    // Search the markets in a fixed pseudo-random order. Each search is paired
+    // with a miss as the model does when checking for optional markets such as
+    // CO2, the missing good is derived from another market's good so that it
+    // has a realistic length.
+    vector<unsigned int> searches( regions.size() );
+    vector<string> missGoods( regions.size() );
+    unsigned long state = 1;
+    for( unsigned int i = 0; i < searches.size(); ++i ){
+        state = state * 6364136223846793005UL + 1442695040888963407UL;
+        searches[ i ] = static_cast<unsigned int>( ( state >> 33 ) % regions.size() );
+        missGoods[ i ] = goods[ ( searches[ i ] + 1 + ( state >> 17 ) % regions.size() ) % regions.size() ] + "-missing";
+    }
+
+    typedef HashMap<string, int> HashGoodMap;
+    typedef HashMap<string, boost::shared_ptr<HashGoodMap> > HashRegionMap;
+    typedef boost::unordered_map<string, int> UnorderedGoodMap;
+    typedef boost::unordered_map<string, boost::shared_ptr<UnorderedGoodMap> > UnorderedRegionMap;
+
+    double hashMapInsertTime = 0;
+    double hashMapSearchTime = 0;
+    const long hashMapSum = timeLookups<HashRegionMap, HashGoodMap>( regions, goods, searches, missGoods,
+                                                                      hashMapInsertTime, hashMapSearchTime );
+    double unorderedInsertTime = 0;
+    double unorderedSearchTime = 0;
+    const long unorderedSum = timeLookups<UnorderedRegionMap, UnorderedGoodMap>( regions, goods, searches, missGoods,
+                                                                                unorderedInsertTime, unorderedSearchTime );
+
+    const double numLookups = static_cast<double>( ITERATIONS ) * searches.size() * 2;
+    aOut << "HashMap benchmark, " << regions.size() << " region and good pairs, " << numLookups
+         << " good lookups of which half miss:" << endl;
+    aOut << "    HashMap inserts: " << hashMapInsertTime << " s." << endl;
+    aOut << "    unordered_map inserts: " << unorderedInsertTime << " s." << endl;
+    aOut << "    HashMap: " << hashMapSearchTime << " s, "
+         << hashMapSearchTime / numLookups * 1e9 << " ns per lookup." << endl;
+    aOut << "    unordered_map: " << unorderedSearchTime << " s, "
+         << unorderedSearchTime / numLookups * 1e9 << " ns per lookup." << endl;
+    double locatorStringTime = 0;
+    double locatorHashedTime = 0;
+    const long locatorSum = timeLocatorLookups( regions, goods, searches, missGoods,
+                                                locatorStringTime, locatorHashedTime );
+    aOut << "    MarketLocator by name: " << locatorStringTime << " s, "
+         << locatorStringTime / numLookups * 1e9 << " ns per lookup." << endl;
+    aOut << "    MarketLocator with precomputed hash codes: " << locatorHashedTime << " s, "
+         << locatorHashedTime / numLookups * 1e9 << " ns per lookup." << endl;
+    if( locatorSum == -1 ){
+        aOut << "    MarketLocator lookups by name and by hash code disagree." << endl;
+    }
+    if( hashMapSum != unorderedSum ){
+        aOut << "    Lookups disagree: " << hashMapSum << " from HashMap and " << unorderedSum
+             << " from unordered_map." << endl;
+    }
+}
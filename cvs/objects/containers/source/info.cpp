@@ -43,8 +43,35 @@
 #include "containers/include/info.h"
 #include "util/logger/include/ilogger.h"
 #include "util/base/include/xml_helper.h"
+#include "util/base/include/atom_registry.h"
+
+#if GCAM_PARALLEL_ENABLED
+#include <tbb/spin_mutex.h>
+#endif
 
 using namespace std;
+using namespace objects;
+
+/*! \brief Get the interned key for a string key.
+* \details Finds the Atom for the key, creating it if this is the first time the
+*          key has been seen. Callers on hot paths should look the key up once
+*          and keep it, for instance in a function level static.
+* \param aStringKey The string key.
+* \return The interned key.
+*/
+const Atom* IInfo::getKey( const string& aStringKey ){
+#if GCAM_PARALLEL_ENABLED
+    // The AtomRegistry itself is not thread safe.
+    static tbb::spin_mutex keyMutex;
+    tbb::spin_mutex::scoped_lock lock( keyMutex );
+#endif
+    const Atom* key = AtomRegistry::getInstance()->findAtom( aStringKey );
+    if( !key ){
+        // The Atom registers itself and is deallocated by the registry.
+        key = new Atom( aStringKey );
+    }
+    return key;
+}
 
 /*! \brief Constructor
 * \details Constructs the Info object by allocating a hashmap to store the
@@ -58,7 +85,9 @@ using namespace std;
 Info::Info( const IInfo* aParentInfo, const string& aOwnerName ) :
 mOwnerName( aOwnerName ),
 mInfoMap( new InfoMap( getInitialSize() ) ),
-mParentInfo( aParentInfo )
+mParentInfo( aParentInfo ),
+mParentAsInfo( dynamic_cast<const Info*>( aParentInfo ) ),
+mKeyGeneration( 0 )
 {
 }
 
@@ -89,14 +118,15 @@ bool Info::setString( const string& aStringKey, const string& aValue ){
     
 bool Info::getBoolean( const string& aStringKey, const bool aMustExist ) const
 {
-    // Perform a local search.
+    // Search this Info and its ancestors, hashing the key once.
     bool found = false;
-    bool value = getItemValueLocal<bool>( aStringKey, found );
+    const IInfo* remaining = 0;
+    bool value = getItemValueChain<bool>( aStringKey, mInfoMap->getHashCode( aStringKey ), found, remaining );
     
-    // If the item wasn't found search the parent info.
+    // If the item wasn't found search the rest of the parents.
     if( !found ){
-        if( mParentInfo ){
-            value = mParentInfo->getBooleanHelper( aStringKey, found );
+        if( remaining ){
+            value = remaining->getBooleanHelper( aStringKey, found );
         }
         // The item must exist and was not found or there was no parent to search.
         if( aMustExist && !found ){
@@ -108,14 +138,15 @@ bool Info::getBoolean( const string& aStringKey, const bool aMustExist ) const
 
 int Info::getInteger( const string& aStringKey, const bool aMustExist ) const
 {
-    // Perform a local search.
+    // Search this Info and its ancestors, hashing the key once.
     bool found = false;
-    int value = getItemValueLocal<int>( aStringKey, found );
+    const IInfo* remaining = 0;
+    int value = getItemValueChain<int>( aStringKey, mInfoMap->getHashCode( aStringKey ), found, remaining );
     
-    // If the item wasn't found search the parent info.
+    // If the item wasn't found search the rest of the parents.
     if( !found ){
-        if( mParentInfo ){
-            value = mParentInfo->getIntegerHelper( aStringKey, found );
+        if( remaining ){
+            value = remaining->getIntegerHelper( aStringKey, found );
         }
         // The item must exist and was not found or there was no parent to search.
         if( aMustExist && !found ){
@@ -127,14 +158,15 @@ int Info::getInteger( const string& aStringKey, const bool aMustExist ) const
 
 double Info::getDouble( const string& aStringKey, const bool aMustExist ) const
 {
-    // Perform a local search.
+    // Search this Info and its ancestors, hashing the key once.
     bool found = false;
-    double value = getItemValueLocal<double>( aStringKey, found );
-
-    // If the item wasn't found search the parent info.
+    const IInfo* remaining = 0;
+    double value = getItemValueChain<double>( aStringKey, mInfoMap->getHashCode( aStringKey ), found, remaining );
+    
+    // If the item wasn't found search the rest of the parents.
     if( !found ){
-        if( mParentInfo ){
-            value = mParentInfo->getDoubleHelper( aStringKey, found );
+        if( remaining ){
+            value = remaining->getDoubleHelper( aStringKey, found );
         }
         // The item must exist and was not found or there was no parent to search.
         if( aMustExist && !found ){
@@ -146,16 +178,18 @@ double Info::getDouble( const string& aStringKey, const bool aMustExist ) const
 
 const string& Info::getString( const string& aStringKey, const bool aMustExist ) const
 {
-    // Perform a local search.
+    // Search this Info and its ancestors, hashing the key once.
     bool found = false;
-    const string& value = getItemValueLocal<string>( aStringKey, found );
+    const IInfo* remaining = 0;
+    const string& value = getItemValueChain<string>( aStringKey, mInfoMap->getHashCode( aStringKey ),
+                                                     found, remaining );
     if( !found ){
-        // If the item wasn't found search the parent info.
-        if( mParentInfo ){
-            return mParentInfo->getStringHelper( aStringKey, found );
+        // If the item wasn't found search the rest of the parents.
+        if( remaining ){
+            return remaining->getStringHelper( aStringKey, found );
         }
         // The item must exist and was not found or there was no parent to search.
-        if( aMustExist && !found ){
+        if( aMustExist && !mParentInfo ){
             printItemNotFoundWarning( aStringKey );
         }
     }
@@ -166,70 +200,224 @@ const string& Info::getString( const string& aStringKey, const bool aMustExist )
 
 bool Info::getBooleanHelper( const string& aStringKey, bool& aFound ) const
 {
-    // Perform a local search.
-    bool value = getItemValueLocal<bool>( aStringKey, aFound );
+    // Search this Info and its ancestors, hashing the key once.
+    const IInfo* remaining = 0;
+    bool value = getItemValueChain<bool>( aStringKey, mInfoMap->getHashCode( aStringKey ), aFound, remaining );
     
-    // If the item wasn't found and parent exists, search the parent info.
-    if( !aFound && mParentInfo ){
-        value = mParentInfo->getBooleanHelper( aStringKey, aFound );
+    // If the item wasn't found search the rest of the parents.
+    if( !aFound && remaining ){
+        value = remaining->getBooleanHelper( aStringKey, aFound );
     }
     return value;
 }
 
 int Info::getIntegerHelper( const string& aStringKey, bool& aFound ) const
 {
-    // Perform a local search.
-    int value = getItemValueLocal<int>( aStringKey, aFound );
+    // Search this Info and its ancestors, hashing the key once.
+    const IInfo* remaining = 0;
+    int value = getItemValueChain<int>( aStringKey, mInfoMap->getHashCode( aStringKey ), aFound, remaining );
     
-    // If the item wasn't found and parent exists, search the parent info.
-    if( !aFound && mParentInfo ){
-        value = mParentInfo->getIntegerHelper( aStringKey, aFound );
+    // If the item wasn't found search the rest of the parents.
+    if( !aFound && remaining ){
+        value = remaining->getIntegerHelper( aStringKey, aFound );
     }
     return value;
 }
 
 double Info::getDoubleHelper( const string& aStringKey, bool& aFound ) const
 {
-    // Perform a local search.
-    double value = getItemValueLocal<double>( aStringKey, aFound );
+    // Search this Info and its ancestors, hashing the key once.
+    const IInfo* remaining = 0;
+    double value = getItemValueChain<double>( aStringKey, mInfoMap->getHashCode( aStringKey ), aFound, remaining );
     
-    // If the item wasn't found and parent exists, search the parent info.
-    if( !aFound && mParentInfo ){
-        value = mParentInfo->getDoubleHelper( aStringKey, aFound );
+    // If the item wasn't found search the rest of the parents.
+    if( !aFound && remaining ){
+        value = remaining->getDoubleHelper( aStringKey, aFound );
     }
     return value;
 }
 
 const string& Info::getStringHelper( const string& aStringKey, bool& aFound ) const
 {
-    // Perform a local search.
-    const string& value = getItemValueLocal<string>( aStringKey, aFound );
+    // Search this Info and its ancestors, hashing the key once.
+    const IInfo* remaining = 0;
+    const string& value = getItemValueChain<string>( aStringKey, mInfoMap->getHashCode( aStringKey ),
+                                                     aFound, remaining );
     
-    // If the item wasn't found and parent exists, search the parent info.
-    if( !aFound && mParentInfo ){
-        return mParentInfo->getStringHelper( aStringKey, aFound );
+    // If the item wasn't found search the rest of the parents.
+    if( !aFound && remaining ){
+        return remaining->getStringHelper( aStringKey, aFound );
     }
     return value;
 }
 
-bool Info::hasValue( const string& aStringKey ) const {
+bool Info::getBoolean( const Atom* aKey, const bool aMustExist ) const {
+    bool found = false;
+    const bool& value = getItemValueFlat<bool>( aKey, found );
+    if( found ){
+        return value;
+    }
+    const IInfo* remaining = 0;
+    const bool& chainValue = getItemValueChain<bool>( aKey->getID(), aKey->getHashCode(), found, remaining );
+    if( !found && remaining ){
+        return remaining->getBoolean( aKey, aMustExist );
+    }
+    if( !found && aMustExist ){
+        printItemNotFoundWarning( aKey->getID() );
+    }
+    return chainValue;
+}
+
+int Info::getInteger( const Atom* aKey, const bool aMustExist ) const {
+    bool found = false;
+    const int& value = getItemValueFlat<int>( aKey, found );
+    if( found ){
+        return value;
+    }
+    const IInfo* remaining = 0;
+    const int& chainValue = getItemValueChain<int>( aKey->getID(), aKey->getHashCode(), found, remaining );
+    if( !found && remaining ){
+        return remaining->getInteger( aKey, aMustExist );
+    }
+    if( !found && aMustExist ){
+        printItemNotFoundWarning( aKey->getID() );
+    }
+    return chainValue;
+}
+
+double Info::getDouble( const Atom* aKey, const bool aMustExist ) const {
+    bool found = false;
+    const double& value = getItemValueFlat<double>( aKey, found );
+    if( found ){
+        return value;
+    }
+    const IInfo* remaining = 0;
+    const double& chainValue = getItemValueChain<double>( aKey->getID(), aKey->getHashCode(), found, remaining );
+    if( !found && remaining ){
+        return remaining->getDouble( aKey, aMustExist );
+    }
+    if( !found && aMustExist ){
+        printItemNotFoundWarning( aKey->getID() );
+    }
+    return chainValue;
+}
+
+const string& Info::getString( const Atom* aKey, const bool aMustExist ) const {
+    bool found = false;
+    const string& value = getItemValueFlat<string>( aKey, found );
+    if( found ){
+        return value;
+    }
+    const IInfo* remaining = 0;
+    const string& chainValue = getItemValueChain<string>( aKey->getID(), aKey->getHashCode(), found, remaining );
+    if( !found && remaining ){
+        return remaining->getString( aKey, aMustExist );
+    }
+    if( !found && aMustExist ){
+        printItemNotFoundWarning( aKey->getID() );
+    }
+    return chainValue;
+}
+
+bool Info::hasValue( const Atom* aKey ) const {
+    {
+#if GCAM_PARALLEL_ENABLED
+        tbb::queuing_rw_mutex::scoped_lock readlock( mInfoMapMutex, false );
+#endif
+        if( isFlattenCurrent() && mSlots->find( aKey ) != mSlots->end() ){
+            return true;
+        }
+    }
+    // The key may have been added to an ancestor after flattening. Search the
+    // chain with the precomputed hash code of the Atom.
+    return hasValueChain( aKey->getID(), aKey->getHashCode() );
+}
+
+/*! \brief Build the flattened lookup table for this Info and its ancestors.
+* \details Walks the parent chain from this Info outward and records where each
+*          key is stored, so that the nearest definition wins in the same way as
+*          the string keyed search. The walk stops at the first ancestor which
+*          is not an Info, keys beyond that are found through the string
+*          fallback. Calling this again rebuilds the table. The key generation
+*          of each Info walked is recorded so the table is only invalidated by
+*          new keys in this chain.
+*/
+void Info::flatten() {
+    auto_ptr<SlotMap> slots( new SlotMap( getInitialSize() ) );
+    vector<pair<const Info*, unsigned long> > generations;
+    for( const Info* curr = this; curr; curr = dynamic_cast<const Info*>( curr->mParentInfo ) ){
 #if GCAM_PARALLEL_ENABLED
-    // get a read lock on the info map
-    tbb::queuing_rw_mutex::scoped_lock readlock(mInfoMapMutex,false);
+        tbb::queuing_rw_mutex::scoped_lock readlock( curr->mInfoMapMutex, false );
 #endif
-    // Check the local store. 
-    bool currHasValue = ( mInfoMap->find( aStringKey ) != mInfoMap->end() );
+        generations.push_back( make_pair( curr, curr->mKeyGeneration.load() ) );
+        for( InfoMap::const_iterator item = curr->mInfoMap->begin(); item != curr->mInfoMap->end(); ++item ){
+            const Atom* key = getKey( item->first );
+            if( slots->find( key ) == slots->end() ){
+                Slot slot = { curr, &item->second };
+                slots->insert( make_pair( key, slot ) );
+            }
+        }
+    }
 
 #if GCAM_PARALLEL_ENABLED
-    // the lock on our local map is no longer needed.  Release before
-    // recursing into parent structures
-    readlock.release();
+    tbb::queuing_rw_mutex::scoped_lock writelock( mInfoMapMutex, true );
 #endif
-    // If the value was not found, check the parent.
-    if( !currHasValue && mParentInfo ){
-        currHasValue = mParentInfo->hasValue( aStringKey );
+    mSlots = slots;
+    mSlotsGenerations.swap( generations );
+}
+
+/*! \brief Return whether the flattened lookup table can be used.
+* \details The table is complete as long as no Info in the chain it was built
+*          from has added a key since. New keys in this Info are added to the
+*          table directly. The chain is only a few levels deep so this is much
+*          cheaper than the string search. The caller must hold a lock on
+*          mInfoMapMutex.
+* \return Whether lookups may use mSlots.
+*/
+bool Info::isFlattenCurrent() const {
+    if( !mSlots.get() ){
+        return false;
+    }
+    for( vector<pair<const Info*, unsigned long> >::const_iterator it = mSlotsGenerations.begin();
+         it != mSlotsGenerations.end(); ++it )
+    {
+        if( it->first->mKeyGeneration.load( memory_order_relaxed ) != it->second ){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Info::hasValue( const string& aStringKey ) const {
+    return hasValueChain( aStringKey, mInfoMap->getHashCode( aStringKey ) );
+}
+
+/*! \brief Check whether this Info or any of its ancestors has a value for a
+*          key given the hash code of the key.
+* \details The key is hashed only once for the chain of Infos. The search
+*          continues through the IInfo interface at the first ancestor which is
+*          not an Info.
+* \param aStringKey The key to search for.
+* \param aHashCode The hash code of aStringKey.
+* \return Whether a value exists for the key.
+*/
+bool Info::hasValueChain( const string& aStringKey, const size_t aHashCode ) const {
+    for( const Info* curr = this; curr; curr = curr->mParentAsInfo ){
+        {
+#if GCAM_PARALLEL_ENABLED
+            // Get a read lock on the info map, released before moving to the
+            // parent.
+            tbb::queuing_rw_mutex::scoped_lock readlock( curr->mInfoMapMutex, false );
+#endif
+            if( curr->mInfoMap->find( aStringKey, aHashCode ) != curr->mInfoMap->end() ){
+                return true;
+            }
+        }
+        if( curr->mParentInfo && !curr->mParentAsInfo ){
+            return curr->mParentInfo->hasValue( aStringKey );
+        }
     }
-    return currHasValue;
+    return false;
 }
 
 void Info::toDebugXML( const int aperiod, Tabs* aTabs, ostream& aOut ) const {
@@ -0,0 +1,129 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*! 
+* \file info_benchmark.cpp
+* \ingroup objects
+* \brief InfoBenchmark class source file.
+*/
+
+#include "util/base/include/definitions.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <iostream>
+#include "containers/include/info_benchmark.h"
+#include "containers/include/iinfo.h"
+#include "containers/include/info_factory.h"
+#include "util/base/include/timer.h"
+
+using namespace std;
+
+/*! \brief Run the benchmark and write the results.
+* \details Both searches read the same values so the sums are compared as a
+*          check that the flattened table agrees with the string search.
+* \param aOut Stream to which to write the timings.
+*/
+void InfoBenchmark::run( ostream& aOut ) {
+    auto_ptr<IInfo> regionInfo( InfoFactory::constructInfo( 0, "benchmark" ) );
+    regionInfo->setDouble( "interest-rate", 0.1 );
+    regionInfo->setDouble( "social-discount-rate", 0.02 );
+    regionInfo->setDouble( "private-discount-rate-land", 0.05 );
+
+    auto_ptr<IInfo> sectorInfo( InfoFactory::constructInfo( regionInfo.get(), "benchmark-sector" ) );
+    sectorInfo->setString( "output-unit", "EJ" );
+    sectorInfo->setString( "input-unit", "EJ" );
+    sectorInfo->setString( "price-unit", "1975$/GJ" );
+    sectorInfo->setDouble( "electricity-reserve-margin", 0.15 );
+
+    auto_ptr<IInfo> subsectorInfo( InfoFactory::constructInfo( sectorInfo.get(), "benchmark-subsector" ) );
+    subsectorInfo->setDouble( "average-grid-capacity-factor", 0.6 );
+
+    auto_ptr<IInfo> techInfo( InfoFactory::constructInfo( subsectorInfo.get(), "benchmark-technology" ) );
+    techInfo->setDouble( "tech-capacity-factor", 0.9 );
+    techInfo->setBoolean( "new-vintage-tech", true );
+    techInfo->setInteger( "initial-tech-period", 1 );
+
+    // Flatten from the top down as the model does in initCalc.
+    regionInfo->flatten();
+    sectorInfo->flatten();
+    subsectorInfo->flatten();
+    techInfo->flatten();
+
+    // Keys stored at each level of the chain.
+    vector<string> stringKeys;
+    stringKeys.push_back( "tech-capacity-factor" );
+    stringKeys.push_back( "average-grid-capacity-factor" );
+    stringKeys.push_back( "electricity-reserve-margin" );
+    stringKeys.push_back( "interest-rate" );
+    stringKeys.push_back( "social-discount-rate" );
+
+    vector<const objects::Atom*> atomKeys;
+    for( unsigned int i = 0; i < stringKeys.size(); ++i ){
+        atomKeys.push_back( IInfo::getKey( stringKeys[ i ] ) );
+    }
+
+    const int ITERATIONS = 1000000;
+    const int numLookups = ITERATIONS * static_cast<int>( stringKeys.size() );
+
+    Timer stringTimer;
+    stringTimer.start();
+    double stringSum = 0;
+    for( int iter = 0; iter < ITERATIONS; ++iter ){
+        for( unsigned int i = 0; i < stringKeys.size(); ++i ){
+            stringSum += techInfo->getDouble( stringKeys[ i ], true );
+        }
+    }
+    stringTimer.stop();
+
+    Timer atomTimer;
+    atomTimer.start();
+    double atomSum = 0;
+    for( int iter = 0; iter < ITERATIONS; ++iter ){
+        for( unsigned int i = 0; i < atomKeys.size(); ++i ){
+            atomSum += techInfo->getDouble( atomKeys[ i ], true );
+        }
+    }
+    atomTimer.stop();
+
+    const double stringTime = stringTimer.getTotalTimeDifference();
+    const double atomTime = atomTimer.getTotalTimeDifference();
+    aOut << "Info lookup benchmark, " << numLookups << " lookups over a four level chain:" << endl;
+    aOut << "    string keys: " << stringTime << " s, "
+         << stringTime / numLookups * 1e9 << " ns per lookup." << endl;
+    aOut << "    interned keys: " << atomTime << " s, "
+         << atomTime / numLookups * 1e9 << " ns per lookup." << endl;
+    if( stringSum != atomSum ){
+        aOut << "    Lookups disagree: " << stringSum << " from string keys and "
+             << atomSum << " from interned keys." << endl;
+    }
+}
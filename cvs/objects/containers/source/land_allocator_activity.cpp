@@ -62,3 +62,7 @@ void LandAllocatorActivity::calc( const int aPeriod ) {
 string LandAllocatorActivity::getDescription() const {
     return mRegionName + " land-allocator";
 }
+
+string LandAllocatorActivity::getRegionName() const {
+    return mRegionName;
+}
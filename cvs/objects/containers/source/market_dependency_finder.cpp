@@ -257,6 +257,51 @@ const vector<IActivity*> MarketDependencyFinder::getOrdering( const int aMarketN
     }
 }
 
+/*!
+ * \brief Get the activities which may set the supply, demand, or price of each
+ *        market.
+ * \details Together with getOrdering this gives the directed dependencies
+ *          between markets:  a change in the price of market j can only change
+ *          the excess demand of market i if one of the activities calculated
+ *          for market j sets market i.  The activities of the item linked to a
+ *          market calculate its supply and price, and the demand activities of
+ *          the items which depend on it add their demands for it.  A trial
+ *          price market and its trial demand market are both set by the same
+ *          activities as the market they replaced.  Markets which are not
+ *          linked to any item, such as policy markets, are left empty since
+ *          the activities which set them are not known here.
+ * \param aMarketSetters Filled with the activities which set each market, by
+ *        market number.
+ */
+void MarketDependencyFinder::getMarketSetters( vector<vector<IActivity*> >& aMarketSetters ) const {
+    aMarketSetters.assign( mMarketplace->mMarkets.size(), vector<IActivity*>() );
+    for( CItemIterator it = mDependencyItems.begin(); it != mDependencyItems.end(); ++it ) {
+        if( (*it)->mLinkedMarket < 0 ) {
+            continue;
+        }
+        vector<IActivity*> setters;
+        for( CVertexIterator vertexIter = (*it)->mPriceVertices.begin(); vertexIter != (*it)->mPriceVertices.end(); ++vertexIter ) {
+            setters.push_back( (*vertexIter)->mCalcItem );
+        }
+        for( CVertexIterator vertexIter = (*it)->mDemandVertices.begin(); vertexIter != (*it)->mDemandVertices.end(); ++vertexIter ) {
+            setters.push_back( (*vertexIter)->mCalcItem );
+        }
+        for( CItemIterator dependIt = (*it)->mDependentList.begin(); dependIt != (*it)->mDependentList.end(); ++dependIt ) {
+            for( CVertexIterator vertexIter = (*dependIt)->mDemandVertices.begin();
+                 vertexIter != (*dependIt)->mDemandVertices.end(); ++vertexIter )
+            {
+                setters.push_back( (*vertexIter)->mCalcItem );
+            }
+        }
+        vector<IActivity*>& marketSetters = aMarketSetters[ (*it)->mLinkedMarket ];
+        marketSetters.insert( marketSetters.end(), setters.begin(), setters.end() );
+        if( (*it)->mLinkedDemandMarket >= 0 ) {
+            vector<IActivity*>& demandSetters = aMarketSetters[ (*it)->mLinkedDemandMarket ];
+            demandSetters.insert( demandSetters.end(), setters.begin(), setters.end() );
+        }
+    }
+}
+
 #if GCAM_PARALLEL_ENABLED
 /*!
  * \brief Get flow graph which can be used to calculate the model in parallel.
@@ -291,7 +336,7 @@ GcamFlowGraph* MarketDependencyFinder::getFlowGraph( const int aMarketNumber ) {
             }
             // build the tbb graph structure
             mTBBGraphGlobal = new GcamFlowGraph();
-            config.makeTBBFlowGraph( grainGraph, gcamFlowGraph, *mTBBGraphGlobal ); 
+            config.makeTBBFlowGraph( grainGraph, gcamFlowGraph, getOrdering(), *mTBBGraphGlobal ); 
         }
         return mTBBGraphGlobal;
     }
@@ -333,7 +378,7 @@ GcamFlowGraph* MarketDependencyFinder::getFlowGraph( const int aMarketNumber ) {
         }
         // build the tbb graph structure
         (*mrktIter)->mFlowGraph = new GcamFlowGraph();
-        config.makeTBBFlowGraph( grainGraph, gcamFlowGraph, *(*mrktIter)->mFlowGraph );
+        config.makeTBBFlowGraph( grainGraph, gcamFlowGraph, getOrdering(), *(*mrktIter)->mFlowGraph );
         return (*mrktIter)->mFlowGraph;
     }
 }
@@ -857,6 +902,7 @@ void MarketDependencyFinder::createTrialsForItem( CItemIterator aItemToReset, Ca
         abort();
     }
     (*aItemToReset)->mIsSolved = true;
+    (*aItemToReset)->mLinkedDemandMarket = demandMrkt;
 
     // Remove dependencies on the demand vertex now that it is solved.
     // Dependencies on the price vertex must remain since it is responsible
@@ -66,6 +66,10 @@
 #include "containers/include/imodel_feedback_calc.h"
 #include "util/base/include/manage_state_variables.hpp"
 #include "util/base/include/supply_demand_curve_saver.h"
+#include "containers/include/info_benchmark.h"
+#include "containers/include/curve_benchmark.h"
+#include "containers/include/hash_map_benchmark.h"
+#include "util/base/include/activity_profiler.h"
 
 #if GCAM_PARALLEL_ENABLED && PARALLEL_DEBUG
 #include <stdlib.h>
@@ -263,6 +267,8 @@ void Scenario::completeInit() {
     // Set the valid period vector to false.
     mIsValidPeriod.clear();
     mIsValidPeriod.resize( mModeltime->getmaxper(), false );
+
+    runBenchmarks();
 }
 
 //! Return scenario name.
@@ -285,6 +291,11 @@ bool Scenario::run( const int aSinglePeriod,
     // Avoid accumulating unsolved periods.
     mUnsolvedPeriods.clear();
     
+    // The model structure may have changed since the last run, for instance
+    // from new policies, so search for state again.
+    delete mManageStateVars;
+    mManageStateVars = 0;
+    
     // Open the debugging files.
     AutoOutputFile XMLDebugFile( "xmlDebugFileName", "debug.xml", aPrintDebugging );
     Tabs tabs;
@@ -403,9 +414,14 @@ bool Scenario::calculatePeriod( const int aPeriod,
         modelFeedback->calcFeedbacksBeforePeriod( this, mWorld->getClimateModel(), aPeriod );
     }
     
-    // Set up the state data for the current period.
-    delete mManageStateVars;
-    mManageStateVars = new ManageStateVariables( aPeriod );
+    // Set up the state data for the current period.  The memory allocated for
+    // it is reused across the periods of a run.
+    if( !mManageStateVars ) {
+        mManageStateVars = new ManageStateVariables( aPeriod );
+    }
+    else {
+        mManageStateVars->beginPeriod( aPeriod );
+    }
     
     // Be sure to clear out any supplies and demands in the marketplace before making our
     // initial call to world.calc.  There may already be values in there if for instance
@@ -425,8 +441,19 @@ bool Scenario::calculatePeriod( const int aPeriod,
     tbb::tick_count t0 = tbb::tick_count::now();
 #endif
     
+    // Optionally record the order state gets written during this serial calc,
+    // which follows the global calc ordering, and re-layout the state to match.
+    const bool reorderState = Configuration::getInstance()->getBool( "reorder-state", false, false );
+    if( reorderState ) {
+        mManageStateVars->startLayoutRecording();
+    }
+
     mWorld->calc( aPeriod ); // call to calculate initial supply and demand
 
+    if( reorderState ) {
+        mManageStateVars->finishLayoutRecording();
+    }
+
 #if GCAM_PARALLEL_ENABLED && PARALLEL_DEBUG
     tbb::tick_count t1 = tbb::tick_count::now();
     
@@ -496,13 +523,15 @@ bool Scenario::calculatePeriod( const int aPeriod,
 
     logPeriodEnding( aPeriod );
     
+    // Write out the time spent in each activity during this period if profiling.
+    ActivityProfiler::getInstance().finishPeriod( mModeltime->getper_to_yr( aPeriod ) );
+    
     // Write out the results for debugging.
     if( aPrintDebugging ){
         writeDebuggingFiles( aXMLDebugFile, aTabs, aPeriod );
     }
 
-    delete mManageStateVars;
-    mManageStateVars = 0;
+    mManageStateVars->endPeriod();
     
     return success;
 }
@@ -695,10 +724,18 @@ bool Scenario::solve( const int period ){
     // Solve the marketplace. If the return code is false than the model did not
     // solve for the period. Add the period to the scenario list of unsolved
     // periods. 
+    const unsigned long startLookups = mMarketplace->getNumStringLookups();
     const bool success = mSolvers[ period ]->solve( period, mSolutionInfoParamParser );
     if( !success ) {
         mUnsolvedPeriods.push_back( period );
     }
+
+    // Report markets which were located by name during the solve rather than
+    // through a CachedMarket resolved in initCalc.
+    ILogger& solverLog = ILogger::getLogger( "solver_log" );
+    solverLog.setLevel( ILogger::DEBUG );
+    solverLog << "Period " << period << ": " << mMarketplace->getNumStringLookups() - startLookups
+              << " market lookups by name during solve." << endl;
     
     return success;
 }
@@ -720,6 +757,40 @@ void Scenario::writeOutputFiles() const {
     }
 }
 
+/*!
+ * \brief Run the micro-benchmarks enabled in the configuration.
+ * \details The benchmarks time lookups against the data read into this
+ *          scenario so they are run once it is completely initialized. Each is
+ *          enabled by its own configuration flag and writes to the main log.
+ */
+void Scenario::runBenchmarks() {
+    const Configuration* conf = Configuration::getInstance();
+    const bool benchmarkInfo = conf->getBool( "benchmark-info-lookups", false, false );
+    const bool benchmarkCurves = conf->getBool( "benchmark-curve-lookups", false, false );
+    const bool benchmarkHashMap = conf->getBool( "benchmark-hash-map-lookups", false, false );
+    if( !benchmarkInfo && !benchmarkCurves && !benchmarkHashMap ){
+        return;
+    }
+
+    ILogger& mainLog = ILogger::getLogger( "main_log" );
+    mainLog.setLevel( ILogger::NOTICE );
+
+    // IInfo lookups by string and by interned key.
+    if( benchmarkInfo ){
+        InfoBenchmark::run( mainLog );
+    }
+
+    // MAC curve lookups with explicit and sorted point sets.
+    if( benchmarkCurves ){
+        CurveBenchmark::run( this, mainLog );
+    }
+
+    // HashMap lookups with the keys interned during this run.
+    if( benchmarkHashMap ){
+        HashMapBenchmark::run( mMarketplace, mainLog );
+    }
+}
+
 /*!
  * \brief A convience method to initialize solvers for all periods.
  * \details First look into the configuration file to see if the user
@@ -108,6 +108,14 @@ string SectorActivity::getDescription() const {
     return mRegionName + " " + mSector->getName();
 }
 
+/*!
+ * \brief Get the name of the region containing the sector.
+ * \return The region name.
+ */
+const string& SectorActivity::getRegionName() const {
+    return mRegionName;
+}
+
 /*!
  * \brief Get the activity that will calculate the prices of this sector.
  * \return The associated price activity.
@@ -148,6 +156,10 @@ string SectorPriceActivity::getDescription() const {
     return mSectorActivity->getDescription() + " Price";
 }
 
+string SectorPriceActivity::getRegionName() const {
+    return mSectorActivity->getRegionName();
+}
+
 /*!
  * \brief Constructor linking back to the sector activity which will do the work.
  * \param aSectorActivity The shared sector activity.
@@ -171,3 +183,7 @@ void SectorDemandActivity::calc( const int aPeriod ) {
 string SectorDemandActivity::getDescription() const {
     return mSectorActivity->getDescription() + " Demand";
 }
+
+string SectorDemandActivity::getRegionName() const {
+    return mSectorActivity->getRegionName();
+}
@@ -44,6 +44,7 @@
 #include "containers/include/single_scenario_runner.h"
 #include "containers/include/scenario.h"
 #include "util/base/include/xml_helper.h"
+#include "util/base/include/concurrent_xml_loader.h"
 #include "util/base/include/configuration.h"
 #include "util/base/include/timer.h"
 #include "util/base/include/configuration.h"
@@ -64,6 +65,8 @@ extern void closeDB();
 extern void openDB();
 extern void createDBout();
 
+auto_ptr<Scenario> SingleScenarioRunner::sSharedBaseScenario;
+
 /*! \brief Constructor */
 SingleScenarioRunner::SingleScenarioRunner(){
     mXMLDBOutputter = 0;
@@ -100,42 +103,42 @@ bool SingleScenarioRunner::setupScenarios( Timer& timer,
         mainLog << "Early warning Java checks failed and database output was requested" << endl;
         abort();
     }
-    // Ensure that a new scenario is created for each run.
-    mScenario.reset( new Scenario );
-
-    // Set the global scenario pointer.
-    // TODO: Remove global scenario pointer.
-    scenario = mScenario.get();
-
-    // Parse the input file.
-    bool success =
-        XMLHelper<void>::parseXML( conf->getFile( "xmlInputFileName" ),
-                                   mScenario.get() );
-    
-    // Check if parsing succeeded.
-    if( !success ){
-        return false;
+    bool success = true;
+    if( sSharedBaseScenario.get() ){
+        // The base input and the configured scenario components were already
+        // parsed before this process was forked by the BatchRunner. Take
+        // ownership of that copy instead of parsing them again.
+        mScenario = sSharedBaseScenario;
+        scenario = mScenario.get();
     }
+    else {
+        // Ensure that a new scenario is created for each run.
+        mScenario.reset( new Scenario );
 
-    // Fetch the listing of Scenario Components.
-    list<string> scenComponents = conf->getScenarioComponents();
+        // Set the global scenario pointer.
+        // TODO: Remove global scenario pointer.
+        scenario = mScenario.get();
 
-    // Add on any scenario components that were passed in.
-    for( list<string>::const_iterator curr = aScenComponents.begin();
-		curr != aScenComponents.end(); ++curr )
-	{
-        scenComponents.push_back( *curr );
+        success = parseBaseInput( mScenario.get(), conf->getInt( "xml-read-ahead", 2, false ) );
+
+        // Check if parsing succeeded.
+        if( !success ){
+            return false;
+        }
     }
-    
-    // Iterate over the vector.
+
+    // Parse any scenario components that were passed in. The files are read
+    // concurrently but applied in order.
+    ConcurrentXMLLoader loader( aScenComponents, conf->getInt( "xml-stream-depth", 0, false ),
+                                conf->getInt( "xml-read-ahead", 2, false ) );
     typedef list<string>::const_iterator ScenCompIter;
     ILogger& mainLog = ILogger::getLogger( "main_log" );
-    for( ScenCompIter currComp = scenComponents.begin();
-		 currComp != scenComponents.end(); ++currComp )
+    for( ScenCompIter currComp = aScenComponents.begin();
+		 currComp != aScenComponents.end(); ++currComp )
 	{
         mainLog.setLevel( ILogger::NOTICE );
         mainLog << "Parsing " << *currComp << " scenario component." << endl;
-        success = XMLHelper<void>::parseXML( *currComp, mScenario.get() );
+        success = loader.parseNext( mScenario.get() );
         
         // Check if parsing succeeded.
         if( !success ){
@@ -167,6 +170,83 @@ bool SingleScenarioRunner::setupScenarios( Timer& timer,
     return true;
 }
 
+/*!
+ * \brief Parse the base input file and the scenario components listed in the
+ *        configuration file into the given scenario.
+ * \param aScenario The scenario to parse into.
+ * \param aMaxReadAhead The maximum number of files to read ahead concurrently,
+ *        see ConcurrentXMLLoader.
+ * \return Whether all files were parsed successfully.
+ */
+bool SingleScenarioRunner::parseBaseInput( Scenario* aScenario, const int aMaxReadAhead ){
+    const Configuration* conf = Configuration::getInstance();
+
+    // Fetch the listing of Scenario Components.
+    const list<string> scenComponents = conf->getScenarioComponents();
+
+    // Read the input file and the scenario components concurrently, they are
+    // still applied in order. Optionally stream the inputs in chunks at the
+    // configured depth instead to limit memory use.
+    list<string> inputFiles = scenComponents;
+    inputFiles.push_front( conf->getFile( "xmlInputFileName" ) );
+    ConcurrentXMLLoader loader( inputFiles, conf->getInt( "xml-stream-depth", 0, false ), aMaxReadAhead );
+
+    // Parse the input file.
+    bool success = loader.parseNext( aScenario );
+    
+    // Check if parsing succeeded.
+    if( !success ){
+        return false;
+    }
+
+    // Iterate over the vector.
+    typedef list<string>::const_iterator ScenCompIter;
+    ILogger& mainLog = ILogger::getLogger( "main_log" );
+    for( ScenCompIter currComp = scenComponents.begin();
+		 currComp != scenComponents.end(); ++currComp )
+	{
+        mainLog.setLevel( ILogger::NOTICE );
+        mainLog << "Parsing " << *currComp << " scenario component." << endl;
+        success = loader.parseNext( aScenario );
+        
+        // Check if parsing succeeded.
+        if( !success ){
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief Parse the base input file and configured scenario components once so
+ *        that they may be shared by scenario runs in forked processes.
+ * \details The next call to setupScenarios in this process, or in any process
+ *          forked from it, takes ownership of the shared scenario and only
+ *          parses the scenario components passed to it. Parsing helpers are
+ *          intentionally not cleaned up so that completeInit may still be
+ *          called on the shared scenario.  The files are parsed serially
+ *          since worker threads must not be running in a process which is
+ *          about to be forked.
+ * \return Whether the shared base scenario was parsed successfully.
+ */
+bool SingleScenarioRunner::parseSharedBaseScenario(){
+    sSharedBaseScenario.reset( new Scenario );
+    scenario = sSharedBaseScenario.get();
+    const bool success = parseBaseInput( sSharedBaseScenario.get(), 0 );
+    scenario = 0;
+    if( !success ){
+        sSharedBaseScenario.reset( 0 );
+    }
+    return success;
+}
+
+/*!
+ * \brief Delete the shared base scenario if it was not used.
+ */
+void SingleScenarioRunner::clearSharedBaseScenario(){
+    sSharedBaseScenario.reset( 0 );
+}
+
 bool SingleScenarioRunner::runScenarios( const int aSinglePeriod,
                                         const bool aPrintDebugging,
                                         Timer& aTimer )
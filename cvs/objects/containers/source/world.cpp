@@ -78,9 +78,12 @@
 #include "containers/include/market_dependency_finder.h"
 #include "technologies/include/global_technology_database.h"
 #include "containers/include/iactivity.h"
+#include "util/base/include/activity_profiler.h"
 
 #if GCAM_PARALLEL_ENABLED
 #include "parallel/include/gcam_parallel.hpp"
+#include "marketplace/include/market.h"
+#include "marketplace/include/market_container.h"
 #endif
 
 // Uncommenting the following two lines will turn on floating-point exceptions within World::calc(),
@@ -190,6 +193,10 @@ void World::completeInit() {
     MarketDependencyFinder* depFinder = scenario->getMarketplace()->getDependencyFinder();
     depFinder->createOrdering();
     mGlobalOrdering = depFinder->getOrdering();
+    for( size_t i = 0; i < mGlobalOrdering.size(); ++i ) {
+        mGlobalOrdering[ i ]->setCalcOrder( static_cast<int>( i ) );
+    }
+    ActivityProfiler::getInstance().init( mGlobalOrdering );
 #if GCAM_PARALLEL_ENABLED
     Timer &totalgraphtimer = TimerRegistry::getInstance().getTimer("total-graph");
     totalgraphtimer.start();
@@ -323,8 +330,19 @@ void World::calc( const int aPeriod, const std::vector<IActivity*>& aItemsToCalc
     mCalcCounter->incrementCount( static_cast<double>( aItemsToCalc.size() ) / static_cast<double>( mGlobalOrdering.size() ) );
     
     // Perform calculation on each item to calculate. 
-    for( vector<IActivity*>::const_iterator it = aItemsToCalc.begin(); it != aItemsToCalc.end(); ++it ) {
-        (*it)->calc( aPeriod );
+    ActivityProfiler& profiler = ActivityProfiler::getInstance();
+    if( profiler.isEnabled() ) {
+        // A full calc is one given the global ordering rather than a subset of
+        // the activities affected by a change in prices.
+        const bool isFullCalc = &aItemsToCalc == &mGlobalOrdering;
+        for( size_t i = 0; i < aItemsToCalc.size(); ++i ) {
+            profiler.calcActivity( aItemsToCalc[ i ], aItemsToCalc[ i ]->getCalcOrder(), aPeriod, isFullCalc );
+        }
+    }
+    else {
+        for( vector<IActivity*>::const_iterator it = aItemsToCalc.begin(); it != aItemsToCalc.end(); ++it ) {
+            (*it)->calc( aPeriod );
+        }
     }
 #ifdef GNU_SOURCE
     feenableexcept(except);
@@ -359,21 +377,129 @@ void World::calc( const int aPeriod, GcamFlowGraph *aWorkGraph, const vector<IAc
         // the given calc list.
         aWorkGraph = mTBBGraphGlobal;
         aWorkGraph->mCalcList = aCalcList;
+        aWorkGraph->mIsFullCalc = !aCalcList;
     }
     else {
         // When a work graph is provided we assume all items in that graph should be
         // calculated.
         aWorkGraph->mCalcList = 0;
+        aWorkGraph->mIsFullCalc = aWorkGraph == mTBBGraphGlobal;
     }
     aWorkGraph->mPeriod = aPeriod;
+    // Defer adds to market supplies and demands so that they can be made without
+    // locking and summed in the serial calc order once all activities are done.
+    const bool deferAdds = !scenario->getMarketplace()->mIsDerivativeCalc;
+    // Full calcs may be checked against a serial calc when debugging.
+    const static bool checkParallelCalc = Configuration::getInstance()->getBool( "check-parallel-calc", false, false );
+    const bool isChecked = checkParallelCalc && deferAdds && aWorkGraph == mTBBGraphGlobal && !aCalcList;
+    vector<double> startValues;
+    if( isChecked ) {
+        getSuppliesAndDemands( startValues );
+    }
+    if( deferAdds ) {
+        Market::beginDeferredAccumulation();
+    }
     // do the model calculation
     aWorkGraph->mHead.try_put( tbb::flow::continue_msg() );
     aWorkGraph->mTBBFlowGraph.wait_for_all();
+    if( deferAdds ) {
+        Market::endDeferredAccumulation();
+    }
+    if( isChecked ) {
+        compareToSerialCalc( aPeriod, startValues );
+    }
 
 #ifdef GNU_SOURCE
     feenableexcept(except);
 #endif
 }
+
+/*!
+ * \brief Get the supply and demand of every market in every period.
+ * \param aValues Filled with the supply and then the demand of each market for
+ *        each period in turn.
+ * \sa setSuppliesAndDemands
+ */
+void World::getSuppliesAndDemands( vector<double>& aValues ) const {
+    const Marketplace* marketplace = scenario->getMarketplace();
+    const int maxPeriod = scenario->getModeltime()->getmaxper();
+    aValues.clear();
+    aValues.reserve( marketplace->mMarkets.size() * maxPeriod * 2 );
+    for( size_t i = 0; i < marketplace->mMarkets.size(); ++i ) {
+        for( int period = 0; period < maxPeriod; ++period ) {
+            const Market* market = marketplace->mMarkets[ i ]->getMarket( period );
+            aValues.push_back( market->getRawSupply() );
+            aValues.push_back( market->getRawDemand() );
+        }
+    }
+}
+
+/*!
+ * \brief Reset the supply and demand of every market in every period.
+ * \param aValues The values as given by getSuppliesAndDemands.
+ */
+void World::setSuppliesAndDemands( const vector<double>& aValues ) {
+    Marketplace* marketplace = scenario->getMarketplace();
+    const int maxPeriod = scenario->getModeltime()->getmaxper();
+    vector<double>::const_iterator valueIt = aValues.begin();
+    for( size_t i = 0; i < marketplace->mMarkets.size(); ++i ) {
+        for( int period = 0; period < maxPeriod; ++period ) {
+            Market* market = marketplace->mMarkets[ i ]->getMarket( period );
+            market->setRawSupply( *valueIt++ );
+            market->setRawDemand( *valueIt++ );
+        }
+    }
+}
+
+/*!
+ * \brief Check that a full parallel calc made exactly the same market supplies
+ *        and demands as a serial calc would have.
+ * \details The markets are reset to their values from before the parallel calc
+ *          and the model is calculated again serially in the global ordering.
+ *          Any supply or demand which is not bit for bit identical is logged as
+ *          a warning.  The serial results are the ones kept.  This is enabled
+ *          with the check-parallel-calc configuration flag and doubles the cost
+ *          of each full calc so it is only meant for debugging.
+ * \param aPeriod The model period which was calculated.
+ * \param aStartValues The supplies and demands before the parallel calc as
+ *        given by getSuppliesAndDemands.
+ */
+void World::compareToSerialCalc( const int aPeriod, const vector<double>& aStartValues ) {
+    vector<double> parallelValues;
+    getSuppliesAndDemands( parallelValues );
+    setSuppliesAndDemands( aStartValues );
+    for( vector<IActivity*>::const_iterator it = mGlobalOrdering.begin(); it != mGlobalOrdering.end(); ++it ) {
+        (*it)->calc( aPeriod );
+    }
+    vector<double> serialValues;
+    getSuppliesAndDemands( serialValues );
+
+    ILogger& mainLog = ILogger::getLogger( "main_log" );
+    mainLog.setLevel( ILogger::WARNING );
+    const Marketplace* marketplace = scenario->getMarketplace();
+    const int maxPeriod = scenario->getModeltime()->getmaxper();
+    int numDifferent = 0;
+    for( size_t i = 0, valueIndex = 0; i < marketplace->mMarkets.size(); ++i ) {
+        for( int period = 0; period < maxPeriod; ++period, valueIndex += 2 ) {
+            for( int isDemand = 0; isDemand < 2; ++isDemand ) {
+                const double parallelValue = parallelValues[ valueIndex + isDemand ];
+                const double serialValue = serialValues[ valueIndex + isDemand ];
+                // Written so that NaNs in both are treated as equal.
+                if( parallelValue != serialValue && !( parallelValue != parallelValue && serialValue != serialValue ) ) {
+                    ++numDifferent;
+                    mainLog << "Parallel calc of period " << aPeriod << " differs from serial calc for the "
+                            << ( isDemand ? "demand" : "supply" ) << " of market "
+                            << marketplace->mMarkets[ i ]->getMarket( period )->getName()
+                            << " in period " << period << ": " << parallelValue << " != " << serialValue << endl;
+                }
+            }
+        }
+    }
+    if( numDifferent > 0 ) {
+        mainLog << numDifferent << " market supplies and demands differed between the parallel and serial calc of period "
+                << aPeriod << "." << endl;
+    }
+}
 #endif
 
 
@@ -53,7 +53,7 @@
 #include "containers/include/iinfo.h"
 #include "containers/include/market_dependency_finder.h"
 #include "util/curves/include/point_set_curve.h"
-#include "util/curves/include/explicit_point_set.h"
+#include "util/curves/include/sorted_point_set.h"
 #include "util/curves/include/xy_data_point.h"
 
 using namespace std;
@@ -69,7 +69,7 @@ mTechChange( new objects::PeriodVector<double>( 0.0 ) ),
 mZeroCostPhaseInTime( 25 ),
 mCovertPriceValue( 1 ),
 mPriceMarketName( "CO2" ),
-mMacCurve( new PointSetCurve( new ExplicitPointSet() ) )
+mMacCurve( new PointSetCurve( new SortedPointSet() ) )
 {
 }
 
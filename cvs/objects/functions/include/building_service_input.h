@@ -46,6 +46,7 @@
 */
 
 #include "util/base/include/definitions.h"
+#include <memory>
 
 #include "functions/include/inested_input.h"
 #include "util/base/include/value.h"
@@ -54,6 +55,7 @@
 class IFunction;
 class BuildingNodeInput;
 class SatiationDemandFunction;
+class CachedMarket;
 
 /*! 
  * \ingroup Objects
@@ -323,6 +325,12 @@ protected:
         //! Satiation demand function.
         DEFINE_VARIABLE( CONTAINER, "satiation-demand-function", mSatiationDemandFunction, SatiationDemandFunction* )
     )
+
+    //! The market for this building service located in initCalc.
+    std::auto_ptr<CachedMarket> mCachedMarket;
+
+    //! The period in which mCachedMarket was located.
+    int mCachedMarketPeriod;
     
     void copy( const BuildingServiceInput& aInput );
 };
@@ -50,6 +50,7 @@
 #include <memory>
 
 class Tabs;
+class CachedMarket;
 
 /*! 
  * \ingroup Objects
@@ -160,6 +161,15 @@ protected:
         //! The C coef associated with mFuelName
         DEFINE_VARIABLE( SIMPLE, "fuel-C-coef", mCachedCCoef, double )
     )
+
+    //! The market for the tax fraction located in initCalc.
+    std::auto_ptr<CachedMarket> mCachedMarket;
+
+    //! The CO2 market located in initCalc.
+    std::auto_ptr<CachedMarket> mCachedCO2Market;
+
+    //! The period in which the cached markets were located.
+    int mCachedMarketPeriod;
 };
 
 #endif // _CTAX_INPUT_H_
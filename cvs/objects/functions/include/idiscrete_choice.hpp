@@ -128,6 +128,20 @@ public:
     virtual double calcUnnormalizedShare( const double aShareWeight, const double aValue,
                                           const int aPeriod ) const = 0;
 
+    /*!
+     * \brief Compute the unnormalized shares for a contiguous set of options.
+     * \details Gives the same results as calling calcUnnormalizedShare for each
+     *          option but allows the loop to be vectorized.
+     * \param aShareWeights The weighting term of each option.
+     * \param aValues The value of each option.
+     * \param aLogShares [out] The log of the unnormalized share of each option.
+     * \param aCount The number of options.
+     * \param aPeriod The current model period.
+     */
+    virtual void calcUnnormalizedShares( const double* aShareWeights, const double* aValues,
+                                         double* aLogShares, const size_t aCount,
+                                         const int aPeriod ) const = 0;
+
     /*!
      * \brief Compute the mean value according the the discrete choice function's
      *        parameterization.
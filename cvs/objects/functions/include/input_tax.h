@@ -53,6 +53,7 @@
 #include "util/base/include/time_vector.h"
 
 class Tabs;
+class CachedMarket;
 
 /*! 
  * \ingroup Objects
@@ -171,6 +172,16 @@ protected:
 
     //! Stash the current sector name for use in setPhysicalDemand
     std::string mSectorName;
+
+    //! The market for this tax located in initCalc.
+    std::auto_ptr<CachedMarket> mCachedMarket;
+
+    //! The market of the sector which uses this input, located in initCalc
+    //! only if the tax is share based.
+    std::auto_ptr<CachedMarket> mCachedSectorMarket;
+
+    //! The period in which the cached markets were located.
+    int mCachedMarketPeriod;
 private:
     const static std::string XML_REPORTING_NAME; //!< tag name for reporting xml db 
 };
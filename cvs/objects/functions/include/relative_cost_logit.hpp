@@ -95,6 +95,10 @@ public:
     virtual double calcUnnormalizedShare( const double aShareWeight, const double aValue,
                                           const int aPeriod ) const;
 
+    virtual void calcUnnormalizedShares( const double* aShareWeights, const double* aValues,
+                                         double* aLogShares, const size_t aCount,
+                                         const int aPeriod ) const;
+
     virtual double calcAverageValue( const double aUnnormalizedShareSum,
                                      const double aLogShareFac,
                                      const int aPeriod ) const;
@@ -188,6 +188,21 @@ double AbsoluteCostLogit::calcUnnormalizedShare( const double aShareWeight, cons
     return logShareWeight + mLogitExponent[ aPeriod ] * aValue / mBaseValue;
 }
 
+void AbsoluteCostLogit::calcUnnormalizedShares( const double* aShareWeights, const double* aValues,
+                                                double* aLogShares, const size_t aCount,
+                                                const int aPeriod ) const
+{
+    assert( mBaseValue > 0 );
+
+    const double minInf = -std::numeric_limits<double>::infinity();
+    const double logitExponent = mLogitExponent[ aPeriod ];
+    const double baseValue = mBaseValue;
+    for( size_t i = 0; i < aCount; ++i ) {
+        const double logShareWeight = aShareWeights[ i ] > 0.0 ? log( aShareWeights[ i ] ) : minInf;
+        aLogShares[ i ] = logShareWeight + logitExponent * aValues[ i ] / baseValue;
+    }
+}
+
 double AbsoluteCostLogit::calcAverageValue( const double aUnnormalizedShareSum,
                                            const double aLogShareFac,
                                            const int aPeriod ) const
@@ -47,6 +47,7 @@
 #include "functions/include/ctax_input.h"
 #include "containers/include/scenario.h"
 #include "marketplace/include/marketplace.h"
+#include "marketplace/include/cached_market.h"
 #include "util/base/include/xml_helper.h"
 #include "containers/include/market_dependency_finder.h"
 #include "containers/include/iinfo.h"
@@ -87,7 +88,8 @@ const string& CTaxInput::getXMLReportingName() const{
 
 //! Constructor
 CTaxInput::CTaxInput()
-: mCachedCCoef( 0.0 )
+: mCachedCCoef( 0.0 ),
+mCachedMarketPeriod( -1 )
 {
 }
 
@@ -106,7 +108,9 @@ CTaxInput::~CTaxInput() {
  *          allocated memory.
  * \param aOther tax input from which to copy.
  */
-CTaxInput::CTaxInput( const CTaxInput& aOther ){
+CTaxInput::CTaxInput( const CTaxInput& aOther )
+:mCachedMarketPeriod( -1 )
+{
     mName = aOther.mName;
     mFuelName = aOther.mFuelName;
     mCachedCCoef = aOther.mCachedCCoef;
@@ -186,6 +190,11 @@ void CTaxInput::initCalc( const string& aRegionName,
     // There must be a valid region name.
     assert( !aRegionName.empty() );
     mCachedCCoef = FunctionUtils::getCO2Coef( aRegionName, mFuelName, aPeriod );
+
+    const Marketplace* marketplace = scenario->getMarketplace();
+    mCachedMarket = marketplace->locateMarket( mName, aRegionName, aPeriod );
+    mCachedCO2Market = marketplace->locateMarket( "CO2", aRegionName, aPeriod );
+    mCachedMarketPeriod = aPeriod;
 }
 
 void CTaxInput::copyParam( const IInput* aInput,
@@ -234,9 +243,19 @@ double CTaxInput::getPrice( const string& aRegionName,
     // Conversion from teragrams of carbon per EJ to metric tons of carbon per GJ
     const double CVRT_TG_MT = 1e-3;
     // A high tax decreases demand.
-    const Marketplace* marketplace = scenario->getMarketplace();
-    double taxFraction = marketplace->getPrice( mName, aRegionName, aPeriod, true );
-    double ctax = marketplace->getPrice( "CO2", aRegionName, aPeriod, false );
+    double taxFraction;
+    double ctax;
+    // Reporting asks for prices in every period but the cached markets are only
+    // valid in the period they were located in.
+    if( aPeriod != mCachedMarketPeriod ) {
+        const Marketplace* marketplace = scenario->getMarketplace();
+        taxFraction = marketplace->getPrice( mName, aRegionName, aPeriod, true );
+        ctax = marketplace->getPrice( "CO2", aRegionName, aPeriod, false );
+    }
+    else {
+        taxFraction = mCachedMarket->getPrice( mName, aRegionName, aPeriod, true );
+        ctax = mCachedCO2Market->getPrice( "CO2", aRegionName, aPeriod, false );
+    }
     
     // note we need to perform some unit conversions since C prices and technology
     // costs in different units
@@ -47,6 +47,7 @@
 #include "functions/include/input_subsidy.h"
 #include "containers/include/scenario.h"
 #include "marketplace/include/marketplace.h"
+#include "marketplace/include/cached_market.h"
 #include "util/base/include/xml_helper.h"
 #include "technologies/include/icapture_component.h"
 #include "functions/include/icoefficient.h"
@@ -94,6 +95,7 @@ const string& InputSubsidy::getXMLReportingName() const{
 
 //! Constructor
 InputSubsidy::InputSubsidy()
+:mCachedMarketPeriod( -1 )
 {
     TechVectorParseHelper<Value>::setDefaultValue( Value( 1.0 ), mAdjustedCoefficients );
 }
@@ -114,6 +116,7 @@ InputSubsidy::~InputSubsidy() {
  * \param aOther subsidy input from which to copy.
  */
 InputSubsidy::InputSubsidy( const InputSubsidy& aOther )
+:mCachedMarketPeriod( -1 )
 {
     MiniCAMInput::copy( aOther );
     // Do not clone the input coefficient as the calculated
@@ -208,6 +211,22 @@ void InputSubsidy::initCalc( const string& aRegionName,
     // There must be a valid region name.
     assert( !aRegionName.empty() );
     mAdjustedCoefficients[ aPeriod ] = 1.0;
+
+    Marketplace* marketplace = scenario->getMarketplace();
+    mCachedMarket = marketplace->locateMarket( mName, aRegionName, aPeriod );
+    mCachedMarketPeriod = aPeriod;
+
+    // If the subsidy is share based the demand will be divided by sector output.
+    // Check if marketInfo exists and has the "isShareBased" boolean.
+    const IInfo* marketInfo = marketplace->getMarketInfo( mName, aRegionName, 0, true );
+    if( marketInfo && marketInfo->hasValue( "isShareBased" )
+        && marketInfo->getBoolean( "isShareBased", true ) )
+    {
+        mCachedSectorMarket = marketplace->locateMarket( mSectorName, aRegionName, aPeriod );
+    }
+    else {
+        mCachedSectorMarket.reset( 0 );
+    }
 }
 
 void InputSubsidy::copyParam( const IInput* aInput,
@@ -243,16 +262,10 @@ void InputSubsidy::setPhysicalDemand( double aPhysicalDemand,
                                      const int aPeriod )
 {
 
-    Marketplace* marketplace = scenario->getMarketplace();
-    IInfo* marketInfo = marketplace->getMarketInfo( mName, aRegionName, 0, true );
-
     // If subsidy is shared based, then divide by sector output.
-    // Check if marketInfo exists and has the "isShareBased" boolean.
-    if( marketInfo && marketInfo->hasValue( "isShareBased" ) ){
-        if( marketInfo->getBoolean( "isShareBased", true ) ){
-            // Each share is additive
-            aPhysicalDemand/= marketplace->getDemand( mSectorName, aRegionName, aPeriod );
-        }
+    if( mCachedSectorMarket.get() ){
+        // Each share is additive
+        aPhysicalDemand/= mCachedSectorMarket->getDemand( mSectorName, aRegionName, aPeriod );
     }
     // mPhysicalDemand can be a share if subsidy is share based.
     mPhysicalDemand[ aPeriod ].set( aPhysicalDemand );
@@ -260,8 +273,8 @@ void InputSubsidy::setPhysicalDemand( double aPhysicalDemand,
     // This is so solver can use the excess demand to determine
     // whether to increase or decrease a subsidy. 
     // Each technology share is additive.
-    marketplace->addToSupply( mName, aRegionName, mPhysicalDemand[ aPeriod ],
-                              aPeriod, true );
+    mCachedMarket->addToSupply( mName, aRegionName, mPhysicalDemand[ aPeriod ],
+                               aPeriod, true );
     ILogger& mainLog = ILogger::getLogger( "main_log" );
     mainLog.setLevel( ILogger::NOTICE );
 }
@@ -285,7 +298,12 @@ double InputSubsidy::getPrice( const string& aRegionName,
     // Return negative of price to reflect subsidy for portfolio
     // standard market.
     // A high subsidy increases supply.
-    return - scenario->getMarketplace()->getPrice( mName, aRegionName, aPeriod, true );
+    // Reporting asks for prices in every period but the cached market is only
+    // valid in the period it was located in.
+    if( aPeriod != mCachedMarketPeriod ) {
+        return - scenario->getMarketplace()->getPrice( mName, aRegionName, aPeriod, true );
+    }
+    return - mCachedMarket->getPrice( mName, aRegionName, aPeriod, true );
 }
 
 void InputSubsidy::setPrice( const string& aRegionName,
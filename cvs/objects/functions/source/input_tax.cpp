@@ -47,6 +47,7 @@
 #include "functions/include/input_tax.h"
 #include "containers/include/scenario.h"
 #include "marketplace/include/marketplace.h"
+#include "marketplace/include/cached_market.h"
 #include "util/base/include/xml_helper.h"
 #include "technologies/include/icapture_component.h"
 #include "functions/include/icoefficient.h"
@@ -94,6 +95,7 @@ const string& InputTax::getXMLReportingName() const{
 
 //! Constructor
 InputTax::InputTax()
+:mCachedMarketPeriod( -1 )
 {
     TechVectorParseHelper<Value>::setDefaultValue( Value( 1.0 ), mAdjustedCoefficients );
 }
@@ -114,6 +116,7 @@ InputTax::~InputTax() {
  * \param aOther tax input from which to copy.
  */
 InputTax::InputTax( const InputTax& aOther )
+:mCachedMarketPeriod( -1 )
 {
     MiniCAMInput::copy( aOther );
     // Do not clone the input coefficient as the calculated
@@ -208,6 +211,22 @@ void InputTax::initCalc( const string& aRegionName,
     // There must be a valid region name.
     assert( !aRegionName.empty() );
     mAdjustedCoefficients[ aPeriod ] = 1.0;
+
+    Marketplace* marketplace = scenario->getMarketplace();
+    mCachedMarket = marketplace->locateMarket( mName, aRegionName, aPeriod );
+    mCachedMarketPeriod = aPeriod;
+
+    // If the tax is share based the demand will be divided by sector output.
+    // Check if marketInfo exists and has the "isShareBased" boolean.
+    const IInfo* marketInfo = marketplace->getMarketInfo( mName, aRegionName, 0, true );
+    if( marketInfo && marketInfo->hasValue( "isShareBased" )
+        && marketInfo->getBoolean( "isShareBased", true ) )
+    {
+        mCachedSectorMarket = marketplace->locateMarket( mSectorName, aRegionName, aPeriod );
+    }
+    else {
+        mCachedSectorMarket.reset( 0 );
+    }
 }
 
 void InputTax::copyParam( const IInput* aInput,
@@ -243,22 +262,16 @@ void InputTax::setPhysicalDemand( double aPhysicalDemand,
                                      const int aPeriod )
 {
 
-    Marketplace* marketplace = scenario->getMarketplace();
-    IInfo* marketInfo = marketplace->getMarketInfo( mName, aRegionName, 0, true );
-
     // If tax is shared based, then divide by sector output.
-    // Check if marketInfo exists and has the "isShareBased" boolean.
-    if( marketInfo && marketInfo->hasValue( "isShareBased" ) ){
-        if( marketInfo->getBoolean( "isShareBased", true ) ){
-            // Each share is additive
-            aPhysicalDemand/= marketplace->getDemand( mSectorName, aRegionName, aPeriod );
-        }
+    if( mCachedSectorMarket.get() ){
+        // Each share is additive
+        aPhysicalDemand/= mCachedSectorMarket->getDemand( mSectorName, aRegionName, aPeriod );
     }
     // mPhysicalDemand can be a share if tax is share based.
     mPhysicalDemand[ aPeriod ].set( aPhysicalDemand );
     // Each technology share is additive.
-    marketplace->addToDemand( mName, aRegionName, mPhysicalDemand[ aPeriod ],
-                              aPeriod, true );
+    mCachedMarket->addToDemand( mName, aRegionName, mPhysicalDemand[ aPeriod ],
+                               aPeriod, true );
     ILogger& mainLog = ILogger::getLogger( "main_log" );
     mainLog.setLevel( ILogger::NOTICE );
 }
@@ -280,7 +293,12 @@ double InputTax::getPrice( const string& aRegionName,
                               const int aPeriod ) const
 {
     // A high tax decreases demand.
-    return scenario->getMarketplace()->getPrice( mName, aRegionName, aPeriod, true );
+    // Reporting asks for prices in every period but the cached market is only
+    // valid in the period it was located in.
+    if( aPeriod != mCachedMarketPeriod ) {
+        return scenario->getMarketplace()->getPrice( mName, aRegionName, aPeriod, true );
+    }
+    return mCachedMarket->getPrice( mName, aRegionName, aPeriod, true );
 }
 
 void InputTax::setPrice( const string& aRegionName,
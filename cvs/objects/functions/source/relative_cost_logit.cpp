@@ -185,6 +185,19 @@ double RelativeCostLogit::calcUnnormalizedShare( const double aShareWeight, cons
     // logit and the absolute value logit.
 }
 
+void RelativeCostLogit::calcUnnormalizedShares( const double* aShareWeights, const double* aValues,
+                                                double* aLogShares, const size_t aCount,
+                                                const int aPeriod ) const
+{
+    const double minInf = -std::numeric_limits<double>::infinity();
+    const double minValue = getMinValueThreshold();
+    const double logitExponent = mLogitExponent[ aPeriod ];
+    for( size_t i = 0; i < aCount; ++i ) {
+        const double logShareWeight = aShareWeights[ i ] > 0.0 ? log( aShareWeights[ i ] ) : minInf;
+        aLogShares[ i ] = logShareWeight + logitExponent * log( std::max( aValues[ i ], minValue ) );
+    }
+}
+
 double RelativeCostLogit::calcAverageValue( const double aUnnormalizedShareSum,
                                            const double aLogShareFac,
                                            const int aPeriod ) const
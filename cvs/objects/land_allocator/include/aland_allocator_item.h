@@ -117,6 +117,7 @@ class ALandAllocatorItem : public TreeItem<ALandAllocatorItem>,
                            private boost::noncopyable
 {
     friend class XMLDBOutputter;
+    friend class LandAllocatorKernel;
 public:
     typedef TreeItem<ALandAllocatorItem> ParentTreeType;
 
@@ -44,11 +44,13 @@
  * \brief The LandAllocator class header file.
  * \author James Blackwood, Josh Lurz, Kate Calvin
  */
+#include <memory>
 #include "land_allocator/include/iland_allocator.h"
 #include "land_allocator/include/land_node.h"
 #include "util/base/include/ivisitable.h"
 
 class IInfo;
+class LandAllocatorKernel;
 
 /*! 
  * \brief Root of a single land allocation tree.
@@ -155,6 +157,9 @@ protected:
     )
 
 private:
+    //! Flattened land allocation tree used to calculate shares and allocations.
+    std::auto_ptr<LandAllocatorKernel> mKernel;
+
     void calibrateLandAllocator( const std::string& aRegionName, const int aPeriod );
 
     void checkLandArea( const std::string& aRegionName, const int aPeriod );
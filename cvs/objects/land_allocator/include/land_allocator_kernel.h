@@ -0,0 +1,132 @@
+#ifndef _LAND_ALLOCATOR_KERNEL_H_
+#define _LAND_ALLOCATOR_KERNEL_H_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+/*! 
+ * \file land_allocator_kernel.h
+ * \ingroup Objects
+ * \brief The LandAllocatorKernel class header file.
+ */
+
+#include <vector>
+#include <string>
+#include <boost/core/noncopyable.hpp>
+
+#if GCAM_PARALLEL_ENABLED
+#include <tbb/enumerable_thread_specific.h>
+#endif
+
+class ALandAllocatorItem;
+class LandNode;
+
+/*!
+ * \brief A flattened representation of a region's land allocation tree used to
+ *        calculate land shares and allocations without recursion.
+ * \details The tree is compiled once into arrays where the children of each node
+ *          are contiguous and nodes are stored breadth first.  Shares are then
+ *          calculated one node at a time from the deepest level up, evaluating
+ *          the discrete choice function over each node's contiguous children,
+ *          and land is allocated from the root down.  Share weights and profit
+ *          rates are gathered from the tree at the start of each calculation and
+ *          the results written back so the object tree remains the source of
+ *          truth for input and output.  The results are identical to the
+ *          recursive LandNode::calcLandShares and LandNode::calcLandAllocation.
+ */
+class LandAllocatorKernel : private boost::noncopyable {
+public:
+    LandAllocatorKernel();
+
+    void compile( LandNode* aRoot );
+
+    void calcLandShares( const int aPeriod );
+
+    void calcLandAllocation( const std::string& aRegionName,
+                             const double aRootLandAllocation,
+                             const int aPeriod );
+private:
+    //! All items in the tree in breadth first order with the root first.
+    std::vector<ALandAllocatorItem*> mItems;
+
+    //! The index of the parent of each item in mItems, -1 for the root.
+    std::vector<int> mParentItems;
+
+    //! The nodes in the tree in breadth first order.
+    std::vector<LandNode*> mNodes;
+
+    //! The index of each node in mItems.
+    std::vector<size_t> mNodeItems;
+
+    //! The index in mItems of the first child of each node.
+    std::vector<size_t> mChildBegin;
+
+    //! The number of children of each node.
+    std::vector<size_t> mChildCount;
+
+    //! Whether each item in mItems is a node.
+    std::vector<bool> mIsNode;
+
+    //! The index in mItems of each leaf in depth first order which is the order
+    //! the recursive calculation allocates them.
+    std::vector<size_t> mLeafItems;
+
+    //! Working arrays for a calculation, indexed the same as mItems.
+    struct Scratch {
+        //! Share weights gathered from the tree.
+        std::vector<double> mShareWeights;
+
+        //! Leaf profit rates gathered from the tree and calculated node profit rates.
+        std::vector<double> mProfitRates;
+
+        //! Log unnormalized shares which are normalized in place.
+        std::vector<double> mShares;
+
+        //! The land allocated to each node.
+        std::vector<double> mLandAllocations;
+    };
+
+    Scratch& getScratch();
+
+#if GCAM_PARALLEL_ENABLED
+    //! Working arrays for each thread as partial derivative calcs may calculate
+    //! the same land allocator concurrently.
+    tbb::enumerable_thread_specific<Scratch> mScratch;
+#else
+    //! Working arrays.
+    Scratch mScratch;
+#endif
+};
+
+#endif // _LAND_ALLOCATOR_KERNEL_H_
@@ -45,12 +45,14 @@
  * \author James Blackwood
  */
 
+#include <memory>
 #include <xercesc/dom/DOMNode.hpp>
 #include "land_allocator/include/aland_allocator_item.h"
 #include "util/base/include/ivisitable.h"
 
 class Tabs;
 class ICarbonCalc;
+class CachedMarket;
 
 /*!
  * \brief A LandLeaf is the leaf of a land allocation tree.
@@ -184,9 +186,24 @@ protected:
         DEFINE_VARIABLE( SIMPLE | STATE, "luc-state", mLastCalcCO2Value, Value )
     )
 
+    //! The land expansion cost market located in initCalc, if this leaf has one.
+    std::auto_ptr<CachedMarket> mCachedExpansionCostMarket;
+
+    //! The CO2_LUC market located in initCalc.
+    std::auto_ptr<CachedMarket> mCachedCO2LUCMarket;
+
+    //! The period in which the cached markets were located.
+    int mCachedMarketPeriod;
+
     double getCarbonSubsidy( const std::string& aRegionName,
                            const int aPeriod ) const;
 
+    double getMarketPrice( const CachedMarket* aCachedMarket,
+                           const std::string& aGoodName,
+                           const std::string& aRegionName,
+                           const int aPeriod,
+                           const bool aMustExist ) const;
+
     virtual bool XMLDerivedClassParse( const std::string& aNodeName,
                                        const xercesc::DOMNode* aCurr );
 
@@ -74,6 +74,7 @@ class NodeCarbonCalc;
  *              - \c node-carbon-calc LandNode::mCarbonCalc
  */
 class LandNode : public ALandAllocatorItem {
+    friend class LandAllocatorKernel;
 public:
     explicit LandNode( const ALandAllocatorItem* aParent );
 
@@ -175,6 +176,10 @@ protected:
     const ALandAllocatorItem* findChild( const std::string& aName,
                                          const LandAllocatorItemType aType ) const;
     
+    void calcChildLUCEmissions( const std::string& aRegionName,
+                                const int aPeriod, const int aEndYear,
+                                const bool aStoreFullEmiss );
+    
     // Define data such that introspection utilities can process the data from this
     // subclass together with the data members of the parent classes.
     DEFINE_DATA_WITH_PARENT(
@@ -45,6 +45,7 @@
 #include "ccarbon_model/include/land_carbon_densities.h"
 #include "util/base/include/ivisitor.h"
 #include "marketplace/include/marketplace.h"
+#include "marketplace/include/cached_market.h"
 #include "containers/include/iinfo.h"
 #include "util/base/include/configuration.h"
 
@@ -89,6 +90,17 @@ const string& CarbonLandLeaf::getXMLNameStatic() {
     return XML_NAME;
 }
 
+/*!
+* \brief Initialize the leaf for the period and locate the CO2 market.
+* \param aRegionName Region.
+* \param aPeriod Period.
+*/
+void CarbonLandLeaf::initCalc( const string& aRegionName, const int aPeriod ) {
+    LandLeaf::initCalc( aRegionName, aPeriod );
+
+    mCachedCO2Market = scenario->getMarketplace()->locateMarket( "CO2", aRegionName, aPeriod );
+}
+
 /*!
 * \brief Sets a the profit rate of a land leaf
 * \details This method adjusts the profit rate of an unmanaged land leaf
@@ -114,8 +126,7 @@ void CarbonLandLeaf::setUnmanagedLandProfitRate( const string& aRegionName,
     // The base profit rate is based on the carbon density and the carbon price
     
     // Check if a carbon market exists and has a non-zero price.
-    const Marketplace* marketplace = scenario->getMarketplace();
-    double carbonPrice = marketplace->getPrice( "CO2", aRegionName, aPeriod, false );
+    double carbonPrice = getMarketPrice( mCachedCO2Market.get(), "CO2", aRegionName, aPeriod, false );
 
     // If a carbon price exists, calculate the subsidy
     if( carbonPrice != Marketplace::NO_MARKET_PRICE && carbonPrice > 0.0 ){
@@ -48,6 +48,7 @@
 #include "ccarbon_model/include/carbon_model_utils.h"
 #include "util/base/include/configuration.h"
 #include "functions/include/idiscrete_choice.hpp"
+#include "land_allocator/include/land_allocator_kernel.h"
 
 using namespace std;
 using namespace xercesc;
@@ -152,6 +153,10 @@ void LandAllocator::completeInit( const string& aRegionName,
 
     // Set the soil time scale
     setSoilTimeScale( mSoilTimeScale );
+
+    // The structure of the tree is now fixed so it can be flattened.
+    mKernel.reset( new LandAllocatorKernel() );
+    mKernel->compile( this );
 }
 
 
@@ -308,7 +313,7 @@ double LandAllocator::calcLandShares( const string& aRegionName,
     // First set value of unmanaged land leaves
     setUnmanagedLandProfitRate( aRegionName, mUnManagedLandValue, aPeriod );
 
-    LandNode::calcLandShares( aRegionName, aChoiceFnAbove, aPeriod );
+    mKernel->calcLandShares( aPeriod );
  
     // This is the root node so its share is 100%.
     mShare[ aPeriod ] = 1;
@@ -318,9 +323,7 @@ double LandAllocator::calcLandShares( const string& aRegionName,
 void LandAllocator::calcLandAllocation( const string& aRegionName,
                                             const double aLandAllocationAbove,
                                             const int aPeriod ){
-    for ( unsigned int i = 0; i < mChildren.size(); ++i ){
-        mChildren[ i ]->calcLandAllocation( aRegionName, mLandAllocation[ aPeriod ], aPeriod );
-    }
+    mKernel->calcLandAllocation( aRegionName, mLandAllocation[ aPeriod ], aPeriod );
 }
 
 void LandAllocator::calcLUCEmissions( const string& aRegionName, const int aPeriod,
@@ -328,9 +331,7 @@ void LandAllocator::calcLUCEmissions( const string& aRegionName, const int aPeri
 {
     // Calculate emissions for all years in this model period.  Note that in
     // period 0 historical emissions are also calculated.
-    for ( unsigned int i = 0; i < mChildren.size(); ++i ){
-        mChildren[ i ]->calcLUCEmissions( aRegionName, aPeriod, aEndYear, aStoreFullEmiss );
-    } 
+    calcChildLUCEmissions( aRegionName, aPeriod, aEndYear, aStoreFullEmiss );
 }
 
 
@@ -0,0 +1,211 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*!
+ * \file land_allocator_kernel.cpp
+ * \ingroup Objects
+ * \brief LandAllocatorKernel class source file.
+ */
+
+#include "util/base/include/definitions.h"
+#include <cassert>
+#include <algorithm>
+
+#include "land_allocator/include/land_allocator_kernel.h"
+#include "land_allocator/include/land_node.h"
+#include "functions/include/idiscrete_choice.hpp"
+#include "sectors/include/sector_utils.h"
+
+using namespace std;
+
+//! Constructor
+LandAllocatorKernel::LandAllocatorKernel()
+{
+}
+
+/*!
+ * \brief Flatten the land allocation tree below the given root.
+ * \details This must be called again if the structure of the tree changes.
+ * \param aRoot The root of the land allocation tree.
+ */
+void LandAllocatorKernel::compile( LandNode* aRoot ) {
+    mItems.clear();
+    mParentItems.clear();
+    mNodes.clear();
+    mNodeItems.clear();
+    mChildBegin.clear();
+    mChildCount.clear();
+    mIsNode.clear();
+    mLeafItems.clear();
+
+    // Breadth first traversal which places the children of each node contiguously.
+    mItems.push_back( aRoot );
+    mParentItems.push_back( -1 );
+    mIsNode.push_back( true );
+    for( size_t i = 0; i < mItems.size(); ++i ) {
+        if( !mIsNode[ i ] ) {
+            continue;
+        }
+        LandNode* node = static_cast<LandNode*>( mItems[ i ] );
+        mNodes.push_back( node );
+        mNodeItems.push_back( i );
+        mChildBegin.push_back( mItems.size() );
+        mChildCount.push_back( node->getNumChildren() );
+        for( size_t child = 0; child < node->getNumChildren(); ++child ) {
+            mItems.push_back( node->getChildAt( child ) );
+            mParentItems.push_back( static_cast<int>( i ) );
+            mIsNode.push_back( node->getChildAt( child )->getType() == eNode );
+        }
+    }
+
+    // Record the leaves in depth first order by walking the flattened nodes with
+    // an explicit stack of (node, next child) positions.
+    vector<pair<size_t, size_t> > stack( 1, make_pair( 0, 0 ) );
+    while( !stack.empty() ) {
+        const size_t nodeIndex = stack.back().first;
+        const size_t child = stack.back().second;
+        if( child == mChildCount[ nodeIndex ] ) {
+            stack.pop_back();
+            continue;
+        }
+        ++stack.back().second;
+        const size_t item = mChildBegin[ nodeIndex ] + child;
+        if( mIsNode[ item ] ) {
+            // Nodes are stored in the same breadth first order as items.
+            const size_t childNode = lower_bound( mNodeItems.begin(), mNodeItems.end(), item ) - mNodeItems.begin();
+            stack.push_back( make_pair( childNode, 0 ) );
+        }
+        else {
+            mLeafItems.push_back( item );
+        }
+    }
+}
+
+/*!
+ * \brief Calculate the shares of every item in the tree and the profit rates of
+ *        the nodes.
+ * \details Leaf profit rates must already have been set.  Nodes are processed in
+ *          reverse breadth first order so all nodes at a level are calculated
+ *          before their parents.
+ * \param aPeriod Model period.
+ */
+void LandAllocatorKernel::calcLandShares( const int aPeriod ) {
+    Scratch& scratch = getScratch();
+    double* shareWeights = &scratch.mShareWeights[ 0 ];
+    double* profitRates = &scratch.mProfitRates[ 0 ];
+    double* shares = &scratch.mShares[ 0 ];
+
+    // Gather the inputs from the tree.
+    const size_t numItems = mItems.size();
+    for( size_t i = 0; i < numItems; ++i ) {
+        shareWeights[ i ] = mItems[ i ]->mShareWeight[ aPeriod ];
+        profitRates[ i ] = mItems[ i ]->mProfitRate[ aPeriod ];
+    }
+
+    for( size_t node = mNodes.size(); node-- > 0; ) {
+        const size_t begin = mChildBegin[ node ];
+        const size_t count = mChildCount[ node ];
+        const IDiscreteChoice* choiceFn = mNodes[ node ]->mChoiceFn;
+        choiceFn->calcUnnormalizedShares( shareWeights + begin, profitRates + begin,
+                                          shares + begin, count, aPeriod );
+#ifndef NDEBUG
+        for( size_t i = begin; i < begin + count; ++i ) {
+            // result should be > 0 for a leaf with a non-zero share-weight (it is -infinity when zero)
+            assert( mIsNode[ i ] || shareWeights[ i ] == 0.0 || shares[ i ] >= 0.0 );
+        }
+#endif
+        const pair<double, double> unnormalizedSum = count > 0 ?
+            SectorUtils::normalizeLogShares( shares + begin, count ) : make_pair( 0.0, 0.0 );
+        profitRates[ mNodeItems[ node ] ] = choiceFn->calcAverageValue( unnormalizedSum.first,
+                                                                        unnormalizedSum.second,
+                                                                        aPeriod );
+    }
+
+    // Write the results back to the tree.
+    for( size_t i = 1; i < numItems; ++i ) {
+        mItems[ i ]->setShare( shares[ i ], aPeriod );
+    }
+    for( size_t node = 0; node < mNodes.size(); ++node ) {
+        mNodes[ node ]->mProfitRate[ aPeriod ] = profitRates[ mNodeItems[ node ] ];
+    }
+}
+
+/*!
+ * \brief Allocate land from the root of the tree down using the current shares.
+ * \details Node allocations are calculated breadth first and the leaves are then
+ *          allocated in the same order the recursive calculation would so that
+ *          any demands they add to the marketplace are added in the same order.
+ * \param aRegionName Region name.
+ * \param aRootLandAllocation The land allocated to the root.
+ * \param aPeriod Model period.
+ */
+void LandAllocatorKernel::calcLandAllocation( const string& aRegionName,
+                                              const double aRootLandAllocation,
+                                              const int aPeriod )
+{
+    Scratch& scratch = getScratch();
+    double* landAllocations = &scratch.mLandAllocations[ 0 ];
+
+    landAllocations[ 0 ] = aRootLandAllocation;
+    for( size_t node = 1; node < mNodes.size(); ++node ) {
+        const size_t item = mNodeItems[ node ];
+        const double share = mItems[ item ]->getShare( aPeriod );
+        assert( share >= 0.0 && share <= 1.0 );
+        const double landAllocationAbove = landAllocations[ mParentItems[ item ] ];
+        landAllocations[ item ] = landAllocationAbove > 0.0 && share > 0.0 ? landAllocationAbove * share : 0.0;
+    }
+
+    for( size_t leaf = 0; leaf < mLeafItems.size(); ++leaf ) {
+        const size_t item = mLeafItems[ leaf ];
+        mItems[ item ]->calcLandAllocation( aRegionName, landAllocations[ mParentItems[ item ] ], aPeriod );
+    }
+}
+
+/*!
+ * \brief Get the working arrays for the current thread sized for the tree.
+ * \return The working arrays.
+ */
+LandAllocatorKernel::Scratch& LandAllocatorKernel::getScratch() {
+#if GCAM_PARALLEL_ENABLED
+    Scratch& scratch = mScratch.local();
+#else
+    Scratch& scratch = mScratch;
+#endif
+    if( scratch.mShares.size() != mItems.size() ) {
+        scratch.mShareWeights.resize( mItems.size() );
+        scratch.mProfitRates.resize( mItems.size() );
+        scratch.mShares.resize( mItems.size() );
+        scratch.mLandAllocations.resize( mItems.size() );
+    }
+    return scratch;
+}
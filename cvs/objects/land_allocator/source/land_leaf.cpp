@@ -47,6 +47,7 @@
 
 #include "util/base/include/xml_helper.h"
 #include "marketplace/include/marketplace.h"
+#include "marketplace/include/cached_market.h"
 #include "containers/include/scenario.h"
 #include "land_allocator/include/land_leaf.h"
 #include "util/base/include/ivisitor.h"
@@ -78,7 +79,8 @@ LandLeaf::LandLeaf( const ALandAllocatorItem* aParent, const std::string &aName
     mCarbonPriceIncreaseRate( Value( 0.0 ) ),
     mLandUseHistory( 0 ),
     mReadinLandAllocation( Value( 0.0 ) ),
-    mLastCalcCO2Value( 0.0 )
+    mLastCalcCO2Value( 0.0 ),
+    mCachedMarketPeriod( -1 )
 {
 }
 
@@ -243,6 +245,40 @@ void LandLeaf::initCalc( const string& aRegionName, const int aPeriod )
     }
 
     mCarbonContentCalc->initCalc( aPeriod );
+
+    // Locate the markets used while calculating so that they are not looked up
+    // by name in every iteration.
+    Marketplace* marketplace = scenario->getMarketplace();
+    if( mIsLandExpansionCost ) {
+        mCachedExpansionCostMarket = marketplace->locateMarket( mLandExpansionCostName, aRegionName, aPeriod );
+    }
+    mCachedCO2LUCMarket = marketplace->locateMarket( "CO2_LUC", aRegionName, aPeriod );
+    mCachedMarketPeriod = aPeriod;
+}
+
+/*!
+ * \brief Get the price of a market this leaf has cached.
+ * \details The land allocator is calibrated, and the ag technologies set
+ *          their profit rates, before the leaves are initialized for the
+ *          period.  Until then the cached markets are those of the previous
+ *          period, so the price is looked up by name instead.
+ * \param aCachedMarket The cached market for the good.
+ * \param aGoodName The good of the market.
+ * \param aRegionName Region name.
+ * \param aPeriod Model period.
+ * \param aMustExist Whether it is an error for the market not to exist.
+ * \return The market price.
+ */
+double LandLeaf::getMarketPrice( const CachedMarket* aCachedMarket,
+                                 const string& aGoodName,
+                                 const string& aRegionName,
+                                 const int aPeriod,
+                                 const bool aMustExist ) const
+{
+    if( aPeriod != mCachedMarketPeriod || !aCachedMarket ) {
+        return scenario->getMarketplace()->getPrice( aGoodName, aRegionName, aPeriod, aMustExist );
+    }
+    return aCachedMarket->getPrice( aGoodName, aRegionName, aPeriod, aMustExist );
 }
 
 /*!
@@ -316,11 +352,11 @@ void LandLeaf::setProfitRate( const string& aRegionName,
 {
     // adjust profit rate for land expnasion costs if applicable
     double adjustedProfitRate = aProfitRate;
-    const Marketplace* marketplace = scenario->getMarketplace();
 
     if ( mIsLandExpansionCost ) {
         //subtract off expansion cost from profit rate
-        double expansionCost = marketplace->getPrice( mLandExpansionCostName, aRegionName, aPeriod );
+        double expansionCost = getMarketPrice( mCachedExpansionCostMarket.get(), mLandExpansionCostName,
+                                               aRegionName, aPeriod, true );
         adjustedProfitRate = aProfitRate - expansionCost;
     }
 
@@ -340,8 +376,7 @@ void LandLeaf::setProfitRate( const string& aRegionName,
 double LandLeaf::getCarbonSubsidy( const string& aRegionName, const int aPeriod ) const {
     const double dollar_conversion_75_90 = 2.212;
     // Check if a carbon market exists and has a non-zero price.
-    const Marketplace* marketplace = scenario->getMarketplace();
-    double carbonPrice = marketplace->getPrice( "CO2_LUC", aRegionName, aPeriod, false );
+    double carbonPrice = getMarketPrice( mCachedCO2LUCMarket.get(), "CO2_LUC", aRegionName, aPeriod, false );
 
     // If a carbon price exists, calculate the subsidy
     if( carbonPrice != Marketplace::NO_MARKET_PRICE && carbonPrice > 0.0 ){
@@ -467,8 +502,7 @@ void LandLeaf::calcLandAllocation( const string& aRegionName,
 
     // compute any demands for land use constraint resources
     if ( mIsLandExpansionCost ) {
-        Marketplace* marketplace = scenario->getMarketplace();
-        marketplace->addToDemand( mLandExpansionCostName, aRegionName,
+        mCachedExpansionCostMarket->addToDemand( mLandExpansionCostName, aRegionName,
             mLandAllocation[ aPeriod ], aPeriod, true );
     }
 
@@ -491,9 +525,8 @@ void LandLeaf::calcLUCEmissions( const string& aRegionName,
 
     // Add emissions to the carbon market.
     if ( !aStoreFullEmiss ) {
-        Marketplace* marketplace = scenario->getMarketplace();
-        marketplace->addToDemand( "CO2_LUC", aRegionName,
-                                  mLastCalcCO2Value, aPeriod, false );
+        mCachedCO2LUCMarket->addToDemand( "CO2_LUC", aRegionName,
+                                          mLastCalcCO2Value, aPeriod, false );
     }  
 }
 
@@ -55,6 +55,10 @@
 #include <numeric>
 #include <utility>
 
+#if GCAM_PARALLEL_ENABLED
+#include <tbb/parallel_for.h>
+#endif
+
 using namespace std;
 using namespace xercesc;
 
@@ -489,6 +493,36 @@ void LandNode::calcLUCEmissions( const string& aRegionName,
         mCarbonCalc->calc( aPeriod, aEndYear, aStoreFullEmiss ? ICarbonCalc::eStoreResults : ICarbonCalc::eReturnTotal );
     }
     
+    calcChildLUCEmissions( aRegionName, aPeriod, aEndYear, aStoreFullEmiss );
+}
+
+/*!
+ * \brief Calculate the land-use change emissions of each child of this node.
+ * \details When storing full emissions (i.e. during postCalc) the carbon calcs
+ *          of the children only touch state private to their own subtree, any
+ *          node carbon calc having already been run above, so the children are
+ *          calculated in parallel.  Otherwise the leaves add to the CO2_LUC
+ *          market and the children must be calculated in order.
+ * \param aRegionName Region name.
+ * \param aPeriod Current model period.
+ * \param aEndYear The year to calculate LUC emissions to.
+ * \param aStoreFullEmiss Flag to pass on to the carbon calcs.
+ */
+void LandNode::calcChildLUCEmissions( const string& aRegionName,
+                                      const int aPeriod, const int aEndYear,
+                                      const bool aStoreFullEmiss )
+{
+#if GCAM_PARALLEL_ENABLED
+    if( aStoreFullEmiss ) {
+        tbb::parallel_for( tbb::blocked_range<size_t>( 0, mChildren.size() ),
+            [this, &aRegionName, aPeriod, aEndYear]( const tbb::blocked_range<size_t>& aRange ) {
+                for( size_t i = aRange.begin(); i != aRange.end(); ++i ) {
+                    this->mChildren[ i ]->calcLUCEmissions( aRegionName, aPeriod, aEndYear, true );
+                }
+            });
+        return;
+    }
+#endif
     for ( unsigned int i = 0; i < mChildren.size(); i++ ) {
         mChildren[ i ]->calcLUCEmissions( aRegionName, aPeriod, aEndYear, aStoreFullEmiss );
     }
@@ -106,11 +106,11 @@ void UnmanagedLandLeaf::setUnmanagedLandProfitRate( const string& aRegionName,
 {
     // Adjust profit rate for land expnasion costs if applicable
     double adjustedProfitRate = aAverageProfitRate;
-    const Marketplace* marketplace = scenario->getMarketplace();
 
     if ( mIsLandExpansionCost ) {
         //subtract off expansion cost from profit rate
-        double expansionCost = marketplace->getPrice( mLandExpansionCostName, aRegionName, aPeriod );
+        double expansionCost = getMarketPrice( mCachedExpansionCostMarket.get(), mLandExpansionCostName,
+                                               aRegionName, aPeriod, true );
         adjustedProfitRate = adjustedProfitRate - expansionCost;
     }
 
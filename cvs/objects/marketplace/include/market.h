@@ -56,7 +56,10 @@
 #include "util/base/include/data_definition_util.h"
 
 #if GCAM_PARALLEL_ENABLED
-#include "tbb/spin_rw_mutex.h"
+#include <atomic>
+#include <deque>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/spin_mutex.h>
 #endif
 
 class IInfo;
@@ -140,11 +143,13 @@ public:
     virtual void addToDemand( const double demandIn );
     virtual double getSolverDemand() const;
     double getRawDemand() const;
+    void setRawDemand( const double aDemand );
     virtual double getDemand() const;
 
     virtual void nullSupply();
     virtual double getSolverSupply() const;
     double getRawSupply() const;
+    void setRawSupply( const double aSupply );
     virtual double getSupply() const;
     virtual void addToSupply( const double supplyIn );
     
@@ -176,6 +181,13 @@ public:
     static const std::string& convert_type_to_string( const IMarketType::Type aType );
 
     void accept( IVisitor* aVisitor, const int aPeriod ) const;
+
+#if GCAM_PARALLEL_ENABLED
+    static void beginDeferredAccumulation();
+    static void setCalcGrain( const int aGrain, const std::vector<bool>* aAncestorGrains );
+    static void setCalcOrder( const int aCalcOrder );
+    static void endDeferredAccumulation();
+#endif
 protected:
     void copy( const Market& aMarket );
     
@@ -213,12 +225,109 @@ protected:
     )
     
 #if GCAM_PARALLEL_ENABLED
-    typedef tbb::speculative_spin_rw_mutex Mutex;
-    //! A fast lock to protect conccurent adds to demand.
-    mutable Mutex mDemandMutex;
-    
-    //! A fast lock to protect concurrent adds to supply.
-    mutable Mutex mSupplyMutex;
+    /*!
+     * \brief A single add to supply or demand made during a parallel calc.
+     * \details Contributions are ordered by the position of the activity which
+     *          made them in the global calculation ordering and then by the
+     *          order the activity made them, which is the order a serial calc
+     *          would have added them in.
+     */
+    struct Contribution {
+        //! The market to which the value was added.
+        Market* mMarket;
+
+        //! Position of the contributing activity in the global ordering.
+        int mCalcOrder;
+
+        //! Index of the flow graph grain the contributing activity is in.
+        int mGrain;
+
+        //! Order of this add within the contributing activity.
+        int mSequence;
+
+        //! The value added.
+        double mValue;
+
+        //! The next contribution to the same market variable.
+        Contribution* mNext;
+    };
+
+    //! Per thread storage for contributions and the activity being calculated.
+    struct ContributionLog {
+        ContributionLog():mCalcOrder( -1 ), mGrain( -1 ), mAncestorGrains( 0 ), mSequence( 0 ) {}
+
+        //! Position of the activity currently calculating on this thread.
+        int mCalcOrder;
+
+        //! Index of the flow graph grain currently calculating on this thread.
+        int mGrain;
+
+        //! Flags for each grain of whether it must finish before mGrain starts,
+        //! or null if this thread is not calculating a grain.
+        const std::vector<bool>* mAncestorGrains;
+
+        //! Number of adds made by that activity so far.
+        int mSequence;
+
+        //! Storage for the contributions, a deque keeps their addresses stable.
+        std::deque<Contribution> mContributions;
+    };
+
+    /*!
+     * \brief The contributions to one market variable along with the last sum
+     *        of them read during the calc.
+     * \details Activities downstream of a market may read it several times once
+     *          all of its contributions are in.  The sum is cached so that the
+     *          contributions are only sorted again when a new one has been added
+     *          or the market is read from a different grain.
+     */
+    struct ContributionList {
+        ContributionList():mHead( 0 ), mSumHead( 0 ), mSumBase( 0.0 ), mSumGrain( -1 ), mSum( 0.0 ) {}
+
+        //! The most recent contribution, which links to all earlier ones.
+        std::atomic<Contribution*> mHead;
+
+        //! Guards the cached sum.
+        mutable tbb::spin_mutex mSumMutex;
+
+        //! The value of mHead when mSum was calculated.
+        mutable const Contribution* mSumHead;
+
+        //! The base value mSum was calculated from.
+        mutable double mSumBase;
+
+        //! The grain mSum was calculated for, or -1 if it includes all
+        //! contributions.
+        mutable int mSumGrain;
+
+        //! The base value plus the contributions up to mSumHead which mSumGrain
+        //! depends on in serial calc order.
+        mutable double mSum;
+    };
+
+    //! Adds to demand deferred during the current parallel calc.
+    ContributionList mDemandContributions;
+
+    //! Adds to supply deferred during the current parallel calc.
+    ContributionList mSupplyContributions;
+
+    //! Whether adds are currently deferred.
+    static bool sIsDeferring;
+
+    //! Contribution storage for each thread.
+    static tbb::enumerable_thread_specific<ContributionLog> sContributionLogs;
+
+    void addContribution( ContributionList& aList, const double aValue );
+
+    double sumContributions( const ContributionList& aList, const double aBase ) const;
+
+    double sumContributions( const ContributionList& aList, const double aBase, const int aGrain,
+                             const std::vector<bool>* aAncestorGrains ) const;
+
+    static double sumContributions( const Contribution* aHead, const double aBase, const int aGrain,
+                                    const std::vector<bool>* aAncestorGrains );
+
+    void reduceContributions();
 #endif
     
     //! Object containing information related to the market.
@@ -86,12 +86,16 @@ public:
     int addMarket( const std::string& aMarket, const std::string& aRegion, const std::string& aGoodName,
         const int aUniqueNumber );
     int getMarketNumber( const std::string& aRegion, const std::string& aGoodName ) const;
+    int getMarketNumber( const std::string& aRegion, const size_t aRegionHashCode,
+                         const std::string& aGoodName, const size_t aGoodHashCode ) const;
+    static size_t getHashCode( const std::string& aName );
 
     //! An identifier returned by the various functions if the market does not
     //! exist.
     static const int MARKET_NOT_FOUND = -1;
 private:
-    int getMarketNumberInternal( const std::string& aRegion, const std::string& aGoodName ) const;
+    int getMarketNumberInternal( const std::string& aRegion, const size_t aRegionHashCode,
+                                 const std::string& aGoodName, const size_t aGoodHashCode ) const;
 
     /*! \brief A single node in a list of goods which contains the name of the
     *          good and its market location.
@@ -117,7 +121,7 @@ private:
         ~RegionOrMarketNode();
         inline const std::string& getName() const;
         int addGood( const std::string& aGoodName, const int aMarketNumber );
-        int getMarketNumber( const std::string& aGoodName ) const;
+        int getMarketNumber( const std::string& aGoodName, const size_t aGoodHashCode ) const;
     private:
         //! The type of the list that contains the goods.
         typedef HashMap<std::string, boost::shared_ptr<GoodNode> > SectorNodeList;
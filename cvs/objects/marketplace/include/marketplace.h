@@ -49,6 +49,9 @@
 #include <string>
 #include <memory>
 #include <boost/core/noncopyable.hpp>
+#if GCAM_PARALLEL_ENABLED
+#include <tbb/combinable.h>
+#endif
 
 #include "marketplace/include/imarket_type.h"
 #include "util/base/include/ivisitable.h"
@@ -137,6 +140,8 @@ class Marketplace: public IVisitable, private boost::noncopyable
     friend class SolverLibrary;
     friend class MarketDependencyFinder;
     friend class LogEDFun;
+    friend class World;
+    friend class HashMapBenchmark;
 #if DEBUG_STATE
     friend class ManageStateVariables;
     friend class Value;
@@ -198,6 +203,8 @@ public:
     
     MarketDependencyFinder* getDependencyFinder() const;
 
+    unsigned long getNumStringLookups() const;
+
     // The methods from here down are diagnostics
     std::vector<double> fullstate( int period ) const; //!< Return all supplies and demands in all markets in a single vector
     bool checkstate(int period, const std::vector<double>&, std::ostream *log=0, unsigned tol=0) const;
@@ -225,6 +232,18 @@ protected:
     
     //! Flag indicating whether the next call to world->calc() will be part of a partial derivative calculation 
     static bool mIsDerivativeCalc;
+
+    //! The number of markets located by good and region name.  Callers in the
+    //! solve loop should hold a CachedMarket instead so this is used to report
+    //! any remaining string lookups.  World calc runs in parallel so each
+    //! thread keeps its own count to avoid contending on a shared counter.
+#if GCAM_PARALLEL_ENABLED
+    mutable tbb::combinable<unsigned long> mNumStringLookups;
+#else
+    mutable unsigned long mNumStringLookups;
+#endif
+
+    int findMarketNumber( const std::string& aRegionName, const std::string& aGoodName ) const;
 };
 
 #endif
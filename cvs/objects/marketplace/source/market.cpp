@@ -65,6 +65,10 @@ using namespace objects;
 
 extern Scenario* scenario; 
 
+#if GCAM_PARALLEL_ENABLED
+bool Market::sIsDeferring = false;
+tbb::enumerable_thread_specific<Market::ContributionLog> Market::sContributionLogs;
+#endif
 
 /*! \brief Constructor
  * \details This is the constructor for the market class. No default constructor
@@ -84,6 +88,10 @@ mMarketInfo( InfoFactory::constructInfo( 0, aContainer->getName() ) )
     mForecastPrice = 0.0;
     mForecastDemand = 0.0;
     mOriginal_price = 0.0;
+
+    // Market infos have no parent so lookups by interned key stay valid as
+    // keys are added.
+    mMarketInfo->flatten();
 }
 
 //! Destructor. This is needed because of the auto_ptr.
@@ -327,16 +335,12 @@ void Market::nullDemand() {
 */
 void Market::addToDemand( const double demandIn ) {
 #if GCAM_PARALLEL_ENABLED
-    if( !Marketplace::mIsDerivativeCalc ) {
-        Mutex::scoped_lock writeLock( mDemandMutex, true );
-        mDemand += demandIn;
+    if( sIsDeferring && !Marketplace::mIsDerivativeCalc ) {
+        addContribution( mDemandContributions, demandIn );
+        return;
     }
-    else {
-        mDemand += demandIn;
-    }
-#else
-    mDemand += demandIn;
 #endif
+    mDemand += demandIn;
 }
 
 /*! \brief Get the raw demand.
@@ -348,16 +352,21 @@ void Market::addToDemand( const double demandIn ) {
 */
 double Market::getRawDemand() const {
 #if GCAM_PARALLEL_ENABLED
-    if( !Marketplace::mIsDerivativeCalc ) {
-        Mutex::scoped_lock readLock( mDemandMutex, false );
-        return mDemand;
+    if( sIsDeferring && !Marketplace::mIsDerivativeCalc ) {
+        return sumContributions( mDemandContributions, mDemand );
     }
-    else {
-        return mDemand;
-    }
-#else
-    return mDemand;
 #endif
+    return mDemand;
+}
+
+/*! \brief Set the raw demand.
+* \details Sets the demand variable directly, bypassing any behavior the
+*          Market's type adds to addToDemand.
+* \param aDemand The new value of the demand variable.
+* \sa getRawDemand
+*/
+void Market::setRawDemand( const double aDemand ) {
+    mDemand = aDemand;
 }
 
 /*! \brief Get the demand used in the solver.
@@ -369,16 +378,11 @@ double Market::getRawDemand() const {
  */
 double Market::getSolverDemand() const {
 #if GCAM_PARALLEL_ENABLED
-    if( !Marketplace::mIsDerivativeCalc ) {
-        Mutex::scoped_lock readLock( mDemandMutex, false );
-        return mDemand;
-    }
-    else {
-        return mDemand;
+    if( sIsDeferring && !Marketplace::mIsDerivativeCalc ) {
+        return sumContributions( mDemandContributions, mDemand );
     }
-#else
-    return mDemand;
 #endif
+    return mDemand;
 }
 
 /*! \brief Get the demand.
@@ -387,16 +391,11 @@ double Market::getSolverDemand() const {
 */
 double Market::getDemand() const {
 #if GCAM_PARALLEL_ENABLED
-    if( !Marketplace::mIsDerivativeCalc ) {
-        Mutex::scoped_lock readLock( mDemandMutex, false );
-        return mDemand;
-    }
-    else {
-        return mDemand;
+    if( sIsDeferring && !Marketplace::mIsDerivativeCalc ) {
+        return sumContributions( mDemandContributions, mDemand );
     }
-#else
-    return mDemand;
 #endif
+    return mDemand;
 }
 
 /*! \brief Null the supply.
@@ -415,16 +414,21 @@ void Market::nullSupply() {
 */
 double Market::getRawSupply() const {
 #if GCAM_PARALLEL_ENABLED
-    if( !Marketplace::mIsDerivativeCalc ) {
-        Mutex::scoped_lock readLock( mSupplyMutex, false );
-        return mSupply;
-    }
-    else {
-        return mSupply;
+    if( sIsDeferring && !Marketplace::mIsDerivativeCalc ) {
+        return sumContributions( mSupplyContributions, mSupply );
     }
-#else
-    return mSupply;
 #endif
+    return mSupply;
+}
+
+/*! \brief Set the raw supply.
+* \details Sets the supply variable directly, bypassing any behavior the
+*          Market's type adds to addToSupply.
+* \param aSupply The new value of the supply variable.
+* \sa getRawSupply
+*/
+void Market::setRawSupply( const double aSupply ) {
+    mSupply = aSupply;
 }
 
 /*! \brief Get the supply value to be used in the solver
@@ -437,16 +441,11 @@ double Market::getRawSupply() const {
 */
 double Market::getSolverSupply() const {
 #if GCAM_PARALLEL_ENABLED
-    if( !Marketplace::mIsDerivativeCalc ) {
-        Mutex::scoped_lock readLock( mSupplyMutex, false );
-        return mSupply;
-    }
-    else {
-        return mSupply;
+    if( sIsDeferring && !Marketplace::mIsDerivativeCalc ) {
+        return sumContributions( mSupplyContributions, mSupply );
     }
-#else
-    return mSupply;
 #endif
+    return mSupply;
 }
 
 /*! \brief Get the supply.
@@ -455,16 +454,11 @@ double Market::getSolverSupply() const {
 */
 double Market::getSupply() const {
 #if GCAM_PARALLEL_ENABLED
-    if( !Marketplace::mIsDerivativeCalc ) {
-        Mutex::scoped_lock readLock( mSupplyMutex, false );
-        return mSupply;
-    }
-    else {
-        return mSupply;
+    if( sIsDeferring && !Marketplace::mIsDerivativeCalc ) {
+        return sumContributions( mSupplyContributions, mSupply );
     }
-#else
-    return mSupply;
 #endif
+    return mSupply;
 }
 
 /*! \brief Add to the the Market an amount of supply in a method based on the
@@ -475,16 +469,12 @@ double Market::getSupply() const {
 */
 void Market::addToSupply( const double supplyIn ) {
 #if GCAM_PARALLEL_ENABLED
-    if( !Marketplace::mIsDerivativeCalc ) {
-        Mutex::scoped_lock writeLock( mSupplyMutex, true );
-        mSupply += supplyIn;
+    if( sIsDeferring && !Marketplace::mIsDerivativeCalc ) {
+        addContribution( mSupplyContributions, supplyIn );
+        return;
     }
-    else {
-        mSupply += supplyIn;
-    }
-#else
-    mSupply += supplyIn;
 #endif
+    mSupply += supplyIn;
 }
 
 /*! \brief Return the market name.
@@ -687,3 +677,194 @@ bool Market::isSolvable() const {
 IInfo* Market::releaseMarketInfo() {
     return mMarketInfo.release();
 }
+
+#if GCAM_PARALLEL_ENABLED
+/*!
+ * \brief Start deferring adds to supply and demand for a parallel calc.
+ * \details While deferring, each add is recorded along with the position of the
+ *          activity which made it rather than summed immediately.  Threads then
+ *          never write to the same market variable and no locking is needed.
+ *          Adds made during partial derivative calcs are not deferred since each
+ *          of those calcs already works on its own state.
+ * \sa endDeferredAccumulation
+ */
+void Market::beginDeferredAccumulation() {
+    sIsDeferring = true;
+}
+
+/*!
+ * \brief Set the flow graph grain about to be calculated on the current thread.
+ * \details Reads of supply and demand made while calculating the grain only see
+ *          contributions from the grains it depends on and from the activities
+ *          of the grain itself, all of which are done by the time of the read.
+ *          Contributions from any other grain may or may not have been made
+ *          depending on how the work was scheduled, so they are left out until
+ *          the end of the calc.
+ * \param aGrain Index of the grain in its flow graph, or -1 when done.
+ * \param aAncestorGrains Flags for each grain of whether aGrain depends on
+ *        it, or null when done.
+ */
+void Market::setCalcGrain( const int aGrain, const std::vector<bool>* aAncestorGrains ) {
+    ContributionLog& log = sContributionLogs.local();
+    log.mGrain = aGrain;
+    log.mAncestorGrains = aAncestorGrains;
+}
+
+/*!
+ * \brief Set the position in the global calculation ordering of the activity
+ *        about to be calculated on the current thread.
+ * \param aCalcOrder Position of the activity in the global ordering.
+ */
+void Market::setCalcOrder( const int aCalcOrder ) {
+    ContributionLog& log = sContributionLogs.local();
+    log.mCalcOrder = aCalcOrder;
+    log.mSequence = 0;
+}
+
+/*!
+ * \brief Stop deferring adds and sum all recorded contributions into the
+ *        markets that received them.
+ * \details Contributions are summed in the order a serial calc would have made
+ *          them, so the result does not depend on how the work was scheduled and
+ *          is identical from run to run.  This must only be called once all
+ *          activities in the parallel calc have finished.
+ */
+void Market::endDeferredAccumulation() {
+    sIsDeferring = false;
+    typedef tbb::enumerable_thread_specific<ContributionLog>::iterator LogIterator;
+    for( LogIterator logIt = sContributionLogs.begin(); logIt != sContributionLogs.end(); ++logIt ) {
+        for( deque<Contribution>::const_iterator it = ( *logIt ).mContributions.begin();
+             it != ( *logIt ).mContributions.end(); ++it )
+        {
+            // Markets which have already been reduced will have empty lists.
+            ( *it ).mMarket->reduceContributions();
+        }
+    }
+    for( LogIterator logIt = sContributionLogs.begin(); logIt != sContributionLogs.end(); ++logIt ) {
+        ( *logIt ).mContributions.clear();
+        ( *logIt ).mCalcOrder = -1;
+        ( *logIt ).mGrain = -1;
+        ( *logIt ).mAncestorGrains = 0;
+        ( *logIt ).mSequence = 0;
+    }
+}
+
+/*!
+ * \brief Record an add to supply or demand to be summed at the end of the calc.
+ * \details The contribution is stored in the storage of the calling thread and
+ *          then pushed onto the market variable's list without locking.
+ * \param aList The list of contributions for supply or demand.
+ * \param aValue The value to add.
+ */
+void Market::addContribution( ContributionList& aList, const double aValue ) {
+    ContributionLog& log = sContributionLogs.local();
+    Contribution contribution = { this, log.mCalcOrder, log.mGrain, log.mSequence++, aValue, 0 };
+    log.mContributions.push_back( contribution );
+    Contribution* newHead = &log.mContributions.back();
+    Contribution* oldHead = aList.mHead.load();
+    do {
+        newHead->mNext = oldHead;
+    } while( !aList.mHead.compare_exchange_weak( oldHead, newHead ) );
+}
+
+//! Helper to sort contributions in the order a serial calc would have made them.
+struct ContributionOrderComp {
+    template<typename ContributionType>
+    bool operator()( const ContributionType* aLHS, const ContributionType* aRHS ) const {
+        return aLHS->mCalcOrder < aRHS->mCalcOrder ||
+            ( aLHS->mCalcOrder == aRHS->mCalcOrder && aLHS->mSequence < aRHS->mSequence );
+    }
+};
+
+/*!
+ * \brief Sum the contributions the activity calculating on the current thread
+ *        may see onto the given base value.
+ * \details Activities downstream of a market may read its supply or demand
+ *          during the calc.  They see the contributions of the grains they
+ *          depend on and of their own grain, summed in serial order, which
+ *          does not depend on how the work was scheduled.  See setCalcGrain.
+ * \param aList The list of contributions for supply or demand.
+ * \param aBase The value before any contributions were made.
+ * \return The base value plus the contributions the reader depends on.
+ */
+double Market::sumContributions( const ContributionList& aList, const double aBase ) const {
+    const ContributionLog& log = sContributionLogs.local();
+    return sumContributions( aList, aBase, log.mGrain, log.mAncestorGrains );
+}
+
+/*!
+ * \brief Sum the contributions made by the given grains onto the given base
+ *        value.
+ * \details The sum is cached until the next contribution or a read from
+ *          another grain so repeated reads do not sort again.
+ * \param aList The list of contributions for supply or demand.
+ * \param aBase The value before any contributions were made.
+ * \param aGrain The grain reading the sum, whose contributions are included.
+ * \param aAncestorGrains Flags for each grain of whether its contributions are
+ *        included, or null to include all contributions.
+ * \return The base value plus the included contributions.
+ */
+double Market::sumContributions( const ContributionList& aList, const double aBase, const int aGrain,
+                                 const vector<bool>* aAncestorGrains ) const
+{
+    const Contribution* head = aList.mHead.load();
+    if( !head ) {
+        return aBase;
+    }
+    const int sumGrain = aAncestorGrains ? aGrain : -1;
+    tbb::spin_mutex::scoped_lock lock( aList.mSumMutex );
+    if( aList.mSumHead != head || aList.mSumBase != aBase || aList.mSumGrain != sumGrain ) {
+        aList.mSum = sumContributions( head, aBase, aGrain, aAncestorGrains );
+        aList.mSumHead = head;
+        aList.mSumBase = aBase;
+        aList.mSumGrain = sumGrain;
+    }
+    return aList.mSum;
+}
+
+/*!
+ * \brief Sum a list of contributions made by the given grains in the order a
+ *        serial calc would have made them.
+ * \param aHead The most recent contribution in the list.
+ * \param aBase The value before any contributions were made.
+ * \param aGrain A grain whose contributions are included.
+ * \param aAncestorGrains Flags for each grain of whether its contributions are
+ *        included, or null to include all contributions.
+ * \return The base value plus the included contributions.
+ */
+double Market::sumContributions( const Contribution* aHead, const double aBase, const int aGrain,
+                                 const vector<bool>* aAncestorGrains )
+{
+    vector<const Contribution*> contributions;
+    for( const Contribution* curr = aHead; curr; curr = curr->mNext ) {
+        if( !aAncestorGrains || curr->mGrain < 0 || curr->mGrain == aGrain || ( *aAncestorGrains )[ curr->mGrain ] ) {
+            contributions.push_back( curr );
+        }
+    }
+    sort( contributions.begin(), contributions.end(), ContributionOrderComp() );
+    double sum = aBase;
+    for( vector<const Contribution*>::const_iterator it = contributions.begin(); it != contributions.end(); ++it ) {
+        sum += ( *it )->mValue;
+    }
+    return sum;
+}
+
+/*!
+ * \brief Add all recorded contributions to supply and demand in the order a serial
+ *        calc would have and clear them.
+ * \details Each list is sorted at most once here, and not at all if it was
+ *          already summed by a read after its last contribution.
+ */
+void Market::reduceContributions() {
+    if( mDemandContributions.mHead.load() ) {
+        mDemand = sumContributions( mDemandContributions, mDemand, -1, 0 );
+        mDemandContributions.mHead = 0;
+        mDemandContributions.mSumHead = 0;
+    }
+    if( mSupplyContributions.mHead.load() ) {
+        mSupply = sumContributions( mSupplyContributions, mSupply, -1, 0 );
+        mSupplyContributions.mHead = 0;
+        mSupplyContributions.mSumHead = 0;
+    }
+}
+#endif
@@ -92,15 +92,17 @@ int MarketLocator::addMarket( const string& aMarket,
                               const string& aGoodName,
                               const int aUniqueNumber )
 {
-    // Check if the market area exists in the market area list.
-    RegionMarketList::iterator iter = mMarketList->find( aMarket );
+    // Check if the market area exists in the market area list. The hash code is
+    // kept so that the key is not hashed again if it must be inserted.
+    const size_t marketHashCode = mMarketList->getHashCode( aMarket );
+    RegionMarketList::iterator iter = mMarketList->find( aMarket, marketHashCode );
     
     int goodNumber;
     // The market area does not exist. Create a new entry.
     if( iter == mMarketList->end() ){
         boost::shared_ptr<RegionOrMarketNode> newMarketNode( new RegionOrMarketNode( aMarket ) );
         // Add the node to the hashmap.
-        mMarketList->insert( make_pair( aMarket, newMarketNode ) );
+        mMarketList->insert( make_pair( aMarket, newMarketNode ), marketHashCode );
 
         // Add the item to it.
         goodNumber = newMarketNode->addGood( aGoodName, aUniqueNumber );
@@ -111,13 +113,14 @@ int MarketLocator::addMarket( const string& aMarket,
     }
 
     // Check if the region exists in the region list.
-    iter = mRegionList->find( aRegion );
+    const size_t regionHashCode = mRegionList->getHashCode( aRegion );
+    iter = mRegionList->find( aRegion, regionHashCode );
 
     // The region does not exist. Create a new entry.
     if( iter == mRegionList->end() ){
         boost::shared_ptr<RegionOrMarketNode> newRegionNode( new RegionOrMarketNode( aRegion ) );
         // Add the new region to the region list.
-        mRegionList->insert( make_pair( aRegion, newRegionNode ) );
+        mRegionList->insert( make_pair( aRegion, newRegionNode ), regionHashCode );
         
         // Add the item to the region list.
         newRegionNode->addGood( aGoodName, goodNumber );
@@ -137,6 +140,26 @@ int MarketLocator::addMarket( const string& aMarket,
 * \return The market number or MARKET_NOT_FOUND if it is not present.
 */
 int MarketLocator::getMarketNumber( const string& aRegion, const string& aGoodName ) const {
+    return getMarketNumber( aRegion, getHashCode( aRegion ), aGoodName, getHashCode( aGoodName ) );
+}
+
+/*! \brief Find the market number for a given region and good given the
+*          precomputed hash codes of the names.
+* \details Callers which search for the same region and good many times may
+*          compute the hash codes once with getHashCode and keep them with the
+*          names so that the names are not hashed again on each search.
+* \param aRegion Region for which to search.
+* \param aRegionHashCode The hash code of aRegion.
+* \param aGoodName Good for which to search.
+* \param aGoodHashCode The hash code of aGoodName.
+* \return The market number or MARKET_NOT_FOUND if it is not present.
+*/
+int MarketLocator::getMarketNumber( const string& aRegion, const size_t aRegionHashCode,
+                                    const string& aGoodName, const size_t aGoodHashCode ) const
+{
+    /*! \pre The hash codes are those of the names. */
+    assert( aRegionHashCode == getHashCode( aRegion ) && aGoodHashCode == getHashCode( aGoodName ) );
+
     // Compile in extra timing. Note that timing causes significant overhead, so
     // timed runs will take longer. The result is useful to compare across timed
     // runs, not vs non-timed runs.
@@ -145,27 +168,38 @@ int MarketLocator::getMarketNumber( const string& aRegion, const string& aGoodNa
     timer.start();
 
     // Lookup the market in the marketList.
-    int marketNumber = getMarketNumberInternal( aRegion, aGoodName );
+    int marketNumber = getMarketNumberInternal( aRegion, aRegionHashCode, aGoodName, aGoodHashCode );
     timer.stop();
     gTotalLookupTime += timer.getTimeDifference();
     ++gNumLookups;
     return marketNumber;
 #else
-    return getMarketNumberInternal( aRegion, aGoodName );
+    return getMarketNumberInternal( aRegion, aRegionHashCode, aGoodName, aGoodHashCode );
 #endif
 }
 
+/*! \brief Compute the hash code of a region, market or good name.
+* \details This is the hash code the lookup lists use for the name.
+* \param aName The name to hash.
+* \return The hash code of the name.
+*/
+size_t MarketLocator::getHashCode( const string& aName ) {
+    return boost::hash<string>()( aName );
+}
+
 /*! \brief Internal calculation which determines the market number from a region
 *          and good name.
 * \details Performs the calculation which determines the market number from a
 *          region and good name.
 * \param aRegion Region for which to search.
+* \param aRegionHashCode The hash code of aRegion.
 * \param aGoodName Good for which to search.
+* \param aGoodHashCode The hash code of aGoodName.
 * \return The number of the associated market or MARKET_NOT_FOUND if it does not
 *         exist.
 */
-int MarketLocator::getMarketNumberInternal( const string& aRegion,
-                                            const string& aGoodName ) const
+int MarketLocator::getMarketNumberInternal( const string& aRegion, const size_t aRegionHashCode,
+                                            const string& aGoodName, const size_t aGoodHashCode ) const
 {
     // First check if the cached market number matched the region.
     const RegionOrMarketNode* region;
@@ -180,7 +214,7 @@ int MarketLocator::getMarketNumberInternal( const string& aRegion,
     }
 #endif
     else {
-        RegionMarketList::const_iterator iter = mRegionList->find( aRegion );
+        RegionMarketList::const_iterator iter = mRegionList->find( aRegion, aRegionHashCode );
         // Check if the region was found.
         if( iter != mRegionList->end() ){
             /*! \invariant If the key is in the list the node must be non-null. */
@@ -200,7 +234,7 @@ int MarketLocator::getMarketNumberInternal( const string& aRegion,
 
     // If the region lookup succeeded search for the good, otherwise return
     // market not found.
-    return region ? region->getMarketNumber( aGoodName ) : MARKET_NOT_FOUND;
+    return region ? region->getMarketNumber( aGoodName, aGoodHashCode ) : MARKET_NOT_FOUND;
 }
 
 //! Constructor
@@ -225,7 +259,8 @@ int MarketLocator::RegionOrMarketNode::addGood( const string& aGoodName,
                                                 const int aUniqueNumber )
 {
     // Check if it exists in the good list.
-    SectorNodeList::iterator iter = mSectorNodeList->find( aGoodName );
+    const size_t goodHashCode = mSectorNodeList->getHashCode( aGoodName );
+    SectorNodeList::iterator iter = mSectorNodeList->find( aGoodName, goodHashCode );
 
     // Check if the good was found.
     if( iter != mSectorNodeList->end() ){
@@ -240,7 +275,7 @@ int MarketLocator::RegionOrMarketNode::addGood( const string& aGoodName,
     boost::shared_ptr<GoodNode> newGoodNode( new GoodNode( aGoodName, aUniqueNumber ) );
 
     // Add the new node to the hashmap.
-    mSectorNodeList->insert( make_pair( aGoodName, newGoodNode ) );
+    mSectorNodeList->insert( make_pair( aGoodName, newGoodNode ), goodHashCode );
 
     // Return the new index.
     return aUniqueNumber;
@@ -248,11 +283,14 @@ int MarketLocator::RegionOrMarketNode::addGood( const string& aGoodName,
 
 /*! \brief Find a market number given a Good name.
 * \param aGoodName The name of the Good to search for.
+* \param aGoodHashCode The hash code of aGoodName.
 * \return The market number for the Good, MARKET_NOT_FOUND otherwise.
 */
-int MarketLocator::RegionOrMarketNode::getMarketNumber( const string& aGoodName ) const {
+int MarketLocator::RegionOrMarketNode::getMarketNumber( const string& aGoodName,
+                                                        const size_t aGoodHashCode ) const
+{
     // Check if it exists in the good list.
-    SectorNodeList::const_iterator iter = mSectorNodeList->find( aGoodName );
+    SectorNodeList::const_iterator iter = mSectorNodeList->find( aGoodName, aGoodHashCode );
     if( iter != mSectorNodeList->end() ){
         return iter->second->mNumber;
     }
@@ -45,6 +45,7 @@
 
 #if GCAM_PARALLEL_ENABLED
 #include <tbb/parallel_for.h>
+#include <functional>
 #endif
 
 #include "marketplace/include/marketplace.h"
@@ -81,6 +82,9 @@ bool Marketplace::mIsDerivativeCalc = false;
 Marketplace::Marketplace():
 mMarketLocator( new MarketLocator() ),
 mDependencyFinder( new MarketDependencyFinder( this ) )
+#if !GCAM_PARALLEL_ENABLED
+,mNumStringLookups( 0 )
+#endif
 {
 }
 
@@ -234,7 +238,7 @@ bool Marketplace::createLinkedMarket( const string& regionName, const string& ma
     const bool isNewMarket = ( marketNumber == uniqueNumber );
 
     // Find the market to link to.
-    const int linkedMarketNumber = mMarketLocator->getMarketNumber( regionName, linkedGoodName );
+    const int linkedMarketNumber = findMarketNumber( regionName, linkedGoodName );
     if( linkedMarketNumber == MarketLocator::MARKET_NOT_FOUND ) {
         ILogger& mainLog = ILogger::getLogger( "main_log" );
         mainLog.setLevel( ILogger::WARNING );
@@ -306,7 +310,7 @@ int Marketplace::resetToPriceMarket( const int aMarketNumber ) {
         marketInfo->setString( "price-unit", marketInfoFrom->getString( "price-unit", true ) );
         marketInfo->setString( "output-unit", marketInfoFrom->getString( "output-unit", true ) );
 
-        int demandMarketNumber = mMarketLocator->getMarketNumber( regionName, demandGoodName );
+        int demandMarketNumber = findMarketNumber( regionName, demandGoodName );
         assert( demandMarketNumber != MarketLocator::MARKET_NOT_FOUND );
         mMarkets[ aMarketNumber ]->resetToPriceMarket( mMarkets[ demandMarketNumber ] );
         return demandMarketNumber;
@@ -327,7 +331,7 @@ int Marketplace::resetToPriceMarket( const int aMarketNumber ) {
 void Marketplace::setPriceVector( const string& goodName, const string& regionName,
                                  const objects::PeriodVector<Value>& prices ){
     // determine what market the region and good are in.
-    const int marketNumber = mMarketLocator->getMarketNumber( regionName, goodName );
+    const int marketNumber = findMarketNumber( regionName, goodName );
     if( marketNumber == MarketLocator::MARKET_NOT_FOUND ){
         ILogger& mainLog = ILogger::getLogger( "main_log" );
         mainLog.setLevel( ILogger::NOTICE );
@@ -374,7 +378,7 @@ void Marketplace::initPrices(){
 * \param per The period for which the market should be solved.
 */
 void Marketplace::setMarketToSolve ( const string& goodName, const string& regionName, const int per ) {
-    const int marketNumber = mMarketLocator->getMarketNumber( regionName, goodName );
+    const int marketNumber = findMarketNumber( regionName, goodName );
 
     // If the market exists.
     if ( marketNumber != MarketLocator::MARKET_NOT_FOUND ) {
@@ -402,7 +406,7 @@ void Marketplace::setMarketToSolve ( const string& goodName, const string& regio
 */
 void Marketplace::unsetMarketToSolve ( const string& goodName, const string& regionName, const int per ) {
 
-    const int marketNumber = mMarketLocator->getMarketNumber( regionName, goodName );
+    const int marketNumber = findMarketNumber( regionName, goodName );
 
     // If the market exists.
     if ( marketNumber != MarketLocator::MARKET_NOT_FOUND ) {
@@ -500,7 +504,7 @@ void Marketplace::setPrice( const string& goodName, const string& regionName, co
         return;
     }
 
-    const int marketNumber = mMarketLocator->getMarketNumber( regionName, goodName );
+    const int marketNumber = findMarketNumber( regionName, goodName );
     if ( marketNumber != MarketLocator::MARKET_NOT_FOUND ) {
         mMarkets[ marketNumber ]->getMarket( per )->setPrice( value );
     }
@@ -537,7 +541,7 @@ void Marketplace::addToSupply( const string& goodName, const string& regionName,
         return;
     }
 
-    const int marketNumber = mMarketLocator->getMarketNumber( regionName, goodName );
+    const int marketNumber = findMarketNumber( regionName, goodName );
 
     if ( marketNumber != MarketLocator::MARKET_NOT_FOUND ) {
         mMarkets[ marketNumber ]->getMarket( per )->addToSupply( mIsDerivativeCalc ? value.getDiff() : value.get() );
@@ -575,7 +579,7 @@ void Marketplace::addToDemand( const string& goodName, const string& regionName,
         return;
     }
 
-    const int marketNumber = mMarketLocator->getMarketNumber( regionName, goodName );
+    const int marketNumber = findMarketNumber( regionName, goodName );
     if ( marketNumber != MarketLocator::MARKET_NOT_FOUND ) {
         mMarkets[ marketNumber ]->getMarket( per )->addToDemand( mIsDerivativeCalc ? value.getDiff() : value.get() );
     }
@@ -602,7 +606,7 @@ void Marketplace::addToDemand( const string& goodName, const string& regionName,
 */  
 double Marketplace::getPrice( const string& goodName, const string& regionName, const int per,
                              bool aMustExist ) const {
-    const int marketNumber = mMarketLocator->getMarketNumber( regionName, goodName );
+    const int marketNumber = findMarketNumber( regionName, goodName );
     
     if( marketNumber != MarketLocator::MARKET_NOT_FOUND ){
         return mMarkets[ marketNumber ]->getMarket( per )->getPrice();
@@ -629,7 +633,7 @@ double Marketplace::getPrice( const string& goodName, const string& regionName,
 * \return The market supply.
 */
 double Marketplace::getSupply( const string& goodName, const string& regionName, const int per ) const {
-    const int marketNumber = mMarketLocator->getMarketNumber( regionName, goodName );
+    const int marketNumber = findMarketNumber( regionName, goodName );
 
     if ( marketNumber != MarketLocator::MARKET_NOT_FOUND ) {
         return mMarkets[ marketNumber ]->getMarket( per )->getSupply();
@@ -653,7 +657,7 @@ double Marketplace::getSupply( const string& goodName, const string& regionName,
 * \return The market demand.
 */
 double Marketplace::getDemand(  const string& goodName, const string& regionName, const int per ) const {
-    const int marketNumber = mMarketLocator->getMarketNumber( regionName, goodName );
+    const int marketNumber = findMarketNumber( regionName, goodName );
 
     if ( marketNumber != MarketLocator::MARKET_NOT_FOUND ) {
         return mMarkets[ marketNumber ]->getMarket( per )->getDemand();
@@ -776,7 +780,7 @@ void Marketplace::restore_prices_for_cost_calculation()
 const IInfo* Marketplace::getMarketInfo( const string& aGoodName, const string& aRegionName,
                                          const int aPeriod, const bool aMustExist ) const 
 {
-    const int marketNumber = mMarketLocator->getMarketNumber( aRegionName, aGoodName );
+    const int marketNumber = findMarketNumber( aRegionName, aGoodName );
     const IInfo* info = 0;
     if ( marketNumber != MarketLocator::MARKET_NOT_FOUND ) {
         info = mMarkets[ marketNumber ]->getMarket( aPeriod )->getMarketInfo();
@@ -819,7 +823,7 @@ const IInfo* Marketplace::getMarketInfo( const string& aGoodName, const string&
 IInfo* Marketplace::getMarketInfo( const string& aGoodName, const string& aRegionName,
                                    const int aPeriod, const bool aMustExist )
 {
-    const int marketNumber = mMarketLocator->getMarketNumber( aRegionName, aGoodName );
+    const int marketNumber = findMarketNumber( aRegionName, aGoodName );
     IInfo* info = 0;
     if ( marketNumber != MarketLocator::MARKET_NOT_FOUND ) {
         info = mMarkets[ marketNumber ]->getMarket( aPeriod )->getMarketInfo();
@@ -856,7 +860,7 @@ IInfo* Marketplace::getMarketInfo( const string& aGoodName, const string& aRegio
 auto_ptr<CachedMarket> Marketplace::locateMarket( const string& aGoodName, const string& aRegionName,
                                                   const int aPeriod ) const
 {
-    const int marketNumber = mMarketLocator->getMarketNumber( aRegionName, aGoodName );
+    const int marketNumber = findMarketNumber( aRegionName, aGoodName );
     auto_ptr<CachedMarket> locatedMarket( new CachedMarket( aGoodName, aRegionName, aPeriod,
                                                             marketNumber != MarketLocator::MARKET_NOT_FOUND ?
                                                             mMarkets[ marketNumber ]->getMarket( aPeriod ) : 0 ) );
@@ -897,6 +901,40 @@ MarketDependencyFinder* Marketplace::getDependencyFinder() const {
     return mDependencyFinder.get();
 }
 
+/*!
+ * \brief Get the number of times a market has been looked up by name.
+ * \details Every method which takes a good and region name must search the
+ *          MarketLocator for the market.  Model components are expected to
+ *          resolve a CachedMarket in initCalc and use it for the rest of the
+ *          period so the difference in this count across a solve indicates
+ *          how many lookups have not yet been converted.
+ * \return The total number of string lookups made so far.
+ */
+unsigned long Marketplace::getNumStringLookups() const {
+#if GCAM_PARALLEL_ENABLED
+    return mNumStringLookups.combine( std::plus<unsigned long>() );
+#else
+    return mNumStringLookups;
+#endif
+}
+
+/*!
+ * \brief Find the market number for the given region and good and count the
+ *        lookup.
+ * \param aRegionName The region of the market to find.
+ * \param aGoodName The good of the market to find.
+ * \return The market number or MarketLocator::MARKET_NOT_FOUND.
+ * \see getNumStringLookups
+ */
+int Marketplace::findMarketNumber( const string& aRegionName, const string& aGoodName ) const {
+#if GCAM_PARALLEL_ENABLED
+    ++mNumStringLookups.local();
+#else
+    ++mNumStringLookups;
+#endif
+    return mMarketLocator->getMarketNumber( aRegionName, aGoodName );
+}
+
 /*!
  * \brief Get the full state of the marketplace.
  * \param period The model period.
@@ -37,7 +37,9 @@
 
 /* standard headers */
 #include <list>
+#include <map>
 #include <set>
+#include <vector>
 
 /* graph analysis headers */
 #include "parallel/include/digraph.hpp"
@@ -59,7 +61,7 @@ class GcamFlowGraph {
     friend class MarketDependencyFinder;
 private:
     //! Private constructor to only allow select classes to create flow graphs.
-    GcamFlowGraph() : mTBBFlowGraph(), mHead( mTBBFlowGraph ), mPeriod( 0 ), mCalcList( 0 ) {}
+    GcamFlowGraph() : mTBBFlowGraph(), mHead( mTBBFlowGraph ), mPeriod( 0 ), mCalcList( 0 ), mIsFullCalc( false ) {}
     
     //! The TBB calculation flow graph.
     tbb::flow::graph mTBBFlowGraph;
@@ -75,6 +77,9 @@ private:
     //! not be calculated for sub-graphs.  Note when null it implies all activities
     //! will be calculated.
     const std::vector<IActivity*>* mCalcList;
+    
+    //! Whether the calculation is of the full model, used when profiling activities.
+    bool mIsFullCalc;
 };
 
 /*!
@@ -105,6 +110,7 @@ public:
                                  const std::vector<FlowGraphNodeType>& aCalcItems );
     
     void makeTBBFlowGraph( const FlowGraph& aGrainGraph, const FlowGraph& aTopology,
+                           const std::vector<FlowGraphNodeType>& aGlobalOrdering,
                            GcamFlowGraph& aTBBGraph );
   
 protected:
@@ -134,6 +140,8 @@ protected:
      */
     struct TBBFlowGraphBody {
         TBBFlowGraphBody( const std::set<FlowGraphNodeType>& aNodes, const FlowGraph& aTopology,
+                          const std::map<FlowGraphNodeType, int>& aCalcOrderTable,
+                          const int aGrain, const std::vector<bool>& aAncestorGrains,
                           const GcamFlowGraph& aGraph );
         
         void operator()( tbb::flow::continue_msg aMessage );
@@ -142,6 +150,18 @@ protected:
         //! to execute.
         std::list<FlowGraphNodeType> mNodes;
         
+        //! The position of each activity in mNodes in the global ordering which
+        //! is used to order adds to market supplies and demands.
+        std::vector<int> mCalcOrders;
+        
+        //! The index of this grain in the flow graph.
+        int mGrain;
+        
+        //! Flags for each grain in the flow graph of whether it must finish
+        //! before this one starts, which limits the market adds that this grain
+        //! sees while the calc is running.
+        std::vector<bool> mAncestorGrains;
+        
         //! A reference to the TBB flow graph to which this node belongs.
         const GcamFlowGraph& mGraph;
     };
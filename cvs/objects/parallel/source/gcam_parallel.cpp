@@ -38,8 +38,10 @@
 #include "containers/include/world.h"
 #include "containers/include/iactivity.h"
 #include "containers/include/market_dependency_finder.h"
+#include "marketplace/include/market.h"
 #include "util/logger/include/ilogger.h"
 #include "util/base/include/timer.h"
+#include "util/base/include/activity_profiler.h"
 #include "util/base/include/auto_file.h"
 /* more graph analysis headers */
 #include "parallel/include/clanid.hpp"
@@ -236,6 +238,8 @@ void GcamParallel::graphParseGrainCollect( const FlowGraph& aGCAMFlowGraph, Flow
  * \param[in] aGrainGraph: graph of the computational grains
  *            (produced by graph_parse_grain_collect()) 
  * \param[in] aTopology: original gcam flow graph (see remark) 
+ * \param[in] aGlobalOrdering: The serial calculation ordering of all activities,
+ *            used to sum market supplies and demands in a deterministic order.
  * \param[inout] aTBBGraph: The class that will hold the flow graph nodes as well
  *             as any other required items to run the flow graph including the
  *             broadcast node which serves as the trigger that causes
@@ -248,6 +252,7 @@ void GcamParallel::graphParseGrainCollect( const FlowGraph& aGCAMFlowGraph, Flow
  *             object.
  */
 void GcamParallel::makeTBBFlowGraph( const FlowGraph& aGrainGraph, const FlowGraph& aTopology,
+                                     const vector<FlowGraphNodeType>& aGlobalOrdering,
                                      GcamFlowGraph& aTBBGraph )
 {
     using tbb::flow::continue_node;
@@ -264,6 +269,23 @@ void GcamParallel::makeTBBFlowGraph( const FlowGraph& aGrainGraph, const FlowGra
     map<FlowGraphNodeType, continue_node<continue_msg>* > nodeTable;
     map<FlowGraphNodeType, int> nodeSizeTable;
     
+    // Look up table for the position of each activity in the global ordering.
+    map<FlowGraphNodeType, int> calcOrderTable;
+    for( size_t i = 0; i < aGlobalOrdering.size(); ++i ) {
+        calcOrderTable[ aGlobalOrdering[ i ] ] = static_cast<int>( i );
+    }
+    
+    // Number the grains and find the grains each one depends on, directly or
+    // indirectly, so that market adds can be kept out of reads made by grains
+    // which do not depend on them.
+    map<FlowGraphNodeType, int> grainIndexTable;
+    for( FlowGraph::nodelist_c_iter_t gnodeIt = aGrainGraph.nodelist().begin();
+         gnodeIt != aGrainGraph.nodelist().end(); ++gnodeIt )
+    {
+        const int grainIndex = static_cast<int>( grainIndexTable.size() );
+        grainIndexTable[ gnodeIt->first ] = grainIndex;
+    }
+    
     // The TBB flow graph structures don't automatically create nodes, so we'll do
     // two passes, creating nodes on the first and connecting them on the second.
     for( FlowGraph::nodelist_c_iter_t gnodeIt = aGrainGraph.nodelist().begin();
@@ -280,9 +302,18 @@ void GcamParallel::makeTBBFlowGraph( const FlowGraph& aGrainGraph, const FlowGra
         // create the node for this grain.  Note that the tbbfg_body constructor
         // uses the topology to order the elements of the grain, but does not store
         // a reference.
+        set<FlowGraphNodeType> ancestors;
+        aGrainGraph.find_ancestors( gnodeIt->first, ancestors );
+        vector<bool> ancestorGrains( grainIndexTable.size(), false );
+        for( set<FlowGraphNodeType>::const_iterator ancestorIt = ancestors.begin();
+             ancestorIt != ancestors.end(); ++ancestorIt )
+        {
+            ancestorGrains[ grainIndexTable[ *ancestorIt ] ] = true;
+        }
         size_t nodeSize = subGraphNodes.size();
         nodeTable[ gnodeIt->first ] = new continue_node<continue_msg>( tbbFlowGraph,
-            TBBFlowGraphBody( subGraphNodes, aTopology, aTBBGraph ) );
+            TBBFlowGraphBody( subGraphNodes, aTopology, calcOrderTable, grainIndexTable[ gnodeIt->first ],
+                              ancestorGrains, aTBBGraph ) );
         nodeSizeTable[ gnodeIt->first ] = nodeSize;
         pgLog << "\tContinue node: " << nodeTable[ gnodeIt->first ] << endl;
     }
@@ -319,21 +350,28 @@ void GcamParallel::makeTBBFlowGraph( const FlowGraph& aGrainGraph, const FlowGra
 
 void GcamParallel::TBBFlowGraphBody::operator()( tbb::flow::continue_msg aMessage )
 {
+    ActivityProfiler& profiler = ActivityProfiler::getInstance();
+    Market::setCalcGrain( mGrain, &mAncestorGrains );
+    vector<int>::const_iterator orderIt = mCalcOrders.begin();
     for( list<FlowGraphNodeType>::const_iterator nodeIt = mNodes.begin();
-         nodeIt != mNodes.end(); ++nodeIt )
+         nodeIt != mNodes.end(); ++nodeIt, ++orderIt )
     {
         if( !mGraph.mCalcList ||
             find( mGraph.mCalcList->begin(), mGraph.mCalcList->end(), *nodeIt ) != mGraph.mCalcList->end() )
         {
-            (*nodeIt)->calc( mGraph.mPeriod );
+            Market::setCalcOrder( *orderIt );
+            profiler.calcActivity( *nodeIt, *orderIt, mGraph.mPeriod, mGraph.mIsFullCalc );
         }
     }
+    Market::setCalcGrain( -1, 0 );
 }
 
 GcamParallel::TBBFlowGraphBody::TBBFlowGraphBody( const std::set<FlowGraphNodeType>& aNodes,
                                                   const FlowGraph& aTopology,
+                                                  const map<FlowGraphNodeType, int>& aCalcOrderTable,
+                                                  const int aGrain, const vector<bool>& aAncestorGrains,
                                                   const GcamFlowGraph& aGraph )
-:mGraph( aGraph )
+:mGrain( aGrain ), mAncestorGrains( aAncestorGrains ), mGraph( aGraph )
 {
     ILogger& pgLog = ILogger::getLogger( "parallel-grain-log" );
     pgLog.setLevel( ILogger::NOTICE );
@@ -346,6 +384,10 @@ GcamParallel::TBBFlowGraphBody::TBBFlowGraphBody( const std::set<FlowGraphNodeTy
     
     mNodes.insert( mNodes.end(), aNodes.begin(), aNodes.end() );
     mNodes.sort( TopologicalComparator( aTopology ) );
+    for( list<FlowGraphNodeType>::const_iterator it = mNodes.begin(); it != mNodes.end(); ++it ) {
+        map<FlowGraphNodeType, int>::const_iterator orderIt = aCalcOrderTable.find( *it );
+        mCalcOrders.push_back( orderIt != aCalcOrderTable.end() ? orderIt->second : -1 );
+    }
     
     // log some output to allow us to analyze the parallel grain
     // structure (this allows us to see what is in the grains, but not
@@ -59,10 +59,14 @@ class BatchCSVOutputter : public DefaultVisitor {
 public:
     BatchCSVOutputter();
 
+    explicit BatchCSVOutputter( const std::string& aFileName );
+
     ~BatchCSVOutputter();
 
     void writeDidScenarioSolve( bool aDidSolve );
 
+    void appendScenarioResults( const std::string& aFileName );
+
     //! IVisitor methods
     void startVisitScenario( const Scenario* aScenario, const int aPeriod );
 
@@ -51,7 +51,10 @@
 #include "marketplace/include/imarket_type.h"
 #include "climate/include/iclimate_model.h"
 
+#include "util/logger/include/ilogger.h"
+
 #include <string>
+#include <fstream>
 
 #include "reporting/include/batch_csv_outputter.h"
 
@@ -68,6 +71,17 @@ mIsFirstScenario(true)
 {
 }
 
+/*!
+ * \brief Constructor which writes to the given file instead of the configured
+ *        batch CSV file.
+ * \param aFileName The name of the file to write to.
+ */
+BatchCSVOutputter::BatchCSVOutputter( const string& aFileName ):
+mFile( aFileName ),
+mIsFirstScenario(true)
+{
+}
+
 /*!
  * \brief Destructor
  */
@@ -178,3 +192,30 @@ void BatchCSVOutputter::startVisitClimateModel( const IClimateModel* aClimateMod
 void BatchCSVOutputter::writeDidScenarioSolve( bool aDidSolve ) {
     mFile << aDidSolve << endl;
 }
+
+/*!
+ * \brief Append the results written by another BatchCSVOutputter.
+ * \details This is used to merge results from scenarios run in forked worker
+ *          processes. The header line of the given file is only copied if no
+ *          scenario has been written to this file yet.
+ * \param aFileName The name of the file written by the other outputter.
+ */
+void BatchCSVOutputter::appendScenarioResults( const string& aFileName ) {
+    ifstream inFile( aFileName.c_str() );
+    if( !inFile.is_open() ) {
+        ILogger& mainLog = ILogger::getLogger( "main_log" );
+        mainLog.setLevel( ILogger::WARNING );
+        mainLog << "Could not open " << aFileName << " to merge batch results." << endl;
+        return;
+    }
+
+    string line;
+    bool isHeader = true;
+    while( getline( inFile, line ) ) {
+        if( !isHeader || mIsFirstScenario ) {
+            mFile << line << endl;
+        }
+        isHeader = false;
+        mIsFirstScenario = false;
+    }
+}
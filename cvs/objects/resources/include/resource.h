@@ -54,6 +54,7 @@
 
 // Forward declaration.
 class SubResource;
+class CachedMarket;
 
 /*! 
 * \ingroup Objects
@@ -119,6 +120,12 @@ protected:
     //! Vector of object meta info to pass to the market
     object_meta_info_vector_type mObjectMetaInfo;
 
+    //! The market for this resource in the current period, located in initCalc.
+    std::auto_ptr<CachedMarket> mCachedMarket;
+
+    //! The market for this resource in the previous period, located in initCalc.
+    std::auto_ptr<CachedMarket> mCachedPrevMarket;
+
     virtual bool XMLDerivedClassParse( const std::string& aNodeName,
                                        const xercesc::DOMNode* aNode );
     virtual const std::string& getXMLName() const;
@@ -43,11 +43,14 @@
  * \brief UnlimitedResource header file.
  * \author Josh Lurz
  */
+#include <memory>
 #include <xercesc/dom/DOMNode.hpp>
 #include "resources/include/aresource.h"
 #include "util/base/include/value.h"
 #include "util/base/include/time_vector.h"
 
+class CachedMarket;
+
 /*! 
  * \ingroup Objects
  * \brief A class which defines an unlimited quantity fixed price resource.
@@ -130,6 +133,9 @@ protected:
         DEFINE_VARIABLE( SIMPLE | STATE, "supply-wedge", mSupplyWedge, Value)
     )
 
+    //! The market for this resource located in initCalc.
+    std::auto_ptr<CachedMarket> mCachedMarket;
+
     void setMarket( const std::string& aRegionName );
 };
 
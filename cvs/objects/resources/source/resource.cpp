@@ -56,6 +56,7 @@
 #include "containers/include/scenario.h"
 #include "util/base/include/model_time.h"
 #include "marketplace/include/marketplace.h"
+#include "marketplace/include/cached_market.h"
 #include "marketplace/include/imarket_type.h"
 #include "resources/include/renewable_subresource.h"
 #include "resources/include/smooth_renewable_subresource.h"
@@ -321,6 +322,10 @@ void Resource::initCalc( const string& aRegionName, const int aPeriod ) {
     for( unsigned int i = 0; i < mOutputs.size(); i++ ) {
         mOutputs[ i ]->initCalc( aRegionName, mName, aPeriod );
     }
+
+    const Marketplace* marketplace = scenario->getMarketplace();
+    mCachedMarket = marketplace->locateMarket( mName, aRegionName, aPeriod );
+    mCachedPrevMarket = marketplace->locateMarket( mName, aRegionName, aPeriod > 0 ? aPeriod - 1 : aPeriod );
     // setup supply curve boundaries here.
     double minprice = util::getLargeNumber();
     double maxprice = -util::getLargeNumber();
@@ -400,16 +405,14 @@ const string& Resource::getName() const {
 //! Calculate total resource supply for a period.
 void Resource::calcSupply( const string& aRegionName, const GDP* aGDP, const int aPeriod ){
     // This code is moved down from Region
-    Marketplace* marketplace = scenario->getMarketplace();
-
-    double price = marketplace->getPrice( mName, aRegionName, aPeriod );
+    double price = mCachedMarket->getPrice( mName, aRegionName, aPeriod );
     double lastPeriodPrice;
 
     if ( aPeriod == 0 ) {
         lastPeriodPrice = price;
     }
     else {
-        lastPeriodPrice = marketplace->getPrice( mName, aRegionName, aPeriod - 1 );
+        lastPeriodPrice = mCachedPrevMarket->getPrice( mName, aRegionName, aPeriod - 1 );
     }
 
     // Create a dummy input vector for use in GHG calls
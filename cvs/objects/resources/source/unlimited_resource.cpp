@@ -51,6 +51,7 @@
 #include "containers/include/scenario.h"
 #include "util/base/include/model_time.h"
 #include "marketplace/include/marketplace.h"
+#include "marketplace/include/cached_market.h"
 #include "marketplace/include/imarket_type.h"
 #include "containers/include/iinfo.h"
 #include "util/base/include/ivisitor.h"
@@ -189,6 +190,8 @@ void UnlimitedResource::initCalc( const string& aRegionName,
     if( mFixedPrices[ aPeriod ].isInited() ) {
         marketplace->setPrice( mName, aRegionName, mFixedPrices[ aPeriod ], aPeriod );
     }
+
+    mCachedMarket = marketplace->locateMarket( mName, aRegionName, aPeriod );
 }
 
 void UnlimitedResource::postCalc( const string& aRegionName,
@@ -205,14 +208,12 @@ void UnlimitedResource::calcSupply( const string& aRegionName,
                                     const GDP* aGDP,
                                     const int aPeriod )
 {
-    Marketplace* marketplace = scenario->getMarketplace();
-
     // Get the current demand and add the difference between current supply and
     // demand to the market.
-    double currDemand = marketplace->getDemand( mName, aRegionName, aPeriod );
-    double currSupply = marketplace->getSupply( mName, aRegionName, aPeriod );
+    double currDemand = mCachedMarket->getDemand( mName, aRegionName, aPeriod );
+    double currSupply = mCachedMarket->getSupply( mName, aRegionName, aPeriod );
     mSupplyWedge = currDemand - currSupply;
-    marketplace->addToSupply( mName, aRegionName, mSupplyWedge, aPeriod );
+    mCachedMarket->addToSupply( mName, aRegionName, mSupplyWedge, aPeriod );
 }
 
 double UnlimitedResource::getAnnualProd( const string& aRegionName,
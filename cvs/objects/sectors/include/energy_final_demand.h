@@ -53,6 +53,7 @@
 // Forward declarations
 class GDP;
 class Demographic;
+class CachedMarket;
 
 /*! 
  * \ingroup Objects
@@ -207,6 +208,9 @@ protected:
 
     //! Object responsible for consuming final energy.
     std::auto_ptr<FinalEnergyConsumer> mFinalEnergyConsumer;
+
+    //! The market of the demanded service located in initCalc.
+    std::auto_ptr<CachedMarket> mCachedMarket;
     
     virtual double calcFinalDemand( const std::string& aRegionName,
                                     const Demographic* aDemographics,
@@ -113,6 +113,8 @@ public:
 
     virtual std::string getDescription() const;
 
+    virtual std::string getRegionName() const;
+
 private:
     //! A weak reference to the sector that will do the work
     const PassThroughSector* mSector;
@@ -81,6 +81,8 @@ public:
     static double normalizeShares( std::vector<double>& aShares );
     static std::pair<double, double> normalizeLogShares( std::vector<double> & alogShares );
 
+    static std::pair<double, double> normalizeLogShares( double* alogShares, const size_t aCount );
+
     static double calcPriceRatio( const std::string& aRegionName,
                                   const std::string& aSectorName,
                                   const int aBasePeriod,
@@ -45,9 +45,11 @@
 * \author James Blackwood
 */
 #include <string>
+#include <memory>
 #include "sectors/include/sector.h"
 class NationalAccount;
 class IInfo;
+class CachedMarket;
 /*! 
 * \ingroup Objects
 * \brief This class represents a single supply sector.
@@ -57,7 +59,7 @@ class SupplySector: public Sector
 {
 public:
     explicit SupplySector( const std::string& aRegionName );
-    virtual ~SupplySector(){};
+    virtual ~SupplySector();
     static const std::string& getXMLNameStatic();
     
     virtual void completeInit( const IInfo* aRegionInfo,
@@ -97,6 +99,10 @@ protected:
         //! Trial supply market prices
         DEFINE_VARIABLE( ARRAY, "price-trial-supply", mPriceTrialSupplyMarket, objects::PeriodVector<double> )
     )
+
+    //! The market for the good produced by this sector, located in initCalc
+    //! so that it is not looked up by name while solving.
+    std::auto_ptr<CachedMarket> mCachedMarket;
 };
 
 #endif // _SUPPLY_SECTOR_H_
@@ -53,6 +53,7 @@
 #include "containers/include/gdp.h"
 #include "containers/include/iinfo.h"
 #include "marketplace/include/marketplace.h"
+#include "marketplace/include/cached_market.h"
 #include "demographics/include/demographic.h"
 #include "sectors/include/energy_final_demand.h"
 #include "sectors/include/sector_utils.h"
@@ -255,6 +256,7 @@ void EnergyFinalDemand::initCalc( const string& aRegionName,
                                   const Demographic* aDemographics,
                                   const int aPeriod )
 {
+    mCachedMarket = scenario->getMarketplace()->locateMarket( mName, aRegionName, aPeriod );
 }
 
 /*! \brief Set the final demand for service into the marketplace after 
@@ -276,8 +278,7 @@ void EnergyFinalDemand::setFinalDemand( const string& aRegionName,
 {
     calcFinalDemand( aRegionName, aDemographics, aGDP, aPeriod );
     // Set the service demand into the marketplace.
-    Marketplace* marketplace = scenario->getMarketplace();
-    marketplace->addToDemand( mName, aRegionName, mServiceDemands[ aPeriod ], aPeriod );
+    mCachedMarket->addToDemand( mName, aRegionName, mServiceDemands[ aPeriod ], aPeriod );
 }
 
 /*! \brief Set the final demand for service using the aggrgate sector energy service 
@@ -199,3 +199,7 @@ string CalcFixedOutputActivity::getDescription() const {
     return mSector->mRegionName + " " + mSector->getName() + "-fixed-output";
 }
 
+string CalcFixedOutputActivity::getRegionName() const {
+    return mSector->mRegionName;
+}
+
@@ -315,6 +315,9 @@ void Sector::initCalc( NationalAccount* aNationalAccount,
                       const int aPeriod )
 {
     mDiscreteChoiceModel->initCalc( mRegionName, mName, false, aPeriod );
+
+    // Flatten before the subsectors so that they see a complete parent.
+    mSectorInfo->flatten();
     
     // do any sub-Sector initializations
     for ( unsigned int i = 0; i < mSubsectors.size(); ++i ){
@@ -216,15 +216,30 @@ double SectorUtils::calcFixedOutputScaleFactor( const double aMarketDemand,
  *         calculations using these values in a numerically stable way.
  */
 pair<double, double> SectorUtils::normalizeLogShares( vector<double>& alogShares ){
+    return alogShares.empty() ? make_pair( 0.0, 0.0 ) : normalizeLogShares( &alogShares[ 0 ], alogShares.size() );
+}
+
+/*!
+ * \brief Normalize a contiguous array of log shares.
+ * \details Performs the same calculation as the vector version of this method
+ *          on aCount log shares starting at alogShares which allows callers to
+ *          normalize a slice of a larger array in place.
+ * \param alogShares Logs of unnormalized shares on input, normalized shares (not
+ *                   logs) on output.
+ * \param aCount The number of shares.
+ * \return The unnormalized sum of the shares and a log(adjustment factor) that
+ *         has been factored out of the sum.
+ */
+pair<double, double> SectorUtils::normalizeLogShares( double* alogShares, const size_t aCount ){
     // find the log of the largest unnormalized share
-    double lfac = *max_element(alogShares.begin(), alogShares.end());
+    double lfac = *max_element( alogShares, alogShares + aCount );
     double sum = 0.0;
     
     // check for all zero prices
     if( lfac == -numeric_limits<double>::infinity() ) {
         // In this case, set all shares to zero and return.
         // This is arguably wrong, but the rest of the code seems to expect it.
-        for( size_t i = 0; i < alogShares.size(); ++i ) {
+        for( size_t i = 0; i < aCount; ++i ) {
             alogShares[ i ] = 0.0;
         }
         return make_pair( 0.0, 0.0 );
@@ -234,14 +249,14 @@ pair<double, double> SectorUtils::normalizeLogShares( vector<double>& alogShares
     // shares are calculated, it would seem like that can't happen.
 
     // rescale and get normalization sum
-    for( size_t i = 0; i < alogShares.size(); ++i ) {
+    for( size_t i = 0; i < aCount; ++i ) {
         alogShares[ i ] -= lfac;
         sum += exp( alogShares[ i ] );
     }
     double unnormAdjustedSum = sum;
     double norm = log( sum );
     sum = 0.0;                               // double check the normalization
-    for( size_t i = 0; i < alogShares.size(); ++i ) {
+    for( size_t i = 0; i < aCount; ++i ) {
         alogShares[ i ] = exp( alogShares[ i ] - norm );   // divide by norm constant and unlog
         sum += alogShares[ i ];                      // accumulate sum of normalized shares 
                                                      //   (should be 1.0 when we're done.)
@@ -481,7 +496,8 @@ bool SectorUtils::isFinalEnergySector( const string& aRegionName,
     assert( sectorInfo );
 
     // Check the final energy flag.
-    return sectorInfo->getBoolean( "is-final-energy", false );
+    const static objects::Atom* FINAL_ENERGY_KEY = IInfo::getKey( "is-final-energy" );
+    return sectorInfo->getBoolean( FINAL_ENERGY_KEY, false );
 }
 
 /*!
@@ -418,6 +418,8 @@ void Subsector::initCalc( NationalAccount* aNationalAccount,
                           const int aPeriod )
 {
     mDiscreteChoiceModel->initCalc( mRegionName, mName, false, aPeriod );
+
+    mSubsectorInfo->flatten();
     
     // Initialize all technologies.
     for( TechIterator techIter = mTechContainers.begin(); techIter != mTechContainers.end(); ++techIter ) {
@@ -55,6 +55,7 @@
 #include "util/base/include/configuration.h"
 #include "containers/include/iinfo.h"
 #include "sectors/include/sector_utils.h"
+#include "marketplace/include/cached_market.h"
 
 using namespace std;
 using namespace xercesc;
@@ -71,6 +72,10 @@ mPriceTrialSupplyMarket( 0.001 )
 {
 }
 
+//! Destructor
+SupplySector::~SupplySector() {
+}
+
 /*! \brief Get the XML node name for output to XML.
 *
 * This public function accesses the private constant string, XML_NAME.
@@ -185,7 +190,8 @@ void SupplySector::setMarket() {
 }
 
 /*! \brief Initialize the SupplySector.
-* \details Currently only calls the base class initCalc.
+* \details Calls the base class initCalc and locates the market for this
+*          sector for the period.
 * \param aNationalAccount National accounts container.
 * \param aDemographics Regional demographics object.
 * \param aPeriod Period for which to initialize the SupplySector.
@@ -195,6 +201,8 @@ void SupplySector::initCalc( NationalAccount* aNationalAccount,
                             const int aPeriod )
 {
     Sector::initCalc( aNationalAccount, aDemographics, aPeriod );
+
+    mCachedMarket = scenario->getMarketplace()->locateMarket( mName, mRegionName, aPeriod );
 }
 
 /*! \brief returns Sector output.
@@ -246,11 +254,9 @@ void SupplySector::calcFinalSupplyPrice( const GDP* aGDP, const int aPeriod ){
     calcCosts( aPeriod );
 
     // Set the price into the market.
-    Marketplace* marketplace = scenario->getMarketplace();
-
     double avgMarginalPrice = getPrice( aGDP, aPeriod );
 
-    marketplace->setPrice( mName, mRegionName, avgMarginalPrice, aPeriod, true );
+    mCachedMarket->setPrice( mName, mRegionName, avgMarginalPrice, aPeriod, true );
 }
 
 /*! \brief Set supply Sector output
@@ -262,9 +268,8 @@ void SupplySector::calcFinalSupplyPrice( const GDP* aGDP, const int aPeriod ){
 * \param aPeriod Model period
 */
 void SupplySector::supply( const GDP* aGDP, const int aPeriod ) {
-	Marketplace* marketplace = scenario->getMarketplace();
 	// demand for the good produced by this Sector
-	double marketDemand = max( marketplace->getDemand( mName, mRegionName, aPeriod ), 0.0 );
+	double marketDemand = max( mCachedMarket->getDemand( mName, mRegionName, aPeriod ), 0.0 );
 
 	// Determine if fixed output must be scaled because fixed supply
 	// exceeded demand.
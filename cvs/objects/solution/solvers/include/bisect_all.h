@@ -82,11 +82,17 @@ protected:
     //! Max iterations for bracketing
     unsigned int mMaxBracketIterations;
     
+    //! The number of trial values to evaluate at once when bracketing and bisecting,
+    //! a value of one gives the original single trial value per iteration
+    unsigned int mNumCandidates;
+    
     //! A filter which will be used to determine which SolutionInfos this solver component
     //! will work on.
     std::auto_ptr<ISolutionInfoFilter> mSolutionInfoFilter;
     
     bool areAllBracketsEqual( SolutionInfoSet& aSolutionSet ) const;
+    
+    void bisectCandidates( SolutionInfoSet& aSolutionSet, const int aPeriod );
 };
 
 #endif // _BISECT_ALL_H_
@@ -49,6 +49,7 @@
 #include <boost/numeric/ublas/matrix.hpp>
 #include "solution/util/include/solvable_nr_solution_info_filter.h"
 #include "solution/util/include/edfun.hpp"
+#include "solution/util/include/linear_solver.hpp"
 
 #define UBLAS boost::numeric::ublas
 #if USE_LAPACK
@@ -83,13 +84,16 @@ public:
   LogBroyden(Marketplace *mktplc, World *world, CalcCounter *ccounter, int itmax=250,
              double ftol=1.0e-4) :
       SolverComponent(mktplc,world,ccounter), mMaxIter( itmax ), mFTOL( ftol ),
-      mLogPricep( true ) {}
+      mLogPricep( true ), mColoredJacobian( false ), mWarmStartJacobian( false ),
+      mLinesearchTrials( 1 ), mBlockSolve( false ) {}
   virtual ~LogBroyden() {}
 
   // SolverComponent methods
   virtual void init() {
     if(!mSolutionInfoFilter.get())
       mSolutionInfoFilter.reset(new SolvableNRSolutionInfoFilter());
+    if(!mLinearSolver.get())
+      mLinearSolver.reset(LinearSolver::create(LinearSolver::getDefaultName()));
   }
   virtual ReturnCode solve( SolutionInfoSet& aSolutionSet, const int aPeriod );
   virtual const std::string& getXMLName() const {return SOLVER_NAME;}
@@ -107,6 +111,11 @@ protected:
   void reportVec(const std::string &aname, const UBLAS::vector<double> &av, const std::vector<int> &amktids,
                  const std::vector<bool> &aissolvable);
   void reportPSD(UBLAS::vector<double> &arptvec, const std::vector<int> &amktids, const std::vector<bool> &aissolvable);
+  //! Solve the independent blocks of markets in upstream to downstream order.
+  bool solveBlocks(SolutionInfoSet &solnset, int period);
+  //! Solve the independent blocks of one level concurrently.
+  bool solveLevel(SolutionInfoSet &solnset, int period,
+                  const std::vector<std::vector<SolutionInfo> > &aBlocks);
 
   //! Maximum number of main-loop iterations for the root-finding algorithm
   unsigned int mMaxIter;
@@ -125,6 +134,17 @@ protected:
 
   bool mLogPricep;              //<! flag indicating whether we should work in price or log-price
 
+  bool mColoredJacobian;        //<! flag indicating whether to compute Jacobians with structurally independent columns grouped
+
+  bool mWarmStartJacobian;      //<! flag indicating whether to start from, and save to, the JacobianStore
+
+  int mLinesearchTrials;        //<! number of line search step lengths to evaluate at once
+
+  bool mBlockSolve;             //<! flag indicating whether to solve strongly connected blocks of markets separately first
+
+  //! Back-end used to solve B . dx = -F at each iteration
+  std::auto_ptr<LinearSolver> mLinearSolver;
+
   // These next two have to be class variables because we sometimes
   // have multiple logbroyden solvers operating.
   static int mLastPer;                 //<! used to detect when the period has changed, so we can reset mPerIter.
@@ -0,0 +1,124 @@
+#ifndef LOGJFNK_HPP_
+#define LOGJFNK_HPP_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*! 
+* \file logjfnk.hpp
+* \ingroup objects
+* \brief Header file for the Jacobian-free Newton-Krylov solver component
+*/
+#include <string>
+#include <boost/numeric/ublas/vector.hpp>
+#include "solution/util/include/solvable_nr_solution_info_filter.h"
+#include "solution/util/include/edfun.hpp"
+
+#define UBLAS boost::numeric::ublas
+
+class CalcCounter; 
+class Marketplace;
+class World;
+class SolutionInfoSet;
+
+/*! 
+* \ingroup Objects 
+* \brief A SolverComponent based on Newton's method with the Newton
+*        step computed by GMRES, without ever forming the Jacobian.
+* \details GMRES only needs the action of the Jacobian on a vector,
+*          which we get from a directional finite difference of the
+*          excess demand function: J v ~ (F(x + h v) - F(x)) / h.
+*          Each GMRES iteration therefore costs a single model
+*          evaluation, and the linear solve is only carried out as
+*          accurately as the current nonlinear residual warrants
+*          (Eisenstat-Walker forcing terms).  Near a solution this
+*          typically takes far fewer evaluations per step than the
+*          N+1 required for a finite-difference Jacobian.  The step is
+*          globalized with the same backtracking line search used by
+*          the other Newton-type solvers.
+*/
+class LogJFNK: public SolverComponent {
+public:
+    LogJFNK( Marketplace* mktplc, World* world, CalcCounter* ccounter, int itmax=50,
+             double ftol=1.0e-4 ) : SolverComponent(mktplc,world,ccounter),
+                                    mMaxIter(itmax), mFTOL(ftol), mKrylovDim(30),
+                                    mMaxKrylovIter(100), mEtaMax(0.5), mLogPricep(true) {}
+    virtual ~LogJFNK() {}
+    
+    // SolverComponent methods
+    virtual void init() {
+        if(!mSolutionInfoFilter.get())
+            mSolutionInfoFilter.reset(new SolvableNRSolutionInfoFilter());
+    }
+    virtual ReturnCode solve( SolutionInfoSet& aSolutionSet, const int aPeriod );
+    virtual const std::string& getXMLName() const {return SOLVER_NAME;}
+    
+    // IParsable methods
+    virtual bool XMLParse( const xercesc::DOMNode* aNode );
+
+    static const std::string & getXMLNameStatic(void) {return SOLVER_NAME;}
+  
+protected:
+    int jfnksolve(VecFVec<double,double> &F, UBLAS::vector<double> &x,
+                  UBLAS::vector<double> &fx, int &neval);
+
+    //! Max iterations for the Newton algorithm (outer iterations)
+    unsigned int mMaxIter;
+  
+    //! Tolerance for convergence test in root-finding algorithm. 
+    double mFTOL;
+
+    //! Dimension of the Krylov space before GMRES restarts
+    int mKrylovDim;
+
+    //! Maximum number of GMRES iterations (model evaluations) per Newton step
+    int mMaxKrylovIter;
+
+    //! Upper limit on the relative residual required of the Newton step
+    double mEtaMax;
+  
+    //! A filter which will be used to determine which SolutionInfos with solver component
+    //! will work on.
+    std::auto_ptr<ISolutionInfoFilter> mSolutionInfoFilter;
+
+    bool mLogPricep;              //<! flag indicating whether we should work in price or log-price 
+
+private:
+    static std::string SOLVER_NAME;
+};
+
+#undef UBLAS
+
+#endif // LOGJFNK_HPP_
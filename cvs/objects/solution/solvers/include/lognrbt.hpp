@@ -49,6 +49,7 @@
 #include <boost/numeric/ublas/matrix.hpp>
 #include "solution/util/include/solvable_nr_solution_info_filter.h"
 #include "solution/util/include/edfun.hpp"
+#include "solution/util/include/linear_solver.hpp"
 
 #define UBLAS boost::numeric::ublas
 #if USE_LAPACK
@@ -81,13 +82,17 @@ class LogNRbt: public SolverComponent {
 public:
     LogNRbt( Marketplace* mktplc, World* world, CalcCounter* ccounter, int itmax=250,
              double ftol=1.0e-7 ) : SolverComponent(mktplc,world,ccounter),
-                                    mMaxIter(itmax), mFTOL(ftol), mLogPricep(true) {}
+                                    mMaxIter(itmax), mFTOL(ftol), mLogPricep(true),
+                                    mColoredJacobian(false),
+                                    mLinesearchTrials(1) {}
     virtual ~LogNRbt() {}
     
     // SolverComponent methods
     virtual void init() {
         if(!mSolutionInfoFilter.get())
             mSolutionInfoFilter.reset(new SolvableNRSolutionInfoFilter());
+        if(!mLinearSolver.get())
+            mLinearSolver.reset(LinearSolver::create(LinearSolver::getDefaultName()));
     }
     virtual ReturnCode solve( SolutionInfoSet& aSolutionSet, const int aPeriod );
     virtual const std::string& getXMLName() const {return SOLVER_NAME;}
@@ -129,6 +134,13 @@ protected:
 
   bool mLogPricep;              //<! flag indicating whether we should work in price or log-price 
 
+  bool mColoredJacobian;        //<! flag indicating whether to compute Jacobians with structurally independent columns grouped
+
+  int mLinesearchTrials;        //<! number of line search step lengths to evaluate at once
+
+  //! Back-end used to solve J . dx = -F at each iteration
+  std::auto_ptr<LinearSolver> mLinearSolver;
+
 private:
     static std::string SOLVER_NAME;
 };
@@ -40,6 +40,9 @@
 
 #include "util/base/include/definitions.h"
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
 #include <xercesc/dom/DOMNode.hpp>
 #include <xercesc/dom/DOMNodeList.hpp>
 
@@ -67,7 +70,8 @@ using namespace xercesc;
 BisectAll::BisectAll( Marketplace* marketplaceIn, World* worldIn, CalcCounter* calcCounterIn ):SolverComponent( marketplaceIn, worldIn, calcCounterIn ),
 mMaxIterations( 30 ),
 mDefaultBracketInterval( 0.4 ),
-mMaxBracketIterations( 40 )
+mMaxBracketIterations( 40 ),
+mNumCandidates( 1 )
 {
 }
 
@@ -114,6 +118,9 @@ bool BisectAll::XMLParse( const DOMNode* aNode ) {
         else if( nodeName == "max-bracket-iterations" ) {
             mMaxBracketIterations = XMLHelper<unsigned int>::getValue( curr );
         }
+        else if( nodeName == "parallel-candidates" ) {
+            mNumCandidates = max( XMLHelper<unsigned int>::getValue( curr ), 1u );
+        }
         else if( nodeName == "solution-info-filter" ) {
             mSolutionInfoFilter.reset(
                 SolutionInfoFilterFactory::createSolutionInfoFilterFromString( XMLHelper<string>::getValue( curr ) ) );
@@ -170,10 +177,13 @@ SolverComponent::ReturnCode BisectAll::solve( SolutionInfoSet& aSolutionSet, con
     
     // need to do bracketing first, does this need to be before or after startMethod?
     aSolutionSet.resetBrackets();
-    solverLog << "Solution set before Bracket: " << endl << aSolutionSet << endl;
+    // Skip printing the solution set when the solver log would discard it.
+    if( solverLog.wouldPrint( ILogger::NOTICE ) ){
+        solverLog << "Solution set before Bracket: " << endl << aSolutionSet << endl;
+    }
     // Currently attempts to bracket but does not necessarily bracket all markets.
     SolverLibrary::bracket( marketplace, world, mDefaultBracketInterval, mMaxBracketIterations,
-                            aSolutionSet, calcCounter, mSolutionInfoFilter.get(), aPeriod );
+                            aSolutionSet, calcCounter, mSolutionInfoFilter.get(), aPeriod, mNumCandidates );
     
     startMethod();
     ReturnCode code = ORIGINAL_STATE; // code that reports success 1 or failure 0
@@ -197,28 +207,37 @@ SolverComponent::ReturnCode BisectAll::solve( SolutionInfoSet& aSolutionSet, con
     do {
         solverLog.setLevel( ILogger::NOTICE );
         solverLog << "BisectionAll " << numIterations << endl;
-        aSolutionSet.printMarketInfo( "Bisect All", calcCounter->getPeriodCount(), singleLog );
+        if( singleLog.wouldPrint( ILogger::DEBUG ) ){
+            aSolutionSet.printMarketInfo( "Bisect All", calcCounter->getPeriodCount(), singleLog );
+        }
 
-        // Since bisection is called after bracketing, the current price and ED will be the
-        // one of the brackets.
-        // Start bisection with mid-point to improve efficiency.
-        for ( unsigned int i = 0; i < aSolutionSet.getNumSolvable(); ++i ) {
-            SolutionInfo& currSol = aSolutionSet.getSolvable( i );
-            // Skip markets that were not bracketed
-            if( !currSol.isBracketed() ) {
-                continue;
+        // When evaluating several trial values at once the brackets are narrowed
+        // by the candidates and X is set to the best of them.
+        if( mNumCandidates > 1 ) {
+            bisectCandidates( aSolutionSet, aPeriod );
+        }
+        else {
+            // Since bisection is called after bracketing, the current price and ED will be the
+            // one of the brackets.
+            // Start bisection with mid-point to improve efficiency.
+            for ( unsigned int i = 0; i < aSolutionSet.getNumSolvable(); ++i ) {
+                SolutionInfo& currSol = aSolutionSet.getSolvable( i );
+                // Skip markets that were not bracketed
+                if( !currSol.isBracketed() ) {
+                    continue;
+                }
+                // If not solved.
+                if ( !currSol.isWithinTolerance() ) {
+                    // Set new trial value to center
+                    currSol.setPriceToCenter();
+                }   
+                // price=0 and supply>demand is true only for constraint case.
+                // Other markets cannot have supply>demand as price->0.
+                // Another condition that should be moved.
+                if ( fabs( currSol.getPrice() ) < util::getSmallNumber() && currSol.getED() < 0 ) { 
+                    currSol.setPrice( 0 ); 
+                } 
             }
-            // If not solved.
-            if ( !currSol.isWithinTolerance() ) {
-                // Set new trial value to center
-                currSol.setPriceToCenter();
-            }   
-            // price=0 and supply>demand is true only for constraint case.
-            // Other markets cannot have supply>demand as price->0.
-            // Another condition that should be moved.
-            if ( fabs( currSol.getPrice() ) < util::getSmallNumber() && currSol.getED() < 0 ) { 
-                currSol.setPrice( 0 ); 
-            } 
         }
 
         marketplace->nullSuppliesAndDemands( aPeriod );
@@ -230,23 +249,29 @@ SolverComponent::ReturnCode BisectAll::solve( SolutionInfoSet& aSolutionSet, con
         aSolutionSet.updateSolvable( mSolutionInfoFilter.get() );
 
         // Print solution set information to solver log.
-        solverLog << aSolutionSet << endl;
+        if( solverLog.wouldPrint( ILogger::NOTICE ) ){
+            solverLog << aSolutionSet << endl;
+        }
 
-        // Move brackets, both price and ED, after solving mid-point.  This ensures that
-        // both price and ED for each bracket is valid and up to date.
-        for ( unsigned int i = 0; i < aSolutionSet.getNumSolvable(); ++i ) {
-            SolutionInfo& currSol = aSolutionSet.getSolvable( i );
-            // If not solved.
-            if ( !currSol.isWithinTolerance() && currSol.isBracketed() ) {
-                // Move the right price bracket in if Supply > Demand
-                if ( currSol.getED() < 0 ) {
-                    currSol.moveRightBracketToX();
-                }
-                // Move the left price bracket in if Demand >= Supply
-                else {
-                    currSol.moveLeftBracketToX();
-                }
-            }   
+        // The candidates have already narrowed the brackets and X may lie outside
+        // of them.
+        if( mNumCandidates == 1 ) {
+            // Move brackets, both price and ED, after solving mid-point.  This ensures that
+            // both price and ED for each bracket is valid and up to date.
+            for ( unsigned int i = 0; i < aSolutionSet.getNumSolvable(); ++i ) {
+                SolutionInfo& currSol = aSolutionSet.getSolvable( i );
+                // If not solved.
+                if ( !currSol.isWithinTolerance() && currSol.isBracketed() ) {
+                    // Move the right price bracket in if Supply > Demand
+                    if ( currSol.getED() < 0 ) {
+                        currSol.moveRightBracketToX();
+                    }
+                    // Move the left price bracket in if Demand >= Supply
+                    else {
+                        currSol.moveLeftBracketToX();
+                    }
+                }   
+            }
         }
 
         if( aSolutionSet.getNumSolvable() > 0 ) {
@@ -296,3 +321,70 @@ bool BisectAll::areAllBracketsEqual( SolutionInfoSet& aSolutionSet ) const {
 	}
 	return true;
 }
+
+/*!
+ * \brief Split the bracket of each unsolved market at several points at once and
+ *        narrow the brackets to the sub-interval containing the solution.
+ * \details Candidate k places every bracketed and unsolved market at ( k + 1 ) /
+ *          ( mNumCandidates + 1 ) of the way between its left and right bracket.
+ *          The candidates are evaluated concurrently on separate state slots by
+ *          SolverLibrary::evaluateCandidates.  Each market then moves its brackets
+ *          in to the adjacent candidates between which its ED changes sign and X
+ *          is set to the candidate with the smallest maximum relative ED.  The
+ *          caller is responsible for calculating the model at the new X.
+ * \param aSolutionSet The solution set.
+ * \param aPeriod Model period.
+ */
+void BisectAll::bisectCandidates( SolutionInfoSet& aSolutionSet, const int aPeriod ) {
+    const unsigned int numSolvable = aSolutionSet.getNumSolvable();
+    vector<bool> isBisecting( numSolvable, false );
+    vector<vector<double> > candidatePrices( mNumCandidates, vector<double>( numSolvable ) );
+    for ( unsigned int i = 0; i < numSolvable; ++i ) {
+        SolutionInfo& currSol = aSolutionSet.getSolvable( i );
+        isBisecting[ i ] = currSol.isBracketed() && !currSol.isWithinTolerance();
+        for( unsigned int k = 0; k < mNumCandidates; ++k ) {
+            double price = currSol.getPrice();
+            if( isBisecting[ i ] ) {
+                const double fraction = static_cast<double>( k + 1 ) / ( mNumCandidates + 1 );
+                price = currSol.getXLeft() + fraction * ( currSol.getXRight() - currSol.getXLeft() );
+            }
+            // price=0 and supply>demand is true only for constraint case.
+            if ( fabs( price ) < util::getSmallNumber() && currSol.getED() < 0 ) {
+                price = 0;
+            }
+            candidatePrices[ k ][ i ] = price;
+        }
+    }
+
+    vector<vector<double> > candidateED;
+    vector<double> candidateMaxRelED;
+    SolverLibrary::evaluateCandidates( marketplace, world, aSolutionSet, candidatePrices, candidateED,
+                                       candidateMaxRelED, aPeriod );
+
+    // Candidates are ordered from the left bracket to the right so each market
+    // keeps moving its left bracket in until it finds Supply > Demand.
+    for ( unsigned int i = 0; i < numSolvable; ++i ) {
+        if( !isBisecting[ i ] ) {
+            continue;
+        }
+        SolutionInfo& currSol = aSolutionSet.getSolvable( i );
+        for( unsigned int k = 0; k < mNumCandidates; ++k ) {
+            if( candidateED[ k ][ i ] < 0 ) {
+                currSol.setRightBracket( candidatePrices[ k ][ i ], candidateED[ k ][ i ] );
+                break;
+            }
+            currSol.setLeftBracket( candidatePrices[ k ][ i ], candidateED[ k ][ i ] );
+        }
+    }
+
+    const unsigned int bestCandidate = static_cast<unsigned int>(
+        min_element( candidateMaxRelED.begin(), candidateMaxRelED.end() ) - candidateMaxRelED.begin() );
+    for ( unsigned int i = 0; i < numSolvable; ++i ) {
+        aSolutionSet.getSolvable( i ).setPrice( candidatePrices[ bestCandidate ][ i ] );
+    }
+
+    ILogger& solverLog = ILogger::getLogger( "solver_log" );
+    solverLog.setLevel( ILogger::DEBUG );
+    solverLog << "Bisect candidate " << bestCandidate + 1 << " of " << mNumCandidates
+              << " selected with max relative ED " << candidateMaxRelED[ bestCandidate ] << endl;
+}
@@ -42,7 +42,11 @@
 #include <string>
 #include <algorithm>
 #include <iomanip>
+#include <sstream>
+#include <map>
+#include <set>
 #include <math.h>
+#include <boost/shared_ptr.hpp>
 #include <xercesc/dom/DOMNode.hpp>
 #include <xercesc/dom/DOMNodeList.hpp>
 
@@ -51,6 +55,9 @@
 #include "solution/util/include/calc_counter.h"
 #include "marketplace/include/marketplace.h"
 #include "containers/include/world.h"
+#include "containers/include/scenario.h"
+#include "containers/include/market_dependency_finder.h"
+#include "util/base/include/manage_state_variables.hpp"
 #include "solution/util/include/solution_info_set.h"
 #include "solution/util/include/solution_info.h"
 #include "solution/util/include/solver_library.h"
@@ -68,22 +75,22 @@
 #include "solution/util/include/ublas-helpers.hpp"
 #include "util/base/include/fltcmp.hpp"
 #include "solution/util/include/jacobian-precondition.hpp"
+#include "solution/util/include/jacobian_store.hpp"
+#include "solution/util/include/jacobian-blocks.hpp"
 
-#if USE_LAPACK
-#include <boost/numeric/bindings/traits/ublas_vector.hpp>
-#include <boost/numeric/bindings/traits/ublas_matrix.hpp>
-#include <boost/numeric/ublas/operation.hpp>
-#include <boost/numeric/bindings/lapack/gesvd.hpp>
-#include "solution/util/include/svd_invert_solve.hpp"
-#else
 #include <boost/numeric/ublas/operation.hpp>
-#include <boost/numeric/ublas/lu.hpp>
-#endif 
 
 #include "util/base/include/timer.h"
 
+#if GCAM_PARALLEL_ENABLED
+#include <tbb/task_group.h>
+#include <tbb/parallel_for.h>
+#endif
+
 using namespace xercesc;
 
+extern Scenario* scenario;
+
 std::string LogBroyden::SOLVER_NAME = "broyden-solver-component";
 
 #if USE_LAPACK
@@ -105,6 +112,109 @@ namespace {
   // read-only accessor for solutionInfoSet (used to prepare log outputs)
   const SolutionInfoSet *cSolInfo=0;
 
+  // Filter accepting only the markets in one level of the block
+  // decomposition.  These are created internally, never from input.
+  class BlockSolutionInfoFilter : public ISolutionInfoFilter {
+  public:
+    BlockSolutionInfoFilter(const std::vector<SolutionInfo> &amkts) : mMkts(amkts) {}
+    virtual bool XMLParse(const DOMNode* aNode) {return false;}
+    virtual bool acceptSolutionInfo(const SolutionInfo &aSolutionInfo) const {
+      return std::find(mMkts.begin(), mMkts.end(), aSolutionInfo) != mMkts.end();
+    }
+  private:
+    std::vector<SolutionInfo> mMkts;
+  };
+
+  // Solve F(x) = 0 for one block of markets by Broyden's method using
+  // only F.trial(), which leaves the base state alone, so that independent
+  // blocks can be solved at the same time on separate state slots.  Each
+  // trial only recalculates the activities that depend on the block's
+  // prices, so the dense Jacobian of a small block is cheap.  The
+  // Jacobian is computed by finite differences at the start and again
+  // whenever the Broyden update stops making progress.  Returns 0 on
+  // success, -1 if the iteration limit was reached, and a positive value if
+  // the Jacobian was singular or no step along the Newton direction
+  // reduced |F|.
+  int trialBroyden(LogEDFun &F, LinearSolver &aSolver, UBVECTOR &x, UBVECTOR &fx,
+                   double aFTOL, unsigned int aMaxIter, int &neval, std::ostream &aLog)
+  {
+    const size_t n = x.size();
+    const double heps = 1.0e-6;
+    const double lseps = 1.0e-4;
+    const double lmin = 1.0e-4;
+    const double TINY = util::getTinyNumber();
+    UBMATRIX B(n, n);
+    UBVECTOR xnew(n), fxnew(n);
+    bool recalcB = true;
+    bool freshB = false;
+
+    F.trial(x, fx);
+    ++neval;
+    for(unsigned int iter=0; iter<aMaxIter; ++iter) {
+      if(boost::numeric::ublas::norm_inf(fx) <= aFTOL) {
+        return 0;
+      }
+      if(recalcB) {
+        for(size_t j=0; j<n; ++j) {
+          xnew = x;
+          const double h = heps * (fabs(x[j]) + TINY);
+          xnew[j] += h;
+          F.trial(xnew, fxnew);
+          ++neval;
+          boost::numeric::ublas::column(B, j) = (fxnew - fx) / h;
+        }
+        aSolver.analyze(B);
+        recalcB = false;
+        freshB = true;
+      }
+
+      UBVECTOR dx(-fx);
+      int fail = aSolver.factorize(B);
+      if(!fail && aSolver.solve(dx, aLog) < 0) {
+        dx = -fx;
+        fail = LinearSolver::solveDirect(B, dx, aLog);
+      }
+      if(fail) {
+        aLog << "\tSingular Jacobian at iteration " << iter << " (row " << fail-1 << ").\n";
+        if(freshB) {
+          return fail;
+        }
+        recalcB = true;
+        continue;
+      }
+
+      // backtrack until |F|^2 decreases sufficiently
+      const double f0 = boost::numeric::ublas::inner_prod(fx, fx);
+      double lambda = 1.0;
+      bool accepted = false;
+      for(; lambda >= lmin; lambda *= 0.5) {
+        xnew = x + lambda*dx;
+        F.trial(xnew, fxnew);
+        ++neval;
+        if(boost::numeric::ublas::inner_prod(fxnew, fxnew) <= (1.0 - lseps*lambda) * f0) {
+          accepted = true;
+          break;
+        }
+      }
+      if(!accepted) {
+        aLog << "\tLine search failed at iteration " << iter << ".\n";
+        if(freshB) {
+          return static_cast<int>(n) + 1;
+        }
+        recalcB = true;
+        continue;
+      }
+
+      UBVECTOR xstep(xnew - x);
+      UBVECTOR fxstep(fxnew - fx);
+      x = xnew;
+      fx = fxnew;
+      aSolver.update(B, fxstep, xstep);
+      freshB = false;
+    }
+    return boost::numeric::ublas::norm_inf(fx) <= aFTOL ? 0 : -1;
+  }
+
   // utility function for finding the minimimum and maximum absolute
   // value entries in a vector.
   void locate_vector_minmax(const UBVECTOR &v, double &vmax, double &vmin, int &imax, int &imin)
@@ -159,6 +269,29 @@ bool LogBroyden::XMLParse( const DOMNode* aNode ) {
         else if(nodeName == "log-price") {
           mLogPricep = true;    // not strictly necessary, as this is the default.
         }
+        else if(nodeName == "colored-jacobian") {
+          mColoredJacobian = true;
+        }
+        else if(nodeName == "warm-start-jacobian") {
+          mWarmStartJacobian = true;
+          JacobianStore::getInstance().enable();
+        }
+        else if(nodeName == "block-solve") {
+          mBlockSolve = true;
+        }
+        else if(nodeName == "linesearch-trials") {
+          mLinesearchTrials = std::max(XMLHelper<int>::getValue( curr ), 1);
+        }
+        else if(nodeName == "linear-solver") {
+          mLinearSolver.reset(LinearSolver::create(curr));
+          if(!mLinearSolver.get()) {
+            ILogger& mainLog = ILogger::getLogger( "main_log" );
+            mainLog.setLevel( ILogger::WARNING );
+            mainLog << "Unknown linear solver " << XMLHelper<std::string>::getValue( curr )
+                    << " in " << getXMLName() << ".  Using " << LinearSolver::getDefaultName()
+                    << "." << std::endl;
+          }
+        }
         else if( SolutionInfoFilterFactory::hasSolutionInfoFilter( nodeName ) ) {
             mSolutionInfoFilter.reset( SolutionInfoFilterFactory::createAndParseSolutionInfoFilter( nodeName, curr ) );
         }
@@ -196,6 +329,10 @@ bool LogBroyden::XMLParse( const DOMNode* aNode ) {
  *
  * The solver can run in either log-log mode or linear-linear mode.
  *
+ * With block-solve set, the markets are first split into blocks which
+ * are solved upstream to downstream (see solveBlocks()).  Whatever is
+ * left unsolved after that is solved all together as usual.
+ *
  * \author Robert Link 
  * \param solnset An initial set of SolutionInfo objects representing all of the markets we will attempt to solve
  * \param period Model time period
@@ -208,6 +345,10 @@ SolverComponent::ReturnCode LogBroyden::solve(SolutionInfoSet &solnset, int peri
     if( solnset.isAllSolved() ){
         return code = SolverComponent::SUCCESS;
     }
+
+    if( mBlockSolve && solveBlocks( solnset, period ) ) {
+        return code = SolverComponent::SUCCESS;
+    }
     
     startMethod();
     if(period != mLastPer) {
@@ -270,6 +411,12 @@ SolverComponent::ReturnCode LogBroyden::solve(SolutionInfoSet &solnset, int peri
     
     // This is the closure that will evaluate the ED function
     LogEDFun F(solnset, world, marketplace, period, mLogPricep); 
+    F.setColoredJacobian(mColoredJacobian);
+    // Sparse linear solvers take their pattern from the Jacobian structure
+    // once, rather than scanning every freshly computed Jacobian.
+    if(mLinearSolver->needsStructure() && F.jacobianColumnRows()) {
+      mLinearSolver->setStructure(*F.jacobianColumnRows());
+    }
     // check the assumptions:  narg==nrtn==nsolv
     if(F.narg() != nsolv || F.nrtn() != nsolv) {
       solverLog.setLevel(ILogger::SEVERE);
@@ -288,12 +435,29 @@ SolverComponent::ReturnCode LogBroyden::solve(SolutionInfoSet &solnset, int peri
 
     solverLog.setLevel(ILogger::DEBUG);
     solverLog << "Initial guess:\n" << x << "\nInitial F( x ):\n" << fx << "\n";
-    solnset.printMarketInfo("Broyden-initial", calcCounter->getPeriodCount(), singleLog);
+    if(singleLog.wouldPrint(ILogger::DEBUG)) {
+      solnset.printMarketInfo("Broyden-initial", calcCounter->getPeriodCount(), singleLog);
+    }
 
     // Precondition the x values to avoid singular columns in the Jacobian
     solverLog.setLevel(ILogger::DEBUG);
     UBMATRIX J(F.narg(), F.nrtn());
-    fdjac(F, x, fx, J, true);
+    std::vector<std::string> mktnames(smkts.size());
+    for(size_t i=0; i<smkts.size(); ++i) {
+      mktnames[i] = smkts[i].getName();
+    }
+    std::vector<int> newcols;
+    if(mWarmStartJacobian &&
+       JacobianStore::getInstance().retrieve(period, mLogPricep, mktnames, F.getInputScale(),
+                                             F.getOutputScale(), J, newcols)) {
+      // Start from the stored Jacobian and only compute the columns
+      // for markets it did not have.
+      solverLog << "Warm start from stored Jacobian; computing " << newcols.size() << " new columns.\n";
+      fdjac_cols(F, x, fx, newcols, J);
+    }
+    else {
+      fdjac(F, x, fx, J, true);
+    }
 
     solverLog << ">>>> Main loop jacobian called.\n";
     int pcfail = jacobian_precondition(x, fx, J, F, &solverLog, mLogPricep);
@@ -306,13 +470,21 @@ SolverComponent::ReturnCode LogBroyden::solve(SolutionInfoSet &solnset, int peri
     else {
       solverLog << "Revised guess:\n" << x << "\nRevised F( x ):\n" << fx << "\n";
     }
-    solnset.printMarketInfo("Broyden-preconditioned", calcCounter->getPeriodCount(), singleLog);
+    if(singleLog.wouldPrint(ILogger::DEBUG)) {
+      solnset.printMarketInfo("Broyden-preconditioned", calcCounter->getPeriodCount(), singleLog);
+    }
     cSolInfo = &solnset;        // make available for log outputs
 
     // call the solver
     int bstatus = bsolve(F, x, fx, J, neval);
     mPerIter++;                 // increment the iteration count.  This should produce a visible gap in the trace plots.
 
+    if(mWarmStartJacobian && bstatus == 0) {
+      // save the final Jacobian to start the next solution from
+      JacobianStore::getInstance().store(period, mLogPricep, mktnames, F.getInputScale(),
+                                         F.getOutputScale(), J, F.jacobianPattern());
+    }
+
     solverTimer.stop(); 
 
     solverLog.setLevel(ILogger::NOTICE);
@@ -360,33 +532,254 @@ SolverComponent::ReturnCode LogBroyden::solve(SolutionInfoSet &solnset, int peri
       worstMarketLog << "###Broyden-end-linearPrice:  " << *maxred << std::endl;
     }
 
-    solnset.printMarketInfo("Broyden-end ", calcCounter->getPeriodCount(), singleLog);
+    if(singleLog.wouldPrint(ILogger::DEBUG)) {
+      solnset.printMarketInfo("Broyden-end ", calcCounter->getPeriodCount(), singleLog);
+    }
     singleLog << std::endl;
 
     return code;
 }
 
+/*!
+ * \brief Solve the markets one level of blocks at a time.
+ * \details A change in the price of market j can only change the excess
+ *          demand of market i if one of the activities recalculated for j
+ *          sets the supply or demand of i, which the MarketDependencyFinder
+ *          tells us (see MarketDependencyFinder::getMarketSetters()).  For
+ *          markets it does not know the setters of, such as policy markets,
+ *          we take them to be set by the activities which use their price.
+ *          The strongly connected components of this directed graph are blocks
+ *          of markets that must be solved together, and a block does not depend
+ *          on the prices of any block downstream of it.  We solve each level of
+ *          the condensation, starting upstream, with the other prices held
+ *          fixed.  The blocks within a level are independent, so they are
+ *          solved at the same time (see solveLevel()).  The time taken is kept
+ *          in the "block-solve" timer for comparison with the unblocked solve.
+ * \param solnset The solution set; its solvable set is restored on return.
+ * \param period Model time period
+ * \return Whether all of the markets were solved.
+ */
+bool LogBroyden::solveBlocks(SolutionInfoSet &solnset, int period)
+{
+    solnset.updateSolvable( mSolutionInfoFilter.get() );
+    ILogger& solverLog = ILogger::getLogger( "solver_log" );
+    solverLog.setLevel( ILogger::NOTICE );
+    if( solnset.getNumSolvable() < 2 ) {
+        return false;
+    }
+
+    // Find which solvable markets each activity sets.
+    std::vector<SolutionInfo> solvables = solnset.getSolvableSet();
+    std::vector<std::vector<IActivity*> > marketSetters;
+    marketplace->getDependencyFinder()->getMarketSetters( marketSetters );
+    std::map<IActivity*, std::vector<int> > setMarkets;
+    for(size_t i=0; i<solvables.size(); ++i) {
+        const int mrkt = solvables[i].getSerialNumber();
+        const std::vector<IActivity*> &setters =
+            mrkt < static_cast<int>( marketSetters.size() ) && !marketSetters[mrkt].empty() ?
+            marketSetters[mrkt] : solvables[i].getDependencies();
+        for(size_t k=0; k<setters.size(); ++k) {
+            setMarkets[setters[k]].push_back(i);
+        }
+    }
+
+    // The markets whose excess demand may change with each price
+    std::vector<std::vector<int> > colRows(solvables.size());
+    for(size_t j=0; j<solvables.size(); ++j) {
+        std::set<int> rows;
+        rows.insert(j);
+        const std::vector<IActivity*> &deps = solvables[j].getDependencies();
+        for(size_t k=0; k<deps.size(); ++k) {
+            std::map<IActivity*, std::vector<int> >::const_iterator it = setMarkets.find(deps[k]);
+            if(it != setMarkets.end()) {
+                rows.insert(it->second.begin(), it->second.end());
+            }
+        }
+        colRows[j].assign(rows.begin(), rows.end());
+    }
+
+    std::vector<std::vector<int> > blocks;
+    std::vector<std::vector<int> > levels;
+    findJacobianBlocks(colRows, blocks, levels);
+    solverLog << "Block decomposition: " << solnset.getNumSolvable() << " markets in "
+              << blocks.size() << " blocks and " << levels.size() << " levels.\n";
+    if(blocks.size() < 2) {
+        // nothing to gain from solving the blocks separately
+        return false;
+    }
+
+    Timer& blockTimer = TimerRegistry::getInstance().getTimer( "block-solve" );
+    blockTimer.start();
+
+    // The blocks are solved with partial calcs from the base state, so it
+    // must first be consistent with the current prices.  Each level leaves
+    // it that way for the next.
+    {
+        LogEDFun F(solnset, world, marketplace, period, mLogPricep);
+        UBVECTOR x(solvables.size()), fx(solvables.size());
+        std::transform(solvables.begin(), solvables.end(), x.begin(),
+                       mLogPricep ? SI2lgprice : SI2price);
+        F.scaleInitInputs(x);
+        F(x, fx);
+    }
+
+    // A level with a single block is handed to this solver as its solvable
+    // set.  The original filter is held aside and restored when we are done.
+    std::auto_ptr<ISolutionInfoFilter> fullFilter( mSolutionInfoFilter );
+    mBlockSolve = false;
+    for(size_t l=0; l<levels.size(); ++l) {
+        std::vector<std::vector<SolutionInfo> > levelBlocks(levels[l].size());
+        size_t nmkt = 0;
+        for(size_t b=0; b<levels[l].size(); ++b) {
+            const std::vector<int> &block = blocks[levels[l][b]];
+            for(size_t k=0; k<block.size(); ++k) {
+                levelBlocks[b].push_back(solvables[block[k]]);
+            }
+            nmkt += block.size();
+        }
+        bool levelSolved;
+        if(levelBlocks.size() == 1) {
+            mSolutionInfoFilter.reset( new BlockSolutionInfoFilter( levelBlocks[0] ) );
+            levelSolved = solve( solnset, period ) == SUCCESS;
+        }
+        else {
+            levelSolved = solveLevel( solnset, period, levelBlocks );
+        }
+        solverLog.setLevel( ILogger::NOTICE );
+        solverLog << "Level " << l << " (" << levelBlocks.size() << " blocks, " << nmkt
+                  << " markets) " << ( levelSolved ? "solved." : "not solved." ) << std::endl;
+    }
+    mBlockSolve = true;
+    mSolutionInfoFilter = fullFilter;
+    solnset.updateSolvable( mSolutionInfoFilter.get() );
+
+    blockTimer.stop();
+    solverLog << "Block solve finished in " << blockTimer.getTotalTimeDifference() << " s total.\n";
+
+    return solnset.isAllSolved();
+}
+
+/*!
+ * \brief Solve the independent blocks of one level at the same time.
+ * \details Each block is solved by Broyden's method using trial evaluations
+ *          (see LogEDFun::trial()), which run on the scratch state slot of the
+ *          thread doing the work and only ever add their differences to the
+ *          base state.  Since no block depends on the prices of another in the
+ *          same level, each block sees the base prices for the others, and
+ *          the blocks can be spread over the thread pool.  Once they are all
+ *          done their solutions are set together by recalculating only the
+ *          activities downstream of the level's prices and keeping that state
+ *          as the base state (see ManageStateVariables::acceptState()).
+ *          Without GCAM_PARALLEL_ENABLED the blocks are solved one after the
+ *          other in the same way.
+ * \param solnset The solution set; its solvable set is left as the level.
+ * \param period Model time period
+ * \param aBlocks The markets in each block.
+ * \return Whether the markets in the level were solved.
+ */
+bool LogBroyden::solveLevel(SolutionInfoSet &solnset, int period,
+                            const std::vector<std::vector<SolutionInfo> > &aBlocks)
+{
+    ILogger& solverLog = ILogger::getLogger( "solver_log" );
+    const size_t nblock = aBlocks.size();
+
+    // Set up each block as its own problem.  LogEDFun takes its markets from
+    // the solvable set, so the filter is changed for each one in turn.
+    std::vector<boost::shared_ptr<LogEDFun> > blockF(nblock);
+    std::vector<boost::shared_ptr<LinearSolver> > blockSolver(nblock);
+    std::vector<std::vector<SolutionInfo> > blockMkts(nblock);
+    std::vector<UBVECTOR> blockX(nblock);
+    std::vector<UBVECTOR> blockFX(nblock);
+    std::vector<SolutionInfo> levelMkts;
+    for(size_t b=0; b<nblock; ++b) {
+        BlockSolutionInfoFilter blockFilter( aBlocks[b] );
+        solnset.updateSolvable( &blockFilter );
+        blockMkts[b] = solnset.getSolvableSet();
+        levelMkts.insert(levelMkts.end(), blockMkts[b].begin(), blockMkts[b].end());
+        blockF[b].reset( new LogEDFun(solnset, world, marketplace, period, mLogPricep) );
+        blockSolver[b].reset( LinearSolver::create( mLinearSolver->getName() ) );
+        if(blockSolver[b]->needsStructure()) {
+            blockSolver[b]->setStructure( blockF[b]->jacobianPattern() );
+        }
+        blockX[b].resize(blockMkts[b].size());
+        blockFX[b].resize(blockMkts[b].size());
+        std::transform(blockMkts[b].begin(), blockMkts[b].end(), blockX[b].begin(),
+                       mLogPricep ? SI2lgprice : SI2price);
+        blockF[b]->scaleInitInputs(blockX[b]);
+    }
+
+    mSolutionInfoFilter.reset( new BlockSolutionInfoFilter( levelMkts ) );
+    solnset.updateSolvable( mSolutionInfoFilter.get() );
+    std::vector<SolutionInfo> levelSolvables = solnset.getSolvableSet();
+    LogEDFun F(solnset, world, marketplace, period, mLogPricep);
+    UBVECTOR x(levelSolvables.size()), fx(levelSolvables.size());
+
+    std::vector<int> status(nblock, 0);
+    std::vector<int> neval(nblock, 0);
+    std::vector<std::string> blockLog(nblock);
+    auto solveBlock = [&](size_t b) {
+        std::ostringstream log;
+        status[b] = trialBroyden(*blockF[b], *blockSolver[b], blockX[b], blockFX[b],
+                                 mFTOL, mMaxIter, neval[b], log);
+        blockLog[b] = log.str();
+    };
+    scenario->getManageStateVariables()->setPartialDeriv(true);
+#if GCAM_PARALLEL_ENABLED
+    tbb::task_arena& threadPool = scenario->getManageStateVariables()->mThreadPool;
+    tbb::task_group tg;
+    threadPool.execute([&](){
+        tg.run([&](){
+            tbb::parallel_for(size_t(0), nblock, solveBlock);
+        });
+    });
+    threadPool.execute([&tg](){ tg.wait(); });
+#else
+    for(size_t b=0; b<nblock; ++b) {
+        solveBlock(b);
+    }
+#endif
+
+    // Set the solutions of all of the blocks together.  Only the activities
+    // downstream of the level's prices are recalculated, on a scratch state
+    // which then replaces the base state.
+    std::vector<double> levelInputs;
+    for(size_t b=0; b<nblock; ++b) {
+        for(size_t k=0; k<blockMkts[b].size(); ++k) {
+            levelInputs.push_back(blockX[b][k] * blockF[b]->getInputScale()[k]);
+        }
+    }
+    for(size_t i=0; i<levelSolvables.size(); ++i) {
+        const size_t k = std::find(levelMkts.begin(), levelMkts.end(), levelSolvables[i]) - levelMkts.begin();
+        x[i] = levelInputs[k] / F.getInputScale()[i];
+    }
+    auto commitLevel = [&]() {
+        F.trial(x, fx);
+        scenario->getManageStateVariables()->acceptState();
+    };
+#if GCAM_PARALLEL_ENABLED
+    threadPool.execute(commitLevel);
+#else
+    commitLevel();
+#endif
+    F.partial(-1);
+
+    solverLog.setLevel( ILogger::NOTICE );
+    for(size_t b=0; b<nblock; ++b) {
+        solverLog << blockLog[b] << "\tBlock " << b << " (" << blockMkts[b].size() << " markets):  neval= "
+                  << neval[b] << "  " << ( status[b] == 0 ? "solved." : status[b] < 0 ?
+                                           "iteration max reached." : "failed." ) << "\n";
+    }
+    return boost::numeric::ublas::norm_inf(fx) <= mFTOL;
+}
+
 int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
                        UBMATRIX & B, int &neval)
 {
-#if !USE_LAPACK
-  using boost::numeric::ublas::permutation_matrix;
-  using boost::numeric::ublas::lu_factorize;
-  using boost::numeric::ublas::lu_substitute;
-#endif
   using boost::numeric::ublas::axpy_prod;
   using boost::numeric::ublas::inner_prod;
-  int nrow = B.size1(), ncol = B.size2();
+  int nrow = B.size1();
   int ageB = 0;   // number of iterations since the last reset on B
-  // svd decomposition elements (note nrow == ncol)
-#if USE_LAPACK
-  UBMATRIX Usv(nrow,ncol),VTsv(ncol,ncol);
-  UBVECTOR Ssv( ncol );
-#else
-  permutation_matrix<int> p(F.narg()); // permutation vector for pivoting in L-U decomposition
-#endif
 
-  UBMATRIX Btmp(nrow, ncol);
   ILogger &solverLog = ILogger::getLogger("solver_log");
   ILogger& worstMarketLog = ILogger::getLogger( "worst_market_log" );
   worstMarketLog.setLevel( ILogger::DEBUG );
@@ -412,6 +805,7 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
   UBVECTOR rptvec_all(mktids_all.size());
   
   F(x,fx);
+  mLinearSolver->analyze(B);
 
   solverLog.setLevel(ILogger::DEBUG);
   
@@ -455,7 +849,9 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
     
     solverLog << "Broyden iter= " << iter << "\tneval= " << neval << "\n";
     solverLog << "Internal iteration count ( mPerIter )= " << mPerIter << "\n";
-    cSolInfo->printMarketInfo("Broyden ", calcCounter->getPeriodCount(), singleLog);
+    if(singleLog.wouldPrint(ILogger::DEBUG)) {
+      cSolInfo->printMarketInfo("Broyden ", calcCounter->getPeriodCount(), singleLog);
+    }
     for(int j=0;j<F.narg();++j) {
       // double bjj= B(j,j);
       // jdiag[j] = bjj;
@@ -464,7 +860,11 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
     double jdmax=0.0, jdmin=0.0;
     int jdjmax=0, jdjmin=0;
     locate_vector_minmax(jdiag, jdmax, jdmin, jdjmax, jdjmin);
-    solverLog << "diag( B ):\n" << jdiag << "\n";
+    // The vector output formats every element before the stream sees it, so
+    // skip it outright when the solver log would discard it.
+    if(solverLog.wouldPrint(ILogger::DEBUG)) {
+      solverLog << "diag( B ):\n" << jdiag << "\n";
+    }
     solverLog << "maxval= " << jdmax << " jmax= " << jdjmax << "  "
               << "minval= " << jdmin << "  jmin= " << jdjmin << "\n";
     
@@ -482,45 +882,19 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
       return -3;
     }
 
-    Btmp = B;                   // save the jacobian approximant
-#if USE_LAPACK /* Solve using SVD */
-    int ierr = boost::numeric::bindings::lapack::gesvd('O','A','A', // control parameters
-                                                       B,           // input matrix
-                                                       Ssv,Usv,VTsv); // outputs
-    if(ierr>0) {
-      // svd failed.  It's not even clear under what circumstances
-      // this can happen
-      solverLog.setLevel(ILogger::SEVERE);
-      solverLog << "****************SVD failed.  This shouldn't happen.  It can't mean anything good.\n";
-      return ierr;
-    }
-
-    // At this point, U, S, and VT contain the SVD of the original Jacobian
-    solverLog.setLevel(ILogger::DEBUG);
-    dx = -1.0*fx; 
-    int nsing = svdInvertSolve(Usv,Ssv,VTsv,dx, solverLog);
-
-    solverLog << "\nIteration " << iter << "\nf0= " << f0
-              << "\tnsing= " << nsing
-              << "\nx: " << x << "\nF( x ): " << fx << "\ndx: " << dx << "\n";
-
-#else /* No USE_LAPACK.  Solve using L-U decomposition */
     int itrial = 0;
-    /* If the L-U decomposition fails the first time around, we will
+    /* If the factorization fails the first time around, we will
        invoke the jacobian preconditioner and try again.  If it fails
        a second time, we bail out */
     do {
-      for(size_t i=0; i<p.size(); ++i) {
-        p[i] = i;
-      }
-      int sing = lu_factorize(B,p);
+      int sing = mLinearSolver->factorize(B);
       if(sing>0) {
         int fail=1;
-        B = Btmp;           // restore Jacobian
         if(itrial == 0) {
             solverLog << "Salvaging Jacobian.\n";
             fail = jacobian_precondition(x, fx, B, F, &solverLog, mLogPricep);
             f0 = inner_prod(fx,fx);
+            mLinearSolver->analyze(B);
 
             // log the diagonal of the new jacobian
             for(int j=0; j<F.narg(); ++j) {
@@ -537,24 +911,28 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
         }
       }
       else {
-        // L-U decomp was successful.  Continue with the next phase of the algorithm.
+        // factorization was successful.  Continue with the next phase of the algorithm.
         break;
       }
     } while(++itrial < 2);
     
-    // J now holds the L-U decomposition of the Jacobian.  Attempt backsubstitution
+    // Solve for the step using the factorization of B
     dx = -1.0*fx;
-    try {
-      lu_substitute(B,p,dx);    // solve dx = J^-1 F
-    }
-    catch (const boost::numeric::ublas::internal_logic &err) {
-      // This error seems to be thrown when the Jacobian is
-      // ill-conditioned.  We let it go because often the solver will
-      // muddle through to a solution.  If not, then it will
-      // eventually stop with a genuinely singular matrix.
+    int nsing = mLinearSolver->solve(dx, solverLog);
+    if(nsing < 0) {
+      // An iterative back-end did not converge; solve directly instead.
+      int sing = LinearSolver::solveDirect(B, dx, solverLog);
+      if(sing > 0) {
+        solverLog.setLevel(ILogger::WARNING);
+        solverLog << "Singular Jacobian:\n" << B << "\n";
+        return sing;
+      }
+      nsing = 0;
     }
-    solverLog << "dx: " << dx << "\n"; 
-#endif /* USE_LAPACK */
+
+    solverLog << "\nIteration " << iter << "\nf0= " << f0
+              << "\tnsing= " << nsing
+              << "\nx: " << x << "\nF( x ): " << fx << "\ndx: " << dx << "\n";
 
     // log the proposal step
     solverLog << "Proposal step magnitude dxmag= " << sqrt(inner_prod(dx,dx)) << "\n\n";
@@ -564,7 +942,7 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
     // dx now holds the newton step.  Execute the line search along
     // that direction.
     double fnew;
-    int lserr = linesearch(fnorm,x,f0,gx,dx, xnew,fnew, neval, &solverLog);
+    int lserr = linesearch(fnorm,x,f0,gx,dx, xnew,fnew, neval, &solverLog, mLinesearchTrials);
 
     if(lserr != 0) {
       // line search failed.  There are a couple of things that could
@@ -577,6 +955,7 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
         solverLog << "**Failed line search. Evaluating fdjac\n";
         lsfail = true;
         fdjac(F,x,fx,B);
+        mLinearSolver->analyze(B);
         neval += x.size();
         ageB = 0;  // reset the age on B
 
@@ -624,7 +1003,9 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
 
     UBVECTOR fxnew(fx.size());
     fnorm.lastF( fxnew );            // get the last value of big-F
-    solverLog << "\nxnew: " << xnew << "\nfxnew: " << fxnew << "\n";
+    if(solverLog.wouldPrint(ILogger::DEBUG)) {
+      solverLog << "\nxnew: " << xnew << "\nfxnew: " << fxnew << "\n";
+    }
     UBVECTOR fxstep(fxnew -fx); // change in F( x ).  We will need this for the secant update
 
     // log the worst market info
@@ -662,10 +1043,10 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
     // secondary convergence test based on an estimated change in the
     // price vector.  Only test this if we have a "fresh" jacobian
     if(ageB == 0)  {
-        maxval = fabs(fxnew[0]) / (util::getSmallNumber() + fabs(Btmp(0,0)));
+        maxval = fabs(fxnew[0]) / (util::getSmallNumber() + fabs(B(0,0)));
         imaxval = 0;
         for(size_t i=1; i<fxnew.size(); ++i) {
-            double val = fabs(fxnew[i]) / (util::getSmallNumber() + fabs(Btmp(i,i)));
+            double val = fabs(fxnew[i]) / (util::getSmallNumber() + fabs(B(i,i)));
             if(val > maxval) {
                 maxval = val;
                 imaxval = i;
@@ -684,12 +1065,7 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
     // update B for next iteration
     double fratio_cutoff = 1.0 - 1.0/nrow;
     if(fnew/f0 < fratio_cutoff) { // making adequate progress with the Broyden formula
-      double dx2 = inner_prod(xstep,xstep);
-      UBVECTOR Bdx(F.nrtn());
-      B = Btmp;
-      fxstep -= axpy_prod(B, xstep, Bdx);
-      fxstep /= dx2;
-      B += outer_prod(fxstep, xstep);
+      mLinearSolver->update(B, fxstep, xstep);
       ageB++;                // increment the age of B
     }
     else {
@@ -699,6 +1075,7 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
       if(ageB > 0) {
         solverLog << "Insufficient progress with Broyden formula.  Resetting the Jacobian.\n(f0= " << f0 << ", fnew= " << fnew << ")\n";
         fdjac(F,xnew,fxnew,B);
+        mLinearSolver->analyze(B);
         neval += x.size();
         ageB = 0;
 
@@ -0,0 +1,381 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+* \file logjfnk.cpp
+* \ingroup objects
+* \brief LogJFNK (Jacobian-free Newton-Krylov) class source file.
+*/
+
+#include "util/base/include/definitions.h"
+#include <string>
+#include <algorithm>
+#include <math.h>
+#include <xercesc/dom/DOMNode.hpp>
+#include <xercesc/dom/DOMNodeList.hpp>
+
+#include "solution/solvers/include/solver_component.h"
+#include "solution/solvers/include/logjfnk.hpp"
+#include "solution/util/include/calc_counter.h"
+#include "marketplace/include/marketplace.h"
+#include "containers/include/world.h"
+#include "solution/util/include/solution_info_set.h"
+#include "solution/util/include/solution_info.h"
+#include "util/base/include/util.h"
+#include "util/logger/include/ilogger.h"
+#include "util/base/include/xml_helper.h"
+#include "solution/util/include/solution_info_filter_factory.h"
+#include "solution/util/include/solvable_nr_solution_info_filter.h"
+
+#include "solution/util/include/functor-subs.hpp"
+#include "solution/util/include/linesearch.hpp"
+#include "solution/util/include/gmres.hpp"
+#include "solution/util/include/edfun.hpp"
+#include "solution/util/include/ublas-helpers.hpp"
+
+#include "util/base/include/timer.h"
+
+using namespace std;
+using namespace xercesc;
+
+std::string LogJFNK::SOLVER_NAME = "jfnk-solver-component";
+
+#define UBVECTOR boost::numeric::ublas::vector<double>
+
+namespace {
+  // helper functions for the std::transform algorithm
+  double SI2lgprice (const SolutionInfo &si) {return log(si.getPrice());}
+  double SI2price (const SolutionInfo &si) {return si.getPrice();}
+
+  /*!
+   * \brief Jacobian of F at a fixed point, available only through
+   *        its action on a vector.
+   * \details Provides the interface expected by gmres().  Each
+   *          product costs one evaluation of F.  No preconditioning
+   *          is applied; LogEDFun already scales its inputs and
+   *          outputs to comparable magnitudes.
+   */
+  class JacobianVectorProduct {
+  public:
+    JacobianVectorProduct(VecFVec<double,double> &F, const UBVECTOR &x, const UBVECTOR &fx) :
+      mF(F), mX(x), mFX(fx), mXp(x.size()), mFp(fx.size()), mNeval(0) {}
+
+    //! out = J v, by a forward difference along v
+    void multiply(const UBVECTOR &v, UBVECTOR &out) {
+      // same relative step size as fdjac
+      const double heps = 1.0e-6;
+      double vnorm = boost::numeric::ublas::norm_2(v);
+      out.resize(v.size(), false);
+      if(vnorm == 0.0) {
+        out.clear();
+        return;
+      }
+      double h = heps * std::max(boost::numeric::ublas::norm_inf(mX), 1.0) / vnorm;
+      mXp = mX + h*v;
+      mF(mXp, mFp);
+      ++mNeval;
+      out = (mFp - mFX) / h;
+    }
+    void precondition(UBVECTOR &v) const {}
+    int getNumEvals() const {return mNeval;}
+  private:
+    VecFVec<double,double> &mF;
+    const UBVECTOR &mX;
+    const UBVECTOR &mFX;
+    UBVECTOR mXp, mFp;
+    int mNeval;
+  };
+}
+
+bool LogJFNK::XMLParse( const DOMNode* aNode ) {
+    // assume we were passed a valid node.
+    assert( aNode );
+    
+    // get the children of the node.
+    DOMNodeList* nodeList = aNode->getChildNodes();
+    
+    // loop through the children
+    for ( unsigned int i = 0; i < nodeList->getLength(); ++i ){
+        DOMNode* curr = nodeList->item( i );
+        string nodeName = XMLHelper<string>::safeTranscode( curr->getNodeName() );
+        
+        if( nodeName == "#text" ) {
+            continue;
+        }
+        else if( nodeName == "max-iterations" ) {
+            mMaxIter = XMLHelper<unsigned int>::getValue( curr );
+        }
+        else if( nodeName == "ftol" ) {
+            mFTOL = XMLHelper<double>::getValue(curr);
+        }
+        else if( nodeName == "krylov-dim" ) {
+            mKrylovDim = XMLHelper<int>::getValue( curr );
+        }
+        else if( nodeName == "max-krylov-iterations" ) {
+            mMaxKrylovIter = XMLHelper<int>::getValue( curr );
+        }
+        else if( nodeName == "eta-max" ) {
+            mEtaMax = XMLHelper<double>::getValue( curr );
+        }
+        else if( nodeName == "solution-info-filter" ) {
+            mSolutionInfoFilter.reset(
+                SolutionInfoFilterFactory::createSolutionInfoFilterFromString( XMLHelper<string>::getValue( curr ) ) );
+        }
+        else if(nodeName == "linear-price") {
+          mLogPricep = false;
+        }
+        else if(nodeName == "log-price") {
+          mLogPricep = true;    // not strictly necessary, as this is the default.
+        }
+        else if( SolutionInfoFilterFactory::hasSolutionInfoFilter( nodeName ) ) {
+            mSolutionInfoFilter.reset( SolutionInfoFilterFactory::createAndParseSolutionInfoFilter( nodeName, curr ) );
+        }
+        else {
+            ILogger& mainLog = ILogger::getLogger( "main_log" );
+            mainLog.setLevel( ILogger::WARNING );
+            mainLog << "Unrecognized text string: " << nodeName << " found while parsing "
+                << getXMLName() << "." << endl;
+        }
+    }
+    return true;
+}
+
+/*! \brief Jacobian-free Newton-Krylov solver
+ * \details Sets up the excess demand function for the selected
+ *          markets and calls jfnksolve() to do the actual work.
+ * \param solnset An initial set of SolutionInfo objects representing all markets which can be filtered.
+ * \param period Model period.
+ * \return A status code to indicate if the algorithm was successful or not.
+ */
+SolverComponent::ReturnCode LogJFNK::solve( SolutionInfoSet& solnset, int period ) {
+    ReturnCode code = SolverComponent::ORIGINAL_STATE;
+
+    // If all markets are solved, then return with success code.
+    if( solnset.isAllSolved() ){
+        return code = SolverComponent::SUCCESS;
+    }
+
+    startMethod();
+    
+    // Update the solution vector for the correct markets to solve.
+    // Need to update solvable status before starting solution (Ignore return code)
+    solnset.updateSolvable( mSolutionInfoFilter.get() );
+
+    ILogger& solverLog = ILogger::getLogger( "solver_log" );
+    solverLog.setLevel( ILogger::NOTICE );
+    solverLog << "Beginning Newton-Krylov solution for period " << period
+              << ".  Solving " << solnset.getNumSolvable() << " markets.\n";
+    
+    size_t nsolv = solnset.getNumSolvable(); 
+    if( nsolv == 0 ){
+        solverLog << "No markets were assigned to this solver.  Exiting." << endl;
+        return SUCCESS;
+    }
+
+    Timer& solverTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::SOLVER );
+    solverTimer.start();
+    
+    UBVECTOR x(nsolv), fx(nsolv);
+    int neval = 0;
+
+    // set our initial x from the solutionInfoSet
+    std::vector<SolutionInfo> smkts(solnset.getSolvableSet());
+    if(mLogPricep)
+      std::transform(smkts.begin(), smkts.end(), x.begin(), SI2lgprice);
+    else
+      std::transform(smkts.begin(), smkts.end(), x.begin(), SI2price);
+
+    // This is the closure that will evaluate the ED function
+    LogEDFun F(solnset, world, marketplace, period, mLogPricep); 
+
+    // scale the initial guess for use in F
+    F.scaleInitInputs(x);
+    
+    // Call F(x), store the result in fx
+    F(x,fx);
+    ++neval;
+
+    solverLog.setLevel(ILogger::DEBUG);
+    solverLog << "Initial guess:\n" << x << "\nInitial F(x):\n" << fx << "\n";
+
+    int status = jfnksolve(F, x, fx, neval);
+
+    solverTimer.stop();
+
+    solverLog.setLevel(ILogger::NOTICE);
+    solverLog << "Newton-Krylov solver:  neval= " << neval << "\nResult:  ";
+    if(status == 0) {
+        solverLog << "JFNK solution success.\n";
+        code = SUCCESS;
+    }
+    else if(status == -1) {
+        code = FAILURE_ITER_MAX_REACHED;
+        solverLog << "JFNK solution failed: Iteration max reached.\n";
+    }
+    else if(status == -4) {
+        code = FAILURE_POOR_PROGRESS;
+        solverLog << "JFNK solution failed:  line search failure.\n";
+    }
+    else if(status > 0) {
+        code = FAILURE_SINGULAR_MATRIX;
+        solverLog << "JFNK solution failed:  GMRES made no progress on the Newton step.\n";
+    }
+    else {
+        code = FAILURE_UNKNOWN;
+        solverLog << "JFNK solution failed for unknown reason.\n";
+    }
+    if(!solnset.isAllSolved()) {
+        solverLog << "The following markets were not solved:\n";
+        solnset.printUnsolved(solverLog);
+    }
+
+    solverLog << endl;
+    return code;
+}
+
+/*!
+ * \brief Newton iterations with the step from GMRES.
+ * \details At each iteration we solve J dx = -F(x) to a relative
+ *          residual of eta, where eta is chosen by the second
+ *          Eisenstat-Walker formula: loose while we are far from the
+ *          solution, and tighter as F decreases quadratically.  The
+ *          line search needs the directional derivative of F.F along
+ *          dx; since J dx = -F + r with ||r|| <= eta ||F||, we use
+ *          -(1-eta) F.F, which is a bound on it, rather than spend an
+ *          extra evaluation computing it exactly.
+ * \return 0 on success, -1 if the iteration limit was reached, -4 on
+ *         a line search failure, and 1 if GMRES could not reduce the
+ *         linear residual at all.
+ */
+int LogJFNK::jfnksolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx, int &neval)
+{
+  using boost::numeric::ublas::inner_prod;
+
+  ILogger &solverLog = ILogger::getLogger("solver_log");
+  solverLog.setLevel(ILogger::DEBUG);
+
+  const double FTINY = mFTOL*mFTOL;
+  UBVECTOR dx(F.narg());
+  UBVECTOR xnew(F.narg());
+  UBVECTOR gx(F.narg());
+  UBVECTOR rhs(F.nrtn());
+
+  // We create a functor that computes f(x) = F(x)*F(x).  It also
+  // stores the value of F that it produces as an intermediate.
+  FdotF<double,double> fnorm(F);
+  double f0 = inner_prod(fx,fx);
+  if(f0 < FTINY)
+    // Guard against F=0 since it can cause a NaN in our solver.
+    return 0;
+
+  double eta = mEtaMax;
+  for(unsigned int iter=0; iter<mMaxIter; ++iter) {
+    solverLog << "JFNK iter= " << iter << "\tneval= " << neval << "\n";
+
+    // Solve J dx = -F(x) approximately.
+    JacobianVectorProduct J(F, x, fx);
+    rhs = -fx;
+    double resid = 1.0;
+    int kiter = gmres(J, rhs, dx, mKrylovDim, mMaxKrylovIter, eta, resid);
+    neval += J.getNumEvals();
+    solverLog << "GMRES iterations= " << kiter << "\teta= " << eta
+              << "\trelative residual= " << resid << "\n"
+              << "dx: " << dx << "\n";
+
+    if(resid >= 1.0) {
+      // The Jacobian-vector products leave the model at a perturbed
+      // point; put it back before returning.
+      F(x,fx);
+      ++neval;
+      solverLog << "GMRES stagnated.\n";
+      return 1;
+    }
+
+    double dx2 = inner_prod(dx,dx);
+    gx = (-(1.0-resid) * f0 / dx2) * dx;
+
+    double fnew;
+    int lserr = linesearch(fnorm, x, f0, gx, dx, xnew, fnew, neval, &solverLog);
+
+    if(lserr != 0) {
+      // The line search leaves the model at its last trial point.
+      F(x,fx);
+      ++neval;
+
+      // Make a relaxed convergence test and return if we have a
+      // "close enough" solution.
+      double msf = f0/fx.size();
+      if(msf < mFTOL)
+        return 0;
+
+      solverLog << "linesearch failure\n";
+      return -4;
+    }
+
+    // Choose the forcing term for the next step.
+    const double gamma = 0.9;
+    double etanew = gamma * fnew / f0; // (||F_new|| / ||F_old||)^2
+    if(gamma*eta*eta > 0.1) {
+      // safeguard against eta dropping too quickly
+      etanew = std::max(etanew, gamma*eta*eta);
+    }
+    // there is no point in solving more accurately than the convergence test requires
+    etanew = std::max(etanew, 0.5*mFTOL/sqrt(fnew + FTINY));
+    eta = std::min(etanew, mEtaMax);
+
+    solverLog << "################Return from linesearch\nfold= " << f0 << "\tfnew= " << fnew
+              << "\n";
+    f0 = fnew;
+    x  = xnew;
+    fnorm.lastF(fx);            // get the last value of big-F
+
+    // test for convergence
+    double maxval = 0.0;
+    for(size_t i=0; i<fx.size(); ++i) {
+      double val = fabs(fx[i]);
+      maxval = val>maxval ? val : maxval;
+    }
+
+    solverLog << "Convergence test maxval: " << maxval << "\n";
+    if(maxval <= mFTOL) {
+      solverLog << "Solution successful.\n";
+      return 0;                 // SUCCESS 
+    }
+  }
+
+  // if we get here, then we didn't converge in the number of
+  // iterations allowed us.  Return an error code
+  solverLog << "\n****************Maximum solver iterations exceeded.\nlastx: " << x
+            << "\nlastF: " << fx << "\n";
+  return -1;
+}
@@ -67,16 +67,7 @@
 #include "solution/util/include/jacobian-precondition.hpp" 
 #include "util/base/include/fltcmp.hpp"
 
-#if USE_LAPACK
-#include <boost/numeric/bindings/traits/ublas_vector.hpp>
-#include <boost/numeric/bindings/traits/ublas_matrix.hpp>
-#include <boost/numeric/ublas/operation.hpp>
-#include <boost/numeric/bindings/lapack/gesvd.hpp>
-#include "solution/util/include/svd_invert_solve.hpp"
-#else
 #include <boost/numeric/ublas/operation.hpp>
-#include <boost/numeric/ublas/lu.hpp>
-#endif
 
 #include "util/base/include/timer.h"
 
@@ -130,7 +121,23 @@ bool LogNRbt::XMLParse( const DOMNode* aNode ) {
         }
         else if(nodeName == "log-price") {
           mLogPricep = true;    // not strictly necessary, as this is the default.
+        }
+        else if(nodeName == "colored-jacobian") {
+          mColoredJacobian = true;
         } 
+        else if(nodeName == "linesearch-trials") {
+          mLinesearchTrials = max(XMLHelper<int>::getValue( curr ), 1);
+        }
+        else if(nodeName == "linear-solver") {
+          mLinearSolver.reset(LinearSolver::create(curr));
+          if(!mLinearSolver.get()) {
+            ILogger& mainLog = ILogger::getLogger( "main_log" );
+            mainLog.setLevel( ILogger::WARNING );
+            mainLog << "Unknown linear solver " << XMLHelper<std::string>::getValue( curr )
+                    << " in " << getXMLName() << ".  Using " << LinearSolver::getDefaultName()
+                    << "." << std::endl;
+          }
+        }
         else if( SolutionInfoFilterFactory::hasSolutionInfoFilter( nodeName ) ) {
             mSolutionInfoFilter.reset( SolutionInfoFilterFactory::createAndParseSolutionInfoFilter( nodeName, curr ) );
         }
@@ -213,6 +220,12 @@ SolverComponent::ReturnCode LogNRbt::solve( SolutionInfoSet& solnset, int period
 
     // This is the closure that will evaluate the ED function
     LogEDFun F(solnset, world, marketplace, period, mLogPricep); 
+    F.setColoredJacobian(mColoredJacobian);
+    // Sparse linear solvers take their pattern from the Jacobian structure
+    // once, rather than scanning every freshly computed Jacobian.
+    if(mLinearSolver->needsStructure() && F.jacobianColumnRows()) {
+      mLinearSolver->setStructure(*F.jacobianColumnRows());
+    }
 
     // scale the initial guess for use in F
     F.scaleInitInputs(x);
@@ -278,31 +291,18 @@ SolverComponent::ReturnCode LogNRbt::solve( SolutionInfoSet& solnset, int period
 int LogNRbt::nrsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx, UBMATRIX &J,
                      int &neval)
 {
-#if !USE_LAPACK
-  using boost::numeric::ublas::permutation_matrix;
-  using boost::numeric::ublas::lu_factorize;
-  using boost::numeric::ublas::lu_substitute;
-#endif
   using boost::numeric::ublas::axpy_prod;
   using boost::numeric::ublas::inner_prod;
-  int nrow = J.size1(), ncol = J.size2();
-  // svd decomposition elements (note nrow == ncol)
-#if USE_LAPACK
-  UBMATRIX Usv(nrow,ncol),VTsv(ncol,ncol);
-  UBVECTOR Ssv(ncol);
+  int nrow = J.size1();
   int singcount = 0;
   const int scmax = nrow/2;
-#else
-  permutation_matrix<int> p(F.narg()); // permutation vector for pivoting in L-U decomposition
-#endif
-  UBMATRIX Jtmp(nrow, ncol);
-  
 
   ILogger &solverLog = ILogger::getLogger("solver_log");
 
   // Note that we no longer need to do a jacobian calculation here
   // because we do one in the preconditioner
   F(x,fx);
+  mLinearSolver->analyze(J);
 
   solverLog.setLevel(ILogger::DEBUG);
   
@@ -339,54 +339,73 @@ int LogNRbt::nrsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx, UBMAT
       return -3;
     }
 
-    Jtmp = J;                   // save the Jacobian, since gesvd destroys it.
-
-#if USE_LAPACK
-    int ierr =
-      boost::numeric::bindings::lapack::gesvd('O','A','A', // control parameters
-                                              J,           // input matrix
-                                              Ssv,Usv,VTsv); // output matrices
-    if(ierr != 0) {
-      // svd failed.  It's not even clear under what circumstances
-      // this can happen
-      solverLog.setLevel(ILogger::SEVERE);
-      solverLog << "****************SVD failed.  This shouldn't happen.  It can't mean anything good.\n";
-      return ierr;
-    } 
+    int itrial = 0;
+    /* If the factorization fails the first time around, we will
+       invoke the jacobian preconditioner and try again.  If it fails
+       a second time, we bail out */
+    do {
+      int sing = mLinearSolver->factorize(J);
+      if(sing>0) {
+        int fail=1;
+        if(itrial == 0) {
+          fail = jacobian_precondition(x, fx, J, F, &solverLog, mLogPricep);
+          f0 = inner_prod(fx,fx);
+          axpy_prod(fx,J,gx);
+          mLinearSolver->analyze(J);
+        }
+        
+        if(fail) {
+          solverLog.setLevel(ILogger::WARNING);
+          solverLog << "Singular Jacobian:\n" << J << "\n";
+          return sing;
+        }
+      }
+      else {
+        // factorization was successful.  Continue with the next phase of the algorithm.
+        break;
+      }
+    } while(++itrial < 2);
     
-    // At this point, U, S, and VT contain the SVD of the original Jacobian
-    solverLog.setLevel(ILogger::DEBUG);
     dx = -1.0*fx; 
-    int nsing = svdInvertSolve(Usv,Ssv,VTsv,dx, solverLog);
+    int nsing = mLinearSolver->solve(dx, solverLog);
+    if(nsing < 0) {
+      // An iterative back-end did not converge; solve directly instead.
+      int sing = LinearSolver::solveDirect(J, dx, solverLog);
+      if(sing > 0) {
+        solverLog.setLevel(ILogger::WARNING);
+        solverLog << "Singular Jacobian:\n" << J << "\n";
+        return sing;
+      }
+      nsing = 0;
+    }
     
     solverLog.setLevel(ILogger::DEBUG);
     solverLog << "\n****************Iteration " << iter << "\nf0= " << f0
               << "\tnsing= " << nsing
               << "\nx: " << x << "\nF(x): " << fx << "\ndx: " << dx << "\n";
 
-
+    // Only the SVD back-end reports singular components; it solves
+    // around them rather than failing outright.
     if(nsing > 0) {
       singcount += nsing;
       if(singcount < scmax) {
         // Try to reset the x value using the preconditioner
         solverLog << "Resetting singular matrix, singcount = " << singcount << "\n";
-        J = Jtmp;
         int fail = jacobian_precondition(x, fx, J, F, &solverLog, mLogPricep);
         if(fail)
           return nsing;
 
         // re-evaluate f0 and gx at the new guess
-        double f0 = inner_prod(fx,fx);
+        f0 = inner_prod(fx,fx);
         axpy_prod(fx,J,gx);         // compute the gradient of F*F (= fx^T * J == J^T * fx)
         
         // re-solve for dx using the new Jacobian
-        ierr = boost::numeric::bindings::lapack::gesvd('O','A','A', // control parameters
-                                                       J,           // input matrix
-                                                       Ssv,Usv,VTsv); // output matrices
-        if(ierr)
+        mLinearSolver->analyze(J);
+        if(mLinearSolver->factorize(J))
           return nsing;
         dx = -1.0*fx;
-        svdInvertSolve(Usv, Ssv, VTsv, dx, solverLog);
+        if(mLinearSolver->solve(dx, solverLog) < 0 && LinearSolver::solveDirect(J, dx, solverLog))
+          return nsing;
       }
       else {
         return nsing;
@@ -394,48 +413,11 @@ int LogNRbt::nrsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx, UBMAT
     }
     else
       singcount = 0;
-#else  /* No USE_LAPACK.  Use L-U decomposition to do the solution. */
-    int itrial = 0;
-    /* If the L-U decomposition fails the first time around, we will
-       invoke the jacobian preconditioner and try again.  If it fails
-       a second time, we bail out */
-    do {
-      for(size_t i=0; i<p.size(); ++i) p[i] = i;
-      int sing = lu_factorize(J,p);
-      if(sing>0) {
-        int fail=1;
-        if(itrial == 0)
-          fail = jacobian_precondition(x, fx, J, F, &solverLog, mLogPricep);
-        
-        if(fail) {
-          solverLog.setLevel(ILogger::WARNING);
-          solverLog << "Singular Jacobian:\n" << Jtmp << "\n";
-          return sing;
-        }
-      }
-      else {
-        // L-U decomp was successful.  Continue with the next phase of the algorithm.
-        break;
-      }
-    } while(++itrial < 2);
-    
-    // J now holds the L-U decomposition of the Jacobian.  Attempt backsubstitution
-    dx = -1.0*fx;
-    try {
-      lu_substitute(J,p,dx);    // solve dx = J^-1 F
-    }
-    catch (const boost::numeric::ublas::internal_logic &err) {
-      // This error seems to be thrown when the Jacobian is
-      // ill-conditioned.  We let it go because often the solver will
-      // muddle through to a solution.  If not, then it will
-      // eventually stop with a genuinely singular matrix.
-    }
-#endif /* USE_LAPACK */
     
     // dx now holds the newton step.  Execute the line search along
     // that direction.
     double fnew;
-    int lserr = linesearch(fnorm,x,f0,gx,dx, xnew,fnew, neval);
+    int lserr = linesearch(fnorm,x,f0,gx,dx, xnew,fnew, neval, 0, mLinesearchTrials);
 
     if(lserr != 0) {
       // line search failed.  This means that the descent direction
@@ -485,6 +467,7 @@ int LogNRbt::nrsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx, UBMAT
     }
     
     fdjac(F,x,fx,J);            // calculate finite difference Jacobian for the next iteration
+    mLinearSolver->analyze(J);
     neval += x.size();          // N evaluations from calculating the Jacobian
   }
 
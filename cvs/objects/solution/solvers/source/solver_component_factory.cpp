@@ -55,6 +55,7 @@
 #include "solution/solvers/include/bisect_policy.h"
 #include "solution/solvers/include/lognrbt.hpp"
 #include "solution/solvers/include/logbroyden.hpp"
+#include "solution/solvers/include/logjfnk.hpp"
 #include "solution/solvers/include/preconditioner.hpp"
 
 using namespace std;
@@ -77,6 +78,7 @@ bool SolverComponentFactory::hasSolverComponent( const string& aXMLName ) {
         || BisectPolicy::getXMLNameStatic() == aXMLName
         || LogNRbt::getXMLNameStatic() == aXMLName
         || LogBroyden::getXMLNameStatic() == aXMLName
+        || LogJFNK::getXMLNameStatic() == aXMLName
         || Preconditioner::getXMLNameStatic() == aXMLName;
 }
 
@@ -129,6 +131,9 @@ SolverComponentFactory::createAndParseSolverComponent( const string& aXMLName,
     else if( LogBroyden::getXMLNameStatic() == aXMLName ) {
         retSolverComponent = new LogBroyden( aMarketplace, aWorld, aCalcCounter );
     }
+    else if( LogJFNK::getXMLNameStatic() == aXMLName ) {
+        retSolverComponent = new LogJFNK( aMarketplace, aWorld, aCalcCounter );
+    }
     else if( Preconditioner::getXMLNameStatic() == aXMLName ) {
         retSolverComponent = new Preconditioner( aMarketplace, aWorld, aCalcCounter );
     }
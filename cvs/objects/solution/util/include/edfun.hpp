@@ -44,10 +44,12 @@
 #include <map>
 #include <set>
 #include <vector>
+#include <mutex>
 #include "marketplace/include/marketplace.h"
 #include "containers/include/world.h"
 #include "solution/util/include/solution_info_set.h"
 #include "solution/util/include/functor.hpp"
+#include "solution/util/include/jacobian-coloring.hpp"
 
 #define UBVECTOR boost::numeric::ublas::vector
 
@@ -95,6 +97,21 @@ class LogEDFun : public VecFVec<double,double>
   int period;
   bool mLogPricep;               //!< Flag indicating whether inputs are prices or log-prices
 
+  bool mColoredJacobian;         //!< Flag indicating whether to report the Jacobian structure to fdjac
+
+  //! Jacobian structure used for compressed finite-difference Jacobians
+  JacobianStructure mJacStructure;
+
+  //! The activities to recalculate for each column group (in global
+  //! order).  Empty for groups with a single column, which use that
+  //! market's dependencies directly.
+  std::vector<std::vector<IActivity*> > mGroupDependencies;
+  //! The activities to recalculate for a trial:  the union of the
+  //! dependencies of all of mkts (in global order).  Found on the first
+  //! trial, which may be one of several running at once.
+  std::vector<IActivity*> mTrialDependencies;
+  std::once_flag mTrialDependenciesFlag;
+
   // diagnostic variables
   std::vector<double> mstate;
 public:
@@ -104,7 +121,18 @@ public:
   virtual void operator()(const UBVECTOR<double> &x, UBVECTOR<double> &fx, const int partj=-1);
   virtual void partial(int ip);
   virtual double partialSize(int ip) const;
+  virtual const JacobianStructure *jacobianStructure();
+  virtual const std::vector<std::vector<int> > *jacobianColumnRows();
+  const std::vector<std::vector<int> > &jacobianPattern();
+  virtual void partialGroup(const UBVECTOR<double> &x, UBVECTOR<double> &fx, int ig);
+  virtual bool concurrentTrials() const;
+  virtual void trial(const UBVECTOR<double> &x, UBVECTOR<double> &fx);
   void scaleInitInputs(UBVECTOR<double> &ax);
+  void setColoredJacobian(bool aColored);
+  //! Scale factors for the inputs: the model sees x[i]*getInputScale()[i]
+  const UBVECTOR<double> &getInputScale() const {return mxscl;}
+  //! Scale factors for the outputs: fx[i] is the model output times getOutputScale()[i]
+  const UBVECTOR<double> &getOutputScale() const {return mfxscl;}
 
   // Constants to protect against overflow: 
   static const double PMAX;            //!< Greatest allowable price
@@ -116,6 +144,10 @@ protected:
   // scale factors for input and output
   UBVECTOR<double> mxscl;
   UBVECTOR<double> mfxscl;
+
+  void collectOutputs(const UBVECTOR<double> &x, UBVECTOR<double> &fx);
+  void findJacobianStructure();
+  void findTrialDependencies();
     
 };  
 
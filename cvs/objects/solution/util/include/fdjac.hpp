@@ -51,6 +51,7 @@
 #include "functor.hpp"
 #include <iostream>
 #include "solution/util/include/ublas-helpers.hpp"
+#include "solution/util/include/jacobian-coloring.hpp"
 
 #define UBLAS boost::numeric::ublas
 
@@ -103,6 +104,60 @@ inline void jacol(VecFVec<FTYPE,FTYPE> &F, const UBLAS::vector<FTYPE> &x,
   } 
 }
 
+/*!
+ * Compute all of the columns in a group of structurally independent
+ * columns using a single function evaluation.  Every input in the
+ * group is perturbed at once, and each row of the result is credited
+ * to the only column in the group that can affect it.  Entries that
+ * are structurally zero are set to zero.
+ * \param[in] ig: Index of the column group in aStructure.mGroups
+ * \param[in] aStructure: Column structure obtained from F.jacobianStructure()
+ */
+template<class FTYPE,class MTRAIT>
+inline void jacgroup(VecFVec<FTYPE,FTYPE> &F, const UBLAS::vector<FTYPE> &x,
+                     const UBLAS::vector<FTYPE> &fx, int ig,
+                     const JacobianStructure &aStructure,
+                     UBLAS::matrix<FTYPE,MTRAIT> &J,
+                     std::ostream *diagnostic=NULL) {
+  const FTYPE heps = 1.0e-6;
+  const FTYPE TINY = 1.0e-6;
+  const std::vector<int> &cols = aStructure.mGroups[ig];
+  UBLAS::vector<FTYPE> xx(x);   // temporary, so we can respect the const on x
+  UBLAS::vector<FTYPE> fxx(fx.size());        // hold the values of F(xx)
+  std::vector<FTYPE> h(cols.size());
+
+  for(size_t k=0; k<cols.size(); ++k) {
+    int j = cols[k];
+    FTYPE t = x[j];
+    xx[j] = t + heps * (fabs(t)+TINY);
+    h[k]  = xx[j]-t;            // reduce roundoff error, as in jacol
+  }
+  if(diagnostic) {
+    (*diagnostic) << "group= " << ig << "\tncol= " << cols.size() << "\nxx:\n" << xx << "\n";
+  }
+
+  F.partial(cols[0]);           // hint to the function that this is a partial derivative calculation
+  F.partialGroup(xx, fxx, ig);
+
+  if(diagnostic) {
+    (*diagnostic) << "fxx:\n" << fxx << "\n";
+  }
+
+  // scatter the compressed column back into the columns of J
+  for(size_t k=0; k<cols.size(); ++k) {
+    int j = cols[k];
+    const std::vector<int> &rows = aStructure.mColRows[j];
+    FTYPE hinv = 1.0/h[k];
+    for(size_t i=0; i<J.size1(); ++i) {
+      J(i,j) = 0.0;
+    }
+    for(size_t r=0; r<rows.size(); ++r) {
+      int i = rows[r];
+      J(i,j) = (fxx[i] - fx[i]) * hinv;
+    }
+  }
+}
+
 
 /*!
  * Compute the Jacobian of a vector function F at point x.
@@ -135,7 +190,10 @@ void fdjac(VecFVec<FTYPE,FTYPE> &F, const UBLAS::vector<FTYPE> &x,
  * \param[out] J: The Jacobian of F
  * \param[in] usepartial: (optional) use partial model evaluation for partial derivatives
  * \param[in] diagnostic: (optional) ostream pointer to which to send additional diagnostics
- *
+ * \remark If usepartial is set and F supplies a Jacobian structure,
+ *         structurally independent columns will be computed together
+ *         (see jacgroup), so the number of function evaluations will be
+ *         the number of column groups rather than the number of columns.
  */
 template<class FTYPE, class MTRAIT>
 void fdjac(VecFVec<FTYPE,FTYPE> &F, const UBLAS::vector<FTYPE> &x,
@@ -150,19 +208,34 @@ void fdjac(VecFVec<FTYPE,FTYPE> &F, const UBLAS::vector<FTYPE> &x,
   Timer& jacTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::JACOBIAN );
   jacTimer.start();
     if(usepartial) { scenario->getManageStateVariables()->setPartialDeriv(true); }
+  const JacobianStructure *jstruct = usepartial ? F.jacobianStructure() : 0;
   
 #if !GCAM_PARALLEL_ENABLED
-  for(size_t j=0; j<x.size(); ++j) {
-    jacol(F, x, fx, j, J, usepartial, diagnostic);
+  if(jstruct) {
+    for(int g=0; g<jstruct->ngroup(); ++g) {
+      jacgroup(F, x, fx, g, *jstruct, J, diagnostic);
+    }
+  }
+  else {
+    for(size_t j=0; j<x.size(); ++j) {
+      jacol(F, x, fx, j, J, usepartial, diagnostic);
+    }
   }
 #else
     tbb::task_arena& threadPool = scenario->getManageStateVariables()->mThreadPool;
     tbb::task_group tg;
     threadPool.execute([&](){
         tg.run([&](){
-            tbb::parallel_for_each( x, [&]( const FTYPE& j ) {
-                jacol(F, x, fx, (&j - &x[0]), J, usepartial, 0/*diagnostic*/);
-            });
+            if(jstruct) {
+                tbb::parallel_for_each( jstruct->mGroups, [&]( const std::vector<int>& grp ) {
+                    jacgroup(F, x, fx, (&grp - &jstruct->mGroups[0]), *jstruct, J, 0/*diagnostic*/);
+                });
+            }
+            else {
+                tbb::parallel_for_each( x, [&]( const FTYPE& j ) {
+                    jacol(F, x, fx, (&j - &x[0]), J, usepartial, 0/*diagnostic*/);
+                });
+            }
         });
     });
     threadPool.execute([&tg](){ tg.wait(); });
@@ -173,6 +246,200 @@ void fdjac(VecFVec<FTYPE,FTYPE> &F, const UBLAS::vector<FTYPE> &x,
 }
 
 
+/*!
+ * Compute only the listed columns of the Jacobian of F at point x,
+ * leaving the rest of J untouched.  This is useful when the rest of
+ * the Jacobian is already known, for instance from a stored Jacobian
+ * that did not include some of the markets.
+ * \param[in] F: The function to have its Jacobian calculated
+ * \param[in] x: The point at which to calculate the Jacobian
+ * \param[in] fx: F(x)
+ * \param[in] cols: The columns to compute
+ * \param[in,out] J: The Jacobian of F
+ */
+template<class FTYPE, class MTRAIT>
+void fdjac_cols(VecFVec<FTYPE,FTYPE> &F, const UBLAS::vector<FTYPE> &x,
+                const UBLAS::vector<FTYPE> &fx, const std::vector<int> &cols,
+                UBLAS::matrix<FTYPE,MTRAIT> &J)
+{
+  if(cols.empty()) {
+    return;
+  }
+
+  Timer& jacTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::JACOBIAN );
+  jacTimer.start();
+  scenario->getManageStateVariables()->setPartialDeriv(true);
+#if !GCAM_PARALLEL_ENABLED
+  for(size_t k=0; k<cols.size(); ++k) {
+    jacol(F, x, fx, cols[k], J, true);
+  }
+#else
+    tbb::task_arena& threadPool = scenario->getManageStateVariables()->mThreadPool;
+    tbb::task_group tg;
+    threadPool.execute([&](){
+        tg.run([&](){
+            tbb::parallel_for_each( cols, [&]( const int j ) {
+                jacol(F, x, fx, j, J, true, 0/*diagnostic*/);
+            });
+        });
+    });
+    threadPool.execute([&tg](){ tg.wait(); });
+#endif
+  F.partial(-1);
+
+  jacTimer.stop();
+}
+
+
+#if DEBUG_JACOBIAN_REFRESH
+/*!
+ * Debug check for fdjac_refresh: compute the full Jacobian at x and
+ * report the largest difference from the partially refreshed J.  This
+ * costs a full Jacobian for every refresh, so it is only compiled in
+ * when DEBUG_JACOBIAN_REFRESH is set.
+ * \param[in] F: The function whose Jacobian was refreshed
+ * \param[in] x: The point at which J was calculated
+ * \param[in] fx: F(x)
+ * \param[in] J: The refreshed Jacobian
+ * \param[in] diagnostic: ostream pointer to which to send the result; the
+ *            check is skipped if this is NULL
+ */
+template<class FTYPE, class MTRAIT>
+void fdjac_refresh_check(VecFVec<FTYPE,FTYPE> &F, const UBLAS::vector<FTYPE> &x,
+                         const UBLAS::vector<FTYPE> &fx, const UBLAS::matrix<FTYPE,MTRAIT> &J,
+                         std::ostream *diagnostic)
+{
+  if(!diagnostic) {
+    return;
+  }
+  UBLAS::matrix<FTYPE,MTRAIT> Jfull(J.size1(), J.size2());
+  fdjac(F,x,fx,Jfull,true);
+  FTYPE maxdiff = 0.0;
+  for(size_t i=0; i<J.size1(); ++i) {
+    for(size_t j=0; j<J.size2(); ++j) {
+      maxdiff = std::max(maxdiff, FTYPE(fabs(J(i,j)-Jfull(i,j))));
+    }
+  }
+  (*diagnostic) << "fdjac_refresh: max difference from full Jacobian = " << maxdiff << "\n";
+}
+#endif
+
+
+/*!
+ * Recompute the Jacobian of F after some of the inputs have moved,
+ * reusing every entry that cannot have changed.
+ * \details A change in x[j] can only change the rows of F that depend
+ *          on x[j], so the only entries of J that can change are in the
+ *          rows of the moved columns.  Any column with a structural
+ *          nonzero in one of those rows is recomputed, which includes
+ *          the moved columns themselves.  If F supplies a compressed
+ *          Jacobian structure, the column groups containing those
+ *          columns are evaluated instead of the individual columns.  If
+ *          F does not know its column structure the whole Jacobian is
+ *          recomputed.
+ * \param[in] F: The function to have its Jacobian calculated
+ * \param[in] x: The point at which to calculate the Jacobian
+ * \param[in] fx: F(x)
+ * \param[in] moved: The columns whose inputs have changed since J was
+ *            calculated
+ * \param[in,out] J: The Jacobian of F at the previous point on input,
+ *                and at x on output
+ * \param[in] diagnostic: (optional) ostream pointer to which to send additional diagnostics
+ * \return The number of function evaluations used.
+ */
+template<class FTYPE, class MTRAIT>
+int fdjac_refresh(VecFVec<FTYPE,FTYPE> &F, const UBLAS::vector<FTYPE> &x,
+                  const UBLAS::vector<FTYPE> &fx, const std::vector<int> &moved,
+                  UBLAS::matrix<FTYPE,MTRAIT> &J, std::ostream *diagnostic=NULL)
+{
+  if(moved.empty()) {
+    return 0;
+  }
+
+  const std::vector<std::vector<int> > *colrows = F.jacobianColumnRows();
+  const JacobianStructure *jstruct = F.jacobianStructure();
+  if(!colrows) {
+    fdjac(F,x,fx,J,true);
+    return jstruct ? jstruct->ngroup() : int(x.size());
+  }
+
+  // rows whose values can have changed
+  std::vector<bool> rowchanged(fx.size(), false);
+  for(size_t k=0; k<moved.size(); ++k) {
+    const std::vector<int> &rows = (*colrows)[moved[k]];
+    for(size_t r=0; r<rows.size(); ++r) {
+      rowchanged[rows[r]] = true;
+    }
+  }
+
+  // columns with a structural nonzero in any of those rows
+  std::vector<int> cols;
+  for(size_t j=0; j<colrows->size(); ++j) {
+    const std::vector<int> &rows = (*colrows)[j];
+    for(size_t r=0; r<rows.size(); ++r) {
+      if(rowchanged[rows[r]]) {
+        cols.push_back(j);
+        break;
+      }
+    }
+  }
+
+  if(!jstruct) {
+    if(diagnostic) {
+      (*diagnostic) << "fdjac_refresh: " << moved.size() << " moved columns, recomputing "
+                    << cols.size() << " of " << x.size() << " columns.\n";
+    }
+    fdjac_cols(F,x,fx,cols,J);
+#if DEBUG_JACOBIAN_REFRESH
+    fdjac_refresh_check(F,x,fx,J,diagnostic);
+#endif
+    return cols.size();
+  }
+
+  // evaluate each group that holds one of the columns
+  std::vector<int> groups;
+  std::vector<bool> ingroup(jstruct->ngroup(), false);
+  for(size_t k=0; k<cols.size(); ++k) {
+    int g = jstruct->mColGroup[cols[k]];
+    if(!ingroup[g]) {
+      ingroup[g] = true;
+      groups.push_back(g);
+    }
+  }
+  if(diagnostic) {
+    (*diagnostic) << "fdjac_refresh: " << moved.size() << " moved columns, recomputing "
+                  << groups.size() << " of " << jstruct->ngroup() << " column groups.\n";
+  }
+
+  Timer& jacTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::JACOBIAN );
+  jacTimer.start();
+  scenario->getManageStateVariables()->setPartialDeriv(true);
+#if !GCAM_PARALLEL_ENABLED
+  for(size_t k=0; k<groups.size(); ++k) {
+    jacgroup(F, x, fx, groups[k], *jstruct, J);
+  }
+#else
+    tbb::task_arena& threadPool = scenario->getManageStateVariables()->mThreadPool;
+    tbb::task_group tg;
+    threadPool.execute([&](){
+        tg.run([&](){
+            tbb::parallel_for_each( groups, [&]( const int g ) {
+                jacgroup(F, x, fx, g, *jstruct, J, 0/*diagnostic*/);
+            });
+        });
+    });
+    threadPool.execute([&tg](){ tg.wait(); });
+#endif
+  F.partial(-1);
+
+  jacTimer.stop();
+#if DEBUG_JACOBIAN_REFRESH
+  fdjac_refresh_check(F,x,fx,J,diagnostic);
+#endif
+  return groups.size();
+}
+
+
 #undef UBLAS
 
 #endif
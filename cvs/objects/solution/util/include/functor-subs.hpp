@@ -66,6 +66,14 @@ public:
     F(x,lstF);
     return inner_prod(lstF,lstF);
   }
+  virtual bool concurrentTrials() const {return F.concurrentTrials();}
+  //! Trial evaluations do not update the stored value of F
+  virtual Tr trial(const UBLAS::vector<Ta> &x) {
+    UBLAS::vector<Tr> Fx(F.nrtn());
+    F.trial(x,Fx);
+    return inner_prod(Fx,Fx);
+  }
+  virtual void endTrials() {F.partial(-1);}
   virtual void prn_diagnostic(std::ostream *out) {
     int ifmax=0;
     double fmax=fabs(lstF[0]);
@@ -45,10 +45,13 @@
  */
 
 #include <iostream>
+#include <vector>
 #include <boost/numeric/ublas/vector.hpp> 
 
 #define UBVECTOR boost::numeric::ublas::vector
 
+struct JacobianStructure;
+
 /*!
  * @class VecFVec
  * @brief Base class template for vector function of a vector argument 
@@ -110,6 +113,51 @@ public:
    * derivative.
    */
   virtual double partialSize(int ip) const {return 1.0;}
+  /*!
+   * Returns the structure of the Jacobian, grouped into structurally
+   * independent columns, for use in compressed finite-difference
+   * Jacobians.
+   *
+   * The default implementation returns NULL, indicating that no
+   * structure is known, and that every column must be evaluated
+   * separately.  Subclasses that return a structure must also
+   * implement partialGroup().
+   */
+  virtual const JacobianStructure *jacobianStructure() {return 0;}
+  /*!
+   * Returns, for each column of the Jacobian, the (sorted) rows
+   * which could possibly be nonzero.
+   *
+   * Callers use this to tell which columns are coupled to a change
+   * in some of the inputs.  The default implementation returns NULL,
+   * indicating that every column may be coupled to every other.
+   */
+  virtual const std::vector<std::vector<int> > *jacobianColumnRows() {return 0;}
+  /*!
+   * Evaluate the function with all of the inputs in column group ig
+   * perturbed at once.
+   *
+   * The default implementation does a full evaluation, which is
+   * always correct, though not especially efficient.
+   *
+   * \param ig: Index of the group in jacobianStructure()->mGroups
+   */
+  virtual void partialGroup(const UBVECTOR<Ta> &arg, UBVECTOR<Tr> &rval, int ig) {(*this)(arg,rval);}
+  /*!
+   * Indicates whether trial() may be called concurrently from several
+   * threads.  The default implementation does not support it.
+   */
+  virtual bool concurrentTrials() const {return false;}
+  /*!
+   * Evaluate the function at a trial point without disturbing the
+   * state seen by a normal call, so that several trial points can be
+   * evaluated at once, e.g. by a line search.
+   *
+   * Callers must finish a batch of trials with partial(-1).  The
+   * default implementation does a normal evaluation, which is only
+   * correct when the trials are run one at a time.
+   */
+  virtual void trial(const UBVECTOR<Ta> &arg, UBVECTOR<Tr> &rval) {(*this)(arg,rval);}
   /*!
    * Turns on implementation-defined diagnostics (default is no-op)
    */
@@ -154,6 +202,16 @@ public:
    * Returns the length of the argument vector required by the function
    */
   int narg() const {return na;}
+  //! trial() is not safe to call concurrently by default
+  virtual bool concurrentTrials() const {return false;}
+  /*!
+   * Evaluate the function at a trial point without changing the
+   * state seen by a normal call.  See VecFVec::trial().  The default
+   * implementation does a normal evaluation.
+   */
+  virtual Tr trial(const UBVECTOR<Ta> &arg) {return (*this)(arg);}
+  //! Finish a batch of trial evaluations (no-op by default)
+  virtual void endTrials() {}
   //! diagnostic output does nothing by default
   virtual void prn_diagnostic(std::ostream *out) {}
 };
@@ -0,0 +1,171 @@
+#ifndef GMRES_HPP_
+#define GMRES_HPP_
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*!
+ * \file gmres.hpp
+ * \ingroup Solution
+ * \brief Restarted GMRES for a linear operator given only by its action on a vector
+ * \remark Because this function is defined as a template, we have to put the entire body in
+ *         the header file.
+ */
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <boost/numeric/ublas/vector.hpp>
+#include <boost/numeric/ublas/matrix.hpp>
+
+#define UBLAS boost::numeric::ublas
+
+/*!
+ * Solve A x = b by restarted GMRES with right preconditioning.
+ * \details The operator and preconditioner are supplied by the
+ *          caller, so that the same iteration serves both for an
+ *          assembled sparse matrix and for a Jacobian that is only
+ *          available through directional derivatives.  Right
+ *          preconditioning (A M^-1 u = b, x = M^-1 u) means the
+ *          residual being minimized is the true residual of the
+ *          original system.  Givens rotations keep the Hessenberg
+ *          least squares problem triangular as it grows.
+ * \tparam OP: class providing multiply(const vector &in, vector &out)
+ *             to compute out = A in, and precondition(vector &v) to
+ *             replace v with M^-1 v.
+ * \param[in] A: the operator and preconditioner
+ * \param[in] b: right hand side
+ * \param[out] x: solution.  The iteration starts from x = 0.
+ * \param[in] restart: dimension of the Krylov space before restarting
+ * \param[in] maxiter: maximum total number of operator applications
+ * \param[in] tol: convergence tolerance on ||b - A x|| / ||b||
+ * \param[out] resid: relative residual achieved
+ * \return number of iterations (operator applications) used
+ */
+template <class OP>
+int gmres(OP &A, const UBLAS::vector<double> &b, UBLAS::vector<double> &x,
+          int restart, int maxiter, double tol, double &resid)
+{
+  using UBLAS::inner_prod;
+  using UBLAS::norm_2;
+  const int n = b.size();
+  const int m = std::min(restart, n);
+  UBLAS::vector<double> r(n), w(n), z(n);
+  x.resize(n, false);
+  x.clear();
+  resid = 0.0;
+  const double bnorm = norm_2(b);
+  if(bnorm == 0.0)
+    return 0;
+
+  std::vector<UBLAS::vector<double> > V(m+1, UBLAS::vector<double>(n));
+  UBLAS::matrix<double> H(m+1, m);
+  std::vector<double> cs(m), sn(m), g(m+1), y(m);
+
+  int iter = 0;
+  resid = 1.0;
+  while(iter < maxiter) {
+    if(iter > 0) {
+      A.multiply(x, r);
+      r = b - r;
+    }
+    else {
+      r = b;                    // x = 0 on the first pass
+    }
+    double beta = norm_2(r);
+    resid = beta / bnorm;
+    if(resid <= tol)
+      break;
+    V[0] = r / beta;
+    std::fill(g.begin(), g.end(), 0.0);
+    g[0] = beta;
+
+    int k = 0;
+    bool breakdown = false;
+    while(k < m && iter < maxiter && resid > tol && !breakdown) {
+      z = V[k];
+      A.precondition(z);
+      A.multiply(z, w);
+      // modified Gram-Schmidt
+      for(int j=0; j<=k; ++j) {
+        H(j,k) = inner_prod(w, V[j]);
+        w -= H(j,k) * V[j];
+      }
+      H(k+1,k) = norm_2(w);
+      breakdown = H(k+1,k) == 0.0;
+      if(!breakdown)
+        V[k+1] = w / H(k+1,k);
+      for(int j=0; j<k; ++j) {
+        double h0 = H(j,k), h1 = H(j+1,k);
+        H(j,k)   =  cs[j]*h0 + sn[j]*h1;
+        H(j+1,k) = -sn[j]*h0 + cs[j]*h1;
+      }
+      double denom = sqrt(H(k,k)*H(k,k) + H(k+1,k)*H(k+1,k));
+      if(denom == 0.0) {
+        // The Krylov space has stopped growing and the projected
+        // matrix is singular; use what we have.
+        breakdown = true;
+        break;
+      }
+      cs[k] = H(k,k) / denom;
+      sn[k] = H(k+1,k) / denom;
+      H(k,k) = denom;
+      H(k+1,k) = 0.0;
+      g[k+1] = -sn[k]*g[k];
+      g[k] = cs[k]*g[k];
+      resid = fabs(g[k+1]) / bnorm;
+      ++k;
+      ++iter;
+    }
+
+    // Solve the triangular system H y = g and add M^-1 V y to x.
+    for(int i=k-1; i>=0; --i) {
+      double s = g[i];
+      for(int j=i+1; j<k; ++j)
+        s -= H(i,j) * y[j];
+      y[i] = s / H(i,i);
+    }
+    z.clear();
+    for(int j=0; j<k; ++j)
+      z += y[j] * V[j];
+    A.precondition(z);
+    x += z;
+
+    if(k == 0 || breakdown)
+      break;
+  }
+  return iter;
+}
+
+#undef UBLAS
+
+#endif
@@ -49,6 +49,9 @@
 #include "solution/util/include/isolution_info_filter.h"
 
 class SolutionInfo;
+namespace objects {
+    class Atom;
+}
 
 /*!
  * \ingroup Objects
@@ -80,8 +83,8 @@ public:
     virtual bool XMLParse( const xercesc::DOMNode* aNode );
     
 private:
-    //! The market info key to check.
-    std::string mMarketInfoKey;
+    //! The market info key to check, interned when parsed.
+    const objects::Atom* mMarketInfoKey;
 };
 
 #endif // _HAS_MARKET_FLAG_SOLUTION_INFO_FILTER_H_
@@ -0,0 +1,160 @@
+#ifndef JACOBIAN_BLOCKS_HPP_
+#define JACOBIAN_BLOCKS_HPP_
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+
+
+/*!
+ * \file jacobian-blocks.hpp
+ * \ingroup Solution
+ * \brief Block decomposition of a system of equations by its Jacobian structure
+ * \details Column j of the Jacobian has a structural nonzero in row i when
+ *          input j can change output i.  Taking these as the edges j -> i of a
+ *          directed graph, the strongly connected components are blocks of
+ *          inputs and outputs that have to be solved together, and the
+ *          condensation of the graph gives the order in which the blocks can be
+ *          solved:  once every block upstream of a block is solved, nothing
+ *          the block does can disturb them.
+ * \remark Everything here is inline, as in jacobian-coloring.hpp.
+ */
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+/*!
+ * \brief Partition a square system into strongly connected blocks and group
+ *        the blocks into levels of the condensation DAG.
+ * \details The blocks are found with Tarjan's algorithm, using an explicit
+ *          stack so that large systems do not overflow the call stack.  Level 0
+ *          holds the blocks which are not affected by any other block, and
+ *          each remaining block is placed one level below the deepest block
+ *          that affects it.  The blocks within a level are independent of each
+ *          other.
+ * \param[in] aColRows For each column, the rows which could possibly be
+ *                     nonzero.  The system must be square.
+ * \param[out] aBlocks The (sorted) columns in each block.
+ * \param[out] aLevels The blocks in each level, upstream levels first.
+ * \return The number of strongly connected blocks.
+ */
+inline int findJacobianBlocks(const std::vector<std::vector<int> > &aColRows,
+                              std::vector<std::vector<int> > &aBlocks,
+                              std::vector<std::vector<int> > &aLevels)
+{
+    const int n = aColRows.size();
+    std::vector<int> index(n, -1);
+    std::vector<int> lowlink(n, 0);
+    std::vector<int> block(n, -1);
+    std::vector<bool> onstack(n, false);
+    std::vector<int> stack;
+    // (vertex, next edge to follow) for each vertex being visited
+    std::vector<std::pair<int, size_t> > visiting;
+    int nextIndex = 0;
+    int nblock = 0;
+
+    for(int s=0; s<n; ++s) {
+        if(index[s] >= 0) {
+            continue;
+        }
+        index[s] = lowlink[s] = nextIndex++;
+        stack.push_back(s);
+        onstack[s] = true;
+        visiting.push_back(std::make_pair(s, size_t(0)));
+        while(!visiting.empty()) {
+            const int v = visiting.back().first;
+            if(visiting.back().second < aColRows[v].size()) {
+                const int w = aColRows[v][visiting.back().second++];
+                if(index[w] < 0) {
+                    index[w] = lowlink[w] = nextIndex++;
+                    stack.push_back(w);
+                    onstack[w] = true;
+                    visiting.push_back(std::make_pair(w, size_t(0)));
+                }
+                else if(onstack[w]) {
+                    lowlink[v] = std::min(lowlink[v], index[w]);
+                }
+                continue;
+            }
+
+            // all edges out of v have been followed
+            visiting.pop_back();
+            if(!visiting.empty()) {
+                const int u = visiting.back().first;
+                lowlink[u] = std::min(lowlink[u], lowlink[v]);
+            }
+            if(lowlink[v] == index[v]) {
+                int w;
+                do {
+                    w = stack.back();
+                    stack.pop_back();
+                    onstack[w] = false;
+                    block[w] = nblock;
+                } while(w != v);
+                ++nblock;
+            }
+        }
+    }
+
+    // Tarjan's algorithm completes a block only after every block it affects,
+    // so visiting the blocks from last to first visits them upstream first.
+    std::vector<std::vector<int> > &blockCols = aBlocks;
+    blockCols.assign(nblock, std::vector<int>());
+    for(int j=0; j<n; ++j) {
+        blockCols[block[j]].push_back(j);
+    }
+    std::vector<int> level(nblock, 0);
+    int nlevel = 0;
+    for(int b=nblock-1; b>=0; --b) {
+        nlevel = std::max(nlevel, level[b] + 1);
+        for(size_t c=0; c<blockCols[b].size(); ++c) {
+            const std::vector<int> &rows = aColRows[blockCols[b][c]];
+            for(size_t r=0; r<rows.size(); ++r) {
+                const int rb = block[rows[r]];
+                if(rb != b) {
+                    level[rb] = std::max(level[rb], level[b] + 1);
+                }
+            }
+        }
+    }
+
+    aLevels.assign(nlevel, std::vector<int>());
+    for(int b=nblock-1; b>=0; --b) {
+        aLevels[level[b]].push_back(b);
+    }
+
+    return nblock;
+}
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef JACOBIAN_COLORING_HPP_
+#define JACOBIAN_COLORING_HPP_
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*!
+ * \file jacobian-coloring.hpp
+ * \ingroup Solution
+ * \brief Column grouping for compressed finite-difference Jacobians
+ * \details Two columns of a Jacobian are structurally independent if there is
+ *          no row in which both of them can be nonzero.  All of the columns in
+ *          a group of mutually independent columns can be perturbed together
+ *          and recovered from a single function evaluation (Curtis, Powell, and
+ *          Reid, 1974).  The grouping is a coloring of the column intersection
+ *          graph, which we compute with a greedy algorithm.
+ * \remark Everything here is inline so that it can be used from the template
+ *         code in fdjac.hpp without any additional compilation unit.
+ */
+
+#include <vector>
+#include <algorithm>
+
+/*!
+ * \brief The structure of a Jacobian as seen by a compressed finite-difference
+ *        calculation.
+ * \details The function being differentiated is responsible for filling in
+ *          mColRows.  The remaining members are filled in by
+ *          colorJacobianColumns.
+ */
+struct JacobianStructure {
+    //! For each column, the (sorted) rows which could possibly be nonzero.
+    std::vector<std::vector<int> > mColRows;
+
+    //! The columns in each group.  Every column appears in exactly one group.
+    std::vector<std::vector<int> > mGroups;
+
+    //! The group to which each column was assigned.
+    std::vector<int> mColGroup;
+
+    //! Number of column groups (i.e., function evaluations per Jacobian).
+    int ngroup() const {return mGroups.size();}
+};
+
+/*!
+ * \brief Comparison functor to order columns with the most structural
+ *        nonzeros first, breaking ties by column index.
+ */
+struct LargerColumnFirst {
+    const std::vector<std::vector<int> > &mColRows;
+    LargerColumnFirst(const std::vector<std::vector<int> > &aColRows) : mColRows(aColRows) {}
+    bool operator()(int aLHS, int aRHS) const {
+        return mColRows[aLHS].size() != mColRows[aRHS].size() ?
+            mColRows[aLHS].size() > mColRows[aRHS].size() : aLHS < aRHS;
+    }
+};
+
+/*!
+ * \brief Partition the columns of a Jacobian into structurally independent groups
+ * \details Uses the largest-first greedy heuristic: columns are visited in
+ *          order of decreasing number of structural nonzeros, and each one is
+ *          assigned to the lowest numbered group that has not yet claimed any
+ *          of its rows.  The result is deterministic for a given structure.
+ * \param[in,out] aStructure Jacobian structure.  mColRows must be set on
+ *                input; mGroups and mColGroup are set on output.
+ * \param[in] nrow The number of rows in the Jacobian.
+ * \return The number of groups.
+ */
+inline int colorJacobianColumns(JacobianStructure &aStructure, int nrow)
+{
+    const std::vector<std::vector<int> > &colrows = aStructure.mColRows;
+    int ncol = colrows.size();
+    std::vector<int> order(ncol);
+    for(int j=0; j<ncol; ++j) {
+        order[j] = j;
+    }
+    std::sort(order.begin(), order.end(), LargerColumnFirst(colrows));
+
+    // rowgroup[i] holds the groups that already have a nonzero in row i.
+    // forbid[g] == j marks group g as unavailable for column j.
+    std::vector<std::vector<int> > rowgroup(nrow);
+    std::vector<int> forbid;
+    aStructure.mColGroup.assign(ncol, -1);
+    aStructure.mGroups.clear();
+
+    for(int k=0; k<ncol; ++k) {
+        int j = order[k];
+        for(size_t r=0; r<colrows[j].size(); ++r) {
+            const std::vector<int> &used = rowgroup[colrows[j][r]];
+            for(size_t u=0; u<used.size(); ++u) {
+                forbid[used[u]] = j;
+            }
+        }
+        int g = 0;
+        while(g < int(forbid.size()) && forbid[g] == j) {
+            ++g;
+        }
+        if(g == int(forbid.size())) {
+            forbid.push_back(-1);
+            aStructure.mGroups.push_back(std::vector<int>());
+        }
+        aStructure.mColGroup[j] = g;
+        aStructure.mGroups[g].push_back(j);
+        for(size_t r=0; r<colrows[j].size(); ++r) {
+            rowgroup[colrows[j][r]].push_back(g);
+        }
+    }
+
+    // keep the columns within each group in their natural order
+    for(size_t g=0; g<aStructure.mGroups.size(); ++g) {
+        std::sort(aStructure.mGroups[g].begin(), aStructure.mGroups[g].end());
+    }
+
+    return aStructure.ngroup();
+}
+
+#endif
@@ -0,0 +1,268 @@
+#ifndef JACOBIAN_STORE_HPP_
+#define JACOBIAN_STORE_HPP_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*!
+ * \file jacobian_store.hpp
+ * \ingroup Solution
+ * \brief Storage for solver Jacobians so they can warm start later solutions
+ * \details Solving a period starts by computing a full finite-difference
+ *          Jacobian, yet the Jacobian changes little from one period to
+ *          the next, or between scenarios that differ only in policy.
+ *          The JacobianStore keeps the final Jacobian of the latest solved
+ *          period so that the next period may start from it, and the
+ *          Jacobians of every period of a reference scenario so that later
+ *          scenarios of a batch may start from the same period of it.  The
+ *          reference is the first scenario run in the process, or the one
+ *          loaded from a file written by another process.
+ */
+
+#include <map>
+#include <string>
+#include <iosfwd>
+#include <vector>
+#include <boost/numeric/ublas/matrix.hpp>
+#include <boost/numeric/ublas/vector.hpp>
+#include <boost/core/noncopyable.hpp>
+
+/*!
+ * \ingroup Solution
+ * \brief A process wide store of Jacobians by model period.
+ * \details Jacobians are stored without the input and output scaling the
+ *          solver applied, since those scales are based on the forecast
+ *          prices and demands of each period, and are rescaled when they
+ *          are retrieved.  Markets are matched by name so the set of markets
+ *          may change between the stored and retrieved Jacobian.
+ *
+ *          Only the entries in the structure of the Jacobian given by the
+ *          solver are kept, so each stored Jacobian takes memory in
+ *          proportion to its structural nonzeros rather than the square of
+ *          the number of markets.  At most one Jacobian for each period of
+ *          the reference scenario and one for the latest period of the
+ *          current scenario are kept.
+ */
+class JacobianStore : private boost::noncopyable {
+public:
+    static JacobianStore& getInstance();
+
+    template<class MTRAIT>
+    void store( const int aPeriod, const bool aIsLogPrice, const std::vector<std::string>& aNames,
+                const boost::numeric::ublas::vector<double>& aInputScale,
+                const boost::numeric::ublas::vector<double>& aOutputScale,
+                const boost::numeric::ublas::matrix<double, MTRAIT>& aJacobian,
+                const std::vector<std::vector<int> >& aColumnRows );
+
+    template<class MTRAIT>
+    bool retrieve( const int aPeriod, const bool aIsLogPrice, const std::vector<std::string>& aNames,
+                   const boost::numeric::ublas::vector<double>& aInputScale,
+                   const boost::numeric::ublas::vector<double>& aOutputScale,
+                   boost::numeric::ublas::matrix<double, MTRAIT>& aJacobian,
+                   std::vector<int>& aMissingColumns ) const;
+
+    /*!
+     * \brief Note that a solver will warm start from the store.
+     */
+    void enable() {
+        mIsEnabled = true;
+    }
+
+    /*!
+     * \brief Whether any solver parsed so far warm starts from the store.
+     * \return True if the store is in use.
+     */
+    bool isEnabled() const {
+        return mIsEnabled;
+    }
+
+    void beginScenario();
+
+    void endScenario();
+
+    void clear();
+
+    void save( std::ostream& aOut ) const;
+
+    bool load( std::istream& aIn );
+
+private:
+    //! The nonzero entries of a column as the stored row and the value,
+    //! sorted by row.
+    typedef std::vector<std::pair<int, double> > SparseColumn;
+
+    //! A Jacobian saved for a single period.
+    struct StoredJacobian {
+        StoredJacobian():mIsLogPrice( true ) {}
+
+        //! Whether the Jacobian is in log price space.
+        bool mIsLogPrice;
+
+        //! The row and column of each market by market name.
+        std::map<std::string, int> mIndex;
+
+        //! The columns of the unscaled Jacobian.
+        std::vector<SparseColumn> mColumns;
+    };
+
+    //! Whether a solver warm starts from the store.
+    bool mIsEnabled;
+
+    //! Whether Jacobians stored are also kept as the reference scenario's.
+    bool mIsRecordingReference;
+
+    //! The period of mLatest or -1 if nothing has been stored this scenario.
+    int mLatestPeriod;
+
+    //! The Jacobian of the latest period stored in the current scenario.
+    StoredJacobian mLatest;
+
+    //! The Jacobians of the reference scenario by model period.
+    std::map<int, StoredJacobian> mReference;
+
+    JacobianStore();
+
+    void merge( const int aPeriod, const bool aIsLogPrice, const std::vector<std::string>& aNames,
+                const std::vector<SparseColumn>& aColumns );
+
+    const StoredJacobian* find( const int aPeriod, const bool aIsLogPrice ) const;
+};
+
+/*!
+ * \brief Save the Jacobian a solver finished a period with.
+ * \details Only the entries in aColumnRows are kept.  The Jacobian is merged
+ *          into the one already stored for the scenario so that a solver
+ *          which only solves a block of the markets, such as LogBroyden with
+ *          block-solve, does not discard what was stored for the other
+ *          markets.  See merge() for the details.
+ * \param aPeriod The model period the Jacobian was computed in.
+ * \param aIsLogPrice Whether the solver was working in log price space.
+ * \param aNames The name of the market for each row and column.
+ * \param aInputScale The scale factor the solver applied to each input.
+ * \param aOutputScale The scale factor the solver applied to each output.
+ * \param aJacobian The scaled Jacobian J(i,j) = dF_i/dx_j.
+ * \param aColumnRows The rows of each column which may be nonzero.
+ */
+template<class MTRAIT>
+void JacobianStore::store( const int aPeriod, const bool aIsLogPrice, const std::vector<std::string>& aNames,
+                           const boost::numeric::ublas::vector<double>& aInputScale,
+                           const boost::numeric::ublas::vector<double>& aOutputScale,
+                           const boost::numeric::ublas::matrix<double, MTRAIT>& aJacobian,
+                           const std::vector<std::vector<int> >& aColumnRows )
+{
+    const size_t n = aNames.size();
+    std::vector<SparseColumn> columns( n );
+    for( size_t j = 0; j < n; ++j ) {
+        const std::vector<int>& rows = aColumnRows[ j ];
+        columns[ j ].reserve( rows.size() );
+        for( size_t k = 0; k < rows.size(); ++k ) {
+            const int i = rows[ k ];
+            const double value = aJacobian( i, j ) / ( aOutputScale[ i ] * aInputScale[ j ] );
+            if( value != 0.0 ) {
+                columns[ j ].push_back( std::make_pair( i, value ) );
+            }
+        }
+    }
+    merge( aPeriod, aIsLogPrice, aNames, columns );
+}
+
+/*!
+ * \brief Fill in a Jacobian from a stored one.
+ * \details A Jacobian stored for aPeriod in the current scenario is preferred,
+ *          then the one the reference scenario stored for aPeriod, and lastly
+ *          the one stored for an earlier period of the current scenario.
+ *          Entries not in the stored Jacobian are set to zero.  The columns
+ *          of markets that are not in it are returned in aMissingColumns so
+ *          that the caller can compute them.  Markets in the stored Jacobian
+ *          that are no longer being solved are simply dropped.
+ * \param aPeriod The model period to get a Jacobian for.
+ * \param aIsLogPrice Whether the solver is working in log price space.
+ * \param aNames The name of the market for each row and column.
+ * \param aInputScale The scale factor the solver applies to each input.
+ * \param aOutputScale The scale factor the solver applies to each output.
+ * \param aJacobian The Jacobian to fill in, which must already be sized.
+ * \param aMissingColumns The columns which could not be filled in.
+ * \return Whether a Jacobian covering at least half of the markets was found,
+ *         aJacobian is not modified if not.
+ */
+template<class MTRAIT>
+bool JacobianStore::retrieve( const int aPeriod, const bool aIsLogPrice, const std::vector<std::string>& aNames,
+                              const boost::numeric::ublas::vector<double>& aInputScale,
+                              const boost::numeric::ublas::vector<double>& aOutputScale,
+                              boost::numeric::ublas::matrix<double, MTRAIT>& aJacobian,
+                              std::vector<int>& aMissingColumns ) const
+{
+    const StoredJacobian* stored = find( aPeriod, aIsLogPrice );
+    if( !stored ) {
+        return false;
+    }
+
+    // Map each market to its position in the stored Jacobian and back.
+    const size_t n = aNames.size();
+    std::vector<int> storedIndex( n, -1 );
+    std::vector<int> solverIndex( stored->mColumns.size(), -1 );
+    aMissingColumns.clear();
+    for( size_t i = 0; i < n; ++i ) {
+        std::map<std::string, int>::const_iterator iter = stored->mIndex.find( aNames[ i ] );
+        if( iter != stored->mIndex.end() ) {
+            storedIndex[ i ] = iter->second;
+            solverIndex[ iter->second ] = i;
+        }
+        else {
+            aMissingColumns.push_back( i );
+        }
+    }
+    if( aMissingColumns.size() * 2 > n ) {
+        aMissingColumns.clear();
+        return false;
+    }
+
+    aJacobian.clear();
+    for( size_t j = 0; j < n; ++j ) {
+        if( storedIndex[ j ] < 0 ) {
+            continue;
+        }
+        const SparseColumn& column = stored->mColumns[ storedIndex[ j ] ];
+        for( SparseColumn::const_iterator entry = column.begin(); entry != column.end(); ++entry ) {
+            const int i = solverIndex[ entry->first ];
+            if( i >= 0 ) {
+                aJacobian( i, j ) = entry->second * aOutputScale[ i ] * aInputScale[ j ];
+            }
+        }
+    }
+    return true;
+}
+
+#endif // JACOBIAN_STORE_HPP_
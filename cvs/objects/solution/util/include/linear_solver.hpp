@@ -0,0 +1,286 @@
+#ifndef LINEAR_SOLVER_HPP_
+#define LINEAR_SOLVER_HPP_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*!
+ * \file linear_solver.hpp
+ * \ingroup Solution
+ * \brief Linear solver back-ends for the Newton and Broyden solvers
+ * \details The Newton-type solvers need to solve J dx = -F(x) on
+ *          every iteration.  Historically this was done with a dense
+ *          LU (or with an SVD when LAPACK is available).  The models
+ *          we solve have Jacobians that are mostly zeros, so this
+ *          file also provides a sparse direct LU with a fill-reducing
+ *          ordering and a restarted GMRES preconditioned with ILU(0).
+ *          The solver components select a back-end with the
+ *          <linear-solver> element in their configuration.
+ */
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <boost/numeric/ublas/matrix.hpp>
+#include <boost/numeric/ublas/vector.hpp>
+#include <boost/numeric/ublas/lu.hpp>
+#include <xercesc/dom/DOMNode.hpp>
+
+#if USE_LAPACK
+#define UBMATRIX boost::numeric::ublas::matrix<double,boost::numeric::ublas::column_major>
+#else
+#define UBMATRIX boost::numeric::ublas::matrix<double>
+#endif
+#define UBVECTOR boost::numeric::ublas::vector<double>
+
+/*!
+ * \brief Abstract interface for solving J x = b with a (possibly
+ *        approximate) Jacobian.
+ * \details The solvers keep the Jacobian as a dense matrix, since
+ *          that is what fdjac and the preconditioner produce.  A
+ *          LinearSolver is handed that matrix and may convert it to
+ *          whatever representation it likes.  Factorization never
+ *          modifies the matrix passed in, so callers do not need to
+ *          keep a backup copy.
+ */
+class LinearSolver {
+public:
+    virtual ~LinearSolver() {}
+
+    //! Create a linear solver from a <linear-solver> element.  Returns NULL if the name is not recognized.
+    static LinearSolver* create( const xercesc::DOMNode* aNode );
+    //! Create a linear solver with default parameters.  Returns NULL if the name is not recognized.
+    static LinearSolver* create( const std::string& aName );
+    //! Name of the back-end used when none is configured.
+    static const std::string& getDefaultName();
+    //! Solve J x = b with sparse LU, or dense LU if that fails.  Returns 0 on success, as for factorize().
+    static int solveDirect( const UBMATRIX& aJ, UBVECTOR& aB, std::ostream& aLog );
+
+    virtual const std::string& getName() const = 0;
+
+    /*!
+     * \brief Record the structure of a freshly computed Jacobian.
+     * \details Called whenever the Jacobian has been recomputed from
+     *          scratch.  Sparse back-ends take their nonzero pattern
+     *          and fill-reducing ordering from here; the dense ones
+     *          ignore it.
+     */
+    virtual void analyze( const UBMATRIX& aJ ) {}
+
+    //! Whether this back-end makes use of setStructure().
+    virtual bool needsStructure() const { return false; }
+
+    /*!
+     * \brief Fix the nonzero pattern from the structure of the Jacobian.
+     * \details When the structure is known, sparse back-ends build their
+     *          pattern and ordering here, once, and analyze() no longer
+     *          needs to scan the dense matrix.  The dense ones ignore it.
+     * \param aColRows For each column, the rows which could be nonzero.
+     */
+    virtual void setStructure( const std::vector<std::vector<int> >& aColRows ) {}
+
+    /*!
+     * \brief Factor the matrix for subsequent calls to solve().
+     * \return 0 on success.  If the matrix is singular, the (1-based)
+     *         index of the row at which the factorization broke down.
+     */
+    virtual int factorize( const UBMATRIX& aJ ) = 0;
+
+    /*!
+     * \brief Solve J x = b using the most recent factorization.
+     * \param[in,out] aB Right-hand side on input, solution on output.
+     * \param aLog Stream for diagnostic messages.
+     * \return Number of singular directions that had to be dropped to
+     *         produce the solution (always zero for the LU back-ends),
+     *         or -1 if an iterative back-end did not converge.  In that
+     *         case aB is left unchanged and the caller can fall back to
+     *         solveDirect().
+     */
+    virtual int solve( UBVECTOR& aB, std::ostream& aLog ) = 0;
+
+    /*!
+     * \brief Apply the Broyden secant update B += (dF - B dx) dx' / (dx' dx).
+     * \details Sparse back-ends override this to preserve the nonzero
+     *          pattern recorded by analyze() (Schubert's update), so
+     *          that the factorization cost does not grow as the
+     *          approximate Jacobian fills in.  Any other change to the
+     *          matrix must be followed by a call to analyze().
+     */
+    virtual void update( UBMATRIX& aB, const UBVECTOR& aDF, const UBVECTOR& aDX );
+};
+
+/*!
+ * \brief Dense LU factorization with partial pivoting.
+ * \details This is what the solvers have always used when LAPACK is
+ *          not available.
+ */
+class DenseLUSolver : public LinearSolver {
+public:
+    DenseLUSolver():mPerm( 0 ) {}
+    virtual const std::string& getName() const;
+    virtual int factorize( const UBMATRIX& aJ );
+    virtual int solve( UBVECTOR& aB, std::ostream& aLog );
+    static const std::string& getNameStatic();
+protected:
+    UBMATRIX mLU;
+    boost::numeric::ublas::permutation_matrix<std::size_t> mPerm;
+};
+
+#if USE_LAPACK
+/*!
+ * \brief Dense solve by singular value decomposition.
+ * \details Singular directions are dropped from the solution rather
+ *          than causing the factorization to fail.
+ */
+class SVDSolver : public LinearSolver {
+public:
+    virtual const std::string& getName() const;
+    virtual int factorize( const UBMATRIX& aJ );
+    virtual int solve( UBVECTOR& aB, std::ostream& aLog );
+    static const std::string& getNameStatic();
+protected:
+    UBMATRIX mU, mVT;
+    UBVECTOR mS;
+};
+#endif
+
+/*!
+ * \brief Sparse LU factors stored by rows.
+ * \details Rows are eliminated in the order given by mRowOrder (the
+ *          fill-reducing ordering).  Columns are identified by their
+ *          original index; mColPos gives the pivot position of each
+ *          column, which can move away from the diagonal of the
+ *          ordered matrix when threshold pivoting finds the diagonal
+ *          element too small.  If fill is not allowed the same
+ *          routine computes an ILU(0) factorization.
+ */
+struct SparseLUFactors {
+    int mN;
+    std::vector<int> mRowOrder;                  //!< original row eliminated at step k
+    std::vector<int> mPosCol;                    //!< original column pivoted at step k
+    std::vector<int> mColPos;                    //!< inverse of mPosCol
+    std::vector<double> mDiag;                   //!< U(k,k)
+    std::vector<std::vector<std::pair<int,double> > > mL; //!< L(k,j) for j<k, as (step j, value)
+    std::vector<std::vector<std::pair<int,double> > > mU; //!< U(k,c) off the diagonal, as (column c, value)
+
+    int factor( const std::vector<int>& aRowStart, const std::vector<int>& aColIndex,
+                const std::vector<double>& aValues, const std::vector<int>& aOrdering,
+                bool aAllowFill, double aPivotThreshold );
+    int refactor( const std::vector<int>& aRowStart, const std::vector<int>& aColIndex,
+                  const std::vector<double>& aValues, bool aAllowFill, double aPivotThreshold );
+    void solve( UBVECTOR& aB ) const;
+    std::size_t nonzeros() const;
+};
+
+/*!
+ * \brief Common base for the back-ends that keep the matrix in
+ *        compressed sparse row form.
+ */
+class SparseMatrixSolver : public LinearSolver {
+public:
+    SparseMatrixSolver():mN( 0 ), mFixedPattern( false ), mValuesCurrent( false ), mPatternVersion( 0 ),
+        mFactorVersion( -1 ) {}
+    virtual void analyze( const UBMATRIX& aJ );
+    virtual bool needsStructure() const { return true; }
+    virtual void setStructure( const std::vector<std::vector<int> >& aColRows );
+    virtual void update( UBMATRIX& aB, const UBVECTOR& aDF, const UBVECTOR& aDX );
+    void multiply( const UBVECTOR& aX, UBVECTOR& aY ) const;
+protected:
+    void gather( const UBMATRIX& aJ );
+    void setPattern();
+    int factorValues( bool aAllowFill, double aPivotThreshold );
+
+    int mN;
+    std::vector<int> mRowStart;
+    std::vector<int> mColIndex;
+    std::vector<double> mValues;
+    //! Fill-reducing elimination order computed by analyze()
+    std::vector<int> mOrdering;
+    SparseLUFactors mFactors;
+    //! Whether the pattern came from setStructure() rather than a scan of the matrix
+    bool mFixedPattern;
+    //! Whether mValues hold the matrix, either gathered or kept up to date by update()
+    bool mValuesCurrent;
+    //! Incremented whenever the pattern or ordering changes
+    int mPatternVersion;
+    //! The pattern version for which mFactors holds a reusable symbolic factorization
+    int mFactorVersion;
+};
+
+/*!
+ * \brief Sparse direct LU with a minimum-degree ordering and
+ *        threshold partial pivoting.
+ */
+class SparseLUSolver : public SparseMatrixSolver {
+public:
+    SparseLUSolver( double aPivotThreshold = 0.1 ):mPivotThreshold( aPivotThreshold ) {}
+    virtual const std::string& getName() const;
+    virtual int factorize( const UBMATRIX& aJ );
+    virtual int solve( UBVECTOR& aB, std::ostream& aLog );
+    static const std::string& getNameStatic();
+protected:
+    double mPivotThreshold;
+};
+
+/*!
+ * \brief Restarted GMRES (see gmres.hpp), right-preconditioned with ILU(0).
+ * \details The solve is iterative, so the result is only accurate to
+ *          mTol relative residual.  That is generally plenty for the
+ *          Newton step, which is followed by a line search anyhow.
+ *          If the true residual does not reach mTol, solve() reports
+ *          failure so that the caller can solve directly instead.
+ */
+class GMRESSolver : public SparseMatrixSolver {
+public:
+    GMRESSolver( int aRestart = 30, int aMaxIter = 300, double aTol = 1.0e-8 ):
+        mRestart( aRestart ), mMaxIter( aMaxIter ), mTol( aTol ), mLastIter( 0 ) {}
+    virtual const std::string& getName() const;
+    virtual int factorize( const UBMATRIX& aJ );
+    virtual int solve( UBVECTOR& aB, std::ostream& aLog );
+    void setParameters( int aRestart, int aMaxIter, double aTol );
+    void precondition( UBVECTOR& aV ) const;
+    static const std::string& getNameStatic();
+protected:
+    int mRestart;
+    int mMaxIter;
+    double mTol;
+    //! iterations used in the last solve
+    int mLastIter;
+};
+
+#undef UBMATRIX
+#undef UBVECTOR
+
+#endif
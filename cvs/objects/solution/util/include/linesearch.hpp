@@ -48,9 +48,108 @@
 #include <boost/numeric/ublas/vector.hpp>
 #include <algorithm>
 #include <iostream>
+#include <vector>
+
+#if GCAM_PARALLEL_ENABLED
+#include <tbb/task_group.h>
+#include <tbb/parallel_for.h>
+#include "containers/include/scenario.h"
+#include "util/base/include/manage_state_variables.hpp"
+#include "util/base/include/timer.h"
+
+extern Scenario* scenario;
+#endif
 
 #define UBLAS boost::numeric::ublas
 
+#if GCAM_PARALLEL_ENABLED
+/*!
+ * Continue a line search by evaluating several step lengths at once.
+ * Each batch starts from the current estimate of lambda and halves it
+ * for each further trial.  The trials are run concurrently on
+ * separate state slots using f.trial(), and the longest step that
+ * passes the sufficient decrease test is accepted.  If none of them
+ * pass, the next batch starts from the quadratic backtrack from the
+ * shortest trial, as in linesearch().
+ * \param[in] lambda: Length of the first step to try
+ * \param[in] lmin: Minimum admissable value for lambda
+ * \param[in] lseps: Sufficient decrease parameter
+ * \param[in] ntrial: Number of step lengths to evaluate at once
+ * \remark The remaining parameters are as for linesearch().  The
+ *         accepted step is recalculated with a normal evaluation so
+ *         that the model is left at x on return.  Time spent on the
+ *         trials is kept in the "linesearch-trials" timer so it can be
+ *         compared against the serial flow-graph evaluations.
+ * \return : 0= success, anything else= fail
+ */
+template <class FTYPE>
+int linesearch_trials(SclFVec<FTYPE,FTYPE> &f, const UBLAS::vector<FTYPE> &x0,
+                      FTYPE f0, FTYPE g0dx, const UBLAS::vector<FTYPE> &dx,
+                      FTYPE lambda, FTYPE lmin, FTYPE lseps, UBLAS::vector<FTYPE> &x,
+                      FTYPE &fx, int &neval, int ntrial, std::ostream *solverlog)
+{
+  Timer& trialTimer = TimerRegistry::getInstance().getTimer("linesearch-trials");
+  tbb::task_arena& threadPool = scenario->getManageStateVariables()->mThreadPool;
+  std::vector<FTYPE> lambdas;
+  std::vector<FTYPE> ftrial;
+  int accept = -1;
+
+  while(accept < 0 && lambda > lmin) {
+    lambdas.clear();
+    for(int k=0; k<ntrial && lambda > lmin; ++k) {
+      lambdas.push_back(lambda);
+      lambda *= 0.5;
+    }
+    ftrial.assign(lambdas.size(), 0.0);
+
+    trialTimer.start();
+    scenario->getManageStateVariables()->setPartialDeriv(true);
+    tbb::task_group tg;
+    threadPool.execute([&](){
+        tg.run([&](){
+            tbb::parallel_for(size_t(0), lambdas.size(), [&](size_t k) {
+                UBLAS::vector<FTYPE> xk(x0 + lambdas[k]*dx);
+                ftrial[k] = f.trial(xk);
+            });
+        });
+    });
+    threadPool.execute([&tg](){ tg.wait(); });
+    f.endTrials();
+    trialTimer.stop();
+    neval += lambdas.size();
+
+    for(size_t k=0; k<lambdas.size(); ++k) {
+      if(solverlog)
+        (*solverlog) << "\tlambda = " << lambdas[k] << "  fx = " << ftrial[k] << " (trial)\n";
+      if(accept < 0 && ftrial[k] <= f0 + lseps*lambdas[k]*g0dx)
+        accept = k;
+    }
+
+    if(accept < 0) {
+      // backtrack from the shortest step, as in linesearch()
+      FTYPE lk = lambdas.back();
+      FTYPE denom = ftrial.back() - f0 - g0dx*lk;
+      FTYPE lnext = denom != 0.0 ? -g0dx * (lk*lk)/(2.0 * denom) : 0.5*lk;
+      lambda = std::max(0.1*lk, std::min(0.5*lk, lnext));
+    }
+  }
+
+  if(solverlog)
+    (*solverlog) << "\tTotal line search trial time: " << trialTimer.getTotalTimeDifference() << "\n";
+
+  if(accept < 0)
+    return 1;
+
+  // Recalculate the accepted step so that the model is left at x.
+  x  = x0 + lambdas[accept]*dx;
+  fx = f(x);
+  neval++;
+  if(solverlog)
+    (*solverlog) << "\tAccepted trial lambda = " << lambdas[accept] << "  fx = " << fx << std::endl;
+  return 0;
+}
+#endif
+
 /*!
  * Perform a line search for use in multidimensional root finders.  This is NOT a 1-D
  * minimization routine!
@@ -66,6 +165,9 @@
  * \param[inout]neval: number of function evaluations. The subroutine
  * adds whatever value is passed in, allowing the caller to keep a
  * running total.
+ * \param[in] ntrial: number of step lengths to evaluate at once when
+ * the full step fails.  Values greater than 1 only take effect when
+ * GCAM_PARALLEL_ENABLED and f supports concurrent trials.
  * \return : 0= success, anything else= fail
  *
  */
@@ -73,7 +175,7 @@ template <class FTYPE>
 int linesearch(SclFVec<FTYPE,FTYPE> &f, const UBLAS::vector<FTYPE> &x0,
                FTYPE f0, const UBLAS::vector<FTYPE> &g0,
                const UBLAS::vector<FTYPE> &dx, UBLAS::vector<FTYPE> &x,
-               FTYPE &fx, int &neval, std::ostream *solverlog = 0)
+               FTYPE &fx, int &neval, std::ostream *solverlog = 0, int ntrial = 1)
 {
   const FTYPE lseps = 1.0e-7;   // part of the definition of "sufficient" decrease
   const FTYPE TOLX = 1.0e-6;    // tolerance for x values
@@ -146,6 +248,14 @@ int linesearch(SclFVec<FTYPE,FTYPE> &f, const UBLAS::vector<FTYPE> &x0,
       lambda = 0.5*lambda;
 
     lambda = std::max(tl0, std::min(tl1,lambda));
+
+#if GCAM_PARALLEL_ENABLED
+    // The full step has failed.  Evaluate the remaining backtracking
+    // steps several at a time rather than one after another.
+    if(ntrial > 1 && f.concurrentTrials())
+      return linesearch_trials(f, x0, f0, g0dx, dx, lambda, lmin, lseps, x, fx,
+                               neval, ntrial, solverlog);
+#endif
   }
   
   // If we get here, then the line search failed.  Depending on the
@@ -104,6 +104,8 @@ public:
     double getED() const;
     double getEDLeft() const;
     double getEDRight() const;
+    double getXLeft() const;
+    double getXRight() const;
     void expandBracket( const double aAdjFactor );
     double getRelativeED() const;
     bool isWithinTolerance() const;
@@ -115,6 +117,8 @@ public:
     void decreaseX( const double multiplier, const double lowerBound );
     void moveRightBracketToX();
     void moveLeftBracketToX();
+    void setRightBracket( const double aX, const double aED );
+    void setLeftBracket( const double aX, const double aED );
     void resetBrackets();
     bool isCurrentlyBracketed() const;
     bool isSolved() const;
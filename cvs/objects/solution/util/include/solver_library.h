@@ -95,7 +95,13 @@ public:
 
    static bool bracket( Marketplace* aMarketplace, World* aWorld, const double aDefaultBracketInterval,
                         const unsigned int aMaxIterations, SolutionInfoSet& aSolSet, CalcCounter* aCalcCounter,
-                        const ISolutionInfoFilter* aSolutionInfoFilter, const int aPeriod );
+                        const ISolutionInfoFilter* aSolutionInfoFilter, const int aPeriod,
+                        const unsigned int aNumCandidates = 1 );
+
+   static void evaluateCandidates( Marketplace* aMarketplace, World* aWorld, SolutionInfoSet& aSolutionSet,
+                                   const std::vector<std::vector<double> >& aCandidatePrices,
+                                   std::vector<std::vector<double> >& aCandidateED,
+                                   std::vector<double>& aCandidateMaxRelED, const int aPeriod );
 
 private:
     //! A function object to compare to values and see if they are approximately equal. 
@@ -35,6 +35,8 @@
 #include <assert.h>
 #include <set>
 #include <vector>
+#include <map>
+#include <algorithm>
 #include "solution/util/include/edfun.hpp"
 #include "util/base/include/fltcmp.hpp"
 #include "containers/include/iactivity.h"
@@ -59,7 +61,8 @@ LogEDFun::LogEDFun(SolutionInfoSet &sisin,
     mkts(sisin.getSolvableSet()),
     solnset(sisin),
     world(w), mktplc(m), period(per),
-    mLogPricep(aLogPricep)
+    mLogPricep(aLogPricep),
+    mColoredJacobian(false)
 {
     na=nr=mkts.size();
     mdiagnostic=false;
@@ -280,16 +283,349 @@ void LogEDFun::operator()(const UBVECTOR<double> &ax, UBVECTOR<double> &fx, cons
     }
   }
 
-  
+
+  /****
+   * 3 Collect the outputs
+   ****/
+  collectOutputs(x, fx);
+}
+
+
+/*!
+ * \brief Turn the compressed (column-grouped) Jacobian on or off.
+ * \details When on, jacobianStructure() will report the structure of the
+ *          Jacobian so that fdjac can evaluate structurally independent
+ *          columns together.
+ * \param aColored Flag indicating whether to use the compressed Jacobian.
+ */
+void LogEDFun::setColoredJacobian(bool aColored)
+{
+    mColoredJacobian = aColored;
+}
+
+/*!
+ * \brief Get the structure of the Jacobian for compressed finite differences.
+ * \details The structure is computed the first time it is requested and reused
+ *          for the lifetime of this object, since the set of markets and the
+ *          activities that depend on them do not change within a solver call.
+ * \return The Jacobian structure, or NULL if compressed Jacobians are not in
+ *         use.
+ */
+const JacobianStructure *LogEDFun::jacobianStructure()
+{
+    if(!mColoredJacobian) {
+        return 0;
+    }
+    if(mJacStructure.mGroups.empty() && !mkts.empty()) {
+        findJacobianStructure();
+    }
+    return &mJacStructure;
+}
+
+/*!
+ * \brief Get the rows of each Jacobian column that may be nonzero.
+ * \details This uses the same structure as jacobianStructure(), and like
+ *          it is only reported when compressed Jacobians are in use so
+ *          that partial Jacobian refreshes are opt-in with the solver's
+ *          colored-jacobian option.
+ * \return The rows of each column, or NULL if compressed Jacobians are not
+ *         in use or there are no markets.
+ */
+const std::vector<std::vector<int> > *LogEDFun::jacobianColumnRows()
+{
+    if(!mColoredJacobian || mkts.empty()) {
+        return 0;
+    }
+    return &jacobianPattern();
+}
+
+/*!
+ * \brief Get the rows of each Jacobian column that may be nonzero whether or
+ *        not compressed Jacobians are in use.
+ * \details This is what the solver uses to decide which entries of its final
+ *          Jacobian are worth keeping in the JacobianStore.
+ * \return The rows of each column.
+ */
+const std::vector<std::vector<int> > &LogEDFun::jacobianPattern()
+{
+    if(mJacStructure.mGroups.empty() && !mkts.empty()) {
+        findJacobianStructure();
+    }
+    return mJacStructure.mColRows;
+}
+
+/*!
+ * \brief Determine which rows of each Jacobian column may be nonzero and
+ *        group the columns accordingly.
+ * \details The MarketDependencyFinder gives us, for each solved market, the
+ *          activities that must be recalculated when that market's price
+ *          changes.  An activity that adds to the supply or demand of a market
+ *          also uses that market's price, so it appears in the market's
+ *          dependencies.  Thus the rows that may be affected by a change in
+ *          price j are the markets that share at least one activity with market
+ *          j, plus market j itself.  The trial price and demand markets created
+ *          to break cycles read each other's values, so if either one of a pair
+ *          is affected we take both to be affected.
+ */
+void LogEDFun::findJacobianStructure()
+{
+    const int nmkt = mkts.size();
+
+    // index each activity by its position in the global ordering
+    const std::vector<IActivity*>& globalOrdering = world->getGlobalOrdering();
+    std::map<const IActivity*, int> activityIndex;
+    for(size_t a=0; a<globalOrdering.size(); ++a) {
+        activityIndex[globalOrdering[a]] = a;
+    }
+
+    // the markets whose price changes cause each activity to be recalculated
+    std::vector<std::vector<int> > activityMarkets(globalOrdering.size());
+    std::vector<std::vector<int> > dependencyIndex(nmkt);
+    for(int i=0; i<nmkt; ++i) {
+        const std::vector<IActivity*>& deps = mkts[i].getDependencies();
+        dependencyIndex[i].reserve(deps.size());
+        for(size_t k=0; k<deps.size(); ++k) {
+            std::map<const IActivity*, int>::const_iterator it = activityIndex.find(deps[k]);
+            if(it != activityIndex.end()) {
+                activityMarkets[it->second].push_back(i);
+                dependencyIndex[i].push_back(it->second);
+            }
+        }
+    }
+
+    // pair up trial price and demand markets
+    const std::string DEMAND_SUFFIX = "Demand_int";
+    std::map<std::string, int> priceMarkets;
+    for(int i=0; i<nmkt; ++i) {
+        if(mkts[i].getType() == IMarketType::PRICE) {
+            priceMarkets[mkts[i].getName()] = i;
+        }
+    }
+    std::vector<int> partner(nmkt, -1);
+    for(int i=0; i<nmkt; ++i) {
+        const std::string& name = mkts[i].getName();
+        if(mkts[i].getType() == IMarketType::DEMAND && name.size() > DEMAND_SUFFIX.size() &&
+           name.compare(name.size() - DEMAND_SUFFIX.size(), DEMAND_SUFFIX.size(), DEMAND_SUFFIX) == 0)
+        {
+            std::map<std::string, int>::const_iterator it =
+                priceMarkets.find(name.substr(0, name.size() - DEMAND_SUFFIX.size()));
+            if(it != priceMarkets.end()) {
+                partner[i] = it->second;
+                partner[it->second] = i;
+            }
+        }
+    }
+
+    // structurally nonzero rows for each column
+    mJacStructure.mColRows.assign(nmkt, std::vector<int>());
+    std::vector<int> stamp(nmkt, -1);
+    for(int j=0; j<nmkt; ++j) {
+        std::vector<int>& rows = mJacStructure.mColRows[j];
+        stamp[j] = j;
+        rows.push_back(j);
+        for(size_t k=0; k<dependencyIndex[j].size(); ++k) {
+            const std::vector<int>& amkts = activityMarkets[dependencyIndex[j][k]];
+            for(size_t m=0; m<amkts.size(); ++m) {
+                if(stamp[amkts[m]] != j) {
+                    stamp[amkts[m]] = j;
+                    rows.push_back(amkts[m]);
+                }
+            }
+        }
+        for(size_t r=0, nr=rows.size(); r<nr; ++r) {
+            int p = partner[rows[r]];
+            if(p >= 0 && stamp[p] != j) {
+                stamp[p] = j;
+                rows.push_back(p);
+            }
+        }
+        std::sort(rows.begin(), rows.end());
+    }
+
+    int ngroup = colorJacobianColumns(mJacStructure, nmkt);
+
+    // The activities to calculate for each group are the union of the
+    // dependencies of its columns, kept in the global order.
+    mGroupDependencies.assign(ngroup, std::vector<IActivity*>());
+    std::vector<int> inGroup(globalOrdering.size(), -1);
+    for(int g=0; g<ngroup; ++g) {
+        const std::vector<int>& cols = mJacStructure.mGroups[g];
+        if(cols.size() == 1) {
+            // single columns use the dependencies directly from the SolutionInfo
+            continue;
+        }
+        for(size_t c=0; c<cols.size(); ++c) {
+            const std::vector<int>& deps = dependencyIndex[cols[c]];
+            for(size_t k=0; k<deps.size(); ++k) {
+                inGroup[deps[k]] = g;
+            }
+        }
+        for(size_t a=0; a<globalOrdering.size(); ++a) {
+            if(inGroup[a] == g) {
+                mGroupDependencies[g].push_back(globalOrdering[a]);
+            }
+        }
+    }
+
+    if(mColoredJacobian) {
+        ILogger& solverLog = ILogger::getLogger("solver_log");
+        solverLog.setLevel(ILogger::NOTICE);
+        solverLog << "Colored Jacobian: " << nmkt << " columns in " << ngroup << " groups." << std::endl;
+    }
+}
+
+/*!
+ * \brief Evaluate the function with all inputs in a column group perturbed.
+ * \details This is the partial derivative version of operator() for a group of
+ *          structurally independent columns.  All of the prices in the group are
+ *          set, and the union of their dependencies is recalculated.
+ * \param ax The input vector with every column in the group perturbed.
+ * \param fx The output vector.
+ * \param ig The index of the group in the Jacobian structure.
+ */
+void LogEDFun::partialGroup(const UBVECTOR<double> &ax, UBVECTOR<double> &fx, int ig)
+{
+  const std::vector<int>& cols = mJacStructure.mGroups[ig];
+  if(cols.size() == 1) {
+    // nothing gained by grouping; use the regular partial derivative
+    (*this)(ax, fx, cols[0]);
+    return;
+  }
+
+  Timer& edfunMiscTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::EDFUN_MISC );
+  Timer& edfunPreTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::EDFUN_PRE );
+  edfunMiscTimer.start();
+  edfunPreTimer.start();
+
+  UBVECTOR<double> x(ax.size());
+  for(unsigned int i=0; i<x.size(); ++i)
+      x[i] = ax[i]*mxscl[i];
+
+  mktplc->mIsDerivativeCalc = true;
+
+  if(mLogPricep) {
+    for(size_t i=0; i<x.size(); ++i) {
+      if(x[i] > ARGMAX)
+        mkts[i].setPrice(PMAX);
+      else
+        mkts[i].setPrice(exp(x[i])); // input vector = log(price)
+    }
+  }
+  else {
+    // all other prices were reset from stored values
+    for(size_t k=0; k<cols.size(); ++k) {
+      mkts[cols[k]].setPrice(x[cols[k]]);
+    }
+  }
+  edfunMiscTimer.stop();
+  edfunPreTimer.stop();
+
+  Timer& evalPartTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::EVAL_PART );
+  evalPartTimer.start();
+  world->calc(period, mGroupDependencies[ig]);
+  evalPartTimer.stop();
+
+  collectOutputs(x, fx);
+}
+
+/*!
+ * \brief Trial evaluations are run on the scratch state slots, one per thread,
+ *        when GCAM_PARALLEL_ENABLED.
+ * \return Whether trial() may be called concurrently.
+ */
+bool LogEDFun::concurrentTrials() const
+{
+#if GCAM_PARALLEL_ENABLED
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*!
+ * \brief Evaluate the model at a trial point on a scratch state.
+ * \details The calling thread's scratch state is reset from the "base" state, all
+ *          of the prices are set, and the activities which depend on any of
+ *          them are recalculated, adding only their differences from the base
+ *          state as is done for partial derivatives.  The other prices are held
+ *          at their base values, so the rest of the model need not be
+ *          recalculated.  The base state is left as it was so several trial
+ *          points may be evaluated at once.  The caller must have called
+ *          ManageStateVariables::setPartialDeriv(true) and must finish the batch
+ *          of trials with partial(-1).
+ * \param ax The input vector.
+ * \param fx The output vector.
+ */
+void LogEDFun::trial(const UBVECTOR<double> &ax, UBVECTOR<double> &fx)
+{
+  assert(ax.size() == mkts.size());
+  assert(fx.size() == mkts.size());
+
+  Timer& edfunMiscTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::EDFUN_MISC );
+  Timer& edfunPreTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::EDFUN_PRE );
+  edfunMiscTimer.start();
+  edfunPreTimer.start();
+
+  UBVECTOR<double> x(ax.size());
+  for(unsigned int i=0; i<x.size(); ++i)
+      x[i] = ax[i]*mxscl[i];
+
+  std::call_once(mTrialDependenciesFlag, &LogEDFun::findTrialDependencies, this);
+  scenario->mManageStateVars->copyState();
+  mktplc->mIsDerivativeCalc = true;
+
+  for(size_t i=0; i<x.size(); ++i) {
+    if(!mLogPricep)
+      mkts[i].setPrice(x[i]);
+    else if(x[i] > ARGMAX)
+      mkts[i].setPrice(PMAX);
+    else
+      mkts[i].setPrice(exp(x[i]));
+  }
+  edfunMiscTimer.stop();
+  edfunPreTimer.stop();
+
+  Timer& evalPartTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::EVAL_PART );
+  evalPartTimer.start();
+  world->calc(period, mTrialDependencies);
+  evalPartTimer.stop();
+
+  collectOutputs(x, fx);
+}
+
+/*!
+ * \brief Find the activities which must be recalculated when any of the prices
+ *        of mkts change, in the global order.
+ */
+void LogEDFun::findTrialDependencies()
+{
+  std::set<const IActivity*> deps;
+  for(size_t i=0; i<mkts.size(); ++i) {
+    deps.insert(mkts[i].getDependencies().begin(), mkts[i].getDependencies().end());
+  }
+  const std::vector<IActivity*>& globalOrdering = world->getGlobalOrdering();
+  for(size_t a=0; a<globalOrdering.size(); ++a) {
+    if(deps.find(globalOrdering[a]) != deps.end()) {
+      mTrialDependencies.push_back(globalOrdering[a]);
+    }
+  }
+}
+
+/*!
+ * \brief Collect the outputs from the solutionInfo objects and repack them in
+ *        the output vector.
+ * \details This is the last step of every evaluation, full or partial.  At
+ *          this point we've recalculated all the supplies and demands.
+ * \param x The (unscaled) inputs for this evaluation.
+ * \param fx The output vector to fill.
+ */
+void LogEDFun::collectOutputs(const UBVECTOR<double> &x, UBVECTOR<double> &fx)
+{
+  Timer& edfunMiscTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::EDFUN_MISC );
   edfunMiscTimer.start();
   Timer& edfunPostTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::EDFUN_POST );
   edfunPostTimer.start();
 
-  /****
-   * 3 Collect the outputs from the solutionInfo objects and repack them in the
-   *   output vector
-   ****/
-  
   // at this point we've recalculated all the supplies and demands.
   // Retrieve them, calculate output according to market type, and
   // store them in fx
@@ -376,4 +712,3 @@ void LogEDFun::operator()(const UBVECTOR<double> &ax, UBVECTOR<double> &fx, cons
 
   edfunMiscTimer.stop();
 }
-
@@ -52,7 +52,9 @@
 using namespace std;
 using namespace xercesc;
 
-HasMarketFlagSolutionInfoFilter::HasMarketFlagSolutionInfoFilter() {
+HasMarketFlagSolutionInfoFilter::HasMarketFlagSolutionInfoFilter():
+mMarketInfoKey( 0 )
+{
 }
 
 HasMarketFlagSolutionInfoFilter::~HasMarketFlagSolutionInfoFilter() {
@@ -79,7 +81,7 @@ bool HasMarketFlagSolutionInfoFilter::XMLParse( const DOMNode* aNode ) {
             continue;
         }
         else if( nodeName == "has-market-flag" ) {
-            mMarketInfoKey = XMLHelper<string>::getValue( curr );
+            mMarketInfoKey = IInfo::getKey( XMLHelper<string>::getValue( curr ) );
         }
         else {
             ILogger& mainLog = ILogger::getLogger( "main_log" );
@@ -95,6 +97,6 @@ bool HasMarketFlagSolutionInfoFilter::acceptSolutionInfo( const SolutionInfo& aS
     /*!
      * \pre mMarketInfoKey was read in.
      */
-    assert( !mMarketInfoKey.empty() );
+    assert( mMarketInfoKey );
     return aSolutionInfo.getMarketInfo()->getBoolean( mMarketInfoKey, false );
 }
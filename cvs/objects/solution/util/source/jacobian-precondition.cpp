@@ -67,6 +67,7 @@ int jacobian_precondition(UBVECTOR &x, UBVECTOR &fx, UBMATRIX &J, VecFVec<double
   int fail = 0;
   int change = 0;
   int ncol = (int) x.size();
+  std::vector<int> moved;  // columns whose prices were tried at other values
 
   Timer& jacPreTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::JAC_PRE );
   jacPreTimer.start();
@@ -171,6 +172,7 @@ int jacobian_precondition(UBVECTOR &x, UBVECTOR &fx, UBMATRIX &J, VecFVec<double
             fxx = fx;
           }
         } while(deltafx < JPCMIN && ++count < ITMAX);
+        moved.push_back(j);
 
         if(deltafx < JPCMIN) {
           fail = 1;
@@ -188,8 +190,14 @@ int jacobian_precondition(UBVECTOR &x, UBVECTOR &fx, UBMATRIX &J, VecFVec<double
   Timer& jacPreJacTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::JAC_PRE_JAC );
   jacPreJacTimer.start();
               
-  if(change)
-    fdjac(F,x,fx,J,true); // recalculate the jacobian
+  // recalculate the parts of the jacobian that the price changes could
+  // have affected
+  if(change) {
+    int neval = fdjac_refresh(F,x,fx,moved,J,diagnostic);
+    if(diagnostic)
+      (*diagnostic) << "jacobian_preconditioner: Jacobian refreshed with " << neval
+                    << " function evaluations.\n";
+  }
 
   jacPreJacTimer.stop();
   jacPreTimer.stop();
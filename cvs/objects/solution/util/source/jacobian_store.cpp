@@ -0,0 +1,273 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*!
+ * \file jacobian_store.cpp
+ * \ingroup Solution
+ * \brief JacobianStore class source file.
+ */
+
+#include "util/base/include/definitions.h"
+#include <iostream>
+#include <algorithm>
+#include <set>
+#include "solution/util/include/jacobian_store.hpp"
+
+using namespace std;
+
+//! A tag written at the start of a saved store to recognize the format.
+static const char SAVE_MAGIC[] = "GCAMJAC1";
+
+/*!
+ * \brief Get the single instance of the JacobianStore.
+ * \return The JacobianStore.
+ */
+JacobianStore& JacobianStore::getInstance() {
+    static JacobianStore JACOBIAN_STORE;
+    return JACOBIAN_STORE;
+}
+
+//! Constructor
+JacobianStore::JacobianStore():
+mIsEnabled( false ),
+mIsRecordingReference( true ),
+mLatestPeriod( -1 )
+{
+}
+
+/*!
+ * \brief Start storing Jacobians for a new scenario.
+ * \details Discards the Jacobian stored for the latest period of the previous
+ *          scenario so that the first period of the new scenario warm starts
+ *          from the reference scenario, if there is one, rather than from the
+ *          last period of the previous scenario.
+ */
+void JacobianStore::beginScenario() {
+    mLatest = StoredJacobian();
+    mLatestPeriod = -1;
+}
+
+/*!
+ * \brief Finish storing Jacobians for a scenario.
+ * \details If the scenario was the reference scenario its Jacobians are kept
+ *          as is from now on.
+ */
+void JacobianStore::endScenario() {
+    if( mLatestPeriod != -1 ) {
+        mIsRecordingReference = false;
+    }
+    beginScenario();
+}
+
+/*!
+ * \brief Discard all stored Jacobians so that the next scenario run becomes
+ *        the reference scenario.
+ */
+void JacobianStore::clear() {
+    beginScenario();
+    mReference.clear();
+    mIsRecordingReference = true;
+}
+
+/*!
+ * \brief Merge a sparse Jacobian into the one stored for the current scenario.
+ * \details Derivatives between the markets in aNames are replaced, those
+ *          involving other markets are kept, and those between a market new to
+ *          the store and any other market are zero.  The stored Jacobian is
+ *          carried over from the previous period so that markets which were not
+ *          solved in this period keep what was last known about them.  A
+ *          Jacobian in the other price space is replaced entirely.  While the
+ *          reference scenario is running the result is also kept for aPeriod.
+ * \param aPeriod The model period the Jacobian was computed in.
+ * \param aIsLogPrice Whether the solver was working in log price space.
+ * \param aNames The name of the market for each row and column.
+ * \param aColumns The unscaled columns of the Jacobian.
+ */
+void JacobianStore::merge( const int aPeriod, const bool aIsLogPrice, const vector<string>& aNames,
+                           const vector<SparseColumn>& aColumns )
+{
+    if( mLatest.mIndex.empty() || mLatest.mIsLogPrice != aIsLogPrice ) {
+        mLatest = StoredJacobian();
+        mLatest.mIsLogPrice = aIsLogPrice;
+    }
+    mLatestPeriod = aPeriod;
+
+    // Give each market that is not already stored a new row and column.
+    const size_t n = aNames.size();
+    vector<int> storedIndex( n );
+    set<int> replacedRows;
+    for( size_t i = 0; i < n; ++i ) {
+        storedIndex[ i ] = mLatest.mIndex.insert( make_pair( aNames[ i ], int( mLatest.mIndex.size() ) ) ).first->second;
+        replacedRows.insert( storedIndex[ i ] );
+    }
+    mLatest.mColumns.resize( mLatest.mIndex.size() );
+
+    for( size_t j = 0; j < n; ++j ) {
+        SparseColumn& column = mLatest.mColumns[ storedIndex[ j ] ];
+        SparseColumn merged;
+        merged.reserve( column.size() + aColumns[ j ].size() );
+        for( SparseColumn::const_iterator entry = column.begin(); entry != column.end(); ++entry ) {
+            if( replacedRows.find( entry->first ) == replacedRows.end() ) {
+                merged.push_back( *entry );
+            }
+        }
+        for( SparseColumn::const_iterator entry = aColumns[ j ].begin(); entry != aColumns[ j ].end(); ++entry ) {
+            merged.push_back( make_pair( storedIndex[ entry->first ], entry->second ) );
+        }
+        sort( merged.begin(), merged.end() );
+        column.swap( merged );
+    }
+
+    if( mIsRecordingReference ) {
+        mReference[ aPeriod ] = mLatest;
+    }
+}
+
+/*!
+ * \brief Write the reference scenario's Jacobians to a stream in a form load()
+ *        can read.
+ * \details The data is binary in the native byte order since it is only meant
+ *          to be passed between processes on the same machine.
+ * \param aOut The stream to write to, which must be opened in binary mode.
+ */
+void JacobianStore::save( ostream& aOut ) const {
+    aOut.write( SAVE_MAGIC, sizeof( SAVE_MAGIC ) );
+    const size_t numPeriods = mReference.size();
+    aOut.write( reinterpret_cast<const char*>( &numPeriods ), sizeof( numPeriods ) );
+    for( map<int, StoredJacobian>::const_iterator iter = mReference.begin(); iter != mReference.end(); ++iter ) {
+        const StoredJacobian& stored = iter->second;
+        const size_t n = stored.mIndex.size();
+        aOut.write( reinterpret_cast<const char*>( &iter->first ), sizeof( iter->first ) );
+        aOut.write( reinterpret_cast<const char*>( &stored.mIsLogPrice ), sizeof( stored.mIsLogPrice ) );
+        aOut.write( reinterpret_cast<const char*>( &n ), sizeof( n ) );
+        vector<const string*> names( n );
+        for( map<string, int>::const_iterator nameIter = stored.mIndex.begin(); nameIter != stored.mIndex.end(); ++nameIter ) {
+            names[ nameIter->second ] = &nameIter->first;
+        }
+        for( size_t i = 0; i < n; ++i ) {
+            const size_t length = names[ i ]->size();
+            aOut.write( reinterpret_cast<const char*>( &length ), sizeof( length ) );
+            aOut.write( names[ i ]->data(), length );
+        }
+        for( size_t j = 0; j < n; ++j ) {
+            const SparseColumn& column = stored.mColumns[ j ];
+            const size_t nnz = column.size();
+            aOut.write( reinterpret_cast<const char*>( &nnz ), sizeof( nnz ) );
+            for( SparseColumn::const_iterator entry = column.begin(); entry != column.end(); ++entry ) {
+                aOut.write( reinterpret_cast<const char*>( &entry->first ), sizeof( entry->first ) );
+                aOut.write( reinterpret_cast<const char*>( &entry->second ), sizeof( entry->second ) );
+            }
+        }
+    }
+}
+
+/*!
+ * \brief Read the reference scenario's Jacobians written by save().
+ * \details The Jacobians read replace any reference already in the store and
+ *          no scenario run later will replace them.
+ * \param aIn The stream to read from, which must be opened in binary mode.
+ * \return Whether the whole stream could be read, nothing is changed if not.
+ */
+bool JacobianStore::load( istream& aIn ) {
+    char magic[ sizeof( SAVE_MAGIC ) ];
+    size_t numPeriods;
+    if( !aIn.read( magic, sizeof( magic ) ) || !equal( magic, magic + sizeof( magic ), SAVE_MAGIC )
+        || !aIn.read( reinterpret_cast<char*>( &numPeriods ), sizeof( numPeriods ) ) )
+    {
+        return false;
+    }
+    map<int, StoredJacobian> reference;
+    for( size_t p = 0; p < numPeriods; ++p ) {
+        int period;
+        size_t n;
+        StoredJacobian stored;
+        aIn.read( reinterpret_cast<char*>( &period ), sizeof( period ) );
+        aIn.read( reinterpret_cast<char*>( &stored.mIsLogPrice ), sizeof( stored.mIsLogPrice ) );
+        aIn.read( reinterpret_cast<char*>( &n ), sizeof( n ) );
+        for( size_t i = 0; aIn && i < n; ++i ) {
+            size_t length;
+            aIn.read( reinterpret_cast<char*>( &length ), sizeof( length ) );
+            string name( aIn ? length : 0, '\0' );
+            aIn.read( &name[ 0 ], name.size() );
+            stored.mIndex[ name ] = i;
+        }
+        if( !aIn || stored.mIndex.size() != n ) {
+            return false;
+        }
+        stored.mColumns.resize( n );
+        for( size_t j = 0; aIn && j < n; ++j ) {
+            size_t nnz;
+            aIn.read( reinterpret_cast<char*>( &nnz ), sizeof( nnz ) );
+            for( size_t k = 0; aIn && k < nnz; ++k ) {
+                pair<int, double> entry;
+                aIn.read( reinterpret_cast<char*>( &entry.first ), sizeof( entry.first ) );
+                aIn.read( reinterpret_cast<char*>( &entry.second ), sizeof( entry.second ) );
+                if( entry.first < 0 || size_t( entry.first ) >= n ) {
+                    return false;
+                }
+                stored.mColumns[ j ].push_back( entry );
+            }
+        }
+        if( !aIn ) {
+            return false;
+        }
+        reference[ period ] = stored;
+    }
+    mReference.swap( reference );
+    mIsRecordingReference = false;
+    return true;
+}
+
+/*!
+ * \brief Find the Jacobian to warm start aPeriod from.
+ * \details The Jacobian stored for aPeriod in the current scenario is the
+ *          closest, then the one the reference scenario stored for aPeriod,
+ *          and lastly the one stored for an earlier period of the current
+ *          scenario.
+ * \param aPeriod The model period to find a Jacobian for.
+ * \param aIsLogPrice Whether the Jacobian should be in log price space.
+ * \return The stored Jacobian or null if there is none.
+ */
+const JacobianStore::StoredJacobian* JacobianStore::find( const int aPeriod, const bool aIsLogPrice ) const {
+    const bool hasLatest = mLatestPeriod != -1 && mLatest.mIsLogPrice == aIsLogPrice;
+    if( hasLatest && mLatestPeriod == aPeriod ) {
+        return &mLatest;
+    }
+    map<int, StoredJacobian>::const_iterator iter = mReference.find( aPeriod );
+    if( iter != mReference.end() && iter->second.mIsLogPrice == aIsLogPrice ) {
+        return &iter->second;
+    }
+    if( hasLatest && mLatestPeriod < aPeriod ) {
+        return &mLatest;
+    }
+    return 0;
+}
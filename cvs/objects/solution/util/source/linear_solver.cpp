@@ -0,0 +1,787 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*!
+ * \file linear_solver.cpp
+ * \ingroup Solution
+ * \brief Implementation of the linear solver back-ends used by the
+ *        Newton and Broyden solvers.
+ */
+
+#include <cmath>
+#include <limits>
+#include <set>
+#include <queue>
+#include <functional>
+#include <algorithm>
+#include <boost/numeric/ublas/operation.hpp>
+
+#if USE_LAPACK
+#include <boost/numeric/bindings/traits/ublas_vector.hpp>
+#include <boost/numeric/bindings/traits/ublas_matrix.hpp>
+#include <boost/numeric/bindings/lapack/gesvd.hpp>
+#include "solution/util/include/svd_invert_solve.hpp"
+#endif
+
+#include "solution/util/include/linear_solver.hpp"
+#include "solution/util/include/gmres.hpp"
+#include "util/base/include/xml_helper.h"
+#include "util/logger/include/ilogger.h"
+
+#if USE_LAPACK
+#define UBMATRIX boost::numeric::ublas::matrix<double,boost::numeric::ublas::column_major>
+#else
+#define UBMATRIX boost::numeric::ublas::matrix<double>
+#endif
+#define UBVECTOR boost::numeric::ublas::vector<double>
+
+using namespace std;
+using namespace xercesc;
+
+namespace {
+    /*!
+     * \brief Approximate minimum degree ordering of the symmetrized
+     *        pattern of a sparse matrix.
+     * \details This is the plain minimum degree algorithm with an
+     *          explicit elimination graph.  Rows that are nearly dense
+     *          (e.g. the CO2 market, which nearly everything feeds
+     *          into) are pulled out and ordered last; otherwise they
+     *          would make every elimination step expensive, and they
+     *          would be filled in anyhow.
+     */
+    void minimumDegreeOrder( const int aN, const vector<int>& aRowStart, const vector<int>& aColIndex,
+                             vector<int>& aOrder )
+    {
+        vector<set<int> > adj( aN );
+        for( int i = 0; i < aN; ++i ) {
+            for( int k = aRowStart[ i ]; k < aRowStart[ i + 1 ]; ++k ) {
+                int j = aColIndex[ k ];
+                if( j != i ) {
+                    adj[ i ].insert( j );
+                    adj[ j ].insert( i );
+                }
+            }
+        }
+
+        const size_t denseThreshold = max( 16, static_cast<int>( 10.0 * sqrt( static_cast<double>( aN ) ) ) );
+        vector<int> denseNodes;
+        vector<bool> eliminated( aN, false );
+        for( int i = 0; i < aN; ++i ) {
+            if( adj[ i ].size() > denseThreshold ) {
+                denseNodes.push_back( i );
+                eliminated[ i ] = true;
+            }
+        }
+        for( size_t d = 0; d < denseNodes.size(); ++d ) {
+            const set<int>& nbrs = adj[ denseNodes[ d ] ];
+            for( set<int>::const_iterator it = nbrs.begin(); it != nbrs.end(); ++it ) {
+                adj[ *it ].erase( denseNodes[ d ] );
+            }
+        }
+
+        set<pair<int,int> > degreeQueue;
+        for( int i = 0; i < aN; ++i ) {
+            if( !eliminated[ i ] ) {
+                degreeQueue.insert( make_pair( static_cast<int>( adj[ i ].size() ), i ) );
+            }
+        }
+
+        aOrder.clear();
+        aOrder.reserve( aN );
+        while( !degreeQueue.empty() ) {
+            int v = degreeQueue.begin()->second;
+            degreeQueue.erase( degreeQueue.begin() );
+            aOrder.push_back( v );
+            eliminated[ v ] = true;
+
+            // Eliminating v turns its neighbors into a clique.
+            vector<int> nbrs( adj[ v ].begin(), adj[ v ].end() );
+            for( size_t a = 0; a < nbrs.size(); ++a ) {
+                int u = nbrs[ a ];
+                degreeQueue.erase( make_pair( static_cast<int>( adj[ u ].size() ), u ) );
+                adj[ u ].erase( v );
+                for( size_t b = 0; b < nbrs.size(); ++b ) {
+                    if( b != a ) {
+                        adj[ u ].insert( nbrs[ b ] );
+                    }
+                }
+                degreeQueue.insert( make_pair( static_cast<int>( adj[ u ].size() ), u ) );
+            }
+            adj[ v ].clear();
+        }
+        aOrder.insert( aOrder.end(), denseNodes.begin(), denseNodes.end() );
+    }
+
+    /*!
+     * \brief Value to put in place of a zero pivot in an incomplete
+     *        factorization.
+     * \details The replacement is scaled by the largest entry of the
+     *          original row, so that it is equally small relative to
+     *          every row whatever its units, and it takes the sign of
+     *          the row's original entry in the pivot column.
+     * \param aRow The original row being eliminated.
+     * \param aCol The original column of the pivot.
+     */
+    double iluZeroPivot( const vector<int>& aRowStart, const vector<int>& aColIndex,
+                         const vector<double>& aValues, const int aRow, const int aCol )
+    {
+        double rowMax = 0.0;
+        double diag = 0.0;
+        for( int k = aRowStart[ aRow ]; k < aRowStart[ aRow + 1 ]; ++k ) {
+            rowMax = max( rowMax, fabs( aValues[ k ] ) );
+            if( aColIndex[ k ] == aCol ) {
+                diag = aValues[ k ];
+            }
+        }
+        const double pivot = ( rowMax > 0.0 ? rowMax : 1.0 ) * sqrt( numeric_limits<double>::epsilon() );
+        return diag < 0.0 ? -pivot : pivot;
+    }
+}
+
+LinearSolver* LinearSolver::create( const DOMNode* aNode ) {
+    const string name = XMLHelper<string>::getValue( aNode );
+    if( name == GMRESSolver::getNameStatic() ) {
+        int restart = XMLHelper<int>::getAttr( aNode, "restart" );
+        int maxIter = XMLHelper<int>::getAttr( aNode, "max-iterations" );
+        double tol = XMLHelper<double>::getAttr( aNode, "tol" );
+        GMRESSolver* solver = new GMRESSolver();
+        solver->setParameters( restart, maxIter, tol );
+        return solver;
+    }
+    else if( name == SparseLUSolver::getNameStatic() ) {
+        double threshold = XMLHelper<double>::getAttr( aNode, "pivot-threshold" );
+        return threshold > 0.0 ? new SparseLUSolver( threshold ) : new SparseLUSolver();
+    }
+    return create( name );
+}
+
+LinearSolver* LinearSolver::create( const string& aName ) {
+    if( aName == DenseLUSolver::getNameStatic() ) {
+        return new DenseLUSolver();
+    }
+#if USE_LAPACK
+    else if( aName == SVDSolver::getNameStatic() ) {
+        return new SVDSolver();
+    }
+#endif
+    else if( aName == SparseLUSolver::getNameStatic() ) {
+        return new SparseLUSolver();
+    }
+    else if( aName == GMRESSolver::getNameStatic() ) {
+        return new GMRESSolver();
+    }
+    return 0;
+}
+
+const string& LinearSolver::getDefaultName() {
+#if USE_LAPACK
+    return SVDSolver::getNameStatic();
+#else
+    return DenseLUSolver::getNameStatic();
+#endif
+}
+
+void LinearSolver::update( UBMATRIX& aB, const UBVECTOR& aDF, const UBVECTOR& aDX ) {
+    using boost::numeric::ublas::axpy_prod;
+    using boost::numeric::ublas::inner_prod;
+    using boost::numeric::ublas::outer_prod;
+
+    double dx2 = inner_prod( aDX, aDX );
+    UBVECTOR Bdx( aB.size1() );
+    UBVECTOR r( aDF );
+    r -= axpy_prod( aB, aDX, Bdx );
+    r /= dx2;
+    aB += outer_prod( r, aDX );
+}
+
+/*!
+ * \brief Solve J x = b with a direct factorization, for when an iterative
+ *        back-end fails to converge.
+ * \details Sparse LU is tried first and dense LU if the sparse
+ *          factorization breaks down.  The pattern is scanned from aJ
+ *          since this is only expected to happen occasionally.
+ * \param aJ The matrix.
+ * \param[in,out] aB Right-hand side on input, solution on output.
+ * \param aLog Stream for diagnostic messages.
+ * \return 0 on success, otherwise the singular row as for factorize().
+ */
+int LinearSolver::solveDirect( const UBMATRIX& aJ, UBVECTOR& aB, ostream& aLog ) {
+    SparseLUSolver sparseLU;
+    sparseLU.analyze( aJ );
+    if( sparseLU.factorize( aJ ) == 0 ) {
+        aLog << "Solving with " << sparseLU.getName() << " instead.\n";
+        return sparseLU.solve( aB, aLog );
+    }
+    DenseLUSolver denseLU;
+    const int sing = denseLU.factorize( aJ );
+    if( sing == 0 ) {
+        aLog << "Solving with " << denseLU.getName() << " instead.\n";
+        denseLU.solve( aB, aLog );
+    }
+    return sing;
+}
+
+const string& DenseLUSolver::getNameStatic() {
+    static const string NAME = "dense-lu";
+    return NAME;
+}
+
+const string& DenseLUSolver::getName() const {
+    return getNameStatic();
+}
+
+int DenseLUSolver::factorize( const UBMATRIX& aJ ) {
+    mLU = aJ;
+    if( mPerm.size() != aJ.size1() ) {
+        mPerm.resize( aJ.size1() );
+    }
+    for( size_t i = 0; i < mPerm.size(); ++i ) {
+        mPerm[ i ] = i;
+    }
+    return boost::numeric::ublas::lu_factorize( mLU, mPerm );
+}
+
+int DenseLUSolver::solve( UBVECTOR& aB, ostream& aLog ) {
+    try {
+        boost::numeric::ublas::lu_substitute( mLU, mPerm, aB );
+    }
+    catch( const boost::numeric::ublas::internal_logic& err ) {
+        // This error seems to be thrown when the Jacobian is
+        // ill-conditioned.  We let it go because often the solver will
+        // muddle through to a solution.  If not, then it will
+        // eventually stop with a genuinely singular matrix.
+    }
+    return 0;
+}
+
+#if USE_LAPACK
+const string& SVDSolver::getNameStatic() {
+    static const string NAME = "svd";
+    return NAME;
+}
+
+const string& SVDSolver::getName() const {
+    return getNameStatic();
+}
+
+int SVDSolver::factorize( const UBMATRIX& aJ ) {
+    const size_t n = aJ.size1();
+    UBMATRIX work( aJ );        // gesvd destroys its input
+    mU.resize( n, n, false );
+    mVT.resize( n, n, false );
+    mS.resize( n, false );
+    int ierr = boost::numeric::bindings::lapack::gesvd( 'O', 'A', 'A', work, mS, mU, mVT );
+    if( ierr > 0 ) {
+        // svd failed.  It's not even clear under what circumstances
+        // this can happen
+        ILogger& solverLog = ILogger::getLogger( "solver_log" );
+        solverLog.setLevel( ILogger::SEVERE );
+        solverLog << "****************SVD failed.  This shouldn't happen.  It can't mean anything good.\n";
+    }
+    return ierr;
+}
+
+int SVDSolver::solve( UBVECTOR& aB, ostream& aLog ) {
+    return svdInvertSolve( mU, mS, mVT, aB, aLog );
+}
+#endif
+
+/*!
+ * \brief Compute the LU factors of a matrix in compressed sparse row form.
+ * \details Rows are eliminated one at a time in the order of
+ *          aOrdering, and the same ordering is used as the initial
+ *          column order, so that the fill-reducing ordering is
+ *          applied symmetrically.  Each row is scattered into a dense
+ *          work vector and reduced by the U rows it touches, taken in
+ *          pivot order.  When fill is not allowed, any entry outside
+ *          the original pattern of the row is discarded, which gives
+ *          ILU(0).  Entries that happen to be zero are kept, so that
+ *          the factors hold the full symbolic structure and can be
+ *          reused by refactor().
+ * \param aPivotThreshold The diagonal element is kept as the pivot
+ *        unless it is smaller than this fraction of the largest
+ *        candidate in its row.  Zero disables pivoting.
+ * \return 0 on success, or the (1-based) original row index at which
+ *         a zero pivot was encountered.
+ */
+int SparseLUFactors::factor( const vector<int>& aRowStart, const vector<int>& aColIndex,
+                             const vector<double>& aValues, const vector<int>& aOrdering,
+                             bool aAllowFill, double aPivotThreshold )
+{
+    mN = aOrdering.size();
+    mRowOrder = aOrdering;
+    mPosCol = aOrdering;
+    mColPos.assign( mN, 0 );
+    for( int k = 0; k < mN; ++k ) {
+        mColPos[ mPosCol[ k ] ] = k;
+    }
+    mDiag.assign( mN, 0.0 );
+    mL.assign( mN, vector<pair<int,double> >() );
+    mU.assign( mN, vector<pair<int,double> >() );
+
+    vector<double> work( mN, 0.0 );
+    vector<int> nzMark( mN, -1 );       // step at which each column became nonzero in the work row
+    vector<int> patternMark( mN, -1 );  // step whose original row has this column in its pattern
+    vector<int> nzCols;
+    nzCols.reserve( mN );
+
+    for( int i = 0; i < mN; ++i ) {
+        const int row = mRowOrder[ i ];
+        priority_queue<int, vector<int>, greater<int> > pending;
+        nzCols.clear();
+
+        for( int k = aRowStart[ row ]; k < aRowStart[ row + 1 ]; ++k ) {
+            const int c = aColIndex[ k ];
+            work[ c ] = aValues[ k ];
+            nzMark[ c ] = i;
+            patternMark[ c ] = i;
+            nzCols.push_back( c );
+            if( mColPos[ c ] < i ) {
+                pending.push( mColPos[ c ] );
+            }
+        }
+
+        // Eliminate the entries to the left of the pivot, in pivot order.
+        while( !pending.empty() ) {
+            const int k = pending.top();
+            pending.pop();
+            const int c = mPosCol[ k ];
+            const double mult = work[ c ] / mDiag[ k ];
+            work[ c ] = 0.0;
+            mL[ i ].push_back( make_pair( k, mult ) );
+            const vector<pair<int,double> >& urow = mU[ k ];
+            for( size_t e = 0; e < urow.size(); ++e ) {
+                const int c2 = urow[ e ].first;
+                if( nzMark[ c2 ] != i ) {
+                    if( !aAllowFill && patternMark[ c2 ] != i ) {
+                        continue;
+                    }
+                    nzMark[ c2 ] = i;
+                    work[ c2 ] = 0.0;
+                    nzCols.push_back( c2 );
+                    if( mColPos[ c2 ] < i ) {
+                        pending.push( mColPos[ c2 ] );
+                    }
+                }
+                work[ c2 ] -= mult * urow[ e ].second;
+            }
+        }
+
+        // Choose the pivot among the columns not yet pivoted.
+        int pivotCol = mPosCol[ i ];
+        double pivotVal = nzMark[ pivotCol ] == i ? work[ pivotCol ] : 0.0;
+        if( aPivotThreshold > 0.0 ) {
+            int maxCol = -1;
+            double maxVal = 0.0;
+            for( size_t e = 0; e < nzCols.size(); ++e ) {
+                const int c = nzCols[ e ];
+                if( mColPos[ c ] >= i && fabs( work[ c ] ) > maxVal ) {
+                    maxVal = fabs( work[ c ] );
+                    maxCol = c;
+                }
+            }
+            if( maxCol >= 0 && fabs( pivotVal ) < aPivotThreshold * maxVal ) {
+                const int maxPos = mColPos[ maxCol ];
+                mPosCol[ maxPos ] = pivotCol;
+                mColPos[ pivotCol ] = maxPos;
+                mPosCol[ i ] = maxCol;
+                mColPos[ maxCol ] = i;
+                pivotCol = maxCol;
+                pivotVal = work[ maxCol ];
+            }
+        }
+
+        if( pivotVal == 0.0 ) {
+            if( aAllowFill || nzCols.empty() ) {
+                // clean up the work vector before bailing out
+                for( size_t e = 0; e < nzCols.size(); ++e ) {
+                    work[ nzCols[ e ] ] = 0.0;
+                }
+                return row + 1;
+            }
+            // An incomplete factorization is only a preconditioner, so
+            // patch up the zero pivot rather than failing.
+            pivotVal = iluZeroPivot( aRowStart, aColIndex, aValues, row, pivotCol );
+        }
+        mDiag[ i ] = pivotVal;
+
+        for( size_t e = 0; e < nzCols.size(); ++e ) {
+            const int c = nzCols[ e ];
+            if( mColPos[ c ] > i ) {
+                mU[ i ].push_back( make_pair( c, work[ c ] ) );
+            }
+            work[ c ] = 0.0;
+        }
+    }
+    return 0;
+}
+
+/*!
+ * \brief Recompute the values of the factors for a matrix with the same
+ *        pattern, keeping the pivot sequence and structure of the last
+ *        call to factor().
+ * \details This skips everything symbolic: the ordering, the search for
+ *          fill, and the choice of pivots.  If a kept pivot no longer
+ *          passes the threshold test the factors are left invalid and
+ *          the caller has to call factor() again.
+ * \return 0 on success, -1 if factor() must be called instead.
+ */
+int SparseLUFactors::refactor( const vector<int>& aRowStart, const vector<int>& aColIndex,
+                               const vector<double>& aValues, bool aAllowFill, double aPivotThreshold )
+{
+    vector<double> work( mN, 0.0 );
+    vector<int> inRow( mN, -1 );
+
+    for( int i = 0; i < mN; ++i ) {
+        const int row = mRowOrder[ i ];
+        vector<pair<int,double> >& lrow = mL[ i ];
+        vector<pair<int,double> >& urow = mU[ i ];
+
+        // The columns this row of the factors can hold
+        inRow[ mPosCol[ i ] ] = i;
+        work[ mPosCol[ i ] ] = 0.0;
+        for( size_t e = 0; e < lrow.size(); ++e ) {
+            inRow[ mPosCol[ lrow[ e ].first ] ] = i;
+            work[ mPosCol[ lrow[ e ].first ] ] = 0.0;
+        }
+        for( size_t e = 0; e < urow.size(); ++e ) {
+            inRow[ urow[ e ].first ] = i;
+            work[ urow[ e ].first ] = 0.0;
+        }
+        for( int k = aRowStart[ row ]; k < aRowStart[ row + 1 ]; ++k ) {
+            work[ aColIndex[ k ] ] = aValues[ k ];
+        }
+
+        // The L entries were recorded in pivot order.
+        for( size_t e = 0; e < lrow.size(); ++e ) {
+            const int k = lrow[ e ].first;
+            const double mult = work[ mPosCol[ k ] ] / mDiag[ k ];
+            lrow[ e ].second = mult;
+            const vector<pair<int,double> >& ukrow = mU[ k ];
+            for( size_t u = 0; u < ukrow.size(); ++u ) {
+                if( inRow[ ukrow[ u ].first ] == i ) {
+                    work[ ukrow[ u ].first ] -= mult * ukrow[ u ].second;
+                }
+            }
+        }
+
+        double pivotVal = work[ mPosCol[ i ] ];
+        double maxVal = fabs( pivotVal );
+        for( size_t e = 0; e < urow.size(); ++e ) {
+            urow[ e ].second = work[ urow[ e ].first ];
+            maxVal = max( maxVal, fabs( urow[ e ].second ) );
+        }
+        if( pivotVal == 0.0 && !aAllowFill ) {
+            pivotVal = iluZeroPivot( aRowStart, aColIndex, aValues, row, mPosCol[ i ] );
+        }
+        else if( pivotVal == 0.0 || fabs( pivotVal ) < aPivotThreshold * maxVal ) {
+            return -1;
+        }
+        mDiag[ i ] = pivotVal;
+    }
+    return 0;
+}
+
+/*!
+ * \brief Solve A x = b with the factors.  x replaces b on output.
+ */
+void SparseLUFactors::solve( UBVECTOR& aB ) const {
+    vector<double> z( mN );
+    for( int k = 0; k < mN; ++k ) {
+        double s = aB[ mRowOrder[ k ] ];
+        const vector<pair<int,double> >& lrow = mL[ k ];
+        for( size_t e = 0; e < lrow.size(); ++e ) {
+            s -= lrow[ e ].second * z[ lrow[ e ].first ];
+        }
+        z[ k ] = s;
+    }
+    for( int k = mN - 1; k >= 0; --k ) {
+        double s = z[ k ];
+        const vector<pair<int,double> >& urow = mU[ k ];
+        for( size_t e = 0; e < urow.size(); ++e ) {
+            s -= urow[ e ].second * aB[ urow[ e ].first ];
+        }
+        // Every column referenced in urow has a later pivot position,
+        // so its entry of aB has already been overwritten by the solution.
+        aB[ mPosCol[ k ] ] = s / mDiag[ k ];
+    }
+}
+
+size_t SparseLUFactors::nonzeros() const {
+    size_t nnz = mN;
+    for( int k = 0; k < mN; ++k ) {
+        nnz += mL[ k ].size() + mU[ k ].size();
+    }
+    return nnz;
+}
+
+/*!
+ * \brief Take the nonzero pattern and fill-reducing ordering from a
+ *        freshly computed Jacobian.
+ * \details The diagonal is always included in the pattern so that the
+ *          Broyden update can move it away from zero.  If the pattern
+ *          was fixed by setStructure() it is kept as long as the size
+ *          matches, and only the stored values are marked as stale.
+ */
+void SparseMatrixSolver::analyze( const UBMATRIX& aJ ) {
+    mValuesCurrent = false;
+    if( mFixedPattern && mN == static_cast<int>( aJ.size1() ) ) {
+        return;
+    }
+    mFixedPattern = false;
+    mN = aJ.size1();
+    mRowStart.assign( 1, 0 );
+    mColIndex.clear();
+    for( int i = 0; i < mN; ++i ) {
+        for( int j = 0; j < mN; ++j ) {
+            if( i == j || aJ( i, j ) != 0.0 ) {
+                mColIndex.push_back( j );
+            }
+        }
+        mRowStart.push_back( mColIndex.size() );
+    }
+    setPattern();
+}
+
+/*!
+ * \brief Build the nonzero pattern from the structure of the Jacobian.
+ * \details Every column's rows are taken as nonzero whatever their current
+ *          values, so the pattern, ordering, and symbolic factorization
+ *          only need to be computed once per solve.
+ * \param aColRows For each column, the rows which could be nonzero.
+ */
+void SparseMatrixSolver::setStructure( const vector<vector<int> >& aColRows ) {
+    mN = aColRows.size();
+    vector<vector<int> > rowCols( mN );
+    for( int j = 0; j < mN; ++j ) {
+        rowCols[ j ].push_back( j );
+        for( size_t r = 0; r < aColRows[ j ].size(); ++r ) {
+            if( aColRows[ j ][ r ] != j ) {
+                rowCols[ aColRows[ j ][ r ] ].push_back( j );
+            }
+        }
+    }
+    mRowStart.assign( 1, 0 );
+    mColIndex.clear();
+    for( int i = 0; i < mN; ++i ) {
+        sort( rowCols[ i ].begin(), rowCols[ i ].end() );
+        mColIndex.insert( mColIndex.end(), rowCols[ i ].begin(), rowCols[ i ].end() );
+        mRowStart.push_back( mColIndex.size() );
+    }
+    mFixedPattern = true;
+    setPattern();
+}
+
+//! Compute the ordering for a new pattern and invalidate the symbolic factorization.
+void SparseMatrixSolver::setPattern() {
+    mValues.assign( mColIndex.size(), 0.0 );
+    mValuesCurrent = false;
+    minimumDegreeOrder( mN, mRowStart, mColIndex, mOrdering );
+    ++mPatternVersion;
+    mFactorVersion = -1;
+
+    ILogger& solverLog = ILogger::getLogger( "solver_log" );
+    solverLog.setLevel( ILogger::DEBUG );
+    solverLog << getName() << ": n= " << mN << "  nnz= " << mColIndex.size()
+              << ( mFixedPattern ? " (from Jacobian structure)\n" : "\n" );
+}
+
+/*!
+ * \brief Factor the gathered values, reusing the symbolic factorization
+ *        from the last successful factorization of the same pattern.
+ * \return 0 on success, otherwise the singular row as for factorize().
+ */
+int SparseMatrixSolver::factorValues( bool aAllowFill, double aPivotThreshold ) {
+    if( mFactorVersion == mPatternVersion &&
+        mFactors.refactor( mRowStart, mColIndex, mValues, aAllowFill, aPivotThreshold ) == 0 )
+    {
+        return 0;
+    }
+    int sing = mFactors.factor( mRowStart, mColIndex, mValues, mOrdering, aAllowFill, aPivotThreshold );
+    mFactorVersion = sing == 0 ? mPatternVersion : -1;
+    return sing;
+}
+
+/*!
+ * \brief Copy the values of the matrix at the stored pattern, unless the
+ *        stored values are already those of the matrix.
+ * \details The stored values stay current from one factorization to the
+ *          next as long as the matrix is only changed through update().
+ */
+void SparseMatrixSolver::gather( const UBMATRIX& aJ ) {
+    if( mN != static_cast<int>( aJ.size1() ) ) {
+        analyze( aJ );
+    }
+    if( mValuesCurrent ) {
+        return;
+    }
+    for( int i = 0; i < mN; ++i ) {
+        for( int k = mRowStart[ i ]; k < mRowStart[ i + 1 ]; ++k ) {
+            mValues[ k ] = aJ( i, mColIndex[ k ] );
+        }
+    }
+    mValuesCurrent = true;
+}
+
+void SparseMatrixSolver::multiply( const UBVECTOR& aX, UBVECTOR& aY ) const {
+    for( int i = 0; i < mN; ++i ) {
+        double s = 0.0;
+        for( int k = mRowStart[ i ]; k < mRowStart[ i + 1 ]; ++k ) {
+            s += mValues[ k ] * aX[ mColIndex[ k ] ];
+        }
+        aY[ i ] = s;
+    }
+}
+
+/*!
+ * \brief Schubert's sparse secant update.
+ * \details Each row of B is updated using only the components of dx
+ *          that fall in that row's nonzero pattern, so B satisfies
+ *          the secant condition B dx = dF while keeping the pattern
+ *          recorded by analyze().  The update is applied to the
+ *          compressed values in place, so the next factorize() does not
+ *          need to gather them again.  The updated entries are copied
+ *          back to aB since the solvers still use it for the gradient.
+ */
+void SparseMatrixSolver::update( UBMATRIX& aB, const UBVECTOR& aDF, const UBVECTOR& aDX ) {
+    gather( aB );
+    for( int i = 0; i < mN; ++i ) {
+        double dx2 = 0.0;
+        double r = aDF[ i ];
+        for( int k = mRowStart[ i ]; k < mRowStart[ i + 1 ]; ++k ) {
+            const int j = mColIndex[ k ];
+            dx2 += aDX[ j ] * aDX[ j ];
+            r -= mValues[ k ] * aDX[ j ];
+        }
+        if( dx2 > 0.0 ) {
+            r /= dx2;
+            for( int k = mRowStart[ i ]; k < mRowStart[ i + 1 ]; ++k ) {
+                const int j = mColIndex[ k ];
+                mValues[ k ] += r * aDX[ j ];
+                aB( i, j ) = mValues[ k ];
+            }
+        }
+    }
+}
+
+const string& SparseLUSolver::getNameStatic() {
+    static const string NAME = "sparse-lu";
+    return NAME;
+}
+
+const string& SparseLUSolver::getName() const {
+    return getNameStatic();
+}
+
+int SparseLUSolver::factorize( const UBMATRIX& aJ ) {
+    gather( aJ );
+    int sing = factorValues( true, mPivotThreshold );
+    if( sing == 0 ) {
+        ILogger& solverLog = ILogger::getLogger( "solver_log" );
+        solverLog.setLevel( ILogger::DEBUG );
+        solverLog << "sparse-lu: nnz( A )= " << mColIndex.size()
+                  << "  nnz( L+U )= " << mFactors.nonzeros() << "\n";
+    }
+    return sing;
+}
+
+int SparseLUSolver::solve( UBVECTOR& aB, ostream& aLog ) {
+    mFactors.solve( aB );
+    return 0;
+}
+
+const string& GMRESSolver::getNameStatic() {
+    static const string NAME = "gmres";
+    return NAME;
+}
+
+const string& GMRESSolver::getName() const {
+    return getNameStatic();
+}
+
+int GMRESSolver::factorize( const UBMATRIX& aJ ) {
+    gather( aJ );
+    return factorValues( false, 0.0 );
+}
+
+/*!
+ * \brief Set the iteration parameters.  Values that are not positive
+ *        leave the corresponding parameter unchanged.
+ */
+void GMRESSolver::setParameters( int aRestart, int aMaxIter, double aTol ) {
+    if( aRestart > 0 ) {
+        mRestart = aRestart;
+    }
+    if( aMaxIter > 0 ) {
+        mMaxIter = aMaxIter;
+    }
+    if( aTol > 0.0 ) {
+        mTol = aTol;
+    }
+}
+
+/*!
+ * \brief Solve with GMRES, right-preconditioned by the ILU(0) factors.
+ * \details Convergence is judged on the true residual ||b - A x|| of the
+ *          result rather than the estimate GMRES updates as it goes,
+ *          which can drift from it, particularly when the ILU(0) factors
+ *          are poor.
+ * \return 0 on success, -1 if the relative residual is above mTol, in
+ *         which case aB is left unchanged.
+ */
+int GMRESSolver::solve( UBVECTOR& aB, ostream& aLog ) {
+    using boost::numeric::ublas::norm_2;
+
+    UBVECTOR x( mN );
+    double resid = 0.0;
+    mLastIter = gmres( *this, aB, x, mRestart, mMaxIter, mTol, resid );
+
+    const double bnorm = norm_2( aB );
+    if( bnorm > 0.0 ) {
+        UBVECTOR r( mN );
+        multiply( x, r );
+        resid = norm_2( aB - r ) / bnorm;
+    }
+    if( !( resid <= mTol ) ) {
+        aLog << "gmres: did not converge in " << mLastIter << " iterations.  Relative residual= "
+             << resid << "\n";
+        return -1;
+    }
+    aLog << "gmres: converged in " << mLastIter << " iterations.\n";
+    aB = x;
+    return 0;
+}
+
+//! Apply the ILU(0) preconditioner in place.
+void GMRESSolver::precondition( UBVECTOR& aV ) const {
+    mFactors.solve( aV );
+}
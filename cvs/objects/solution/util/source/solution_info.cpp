@@ -227,6 +227,16 @@ double SolutionInfo::getEDRight() const {
     return EDR;
 }
 
+//! Get the price at the left bracket.
+double SolutionInfo::getXLeft() const {
+    return XL;
+}
+
+//! Get the price at the right bracket.
+double SolutionInfo::getXRight() const {
+    return XR;
+}
+
 /*! \brief Return the name of the SolutionInfo object.
 * \author Josh Lurz
 * \return The name of the market the SolutionInfo is connected to.
@@ -449,6 +459,30 @@ void SolutionInfo::moveLeftBracketToX(){
     EDL = getED();
 }
 
+/*!
+ * \brief Set the right bracket to a price and ED which were not necessarily
+ *        calculated at the current X, such as a trial value evaluated on a
+ *        scratch state.
+ * \param aX The price of the new right bracket.
+ * \param aED The excess demand at aX.
+ */
+void SolutionInfo::setRightBracket( const double aX, const double aED ){
+    XR = aX;
+    EDR = aED;
+}
+
+/*!
+ * \brief Set the left bracket to a price and ED which were not necessarily
+ *        calculated at the current X, such as a trial value evaluated on a
+ *        scratch state.
+ * \param aX The price of the new left bracket.
+ * \param aED The excess demand at aX.
+ */
+void SolutionInfo::setLeftBracket( const double aX, const double aED ){
+    XL = aX;
+    EDL = aED;
+}
+
 //! Reset left and right bracket to X.
 void SolutionInfo::resetBrackets(){
     bracketed = false;
@@ -600,7 +634,7 @@ double SolutionInfo::getUpperBoundSupplyPrice() const
 
 double SolutionInfo::getLowerBoundSupplyPriceInternal() const
 {
-    const string LOWER_BOUND_KEY = "lower-bound-supply-price";
+    const static objects::Atom* LOWER_BOUND_KEY = IInfo::getKey( "lower-bound-supply-price" );
     return linkedMarket->getMarketInfo()->hasValue( LOWER_BOUND_KEY ) ?
         linkedMarket->getMarketInfo()->getDouble( LOWER_BOUND_KEY, true ) :
         -util::getLargeNumber();
@@ -608,7 +642,7 @@ double SolutionInfo::getLowerBoundSupplyPriceInternal() const
 
 double SolutionInfo::getUpperBoundSupplyPriceInternal() const
 {
-    const string UPPER_BOUND_KEY = "upper-bound-supply-price";
+    const static objects::Atom* UPPER_BOUND_KEY = IInfo::getKey( "upper-bound-supply-price" );
     return linkedMarket->getMarketInfo()->hasValue( UPPER_BOUND_KEY ) ?
         linkedMarket->getMarketInfo()->getDouble( UPPER_BOUND_KEY, true ) :
         util::getLargeNumber();
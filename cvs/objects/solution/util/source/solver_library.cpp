@@ -62,9 +62,19 @@
 #include "util/logger/include/ilogger.h"
 #include "solution/util/include/ublas-helpers.hpp"
 #include "containers/include/iactivity.h"
+#include "containers/include/scenario.h"
+#include "util/base/include/manage_state_variables.hpp"
+#include "util/base/include/timer.h"
+
+#if GCAM_PARALLEL_ENABLED
+#include <tbb/task_group.h>
+#include <tbb/parallel_for.h>
+#endif
 
 using namespace std;
 
+extern Scenario* scenario;
+
 #define NO_REGIONAL_DERIVATIVES 0
 
 /*! \brief Calculate and return a relative excess demand.
@@ -317,11 +327,18 @@ bool SolverLibrary::luFactorizeMatrix( Matrix& aInputMatrix, PermutationMatrix&
 * \param aSolutionSet Vector of market solution information
 * \param aCalcCounter The calculation counter.
 * \param aPeriod Model period
+* \param aNumCandidates The number of bracket expansions to try at once in each
+*                       iteration.  When greater than one each market which is
+*                       still expanding its bracket is also moved by 2 through
+*                       aNumCandidates steps, the candidates are evaluated
+*                       concurrently with evaluateCandidates, and the candidate
+*                       which brackets the most markets is kept.
 * \return Whether bracketing of all markets completed successfully.
 */
 bool SolverLibrary::bracket( Marketplace* aMarketplace, World* aWorld, const double aDefaultBracketInterval,
                              const unsigned int aMaxIterations, SolutionInfoSet& aSolutionSet, CalcCounter* aCalcCounter,
-                             const ISolutionInfoFilter* aSolutionInfoFilter, const int aPeriod )
+                             const ISolutionInfoFilter* aSolutionInfoFilter, const int aPeriod,
+                             const unsigned int aNumCandidates )
 {
     bool code = false;
     static const double LOWER_BOUND = util::getVerySmallNumber();
@@ -358,6 +375,10 @@ bool SolverLibrary::bracket( Marketplace* aMarketplace, World* aWorld, const dou
     do {
         aSolutionSet.printMarketInfo( "Bracket All", aCalcCounter->getPeriodCount(), singleLog );
 
+        // The markets which are expanding their bracket in this iteration along
+        // with the direction: 1 to increase X, -1 to decrease X, and 0 otherwise.
+        vector<int> expandDirection( aSolutionSet.getNumSolvable(), 0 );
+
         // Iterate through each market.
         for ( unsigned int i = 0; i < aSolutionSet.getNumSolvable(); i++ ) {
             // Fetch the current 
@@ -381,6 +402,7 @@ bool SolverLibrary::bracket( Marketplace* aMarketplace, World* aWorld, const dou
                     if ( currSol.getED() < 0 ) {
                         currSol.moveRightBracketToX();
                         currSol.decreaseX( currBracketInterval, LOWER_BOUND );
+                        expandDirection[ i ] = -1;
                     } // END: if statement testing if ED < 0
                     // If Supply <= Demand. Price needs to increase so demand decreases
                     // If ED is positive, then so are EDL and EDR
@@ -388,6 +410,7 @@ bool SolverLibrary::bracket( Marketplace* aMarketplace, World* aWorld, const dou
                     else {
                         currSol.moveLeftBracketToX();
                         currSol.increaseX( currBracketInterval, LOWER_BOUND );
+                        expandDirection[ i ] = 1;
                     } // END: if statement testing if ED > 0
                 } // END: if statement testing if ED and EDL have the same sign
                 // If market is unbracketed, EDL and EDR have the same sign
@@ -444,6 +467,74 @@ bool SolverLibrary::bracket( Marketplace* aMarketplace, World* aWorld, const dou
             } // END: if statement testing if currSol is bracketed with XL == XR
         } // end for loop
 
+        if( aNumCandidates > 1 &&
+            find_if( expandDirection.begin(), expandDirection.end(), []( int aDir ) { return aDir != 0; } )
+                != expandDirection.end() )
+        {
+            // Candidate k has taken k + 1 expansion steps for each expanding market.
+            // The remaining markets keep the price they were just given.
+            vector<vector<double> > candidatePrices( aNumCandidates );
+            for( unsigned int k = 0; k < aNumCandidates; ++k ) {
+                for ( unsigned int i = 0; i < aSolutionSet.getNumSolvable(); ++i ) {
+                    SolutionInfo& currSol = aSolutionSet.getSolvable( i );
+                    if( k > 0 && expandDirection[ i ] > 0 ) {
+                        currSol.increaseX( currSol.getBracketInterval( aDefaultBracketInterval ), LOWER_BOUND );
+                    }
+                    else if( k > 0 && expandDirection[ i ] < 0 ) {
+                        currSol.decreaseX( currSol.getBracketInterval( aDefaultBracketInterval ), LOWER_BOUND );
+                    }
+                    candidatePrices[ k ].push_back( currSol.getPrice() );
+                }
+            }
+
+            vector<vector<double> > candidateED;
+            vector<double> candidateMaxRelED;
+            evaluateCandidates( aMarketplace, aWorld, aSolutionSet, candidatePrices, candidateED,
+                                candidateMaxRelED, aPeriod );
+
+            // Keep the candidate which brackets the most markets, preferring the
+            // smallest step so that brackets stay tight.  If none of them bracket
+            // any new markets take the largest step to cover the most ground.
+            unsigned int bestCandidate = aNumCandidates - 1;
+            unsigned int bestNumBracketed = 0;
+            for( unsigned int k = 0; k < aNumCandidates; ++k ) {
+                unsigned int numBracketed = 0;
+                for ( unsigned int i = 0; i < aSolutionSet.getNumSolvable(); ++i ) {
+                    if( expandDirection[ i ] != 0 &&
+                        util::sign( candidateED[ k ][ i ] ) != util::sign( aSolutionSet.getSolvable( i ).getEDLeft() ) )
+                    {
+                        ++numBracketed;
+                    }
+                }
+                if( numBracketed > bestNumBracketed ) {
+                    bestNumBracketed = numBracketed;
+                    bestCandidate = k;
+                }
+            }
+            // The candidate just short of the one kept has already been calculated,
+            // so markets it did not bracket can move their bracket in to it.
+            for ( unsigned int i = 0; bestCandidate > 0 && i < aSolutionSet.getNumSolvable(); ++i ) {
+                SolutionInfo& currSol = aSolutionSet.getSolvable( i );
+                const double prevPrice = candidatePrices[ bestCandidate - 1 ][ i ];
+                const double prevED = candidateED[ bestCandidate - 1 ][ i ];
+                if( expandDirection[ i ] == 0 || util::sign( prevED ) != util::sign( currSol.getEDLeft() ) ) {
+                    continue;
+                }
+                if( expandDirection[ i ] > 0 ) {
+                    currSol.setLeftBracket( prevPrice, prevED );
+                }
+                else {
+                    currSol.setRightBracket( prevPrice, prevED );
+                }
+            }
+            for ( unsigned int i = 0; i < aSolutionSet.getNumSolvable(); ++i ) {
+                aSolutionSet.getSolvable( i ).setPrice( candidatePrices[ bestCandidate ][ i ] );
+            }
+            solverLog.setLevel( ILogger::DEBUG );
+            solverLog << "Bracket candidate " << bestCandidate + 1 << " of " << aNumCandidates
+                      << " selected, newly bracketing " << bestNumBracketed << " markets." << endl;
+        }
+
         aMarketplace->nullSuppliesAndDemands( aPeriod );
 #if GCAM_PARALLEL_ENABLED
         aWorld->calc( aPeriod, aWorld->getGlobalFlowGraph() );
@@ -575,6 +666,83 @@ bool SolverLibrary::bracketOne( Marketplace* aMarketplace, World* aWorld, const
     return aSol->isBracketed();
 }
 
+/*!
+ * \brief Calculate the excess demands for several sets of trial prices at once.
+ * \details Each candidate is calculated with a complete World::calc on one of
+ *          the "scratch" state slots of ManageStateVariables, the same mechanism
+ *          used to calculate partial derivatives.  The candidates may therefore be
+ *          evaluated concurrently in parallel builds and the "base" state, which
+ *          includes the prices currently set in the markets, is left untouched.
+ *          The base state must be up to date, i.e. calculated for its prices, as
+ *          the candidates only add differences from it.  Serial builds evaluate
+ *          the candidates one after the other.
+ * \param aMarketplace Marketplace reference.
+ * \param aWorld World reference.
+ * \param aSolutionSet The solution set, candidate values are given by solvable index.
+ * \param aCandidatePrices The price of each solvable market for each candidate.
+ * \param aCandidateED Output of the excess demand of each solvable market for each
+ *                     candidate.
+ * \param aCandidateMaxRelED Output of the largest relative excess demand of the
+ *                           solvable markets for each candidate.
+ * \param aPeriod Model period.
+ */
+void SolverLibrary::evaluateCandidates( Marketplace* aMarketplace, World* aWorld, SolutionInfoSet& aSolutionSet,
+                                        const vector<vector<double> >& aCandidatePrices,
+                                        vector<vector<double> >& aCandidateED,
+                                        vector<double>& aCandidateMaxRelED, const int aPeriod )
+{
+    const size_t numCandidates = aCandidatePrices.size();
+    const unsigned int numSolvable = aSolutionSet.getNumSolvable();
+    aCandidateED.assign( numCandidates, vector<double>( numSolvable, 0.0 ) );
+    aCandidateMaxRelED.assign( numCandidates, 0.0 );
+
+    Timer& candidateTimer = TimerRegistry::getInstance().getTimer( "candidate-eval" );
+    candidateTimer.start();
+    ManageStateVariables* stateVars = scenario->getManageStateVariables();
+    stateVars->setPartialDeriv( true );
+    aMarketplace->mIsDerivativeCalc = true;
+
+    const vector<IActivity*>& globalOrdering = aWorld->getGlobalOrdering();
+    auto evaluateCandidate = [&]( const size_t aCandidate ) {
+        // Start from the base state, set the candidate prices, and calculate
+        // the full model on this thread's scratch state.
+        stateVars->copyState();
+        for( unsigned int i = 0; i < numSolvable; ++i ) {
+            aSolutionSet.getSolvable( i ).setPrice( aCandidatePrices[ aCandidate ][ i ] );
+        }
+        aWorld->calc( aPeriod, globalOrdering );
+        for( unsigned int i = 0; i < numSolvable; ++i ) {
+            const SolutionInfo& currSol = aSolutionSet.getSolvable( i );
+            aCandidateED[ aCandidate ][ i ] = currSol.getED();
+            aCandidateMaxRelED[ aCandidate ] = max( aCandidateMaxRelED[ aCandidate ],
+                                                    currSol.getRelativeED() );
+        }
+    };
+#if GCAM_PARALLEL_ENABLED
+    tbb::task_arena& threadPool = stateVars->mThreadPool;
+    tbb::task_group tg;
+    threadPool.execute([&](){
+        tg.run([&](){
+            tbb::parallel_for( size_t( 0 ), numCandidates, evaluateCandidate );
+        });
+    });
+    threadPool.execute([&tg](){ tg.wait(); });
+#else
+    for( size_t k = 0; k < numCandidates; ++k ) {
+        evaluateCandidate( k );
+    }
+#endif
+
+    aMarketplace->mIsDerivativeCalc = false;
+    stateVars->setPartialDeriv( false );
+    candidateTimer.stop();
+
+    ILogger& solverLog = ILogger::getLogger( "solver_log" );
+    solverLog.setLevel( ILogger::DEBUG );
+    solverLog << "Evaluated " << numCandidates << " candidates, total candidate time: "
+              << candidateTimer.getTotalTimeDifference() << endl;
+}
+
 /*! \brief Store the current prices in the solver set in a vector.
 * \param aSolutionSet Solution set.
 * \return Vector of prices currently in the solver set.
@@ -45,9 +45,11 @@
  */
 
 #include <string>
+#include <memory>
 #include <xercesc/dom/DOMNode.hpp>
 
 class Tabs;
+class CachedMarket;
 
 #include "technologies/include/ioutput.h"
 #include "util/base/include/value.h"
@@ -199,6 +201,9 @@ protected:
         //! the current region is assumed.
         DEFINE_VARIABLE( SIMPLE, "market-name", mMarketName, std::string )
     )
+
+    //! The market of the secondary good located in initCalc.
+    std::auto_ptr<CachedMarket> mCachedMarket;
     
     void copy( const SecondaryOutput& aOther );
 };
@@ -0,0 +1,138 @@
+#ifndef _ACTIVITY_PROFILER_H_
+#define _ACTIVITY_PROFILER_H_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+* \file activity_profiler.h  
+* \ingroup Objects
+* \brief Header file for the ActivityProfiler class.
+*/
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <boost/core/noncopyable.hpp>
+
+#if GCAM_PARALLEL_ENABLED
+#include <tbb/enumerable_thread_specific.h>
+#endif
+
+class IActivity;
+class AutoOutputFile;
+
+/*!
+ * \brief Records the time spent in and the number of calls to each IActivity::calc.
+ * \details Unlike the timers in the TimerRegistry this profiler is meant to be
+ *          left on for a whole run.  Each thread accumulates into its own table
+ *          so no locking is done while timing, and the tables are only combined
+ *          at the end of each period.  Times are kept separately for full
+ *          calcs and the partial calcs of only the activities affected by a
+ *          change in prices, such as those made for derivatives.  At the end
+ *          of each period a row for each activity which was calculated is
+ *          written to a CSV file and the same times are written to a
+ *          collapsed-stack file of the form period;calc-type;region;activity
+ *          which can be fed to flame graph tools.
+ *
+ *          The profiler is enabled by the configuration flag profile-activities.
+ *          The file names are set by the activity-profile and
+ *          activity-profile-stacks files in the configuration.
+ */
+class ActivityProfiler : private boost::noncopyable {
+public:
+    ~ActivityProfiler();
+
+    static ActivityProfiler& getInstance();
+
+    void init( const std::vector<IActivity*>& aGlobalOrdering );
+
+    /*!
+     * \brief Whether activity calcs are being profiled.
+     * \return True if the profiler is enabled.
+     */
+    bool isEnabled() const {
+        return mIsEnabled;
+    }
+
+    void calcActivity( IActivity* aActivity, const int aCalcOrder, const int aPeriod,
+                       const bool aIsFullCalc );
+
+    void finishPeriod( const int aYear );
+private:
+    ActivityProfiler();
+
+    //! Time and call count for one activity and type of calc.
+    struct ActivityStats {
+        ActivityStats():mTime( 0 ), mCount( 0 ) {}
+
+        //! Total time spent in calc in seconds.
+        double mTime;
+
+        //! The number of calls to calc.
+        unsigned long mCount;
+    };
+
+    //! Stats for each activity indexed by 2 * calc order + 1 if a full calc.
+    typedef std::vector<ActivityStats> StatsVector;
+
+    StatsVector& getLocalStats();
+
+    //! Whether the profiler is enabled.
+    bool mIsEnabled;
+
+    //! The region name for each activity in the global ordering.
+    std::vector<std::string> mRegionNames;
+
+    //! The description of each activity in the global ordering less the region name.
+    std::vector<std::string> mActivityNames;
+
+#if GCAM_PARALLEL_ENABLED
+    //! Stats accumulated by each thread.
+    tbb::enumerable_thread_specific<StatsVector> mThreadStats;
+#else
+    //! Stats accumulated during the current period.
+    StatsVector mStats;
+#endif
+
+    //! The CSV file of times per period.
+    std::auto_ptr<AutoOutputFile> mCSVFile;
+
+    //! The collapsed-stack file of times.
+    std::auto_ptr<AutoOutputFile> mStackFile;
+};
+
+#endif // _ACTIVITY_PROFILER_H_
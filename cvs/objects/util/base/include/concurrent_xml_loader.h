@@ -0,0 +1,128 @@
+#ifndef _CONCURRENT_XML_LOADER_H_
+#define _CONCURRENT_XML_LOADER_H_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*! 
+* \file concurrent_xml_loader.h  
+* \ingroup Objects
+* \brief Header file for the ConcurrentXMLLoader class.
+*/
+
+#include <string>
+#include <list>
+#include <vector>
+#include <memory>
+#include <boost/core/noncopyable.hpp>
+
+#if GCAM_PARALLEL_ENABLED
+#include <tbb/task_group.h>
+#endif
+
+namespace xercesc {
+    class DOMDocument;
+}
+class IParsable;
+
+/*!
+* \ingroup Objects
+* \brief Reads a list of XML files ahead of time and applies them in order.
+* \details Each file is scanned, validated and turned into a DOM document on a
+*          worker thread with its own parser, reading ahead of the file that is
+*          currently being applied by at most the given number of files, which
+*          defaults to the number of available threads.  Each file read ahead
+*          is held in memory as a DOM document until it is applied.
+*          Calls to parseNext then hand the documents to IParsable::XMLParse one
+*          at a time in the original order, on the calling thread, so the
+*          results of merging the files are the same as parsing them one after
+*          another. Documents are rebuilt from XML snapshots when available.
+*
+*          When streaming is requested, no read ahead is allowed, or in builds
+*          without parallel support, each file is simply parsed with
+*          XMLHelper::parseXML when it is applied.  No worker threads are
+*          started in that case which is required if the process will be
+*          forked afterwards.
+*/
+class ConcurrentXMLLoader: private boost::noncopyable {
+public:
+    ConcurrentXMLLoader( const std::list<std::string>& aXMLFiles,
+                         const int aStreamDepth,
+                         const int aMaxReadAhead );
+
+    ~ConcurrentXMLLoader();
+
+    bool parseNext( IParsable* aModelElement );
+private:
+    //! A file which is being read ahead of time.
+    struct PendingDocument {
+        //! The name of the file.
+        std::string mFileName;
+
+        //! The document read from the file, or null if it was not read yet
+        //! or reading it failed.
+        xercesc::DOMDocument* mDocument;
+
+        //! The error message if reading the file failed.
+        std::string mError;
+    };
+
+    //! The files in the order they are to be applied.
+    std::vector<PendingDocument> mDocuments;
+
+    //! The index of the next document to apply.
+    size_t mNextToApply;
+
+    //! The depth to stream files at, or zero to read whole documents.
+    const int mStreamDepth;
+
+#if GCAM_PARALLEL_ENABLED
+    //! The index of the next document to start reading.
+    size_t mNextToRead;
+
+    //! The maximum number of documents read ahead of the one being applied,
+    //! zero to read each document when it is applied.
+    size_t mMaxReadAhead;
+
+    //! One task group per document so that each may be waited on separately.
+    std::unique_ptr<tbb::task_group[]> mReadGroups;
+
+    void startReading();
+#endif
+
+    static void readDocument( PendingDocument& aDocument );
+};
+
+#endif // _CONCURRENT_XML_LOADER_H_
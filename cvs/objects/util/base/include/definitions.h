@@ -67,6 +67,24 @@
 #define USE_HECTOR 1
 #endif
 
+//! A flag which turns on sparse copy on write "scratch" state for parallel partial
+//! derivatives instead of a full copy of the state for each thread.  Only has an
+//! effect when GCAM_PARALLEL_ENABLED.
+#ifndef GCAM_SPARSE_SCRATCH
+#define GCAM_SPARSE_SCRATCH 0
+#endif
+#if !GCAM_PARALLEL_ENABLED
+#undef GCAM_SPARSE_SCRATCH
+#define GCAM_SPARSE_SCRATCH 0
+#endif
+
+//! A flag which turns on checking each partial Jacobian refresh against a full
+//! finite difference Jacobian, reported to the solver log.  This is expensive
+//! and only intended for debugging.
+#ifndef DEBUG_JACOBIAN_REFRESH
+#define DEBUG_JACOBIAN_REFRESH 0
+#endif
+
 // This allows for memory leak debugging.
 #if defined(_MSC_VER)
 #   ifdef _DEBUG
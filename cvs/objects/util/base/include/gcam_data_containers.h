@@ -200,6 +200,7 @@
 #include "util/curves/include/explicit_point_set.h"
 #include "util/curves/include/point_set.h"
 #include "util/curves/include/point_set_curve.h"
+#include "util/curves/include/sorted_point_set.h"
 #include "util/curves/include/xy_data_point.h"
 
 #endif // _GCAM_DATA_CONTAINERS_H_
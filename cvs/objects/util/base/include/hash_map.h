@@ -45,11 +45,13 @@
 */
 #include <string>
 #include <vector>
+#include <deque>
+#include <algorithm>
 #include <memory>
+#include <cassert>
 
 #include "util/base/include/atom.h"
 #include <boost/functional/hash/hash.hpp>
-#include <boost/shared_ptr.hpp>
 
 //! Turn on hash map tuning. This imposes a slight overhead.
 #define TUNING_STATS 0
@@ -69,44 +71,57 @@
 *          using a hash function. A hash function is a function which converts a
 *          key into a pseudo-random value distributed over the range of the
 *          internal storage array. If the hash function converts two distinct
-*          keys into the same value, a collision occurs which the map must
-*          handle. The hash map is implemented as a list of buckets, accessed by
-*          an integer index. Each bucket can contain a single key-value pairing,
-*          or a chain of pairings implemented as a linked list. If there are no
-*          collisions, then each bucket only contains a single key-value pair.
-*          When a collision does occur, the collided values are placed in the
-*          bucket's chain. As a result of this design, access to a value given a
-*          key can occur in constant time unless there is a collision on the
-*          key. To minimize collisions, the hashmap automatically increases its
-*          size to prevent the map from reaching over 40 percent of its
-*          capacity.
+*          keys into the same position, a collision occurs which the map must
+*          handle. The hash map is implemented with open addressing: a single
+*          power of two sized array of slots, each holding the full hash code of
+*          a key and the position of its key-value pair. Collisions are resolved
+*          by linear probing with Robin Hood ordering, an item which is further
+*          from its preferred slot takes the place of one which is closer, which
+*          keeps probe sequences short and lets an unsuccessful search stop
+*          early. Since the full hash code is kept in the slot most mismatches
+*          are rejected without comparing keys and the map can grow without
+*          hashing any keys again. The key-value pairs themselves are stored in
+*          insertion order in a deque so that they are never moved once added,
+*          references to values remain valid as the map grows, and iteration
+*          visits the items in the order they were added. The hashmap
+*          automatically increases its size to prevent the slots from reaching
+*          over 75 percent of their capacity.
 * \note This is not currently a complete map implementation, it only allows for
 *       getting and setting individual values. There is currently not a way to
-*       iterate over the key-value set or remove keys from the map.
+*       remove keys from the map.
 * \note The Value type is required to implement the no-argument constructor.
 *       This condition must be true for standard library containers as well.
-* \note Do not use auto_ptrs as Values as they may be accidentally deleted during
-*       resizes. This is true of standard library containers as well.
+* \note Keys which are searched for many times may have their hash code
+*       precomputed with getHashCode and passed to find to avoid hashing the key
+*       on each search.
 * \author Josh Lurz
 */
 
 template <class Key, class Value>
 class HashMap {
 private:
-	// Forward declare the Item so the interface is easier to read.
-	struct Item;
+	/*! \brief A slot locates a key-value pair from its hash code.
+	* \details The slot stores the full hash code of the key along with the
+	*          position of the key-value pair in the item storage. An empty
+	*          slot has a position of EMPTY.
+    */
+	struct Slot {
+        //! The full hash code of the key.
+		size_t mHashCode;
+
+        //! The position of the item in mItems or EMPTY.
+		size_t mPosition;
+	};
 
-    //! Typedef which defines the type of a pair containing pointer to an Item
-    //! and it's position in the bucket vector.
-    typedef std::pair<Item*,size_t> ItemPair;
-    typedef std::pair<const Item*, size_t> CItemPair;
+    //! Typedef of a key-value pair as it is stored.
+    typedef std::pair<Key, Value> Item;
 public:
 	/*! \brief Constant iterator to a HashMap. */
 	class const_iterator {
 	public:
         const_iterator();
 		explicit const_iterator( const Item* aCurrentItem,
-                                 const size_t aBucketPosition,
+                                 const size_t aPosition,
                                  const HashMap* aParent );
 
 		bool operator==( const const_iterator& aOther ) const;
@@ -116,9 +131,12 @@ public:
         const_iterator& operator++();    // prefix ++
         const_iterator operator++(int); // postfix ++
 	protected:
-        //! The current item at which the iterator is pointing and it's bucket
-        //! spot.
-        CItemPair mCurrentItem;
+        //! The current item at which the iterator is pointing, null for the end
+        //! iterator.
+        const Item* mCurrentItem;
+
+        //! The position of the current item in insertion order.
+        size_t mPosition;
 
         //! Pointer to the parent hashmap of the iterator.
         const HashMap* mParent;
@@ -130,7 +148,7 @@ public:
 	public:
         iterator();
 		explicit iterator( Item* aCurrentItem,
-                           const size_t aBucketPosition,
+                           const size_t aPosition,
                            const HashMap* aParent );
 
 		bool operator==( const iterator& aOther ) const;
@@ -145,54 +163,45 @@ public:
 	~HashMap();
     bool empty() const;
     size_t size() const;
+    size_t getHashCode( const Key& aKey ) const;
 	std::pair<iterator, bool> insert( const std::pair<Key, Value> aKeyValuePair );
+	std::pair<iterator, bool> insert( const std::pair<Key, Value> aKeyValuePair,
+                                      const size_t aHashCode );
     Value& operator[]( const Key& aKey );
 	const_iterator find( const Key& aKey ) const;
 	iterator find( const Key& aKey );
+	const_iterator find( const Key& aKey, const size_t aHashCode ) const;
+	iterator find( const Key& aKey, const size_t aHashCode );
 	const_iterator begin() const;
 	iterator begin();
 	const_iterator end() const;
 	iterator end();
 private:
 	void resize( const size_t aNewSize );
+    size_t findPosition( const Key& aKey, const size_t aHashCode ) const;
+    size_t getPreferredSlot( const size_t aHashCode ) const;
+    void placeSlot( Slot aSlot );
     
-    CItemPair getFirstItem() const;
-    CItemPair getNextItem( const CItemPair& aItemPair ) const;
-    
-    ItemPair getFirstItem();
-    ItemPair getNextItem( const ItemPair& aItemPair );
+    const Item* getNextItem( const size_t aPosition ) const;
 
-	//! The internal storage for the buckets.
-	std::vector<boost::shared_ptr<Item> > mBuckets;
+	//! The internal storage for the slots, the size is always a power of two.
+	std::vector<Slot> mSlots;
 
-	//! Current size of the storage vector, which is greater than the number of
+	//! Current size of the slot vector, which is greater than the number of
     //! values.
 	size_t mSize;
 
-	//! Number of entries.
-	size_t mNumEntries;
+    //! The number of bits to shift a mixed hash code to select a slot.
+    size_t mShift;
+
+    //! The key-value pairs in insertion order.
+    std::deque<Item> mItems;
 
 	//! The hashmap's hash function
 	boost::hash<Key> mHashFunction;
 
-	/*! \brief An item stores a key value pairing together.
-	* \details The Item structure stores the key value pairing, along with a
-	*          pointer to the next item in the bucket to allow chaining.
-    */
-	struct Item {
-		inline Item( const std::pair<Key, Value>& aKeyValuePair );
-		/*! \brief The key value pair.
-        */
-		std::pair<Key, Value> mKeyValuePair;
-
-		/*! \brief A pointer to the next Item in the bucket, null if it is the
-		*          last item in the bucket.
-		* \note The use of a smart pointer allows for an entire chain to be
-        *       deleted by deleting the head of the chain, which induces a
-        *       cascading deletion.
-        */
-		boost::shared_ptr<Item> mNext;
-	};
+    //! Position marking an empty slot.
+    static const size_t EMPTY = static_cast<size_t>( -1 );
 
 #if( TUNING_STATS )
 	//! Number of collisions if TUNING_STATS is on.
@@ -206,20 +215,27 @@ private:
 /*! \brief Constructor
 * \details Construct a hashmap with a specified size.
 * \param aSize The initial size of the map. The map may grow from this size if
-*        enough entries are added.
+*        enough entries are added. The size will be rounded up to a power of
+*        two.
 */
 template <class Key, class Value>
 HashMap<Key, Value>::HashMap( const size_t aSize ):
-mBuckets( aSize ), mSize( aSize ), mNumEntries( 0 )
+mSize( 0 ), mShift( 0 )
 #if( TUNING_STATS )
 , mNumCollisions( 0 ),
 mNumResizes( 0 )
 #endif
 {
+    // Use a minimum of eight slots.
+    size_t initialSize = 8;
+    while( initialSize < aSize ){
+        initialSize *= 2;
+    }
+    resize( initialSize );
 }
 
 /*! \brief Destructor
-* \details All memory deallocation is performed by the smart pointers, the
+* \details All memory deallocation is performed by the containers, the
 *          destructor is only responsible for printing hash map statistics(if
 *          TUNING_STATS is compiled on).
 * \warning Deleting the map will not delete any allocated memory the user
@@ -230,9 +246,9 @@ template <class Key, class Value>
 HashMap<Key, Value>::~HashMap(){
 #if( TUNING_STATS )
 	std::cout << "Hashmap stats - Size: " << static_cast<unsigned int>( mSize ) 
-		<< " Number of entries: " << static_cast<unsigned int>( mNumEntries )
+		<< " Number of entries: " << static_cast<unsigned int>( mItems.size() )
 		<< " Collisions: " << mNumCollisions << " Percent full : " 
-		<< static_cast<double>( mNumEntries ) / mSize * 100 
+		<< static_cast<double>( mItems.size() ) / mSize * 100 
 		<< " Number of resizes: " << mNumResizes << std::endl;
 #endif
 }
@@ -243,7 +259,7 @@ HashMap<Key, Value>::~HashMap(){
 template <class Key, class Value>
 bool
 HashMap<Key, Value>::empty() const {
-    return mNumEntries == 0;
+    return mItems.empty();
 }
 
 /*! \brief Return the number of items in the hashmap.
@@ -252,18 +268,25 @@ HashMap<Key, Value>::empty() const {
 template <class Key, class Value>
 size_t
 HashMap<Key, Value>::size() const {
-    return mNumEntries;
+    return mItems.size();
+}
+
+/*! \brief Compute the hash code of a key.
+* \details The hash code may be stored by callers which search for the same key
+*          many times and passed to find or insert.
+* \param aKey The key to hash.
+* \return The hash code of the key.
+*/
+template <class Key, class Value>
+size_t
+HashMap<Key, Value>::getHashCode( const Key& aKey ) const {
+    return mHashFunction( aKey );
 }
 
 /*! \brief Insert a key-value pair to the map.
 * \details This function takes a key value pairing and adds it to the hashmap.
-*          To do this, it first calls the hash function on the key to determine
-*          which bucket the item should reside in. If the bucket is currently
-*          empty, the item is added as the first item in the bucket. Otherwise
-*          the linked list is traversed to see if the item already exists. If it
-*          does, the value is updated and the function will return true.
-*          Otherwise an item is added to the end of the list for this key-value
-*          pairing.
+*          If the key already exists the value is updated, otherwise the pair is
+*          added.
 * \param aKeyValuePair The key value pair to add to the hashmap.
 * \return A pair consisting of the iterator where the value was found and a bool
 *         representing whether the insert was a new value.
@@ -271,93 +294,57 @@ HashMap<Key, Value>::size() const {
 template <class Key, class Value>
 std::pair<typename HashMap<Key, Value>::iterator, bool>
 HashMap<Key, Value>::insert( const std::pair<Key, Value> aKeyValuePair ){
-	// First find the hash value and use the modulo function to reduce it to
-	// within the size of the bucket vector.
-	const size_t bucketSpot = mHashFunction( aKeyValuePair.first ) % mSize;
-
-	// We now know which bucket to either add the value to or update. Begin the
-    // search.
-	Item* curr = mBuckets[ bucketSpot ].get();
-	Item* prev = 0;   
-
-	// If the head of the chain is null, avoid attempting to search. Keep
-	// searching until we find the correct Item or the end of the chain. Track
-	// the previous position in the chain so that we can add to the end if the
-	// key is not found.
-	bool update = false;
-	while( curr ){
-		// Check if this is the correct spot.
-		if( curr->mKeyValuePair.first == aKeyValuePair.first ){
-			// Stop the search here as this is the postion to update.
-			update = true;
-			break;
-		}
-
-		// Move to the next item in the chain, which may be null.
-		prev = curr;
-
-		/*! \invariant Ensure that a pointer is not being assigned a reference
-        *              to itself. 
-        */
-		assert( curr != curr->mNext.get() );
-
-		curr = curr->mNext.get();
-	}
-
-	// If we found a spot to update, curr will not be null as the loop will have
-	// been exited by the successful match. Update the value and return that the
-	// value existed.
-	if( update ){
-		curr->mKeyValuePair.second = aKeyValuePair.second;
-		return std::make_pair( iterator( curr, bucketSpot, this ), false );
-	}
+    return insert( aKeyValuePair, mHashFunction( aKeyValuePair.first ) );
+}
 
-	// We are not updating, so a new value must be added.
-	boost::shared_ptr<Item> newValue( new Item( aKeyValuePair ) );
-	++mNumEntries;
+/*! \brief Insert a key-value pair to the map given the hash code of the key.
+* \details This function first searches for the key. If it does exist the value
+*          is updated and the function will return false. Otherwise the pair is
+*          added to the end of the item storage and a slot for it is placed in
+*          the slot vector, growing the slot vector first if it would exceed the
+*          capacity threshold.
+* \param aKeyValuePair The key value pair to add to the hashmap.
+* \param aHashCode The hash code of the key as returned by getHashCode.
+* \return A pair consisting of the iterator where the value was found and a bool
+*         representing whether the insert was a new value.
+*/
+template <class Key, class Value>
+std::pair<typename HashMap<Key, Value>::iterator, bool>
+HashMap<Key, Value>::insert( const std::pair<Key, Value> aKeyValuePair,
+                             const size_t aHashCode )
+{
+    /*! \pre The hash code must be the hash code of the key. */
+    assert( aHashCode == mHashFunction( aKeyValuePair.first ) );
+
+    // Check if this key already exists, in which case update the value and
+    // return that the value existed.
+    const size_t existing = findPosition( aKeyValuePair.first, aHashCode );
+    if( existing != EMPTY ){
+        mItems[ existing ].second = aKeyValuePair.second;
+        return std::make_pair( iterator( &mItems[ existing ], existing, this ), false );
+    }
 
-	// Add the entry as the first item in the bucket if there is not a previous
-    // pairing.
-	if( !prev ){
-		mBuckets[ bucketSpot ] = newValue;
-	}
-	else {
-		/*! \invariant Ensure that a loop is not created. */
-		assert( prev != newValue.get() );
+	// The ratio of entries to the size of the slot vector at which to increase
+	// the size. Robin Hood ordering keeps probe sequences short up to a fairly
+    // high load.
+	const double CAPACITY_THRESHHOLD = 0.75;
 
-		// Add the new item to the end of the chain.
-		prev->mNext = newValue;
-#if( TUNING_STATS )
-		// Record the collision.
-		++mNumCollisions;
-#endif
-	}
-	// The ratio of entries to the maximum size of the map at which to increase
-	// the map size. This is currently a low threshold as the maps are adjusted
-    // for performance not size. This may need to be adjusted for small maps.
-	const double CAPACITY_THRESHHOLD = 0.4;
-
-	// The multiple of the current size to which to set the new size.
-	const unsigned int RESIZE_MULTIPLE = 3;
-
-	// An additional size increment which helps performance for small maps where
-    // resizing by the above factor would not be enough.
-	const unsigned int ADDITIONAL_INCREMENT = 5;
-
-	// Check if the size of the bucket vector should be increased for
-	// performance. This should be done if the ratio of full to total buckets
-	// exceeds CAPACITY_THRESHHOLD.
-	if( static_cast<double>( mNumEntries ) / mSize > CAPACITY_THRESHHOLD ){
-		// Resize to three times the number of current entries plus several
-		// extra to handle small hashmaps. The bucket was empty, so add it as
-		// the first value.
+	// Check if the size of the slot vector should be increased before adding.
+	if( static_cast<double>( mItems.size() + 1 ) / mSize > CAPACITY_THRESHHOLD ){
 #if( TUNING_STATS )
 		++mNumResizes;
 #endif
-		resize( mNumEntries * RESIZE_MULTIPLE + ADDITIONAL_INCREMENT );
+		resize( mSize * 2 );
 	}
+
+	// We are not updating, so a new value must be added.
+    mItems.push_back( aKeyValuePair );
+    const size_t position = mItems.size() - 1;
+    Slot newSlot = { aHashCode, position };
+    placeSlot( newSlot );
+
 	// Return that an add and not an update occurred.
-	return std::make_pair( iterator( newValue.get(), bucketSpot, this ), true );
+	return std::make_pair( iterator( &mItems[ position ], position, this ), true );
 }
 
 /*!
@@ -371,26 +358,23 @@ HashMap<Key, Value>::insert( const std::pair<Key, Value> aKeyValuePair ){
 template <class Key, class Value>
 Value&
 HashMap<Key, Value>::operator[]( const Key& aKey ){
-    // Check if the key already exists.
-    typedef typename HashMap<Key, Value>::iterator hashMapIterator;
-    hashMapIterator currValue = find( aKey );
+    // Only hash the key once for both the search and the insert.
+    const size_t hashCode = mHashFunction( aKey );
 
     // Return the value if it already exists.
-    if( currValue != end() ){
-        return currValue->second;
+    const size_t existing = findPosition( aKey, hashCode );
+    if( existing != EMPTY ){
+        return mItems[ existing ].second;
     }
 
     // Insert the default value.
-    std::pair<iterator, bool> newPair = insert( make_pair( aKey, Value() ) );
+    std::pair<iterator, bool> newPair = insert( std::make_pair( aKey, Value() ), hashCode );
     assert( newPair.second );
 
-    // The first value in the iterator is a pair<Key, Value&>, so return the
-    // first->second.
     return newPair.first->second;
 }
 
 /*! \brief Returns a mutable iterator for a given key.
-* \details
 * \param aKey Key for which to return the value.
 * \return An iterator to the requested value or the end iterator if the key was
 *         not found.
@@ -398,28 +382,10 @@ HashMap<Key, Value>::operator[]( const Key& aKey ){
 template <class Key, class Value>
 typename HashMap<Key, Value>::iterator
 HashMap<Key, Value>::find( const Key& aKey ){
-	// First find the hash value and use the modulus function to reduce it to
-	// within the size of the bucket vector.
-	const size_t bucketSpot = mHashFunction( aKey ) % mSize;
-
-	// We now know which bucket the key resides in if it exists.
-	Item* curr = mBuckets[ bucketSpot ].get();
-
-	// Keep searching until we find the correct Item or the end of the chain.
-	while( curr ){
-		// Check if this is the correct spot.
-		if( curr->mKeyValuePair.first == aKey ){
-			return iterator( curr, bucketSpot, this );
-		}
-		// Move to the next item in the chain, which may be null.
-		curr = curr->mNext.get();
-	}
-	// Return the end iterator is the key was not found.
-	return end();
+    return find( aKey, mHashFunction( aKey ) );
 }
 
 /*! \brief Returns an immutable value for a given key.
-* \details
 * \param aKey Key for which to return the value.
 * \return A constant iterator to the result or the end iterator if the key is
 *         not found.
@@ -427,50 +393,54 @@ HashMap<Key, Value>::find( const Key& aKey ){
 template <class Key, class Value>
 typename HashMap<Key, Value>::const_iterator
 HashMap<Key, Value>::find( const Key& aKey ) const {
-	// First find the hash value and use the mod function to reduce it to within
-	// the size of the bucket vector.
-	const size_t bucketSpot = mHashFunction( aKey ) % mSize;
-
-	// We now know which bucket the key resides in if it exists.
-	const Item* curr = mBuckets[ bucketSpot ].get();
-
-	// Keep searching until we find the correct Item or the end of the chain.
-	while( curr ){
-		// Check if this is the correct spot.
-		if( curr->mKeyValuePair.first == aKey ){
-			return const_iterator( curr, bucketSpot, this );
-		}
-		// Move to the next item in the chain, which may be null.
-		curr = curr->mNext.get();
-	}
-	// Return the end iterator is the key was not found.
-	return end();
+    return find( aKey, mHashFunction( aKey ) );
+}
+
+/*! \brief Returns a mutable iterator for a given key and its hash code.
+* \param aKey Key for which to return the value.
+* \param aHashCode The hash code of the key as returned by getHashCode.
+* \return An iterator to the requested value or the end iterator if the key was
+*         not found.
+*/
+template <class Key, class Value>
+typename HashMap<Key, Value>::iterator
+HashMap<Key, Value>::find( const Key& aKey, const size_t aHashCode ){
+    const size_t position = findPosition( aKey, aHashCode );
+    return position != EMPTY ? iterator( &mItems[ position ], position, this ) : end();
+}
+
+/*! \brief Returns an immutable value for a given key and its hash code.
+* \param aKey Key for which to return the value.
+* \param aHashCode The hash code of the key as returned by getHashCode.
+* \return A constant iterator to the result or the end iterator if the key is
+*         not found.
+*/
+template <class Key, class Value>
+typename HashMap<Key, Value>::const_iterator
+HashMap<Key, Value>::find( const Key& aKey, const size_t aHashCode ) const {
+    const size_t position = findPosition( aKey, aHashCode );
+    return position != EMPTY ? const_iterator( &mItems[ position ], position, this ) : end();
 }
 
 /*! \brief Return the begin iterator.
-* \details
 * \return The begin iterator.
 */
 template<class Key, class Value>
 typename HashMap<Key, Value>::iterator
 HashMap<Key, Value>::begin() {
-    ItemPair itemPair = getFirstItem();
-	return iterator( itemPair.first, itemPair.second, this );
+    return empty() ? end() : iterator( &mItems[ 0 ], 0, this );
 }
 
 /*! \brief Return the constant begin iterator.
-* \details
 * \return The constant begin iterator.
 */
 template<class Key, class Value>
 typename HashMap<Key, Value>::const_iterator
 HashMap<Key, Value>::begin() const {
-    CItemPair itemPair = getFirstItem();
-	return const_iterator( itemPair.first, itemPair.second, this );
+    return empty() ? end() : const_iterator( &mItems[ 0 ], 0, this );
 }
 
 /*! \brief Return the end iterator.
-* \details
 * \return The end iterator.
 */
 template<class Key, class Value>
@@ -480,7 +450,6 @@ HashMap<Key, Value>::end() {
 }
 
 /*! \brief Return the constant end iterator.
-* \details
 * \return The constant end iterator.
 */
 template<class Key, class Value>
@@ -489,235 +458,129 @@ HashMap<Key, Value>::end() const {
 	return const_iterator( 0, 0, 0 );
 }
 
-/*! \brief Resize the bucket vector. 
-* \details To resize the vector, the function first walks the hashmap to store
-*          the list of all items in the map. It then resizes the bucket vector
-*          and reinserts all the values into the map.
-* \warning This operation is very slow as it requires rehashing all entries.
-* \param aNewSize New size of the bucket vector.
+/*! \brief Resize the slot vector. 
+* \details The slots are placed into a new slot vector using their stored hash
+*          codes so no keys are hashed again and the items themselves do not
+*          move.
+* \param aNewSize New size of the slot vector which must be a power of two.
 */
 template<class Key, class Value>
 void HashMap<Key, Value>::resize( const size_t aNewSize ){
+    /*! \pre The new size is a power of two large enough for all items. */
+    assert( aNewSize > 1 && ( aNewSize & ( aNewSize - 1 ) ) == 0 );
+    assert( aNewSize > mItems.size() );
+
 	// Check if the new and old size are the same to avoid resizing.
 	if( aNewSize == mSize ){
 		return;
 	}
 
-	// Walk the hashmap and create a list of all items in the tree. Create a
-	// temporary vector to hold all the entries.
-	std::vector<boost::shared_ptr<Item> > temporaryList;
-
-	// Iterate over the buckets.
-	for( unsigned int i = 0; i < mSize; ++i ){
-		// Set a pointer to the first item in the bucket.
-		boost::shared_ptr<Item> curr = mBuckets[ i ];
-		// Add all items in the chain to the temporary list.
-		while( curr.get() ){
-			temporaryList.push_back( curr );
-			
-			/*! \invariant Ensure that no pointer refers to itself. */
-			assert( curr.get() != curr->mNext.get() );
-
-			// Move to the next item in the chain.
-			curr = curr->mNext;
-		}
-	}
-	// Check that the temporary list contains all entries.
-	assert( temporaryList.size() == mNumEntries );
+    std::vector<Slot> oldSlots( aNewSize );
+    oldSlots.swap( mSlots );
+    Slot emptySlot = { 0, EMPTY };
+    std::fill( mSlots.begin(), mSlots.end(), emptySlot );
+    mSize = aNewSize;
 
-	// Resize the bucket vector.
-	mSize = aNewSize;
-	// Clear the bucket vector before resizing so all pointers are null, not
-	// pointing at old values.
-	mBuckets.clear();
-	mBuckets.resize( mSize );
+    // Calculate the shift which selects the top bits of a mixed hash code.
+    size_t sizeBits = 0;
+    while( ( static_cast<size_t>( 1 ) << sizeBits ) < mSize ){
+        ++sizeBits;
+    }
+    mShift = sizeof( size_t ) * 8 - sizeBits;
 
 #if( TUNING_STATS )
 	// Reset the collision count.
 	mNumCollisions = 0;
 #endif
-	// Now add each item back to the list. Can't use the add function as we
-	// already have allocated items and we don't want to change the count of the
-	// number of entries.
-	for( unsigned int i = 0; i < temporaryList.size(); ++i ){
-		/*! \invariant Every position in the temporary list has a valid pointer. */
-		assert( temporaryList[ i ].get() );
-		
-		/*! \invariant There is a second reference to the item pointed to by the
-        *              next pointer. 
-        */
-		assert( !temporaryList[ i ]->mNext.unique() );
-		
-		// Clear out the next pointer as it is no longer valid. The temporary
-		// list is holding a reference to all items in the list, so this cannot
-        // cause a deallocation.
-		temporaryList[ i ]->mNext.reset();
-
-		// Add a single item to the map. Find the hash value and use the mod
-        // function to reduce it to within the size of the bucket vector.
-		const size_t bucketSpot = mHashFunction( temporaryList[ i ]->mKeyValuePair.first ) % mSize;
-
-		// We now know which bucket the key resides in if it exists.
-		Item* curr = mBuckets[ bucketSpot ].get();
-
-		// If the spot is null, add this item as the head of the bucket's chain.
-		if( !curr ){
-			mBuckets[ bucketSpot ] = temporaryList[ i ];
-		}
-		// Otherwise we need to search for the end of the current bucket's
-        // chain.
-		else {
-			while( curr->mNext.get() ){
-				/*! \invariant Ensure that no pointer refers to itself. */
-				assert( curr != curr->mNext.get() );
-				
-				curr = curr->mNext.get();
-			}
-			// Curr now points to the last item in the chain, add the current
-			// item as the end of the chain.
-			/*! \invariant Ensure that no pointer refers to itself. */
-			assert( curr != temporaryList[ i ].get() );
-
-			curr->mNext = temporaryList[ i ];
-#if( TUNING_STATS )
-			// Record the collision.
-			++mNumCollisions;
-#endif
-		}
-	}
+    for( size_t i = 0; i < oldSlots.size(); ++i ){
+        if( oldSlots[ i ].mPosition != EMPTY ){
+            placeSlot( oldSlots[ i ] );
+        }
+    }
 }
 
-/*! \brief Find the first item in the hashmap.
-* \details This function is used to initialize the constant begin iterator. It
-*          returns a pair containing a constant pointer to the first item and
-*          the position of the item in the bucket vector.
-* \return A pair containing a constant pointer to the first item and its
-*         position in the bucket vector. If the vector is empty this will return
-*         a pair containing null and zero.
+/*! \brief Find the position of the item with the given key.
+* \details The search starts at the preferred slot of the hash code and checks
+*          each slot in turn. Since slots are kept in Robin Hood order the
+*          search can stop as soon as it finds a slot which is closer to its own
+*          preferred slot than the key would be.
+* \param aKey The key to search for.
+* \param aHashCode The hash code of the key.
+* \return The position of the item in mItems or EMPTY if it was not found.
 */
 template<class Key, class Value>
-typename HashMap<Key, Value>::CItemPair
-HashMap<Key, Value>::getFirstItem() const {
-    // Check for empty hashmap first to avoid a slow unsuccessful search.
-    if( empty() ){
-        return CItemPair( static_cast<Item*>( 0 ), 0 );
-    }
-
-    // Search starting at the beginning of the bucket vector to find the first
-    // item.
-    for( unsigned int i = 0; i < mBuckets.size(); i++ ){
-        if( mBuckets[ i ] ){
-            return CItemPair( mBuckets[ i ].get() , i );
+size_t HashMap<Key, Value>::findPosition( const Key& aKey, const size_t aHashCode ) const {
+    const size_t mask = mSize - 1;
+    size_t slot = getPreferredSlot( aHashCode );
+    for( size_t distance = 0; ; ++distance ){
+        const Slot& curr = mSlots[ slot ];
+        if( curr.mPosition == EMPTY ||
+            ( ( slot - getPreferredSlot( curr.mHashCode ) ) & mask ) < distance )
+        {
+            return EMPTY;
         }
+        if( curr.mHashCode == aHashCode && mItems[ curr.mPosition ].first == aKey ){
+            return curr.mPosition;
+        }
+        slot = ( slot + 1 ) & mask;
     }
-
-    /*! \post An item must have been found because this function initially
-    *         checks for an empty list. 
-    */
-    assert( false );
-    
-    // Make the compiler happy.
-    return CItemPair( static_cast<Item*>( 0 ), 0 );
 }
 
-/*! \brief Return the next item in the hashmap.
-* \details This function is used by the iterator to find the next value in the
-*          hashmap.
-* \param aItemPair A pair containing the current item and its bucket position.
-* \return A pair containing the next item and its bucket position or the end
-*         iterator if it was the last item.
+/*! \brief Get the preferred slot for a hash code.
+* \details The hash code is mixed with a multiplicative hash and the top bits
+*          selected so that hash functions which do not distribute well in the
+*          low bits still spread over the slots.
+* \param aHashCode The hash code.
+* \return The index of the preferred slot.
 */
 template<class Key, class Value>
-typename HashMap<Key, Value>::CItemPair
-HashMap<Key, Value>::getNextItem( const CItemPair& aItemPair ) const {
-    // First check if there is a next item in the current item's chain.
-    if( aItemPair.first->mNext ){
-        // Return a pair containing the next item and the current bucket spot
-        // since the item is in the same chain.
-        return CItemPair( aItemPair.first->mNext.get(), aItemPair.second );
-    }
-
-    // Otherwise search forward in the bucket vector starting at the current position.
-    for( size_t i = aItemPair.second + 1; i < mBuckets.size(); ++i ){
-        // If there is an item at this bucket position return it.
-        if( mBuckets[ i ] ){
-            return CItemPair( mBuckets[ i ].get(), i );
-        }
-    }
-
-    // The end of the bucket vector was reached so there is not a next item.
-    return CItemPair( static_cast<Item*>( 0 ), 0 );
+size_t HashMap<Key, Value>::getPreferredSlot( const size_t aHashCode ) const {
+    const size_t MULTIPLIER = static_cast<size_t>( 0x9E3779B97F4A7C15ULL );
+    return ( aHashCode * MULTIPLIER ) >> mShift;
 }
 
-/*! \brief Find the first item in the hashmap.
-* \details This function is used to initialize the begin iterator. It returns a
-*          pair containing a pointer to the first item and the position of the
-*          item in the bucket vector.
-* \return A pair containing a pointer to the first item and its position in the
-*         bucket vector. If the vector is empty this will return a pair
-*         containing null and zero.
+/*! \brief Place a slot in the slot vector in Robin Hood order.
+* \details Starting at the preferred slot, the slot being placed takes the
+*          place of the first slot which is closer to its own preferred slot,
+*          which is then placed further along in the same way until an empty
+*          slot is reached.
+* \param aSlot The slot to place which must not already be in the vector.
 */
 template<class Key, class Value>
-typename HashMap<Key, Value>::ItemPair HashMap<Key, Value>::getFirstItem() {
-    // Check for empty hashmap first to avoid a slow unsuccessful search.
-    if( empty() ){
-        return ItemPair( static_cast<Item*>( 0 ), 0 );
+void HashMap<Key, Value>::placeSlot( Slot aSlot ){
+    const size_t mask = mSize - 1;
+    size_t slot = getPreferredSlot( aSlot.mHashCode );
+#if( TUNING_STATS )
+    if( mSlots[ slot ].mPosition != EMPTY ){
+        // Record the collision.
+        ++mNumCollisions;
     }
-
-    // Search starting at the beginning of the bucket vector to find the first
-    // item.
-    for( unsigned int i = 0; i < mBuckets.size(); i++ ){
-        if( mBuckets[ i ] ){
-            return ItemPair( mBuckets[ i ].get(), i );
+#endif
+    for( size_t distance = 0; ; ++distance ){
+        Slot& curr = mSlots[ slot ];
+        if( curr.mPosition == EMPTY ){
+            curr = aSlot;
+            return;
+        }
+        const size_t currDistance = ( slot - getPreferredSlot( curr.mHashCode ) ) & mask;
+        if( currDistance < distance ){
+            std::swap( curr, aSlot );
+            distance = currDistance;
         }
+        slot = ( slot + 1 ) & mask;
     }
-
-    /*! \post An item must have been found because this function initially
-    *         checks for an empty list. 
-    */
-    assert( false );
-    
-    // Make the compiler happy.
-    return ItemPair( static_cast<Item*>( 0 ), 0 );
 }
 
 /*! \brief Return the next item in the hashmap.
 * \details This function is used by the iterator to find the next value in the
 *          hashmap.
-* \param aItemPair A pair containing the current item and its bucket position.
-* \return A pair containing the next item and its bucket position or the end
-*         iterator if it was the last item.
+* \param aPosition The position of the current item.
+* \return The next item or null if it was the last item.
 */
 template<class Key, class Value>
-typename HashMap<Key, Value>::ItemPair
-HashMap<Key, Value>::getNextItem( const ItemPair& aItemPair ) {
-    // First check if there is a next item in the current item's chain.
-    if( aItemPair.first->mNext ){
-        // Return a pair containing the next item and the current bucket spot
-        // since the item is in the same chain.
-        return ItemPair( aItemPair.first->mNext, aItemPair.second );
-    }
-
-    // Otherwise search forward in the bucket vector starting at the current position.
-    for( size_t i = aItemPair.second + 1; i < mBuckets.size(); ++i ){
-        // If there is an item at this bucket position return it.
-        if( mBuckets[ i ] ){
-            return ItemPair( mBuckets[ i ], i );
-        }
-    }
-
-    // The end of the bucket vector was reached so there is not a next item.
-    return end();
-}
-
-// ItemPair getNextItem( const ItemPair& aItemPair );
-/*! \brief Item structure constructor.
-* \param aKey The key.
-* \param aValue The value.
-*/
-template<class Key, class Value>
-HashMap<Key, Value>::Item::Item( const std::pair<Key, Value>& aKeyValuePair ):
-mKeyValuePair( aKeyValuePair ){
+const typename HashMap<Key, Value>::Item*
+HashMap<Key, Value>::getNextItem( const size_t aPosition ) const {
+    return aPosition + 1 < mItems.size() ? &mItems[ aPosition + 1 ] : 0;
 }
 
 /*! \brief iterator constructor which sets the internal pointer to null.
@@ -727,19 +590,18 @@ HashMap<Key, Value>::iterator::iterator(){}
 
 /*! \brief iterator constructor.
 * \param aCurrentItem The current Item.
-* \param aBucketPosition The position of the Item in the bucket vector.
+* \param aPosition The position of the Item in insertion order.
 * \param aParent A pointer to the parent hashmap.
 */
 template<class Key, class Value>
 HashMap<Key, Value>::iterator::iterator( Item* aCurrentItem,
-                                         const size_t aBucketPosition,
+                                         const size_t aPosition,
                                          const HashMap* aParent ):
-const_iterator( aCurrentItem, aBucketPosition, aParent ){
+const_iterator( aCurrentItem, aPosition, aParent ){
 }
 
 /*! \brief Equals operator
-* \param aKey The key.
-* \param aValue The value.
+* \param aOther The iterator to compare with.
 */
 template<class Key, class Value>
 bool HashMap<Key, Value>::iterator::operator ==( const typename HashMap<Key, Value>::iterator& aOther ) const {
@@ -747,8 +609,7 @@ bool HashMap<Key, Value>::iterator::operator ==( const typename HashMap<Key, Val
 }
 
 /*! \brief Not-equals operator
-* \param aKey The key.
-* \param aValue The value.
+* \param aOther The iterator to compare with.
 */
 template<class Key, class Value>
 bool HashMap<Key, Value>::iterator::operator !=( const typename HashMap<Key, Value>::iterator& aOther ) const {
@@ -761,11 +622,11 @@ bool HashMap<Key, Value>::iterator::operator !=( const typename HashMap<Key, Val
 template<class Key, class Value>
 std::pair<Key, Value>* HashMap<Key, Value>::iterator::operator->(){
 	/*! \pre The current item pointer must be non-null. */
-	assert( const_iterator::mCurrentItem.first != 0 );
+	assert( const_iterator::mCurrentItem != 0 );
 
     // The mCurrentItem is inherited from const_iterator and must be cast so
     // that the return value is mutable.
-	return const_cast<std::pair<Key, Value>*>( &const_iterator::mCurrentItem.first->mKeyValuePair );
+	return const_cast<std::pair<Key, Value>*>( const_iterator::mCurrentItem );
 }
 
 /*! \brief Dereference operator
@@ -774,11 +635,11 @@ std::pair<Key, Value>* HashMap<Key, Value>::iterator::operator->(){
 template<class Key, class Value>
 std::pair<Key, Value>& HashMap<Key, Value>::iterator::operator*() {
 	/*! \pre The current item pointer must be non-null. */
-	assert( const_iterator::mCurrentItem.first != 0 );
+	assert( const_iterator::mCurrentItem != 0 );
 
     // The mCurrentItem is inherited from const_iterator and must be cast so
     // that the return value is mutable.
-	return const_cast<std::pair<Key, Value>&>( const_iterator::mCurrentItem.first->mKeyValuePair );
+	return const_cast<std::pair<Key, Value>&>( *const_iterator::mCurrentItem );
 }
 
 /*! \brief Prefix increment operator.
@@ -787,10 +648,7 @@ std::pair<Key, Value>& HashMap<Key, Value>::iterator::operator*() {
 template<class Key, class Value>
 typename HashMap<Key, Value>::iterator&
 HashMap<Key, Value>::iterator::operator++(){
-    /*! \pre Need a non-null parent hashmap. */
-    assert( const_iterator::mParent );
-
-    const_iterator::mCurrentItem = const_iterator::mParent->getNextItem( const_iterator::mCurrentItem );
+    const_iterator::operator++();
     return *this;
 }
 
@@ -809,25 +667,26 @@ HashMap<Key, Value>::iterator::operator++ (int){
 */
 template<class Key, class Value>
 HashMap<Key, Value>::const_iterator::const_iterator():
-mCurrentItem( 0, 0 ),
+mCurrentItem( 0 ),
+mPosition( 0 ),
 mParent( 0 ){}
 
 /*! \brief const_iterator constructor.
 * \param aCurrentItem The current Item.
-* \param aBucketPosition The position of the current Item within the bucket
-*        vector.
+* \param aPosition The position of the current Item in insertion order.
+* \param aParent A pointer to the parent hashmap.
 */
 template<class Key, class Value>
 HashMap<Key, Value>::const_iterator::const_iterator( const Item* aCurrentItem,
-                                                     const size_t aBucketPosition,
+                                                     const size_t aPosition,
                                                      const HashMap* aParent )
-:mCurrentItem( aCurrentItem, aBucketPosition ),
+:mCurrentItem( aCurrentItem ),
+mPosition( aPosition ),
 mParent( aParent ){
 }
 
 /*! \brief Equals operator
-* \param aKey The key.
-* \param aValue The value.
+* \param aOther The iterator to compare with.
 */
 template<class Key, class Value>
 bool HashMap<Key, Value>::const_iterator::operator ==( const typename HashMap<Key, Value>::const_iterator& aOther ) const {
@@ -835,8 +694,7 @@ bool HashMap<Key, Value>::const_iterator::operator ==( const typename HashMap<Ke
 }
 
 /*! \brief Not-equals operator
-* \param aKey The key.
-* \param aValue The value.
+* \param aOther The iterator to compare with.
 */
 template<class Key, class Value>
 bool HashMap<Key, Value>::const_iterator::operator !=( const typename HashMap<Key, Value>::const_iterator& aOther ) const {
@@ -849,8 +707,8 @@ bool HashMap<Key, Value>::const_iterator::operator !=( const typename HashMap<Ke
 template<class Key, class Value>
 const std::pair<Key, Value>* HashMap<Key, Value>::const_iterator::operator->() const {
 	/*! \pre The current item pointer must be non-null. */
-	assert( mCurrentItem.first != 0 );
-	return &mCurrentItem.first->mKeyValuePair;
+	assert( mCurrentItem != 0 );
+	return mCurrentItem;
 }
 
 /*! \brief Prefix increment operator.
@@ -862,7 +720,8 @@ HashMap<Key, Value>::const_iterator::operator++(){
     /*! \pre Need a non-null parent hashmap. */
     assert( mParent );
 
-    mCurrentItem = mParent->getNextItem( mCurrentItem );
+    mCurrentItem = mParent->getNextItem( mPosition );
+    ++mPosition;
     return *this;
 }
 
@@ -883,8 +742,8 @@ HashMap<Key, Value>::const_iterator::operator++ (int){
 template<class Key, class Value>
 const std::pair<Key, Value>& HashMap<Key, Value>::const_iterator::operator*() const {
 	/*! \pre The current item pointer must be non-null. */
-	assert( mCurrentItem.first != 0 );
-	return mCurrentItem.first->mKeyValuePair;
+	assert( mCurrentItem != 0 );
+	return *mCurrentItem;
 }
 
 #endif // _HASH_MAP_H_
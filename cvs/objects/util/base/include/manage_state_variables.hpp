@@ -46,12 +46,18 @@
 #include <cassert>
 #include <forward_list>
 #include <string>
+#include <vector>
 #include "util/base/include/definitions.h"
 
 class Value;
+class DirtyStateBlocks;
+class ITechnology;
+class Market;
 
 #if GCAM_PARALLEL_ENABLED
+#include <thread>
 #include <tbb/task_arena.h>
+#include <tbb/spin_mutex.h>
 #endif
 
 /*!
@@ -70,14 +76,27 @@ class Value;
  * \author Pralit Patel
  */
 class ManageStateVariables {
+#if GCAM_PARALLEL_ENABLED
+    friend struct AssignThreadStateFun;
+#endif
 public:
     ManageStateVariables( const int aPeriod );
     ~ManageStateVariables();
     
+    void beginPeriod( const int aPeriod );
+    
+    void endPeriod();
+    
     void copyState();
     
+    void acceptState();
+    
     void setPartialDeriv( const bool aIsPartialDeriv );
     
+    void startLayoutRecording();
+    
+    void finishLayoutRecording();
+    
 #if GCAM_PARALLEL_ENABLED
     //! A tbb task arena which is the closest tbb comes to a thread pool which we
     //! will insist parallel calculations use so that we can ensure that we have
@@ -97,6 +116,48 @@ private:
     //! running the code.
     double** mStateData;
     
+#if GCAM_SPARSE_SCRATCH
+    //! The block tables for each state slot, the first of which always refers
+    //! to the "base" state.  When a thread writes to a block of its "scratch"
+    //! state the block is copied into mStateData for that slot.
+    double*** mBlockTables;
+#endif
+    
+#if GCAM_PARALLEL_ENABLED
+    //! The thread which last used each state slot.  Threads are given back the
+    //! same slot so that the memory, which is allocated and first written by
+    //! that thread, stays local to it.
+    std::vector<std::thread::id> mSlotOwner;
+    
+    //! Flags for the state slots that have been handed out to a thread since
+    //! the last call to setPartialDeriv( true ).
+    std::vector<char> mSlotInUse;
+    
+    //! Guards mSlotOwner and mSlotInUse.
+    tbb::spin_mutex mSlotMutex;
+#endif
+    
+    //! Tracks the writes made into each "scratch" state in mStateData so that
+    //! copyState only needs to reset what was actually changed by the last
+    //! partial derivative.  The entry for the "base" state is unused.
+    DirtyStateBlocks* mDirtyBlocks;
+    
+    //! Records the order in which each "base" state value is first written while
+    //! layout recording is active, otherwise null.
+    DirtyStateBlocks* mLayoutRecorder;
+    
+    //! The index each Value was given in collection order mapped to the index it
+    //! currently has in mStateData.  Empty if the state has not been re-laid out.
+    std::vector<unsigned int> mLayout;
+    
+    //! The number of values each array in mStateData has room for.  The arrays
+    //! are kept across periods and only reallocated when they need to grow.
+    size_t mStateCapacity;
+    
+    //! Whether state is currently collected for a period, i.e. between
+    //! beginPeriod and endPeriod.
+    bool mIsPeriodActive;
+    
     //! The period this state was collected for.
     int mPeriodToCollect;
     
@@ -112,10 +173,41 @@ private:
     //! be changed during World.calc( mPeriodToCollect ).
     size_t mNumCollected;
     
+    /*!
+     * \brief All data flagged as STATE found by searching the model with GCAMFusion
+     *        along with the Technology or Market that determines if it is active.
+     * \details Searching is a relatively expensive operation so when the
+     *          reuse-state-collection flag is set the results are kept in
+     *          mCollection and reused for each period of a run.
+     */
+    struct CollectedState {
+        //! The type of container mData refers to.
+        enum ContainerType {
+            SINGLE,
+            PERIOD_VECTOR,
+            TECH_VINTAGE_VECTOR,
+            YEAR_VECTOR
+        } mType;
+        
+        //! The STATE data, which is a Value or vector of Values depending on mType.
+        void* mData;
+        
+        //! The Technology containing this data or null if none, the data is only
+        //! active in periods the Technology is operating.
+        const ITechnology* mTechnology;
+        
+        //! The Market containing this data or null if none, the data is only
+        //! active in the year of the Market.
+        const Market* mMarket;
+    };
+    
+    //! Every container of data flagged as STATE in the model in the order
+    //! GCAMFusion found them, active or not.
+    std::vector<CollectedState> mCollection;
+    
     //! The list of individual Values flagged as STATE that could possibly be
     //! changed during World.calc( mPeriodToCollect ).  We store them in a list
-    //! since searching via GCAMFusion is a relatively expensive operation and we
-    //! will need to take three passes at them:
+    //! since we will need to take three passes at them:
     //! - Figure out how many we have so what we can allocate enough memory for mStateData.
     //! - Copy the actual data from each Value to initialize the "base" state.
     //! - When we are done with this period copy the "base" state back into each Value.
@@ -123,8 +215,26 @@ private:
     
     void collectState();
     
+    void searchForState();
+    
     void resetState();
     
+    void restoreScratch( const size_t aStateInd );
+    
+    size_t getThreadSlot() const;
+    
+#if GCAM_PARALLEL_ENABLED
+    size_t assignThreadSlot();
+#endif
+    
+#if GCAM_SPARSE_SCRATCH
+    void resetBlockTable( const size_t aStateInd );
+#endif
+    
+    void initDirtyBlocks( DirtyStateBlocks& aDirty, const unsigned int aBlockShift ) const;
+    
+    void logCacheLineTouches() const;
+    
     std::string getRestartFileName() const;
     
     void loadRestartFile();
@@ -136,19 +246,23 @@ private:
      *        for data flagged STATE.
      * \details In addition to handling the processData call back we also are
      *          interested in the push/pop filter steps, particularly for Technology
-     *          and MarketContainer to avoid collecting Data in a Technology or
-     *          Market that is going to be inactive during mPeriodToCollect.
+     *          and MarketContainer so that we can later skip Data in a Technology
+     *          or Market that is going to be inactive during mPeriodToCollect.
      */
     struct DoCollect {
         //! A reference to the containing class where each collected state data
         //! will be added.
         ManageStateVariables* mParentClass;
         
-        //! A state variable while processing GCAMFusion which when set indicates
-        //! we are in a Technology or MarketContainer that is inactive in the
-        //! current period.  This flag gets reset when the corresponding popFilterStep
-        //! is found.
-        bool mIgnoreCurrValue = false;
+        //! The Technology we are currently searching in, if any.  This gets reset
+        //! when the corresponding popFilterStep is found.
+        const ITechnology* mCurrTechnology = 0;
+        
+        //! The Market we are currently searching in, if any.  This gets reset
+        //! when the corresponding popFilterStep is found.
+        const Market* mCurrMarket = 0;
+        
+        void addState( const CollectedState::ContainerType aType, void* aData );
         
         // Templated callbacks for GCAMFusion
         template<typename DataType>
@@ -46,12 +46,94 @@
 */
 // Should only include these in debug.
 #include <cassert>
+#include <cstring>
+#include <vector>
 #include "util/base/include/util.h"
 
 #if GCAM_PARALLEL_ENABLED
 #include <tbb/enumerable_thread_specific.h>
 #endif
 
+/*!
+ * \brief Tracks which blocks of a "scratch" state array in ManageStateVariables
+ *        have been written since it was last reset to the "base" state.
+ * \details Partial derivatives only recalculate a small part of the model, so
+ *          only a small part of the scratch state needs to be put back before
+ *          the next one.  Writes are tracked by blocks of 2^mBlockShift values
+ *          so that restoring remains a handful of memcpys.  A block shift of
+ *          zero records each individual value in the order it was first written
+ *          which ManageStateVariables uses to re-layout the state.
+ *
+ *          When GCAM_SPARSE_SCRATCH is enabled a "scratch" state is not a full
+ *          copy but a table of pointers to blocks which initially point into the
+ *          "base" state.  The first write to a block copies it into mBlockPool
+ *          and redirects the table to the copy.
+ */
+class DirtyStateBlocks {
+public:
+    //! The default log2 of the number of state values in a block.
+    static const unsigned int BLOCK_SHIFT = 6;
+    //! The mask to get the offset of a state value in a block of the default size.
+    static const unsigned int BLOCK_MASK = ( 1 << BLOCK_SHIFT ) - 1;
+    //! The log2 of the number of state values that fit in a cache line.
+    static const unsigned int CACHE_LINE_SHIFT = 3;
+
+    void markIndex( const unsigned int aIndex );
+#if GCAM_SPARSE_SCRATCH
+    void copyOnWrite( const unsigned int aBlock );
+#endif
+
+    //! The log2 of the number of state values in a block.
+    unsigned int mBlockShift;
+    //! One flag per block, set if the block is in mDirtyBlocks.
+    std::vector<unsigned char> mIsDirty;
+    //! The blocks that have been written, in the order they were first written.
+    std::vector<unsigned int> mDirtyBlocks;
+    //! Set when the whole array must be reset regardless of mDirtyBlocks.
+    bool mAllDirty;
+    //! The number of times the tracked writes have been reset.
+    unsigned long mNumResets;
+    //! The total number of cache lines spanned by the tracked writes over all resets.
+    unsigned long mNumLinesTouched;
+#if GCAM_SPARSE_SCRATCH
+    //! The block table of the tracked "scratch" state or null if the state is
+    //! a full copy.
+    double** mBlockTable;
+    //! Storage for the blocks which have been copied on write, indexed in the
+    //! same order as mDirtyBlocks.
+    double* mBlockPool;
+    //! The "base" state blocks get copied from.
+    const double* mBase;
+    //! The total number of state values.
+    size_t mNumValues;
+#endif
+};
+
+//! Flag the block containing the state value at the given index as written to.
+inline void DirtyStateBlocks::markIndex( const unsigned int aIndex ) {
+    const unsigned int block = aIndex >> mBlockShift;
+    if( !mIsDirty[ block ] ) {
+        mIsDirty[ block ] = 1;
+#if GCAM_SPARSE_SCRATCH
+        if( mBlockTable ) {
+            copyOnWrite( block );
+        }
+#endif
+        mDirtyBlocks.push_back( block );
+    }
+}
+
+#if GCAM_SPARSE_SCRATCH
+//! Give a block that is about to be written its own copy of the "base" data.
+inline void DirtyStateBlocks::copyOnWrite( const unsigned int aBlock ) {
+    const size_t start = size_t( aBlock ) << mBlockShift;
+    const size_t count = std::min( size_t( 1 ) << mBlockShift, mNumValues - start );
+    double* copy = mBlockPool + ( mDirtyBlocks.size() << mBlockShift );
+    std::memcpy( copy, mBase + start, sizeof( double ) * count );
+    mBlockTable[ aBlock ] = copy;
+}
+#endif
+
 /*! 
  * \ingroup Objects
  * \brief A class containing a single value in the model.
@@ -69,6 +151,7 @@
 
 class Value {
     friend class ManageStateVariables;
+    friend struct AssignThreadStateFun;
     /*!
      * \brief Output stream operator to print a Value.
      * \details Output stream operators allow classes to be printed using the <<
@@ -125,11 +208,29 @@ private:
 #if !GCAM_PARALLEL_ENABLED
     typedef double* CentralValueType;
 #else
+    /*!
+     * \brief The state slot assigned to a worker thread along with the write
+     *        tracking for it.
+     * \details These are kept together so that a write only needs a single thread
+     *          local storage lookup.
+     */
+    struct CentralState {
+#if !GCAM_SPARSE_SCRATCH
+        //! The state array.
+        double* mValues;
+#else
+        //! The table of blocks of state, see DirtyStateBlocks.
+        double** mValues;
+#endif
+        //! The write tracking for mValues, or null if writes do not need to be
+        //! tracked (i.e. the "base" state).
+        DirtyStateBlocks* mDirty;
+    };
     // When GCAM_PARALLEL_ENABLED each worker thread will have it's own slot of
     // state assigned to it.  Note it is important that we use tbb::ets_key_per_instance
     // which as it uses up a finite resource certainly qualifies as a performance
     // critical use.
-    typedef tbb::enumerable_thread_specific<double*, tbb::cache_aligned_allocator<double*>, tbb::ets_key_per_instance> CentralValueType;
+    typedef tbb::enumerable_thread_specific<CentralState, tbb::cache_aligned_allocator<CentralState>, tbb::ets_key_per_instance> CentralValueType;
 #endif
     //! A static reference into ManageStateVariables::mStateData only used if mIsStateCopy
     //! is true.  Note we make this field static so that we can quickly swap state
@@ -138,6 +239,11 @@ private:
     //! A static reference into the "base" state of ManageStateVariables::mStateData
     //! mostly for convenience.
     static double* sBaseCentralValue;
+#if !GCAM_PARALLEL_ENABLED
+    //! The write tracking for the state array sCentralValue currently refers to,
+    //! or null if writes do not need to be tracked (i.e. the "base" state).
+    static DirtyStateBlocks* sCentralDirty;
+#endif
     //! The index into sCentralValue that contains the data for this instance.
     unsigned int mCentralValueIndex;
     //! A flag to indicate if this instance of Value has been identified as active
@@ -180,17 +286,32 @@ inline void Value::init( const double aNewValue ){
 /*!
  * \brief An accessor method to get at the actual data held in this class.
  * \details This method will appropriately get the value locally or the centrally
- *          managed state if the mIsStateCopy flag is set.
+ *          managed state if the mIsStateCopy flag is set.  Only the mutating
+ *          operations use this non-const version so it also records the write
+ *          when working in a "scratch" state.
  * \return A reference the the appropriate value represented by this class.
  */
 inline double& Value::getInternal() {
-    return mIsStateCopy ?
+    if( !mIsStateCopy ) {
+        return mValue;
+    }
 #if !GCAM_PARALLEL_ENABLED
-        sCentralValue[mCentralValueIndex]
+    if( sCentralDirty ) {
+        sCentralDirty->markIndex( mCentralValueIndex );
+    }
+    return sCentralValue[mCentralValueIndex];
 #else
-        sCentralValue.local()[mCentralValueIndex]
+    CentralState& central = sCentralValue.local();
+    if( central.mDirty ) {
+        central.mDirty->markIndex( mCentralValueIndex );
+    }
+#if !GCAM_SPARSE_SCRATCH
+    return central.mValues[mCentralValueIndex];
+#else
+    return central.mValues[ mCentralValueIndex >> DirtyStateBlocks::BLOCK_SHIFT ]
+        [ mCentralValueIndex & DirtyStateBlocks::BLOCK_MASK ];
+#endif
 #endif
-        : mValue;
 }
 
 /*!
@@ -203,8 +324,11 @@ inline const double& Value::getInternal() const {
     return mIsStateCopy ?
 #if !GCAM_PARALLEL_ENABLED
         sCentralValue[mCentralValueIndex]
+#elif !GCAM_SPARSE_SCRATCH
+        sCentralValue.local().mValues[mCentralValueIndex]
 #else
-        sCentralValue.local()[mCentralValueIndex]
+        sCentralValue.local().mValues[ mCentralValueIndex >> DirtyStateBlocks::BLOCK_SHIFT ]
+            [ mCentralValueIndex & DirtyStateBlocks::BLOCK_MASK ]
 #endif
         : mValue;
 }
@@ -103,6 +103,8 @@
 #include "util/base/include/iparsable.h"
 #include "util/base/include/time_vector.h"
 #include "util/base/include/value.h"
+#include "util/base/include/xml_snapshot.h"
+#include "util/base/include/xml_stream_parser.h"
 
 /*!
  * \ingroup Objects
@@ -191,7 +193,7 @@ public:
                                        const Modeltime* aModeltime );
 
    static int getNodePeriod ( const xercesc::DOMNode* node, const Modeltime* modeltime );
-   static bool parseXML( const std::string& aXMLFile, IParsable* aModelElement );
+   static bool parseXML( const std::string& aXMLFile, IParsable* aModelElement, const int aStreamDepth = 0 );
    static const std::string& text();
    static const std::string& name();
    static void cleanupParser();
@@ -199,12 +201,13 @@ public:
    static void serializeNode( const xercesc::DOMNode* aNode, std::ostream& aOut, Tabs* aTabs,
                               const bool aDeep );
    static xercesc::DOMDocument* getDOMDocument();
+   static xercesc::XercesDOMParser* getParser();
+   static void configureParser( xercesc::XercesDOMParser* aParser );
 private:
     static xercesc::XercesDOMParser** getParserPointerInternal();
     static xercesc::ErrorHandler** getErrorHandlerPointerInternal();
     static xercesc::DOMDocument** getDOMDocumentInternal();
     static void initParser();
-    static xercesc::XercesDOMParser* getParser();
 };
 
 /*!
@@ -1030,39 +1033,60 @@ void XMLWriteVector( const objects::PeriodVector<T>& aOutputVector,
 * \brief Function to parse an XML file, returning a pointer to the root.
 *
 * This is a very simple function which calls the parse function and handles the exceptions which it may throw.
-* It also takes care of fetching the document and its root element.
+* It also takes care of fetching the document and its root element. If XML snapshots are enabled the document
+* is rebuilt from an up to date snapshot instead of parsing the file, otherwise a snapshot is saved after parsing.
+* If a stream depth is given the file is instead streamed and passed to aModelElement in chunks.
+* \sa XMLSnapshot
+* \sa XMLStreamParser
 * \param aXMLFile The name of the file to parse.
 * \param aModelElement Element to call XMLParse on.
+* \param aStreamDepth The depth of the elements to parse as separate chunks with a streaming
+*        parser, or zero to parse the whole document at once.
 * \return Whether parsing was successful.
 */
 
 template <class T>
-bool XMLHelper<T>::parseXML( const std::string& aXMLFile, IParsable* aModelElement ) {
+bool XMLHelper<T>::parseXML( const std::string& aXMLFile, IParsable* aModelElement, const int aStreamDepth ) {
     // Track the number of active parses to avoid destroying a document that causes other
     // documents to be parsed before its own parsing was complete.
     static unsigned int numParses = 0;
     ++numParses;
     xercesc::XercesDOMParser* parser = XMLHelper<T>::getParser();
-    try {
-        parser->parse( aXMLFile.c_str() );
-    } catch ( const xercesc::XMLException& toCatch ) {
-        std::string message = XMLHelper<std::string>::safeTranscode( toCatch.getMessage() );
-        std::cout << "ERROR: XML Read Exception message is:" << std::endl << message << std::endl;
-        return false;
-    } catch ( const xercesc::DOMException& toCatch ) {
-        std::string message = XMLHelper<std::string>::safeTranscode( toCatch.msg );
-        std::cout << "ERROR: XML Read Exception message is:" << std::endl << message << std::endl;
-        return false;
-    } catch ( const xercesc::SAXException& toCatch ){
-        std::string message = XMLHelper<std::string>::safeTranscode( toCatch.getMessage() );
-        std::cout << "ERROR: XML Read Exception message is:" << std::endl << message << std::endl;
-        return false;
-    } catch (...) {
-        std::cout << "ERROR:Unexpected XML Read Exception." << std::endl;
-        return false;
+    bool success;
+    xercesc::DOMDocument* snapshotDocument = 0;
+    if( aStreamDepth > 0 ) {
+        // Stream the file in chunks. Snapshots hold the whole document so
+        // they are not used when streaming.
+        success = XMLStreamParser::parseXML( aXMLFile, aModelElement, aStreamDepth );
+    }
+    // Rebuild the document from an up to date snapshot if one exists.
+    else if( ( snapshotDocument = XMLSnapshot::loadSnapshot( aXMLFile ) ) != 0 ) {
+        success = aModelElement->XMLParse( snapshotDocument->getDocumentElement() );
+        snapshotDocument->release();
     }
+    else {
+        try {
+            parser->parse( aXMLFile.c_str() );
+        } catch ( const xercesc::XMLException& toCatch ) {
+            std::string message = XMLHelper<std::string>::safeTranscode( toCatch.getMessage() );
+            std::cout << "ERROR: XML Read Exception message is:" << std::endl << message << std::endl;
+            return false;
+        } catch ( const xercesc::DOMException& toCatch ) {
+            std::string message = XMLHelper<std::string>::safeTranscode( toCatch.msg );
+            std::cout << "ERROR: XML Read Exception message is:" << std::endl << message << std::endl;
+            return false;
+        } catch ( const xercesc::SAXException& toCatch ){
+            std::string message = XMLHelper<std::string>::safeTranscode( toCatch.getMessage() );
+            std::cout << "ERROR: XML Read Exception message is:" << std::endl << message << std::endl;
+            return false;
+        } catch (...) {
+            std::cout << "ERROR:Unexpected XML Read Exception." << std::endl;
+            return false;
+        }
 
-    bool success = aModelElement->XMLParse( parser->getDocument()->getDocumentElement() );
+        XMLSnapshot::saveSnapshot( aXMLFile, parser->getDocument() );
+        success = aModelElement->XMLParse( parser->getDocument()->getDocumentElement() );
+    }
     // Cleanup parser memory if there are no active parses.
     if( --numParses == 0 ){
         parser->resetDocumentPool();
@@ -1089,11 +1113,7 @@ void XMLHelper<T>::initParser() {
 
     // Initialize the instances of the parser and error handler.
     *getParserPointerInternal() = new xercesc::XercesDOMParser();
-    (*getParserPointerInternal())->setValidationScheme( xercesc::XercesDOMParser::Val_Always );
-    (*getParserPointerInternal())->setDoNamespaces( false );
-    (*getParserPointerInternal())->setDoSchema( true );
-    (*getParserPointerInternal())->setCreateCommentNodes( false ); // No comment nodes
-    (*getParserPointerInternal())->setIncludeIgnorableWhitespace( false ); // No text nodes
+    configureParser( *getParserPointerInternal() );
 
     *getErrorHandlerPointerInternal() = ( (xercesc::ErrorHandler*)new xercesc::HandlerBase() );
     (*getParserPointerInternal())->setErrorHandler( *getErrorHandlerPointerInternal() );
@@ -1110,6 +1130,20 @@ void XMLHelper<T>::initParser() {
     });
 }
 
+/*! \brief Set the options used by all DOM parsers of model input files.
+* \details This is used by the parser created in initParser and by any other
+*          parsers, such as those used to read files concurrently.
+* \param aParser The parser to configure.
+*/
+template<class T>
+void XMLHelper<T>::configureParser( xercesc::XercesDOMParser* aParser ) {
+    aParser->setValidationScheme( xercesc::XercesDOMParser::Val_Always );
+    aParser->setDoNamespaces( false );
+    aParser->setDoSchema( true );
+    aParser->setCreateCommentNodes( false ); // No comment nodes
+    aParser->setIncludeIgnorableWhitespace( false ); // No text nodes
+}
+
 /*! \brief Return the text string.
 * \author Josh Lurz
 * \return The #text string.
@@ -0,0 +1,91 @@
+#ifndef _XML_SNAPSHOT_H_
+#define _XML_SNAPSHOT_H_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*! 
+* \file xml_snapshot.h  
+* \ingroup Objects
+* \brief Header file for the XMLSnapshot class.
+*/
+
+#include <string>
+
+namespace xercesc {
+    class DOMDocument;
+}
+
+/*!
+* \ingroup Objects
+* \brief Saves and loads binary snapshots of parsed XML input files.
+* \details Parsing and validating large input files with xerces takes a
+*          significant amount of the model start up time. After an input file
+*          has been parsed its DOM tree can be written to a compact binary
+*          snapshot which records the size, modification time and content hash
+*          of the original file. When the same file is parsed again and it has
+*          not changed, the snapshot is memory mapped and the DOM tree is
+*          rebuilt directly from it, skipping the scanning and schema validation
+*          done by the parser. The content hash is only computed again if the
+*          modification time changed. Only the DOM is cached, the model still
+*          reads each document with XMLParse.
+*          Element and attribute names are stored once in a name table and all
+*          strings are stored as null terminated XMLCh arrays so that they may
+*          be handed to the DOM straight from the mapped file.
+*
+*          Snapshots are enabled by setting the write flag of the file
+*          configuration value "xml-snapshot-dir", which names an existing
+*          directory to store them in. Snapshots are written in the native byte
+*          order and are only meant to be reused on the same machine, a snapshot
+*          written by a build with a different format version, xerces version
+*          or byte order is ignored.
+*/
+class XMLSnapshot {
+public:
+    static xercesc::DOMDocument* loadSnapshot( const std::string& aXMLFile );
+
+    static void saveSnapshot( const std::string& aXMLFile,
+                              const xercesc::DOMDocument* aDocument );
+private:
+    static bool isEnabled();
+
+    static std::string getSnapshotFileName( const std::string& aXMLFile );
+
+    static bool hashFile( const std::string& aFileName,
+                          unsigned long long& aHash,
+                          unsigned long long& aSize );
+};
+
+#endif // _XML_SNAPSHOT_H_
@@ -0,0 +1,82 @@
+#ifndef _XML_STREAM_PARSER_H_
+#define _XML_STREAM_PARSER_H_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*! 
+* \file xml_stream_parser.h  
+* \ingroup Objects
+* \brief Header file for the XMLStreamParser class.
+*/
+
+#include <string>
+
+class IParsable;
+
+/*!
+* \ingroup Objects
+* \brief Parses an XML file with a streaming SAX parser and hands it to an
+*        IParsable in small pieces.
+* \details Building the DOM tree for a whole input file can take several times
+*          the size of the file in memory. Instead, this parser streams the file
+*          and only builds a DOM tree for one element at the chunk depth at a
+*          time. Each chunk is wrapped in copies of its ancestor elements and
+*          passed to IParsable::XMLParse before it is released. Only the
+*          attributes which identify an ancestor (name, type and year) or
+*          which are safe to apply repeatedly (nocreate) are copied. An
+*          element above the chunk depth with delete set is passed on whole as
+*          a single chunk. Elements above the chunk depth which have no child
+*          elements are passed on the same way, together with their text.
+*          Peak memory then depends on the nesting depth and the size of the
+*          largest chunk rather than on the size of the file.
+*
+*          This relies on XMLParse merging repeated parses into the same
+*          objects, as it already does for add-on scenario components. Not
+*          every object does so, for instance those which replace a child
+*          object rather than parse into the existing one, so streaming must
+*          only be used at a chunk depth at and above which every element
+*          merges. A chunk depth should be chosen at which each element is a
+*          complete object, such as the sectors within a region of a scenario
+*          input file.
+*/
+class XMLStreamParser {
+public:
+    static bool parseXML( const std::string& aXMLFile,
+                          IParsable* aModelElement,
+                          const int aChunkDepth );
+};
+
+#endif // _XML_STREAM_PARSER_H_
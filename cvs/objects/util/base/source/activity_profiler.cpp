@@ -0,0 +1,190 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+
+/*! 
+* \file activity_profiler.cpp
+* \ingroup Objects
+* \brief ActivityProfiler class source file.
+*/
+
+#include "util/base/include/definitions.h"
+#include <chrono>
+#include "util/base/include/activity_profiler.h"
+#include "util/base/include/auto_file.h"
+#include "util/base/include/configuration.h"
+#include "containers/include/iactivity.h"
+
+using namespace std;
+
+//! Constructor
+ActivityProfiler::ActivityProfiler():mIsEnabled( false )
+{
+}
+
+//! Destructor
+ActivityProfiler::~ActivityProfiler() {
+}
+
+/*!
+ * \brief Get the singleton instance of the ActivityProfiler.
+ * \return The ActivityProfiler.
+ */
+ActivityProfiler& ActivityProfiler::getInstance() {
+    static ActivityProfiler ACTIVITY_PROFILER;
+    return ACTIVITY_PROFILER;
+}
+
+/*!
+ * \brief Set up the profiler for the activities in the global ordering and open
+ *        the output files if the profiler is enabled.
+ * \details Activities are reported by their region and their description
+ *          less the region name which region level activities start with.
+ * \param aGlobalOrdering The global calc ordering of all activities.
+ */
+void ActivityProfiler::init( const vector<IActivity*>& aGlobalOrdering ) {
+    const Configuration* conf = Configuration::getInstance();
+    mIsEnabled = conf->getBool( "profile-activities", false, false );
+    if( !mIsEnabled ) {
+        return;
+    }
+
+    mRegionNames.clear();
+    mActivityNames.clear();
+    for( size_t i = 0; i < aGlobalOrdering.size(); ++i ) {
+        const string regionName = aGlobalOrdering[ i ]->getRegionName();
+        const string description = aGlobalOrdering[ i ]->getDescription();
+        const string regionPrefix = regionName + " ";
+        mRegionNames.push_back( regionName.empty() ? "global" : regionName );
+        if( !regionName.empty() && description.compare( 0, regionPrefix.size(), regionPrefix ) == 0 ) {
+            mActivityNames.push_back( description.substr( regionPrefix.size() ) );
+        }
+        else {
+            mActivityNames.push_back( description );
+        }
+    }
+
+    mCSVFile.reset( new AutoOutputFile( conf->getFile( "activity-profile", "activity-profile.csv", false ) ) );
+    **mCSVFile << "year,region,activity,calc-type,count,seconds" << endl;
+    mStackFile.reset( new AutoOutputFile( conf->getFile( "activity-profile-stacks", "activity-profile.folded", false ) ) );
+}
+
+/*!
+ * \brief Calculate an activity recording the time it took if the profiler is
+ *        enabled.
+ * \details This may be called concurrently from different threads.
+ * \param aActivity The activity to calculate.
+ * \param aCalcOrder The position of the activity in the global ordering.
+ * \param aPeriod The model period to calculate.
+ * \param aIsFullCalc Whether the calc is of every activity rather than of a
+ *                    subset affected by a change in prices.
+ */
+void ActivityProfiler::calcActivity( IActivity* aActivity, const int aCalcOrder, const int aPeriod,
+                                     const bool aIsFullCalc )
+{
+    if( !mIsEnabled || aCalcOrder < 0 ) {
+        aActivity->calc( aPeriod );
+        return;
+    }
+
+    typedef chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    aActivity->calc( aPeriod );
+    const chrono::duration<double> elapsed = Clock::now() - start;
+
+    ActivityStats& stats = getLocalStats()[ 2 * aCalcOrder + ( aIsFullCalc ? 1 : 0 ) ];
+    stats.mTime += elapsed.count();
+    ++stats.mCount;
+}
+
+/*!
+ * \brief Combine the stats from all threads, write them out for the period
+ *        and reset them.
+ * \param aYear The year of the period which just finished.
+ */
+void ActivityProfiler::finishPeriod( const int aYear ) {
+    if( !mIsEnabled ) {
+        return;
+    }
+
+    vector<StatsVector*> threadStats;
+#if GCAM_PARALLEL_ENABLED
+    for( tbb::enumerable_thread_specific<StatsVector>::iterator it = mThreadStats.begin();
+         it != mThreadStats.end(); ++it )
+    {
+        threadStats.push_back( &*it );
+    }
+#else
+    threadStats.push_back( &mStats );
+#endif
+
+    StatsVector totals( 2 * mActivityNames.size() );
+    for( vector<StatsVector*>::const_iterator it = threadStats.begin(); it != threadStats.end(); ++it ) {
+        StatsVector& stats = **it;
+        for( size_t i = 0; i < stats.size() && i < totals.size(); ++i ) {
+            totals[ i ].mTime += stats[ i ].mTime;
+            totals[ i ].mCount += stats[ i ].mCount;
+            stats[ i ] = ActivityStats();
+        }
+    }
+
+    for( size_t i = 0; i < totals.size(); ++i ) {
+        if( totals[ i ].mCount == 0 ) {
+            continue;
+        }
+        const size_t activity = i / 2;
+        const string calcType = i % 2 == 1 ? "full" : "partial";
+        **mCSVFile << aYear << ',' << mRegionNames[ activity ] << ',' << mActivityNames[ activity ]
+                   << ',' << calcType << ',' << totals[ i ].mCount << ',' << totals[ i ].mTime << endl;
+        // Flame graph tools expect integer sample counts so write microseconds.
+        **mStackFile << aYear << ';' << calcType << ';' << mRegionNames[ activity ] << ';'
+                     << mActivityNames[ activity ] << ' '
+                     << static_cast<unsigned long>( totals[ i ].mTime * 1e6 ) << endl;
+    }
+}
+
+/*!
+ * \brief Get the stats for the current thread sized for all activities.
+ * \return The stats for the current thread.
+ */
+ActivityProfiler::StatsVector& ActivityProfiler::getLocalStats() {
+#if GCAM_PARALLEL_ENABLED
+    StatsVector& stats = mThreadStats.local();
+#else
+    StatsVector& stats = mStats;
+#endif
+    if( stats.size() != 2 * mActivityNames.size() ) {
+        stats.resize( 2 * mActivityNames.size() );
+    }
+    return stats;
+}
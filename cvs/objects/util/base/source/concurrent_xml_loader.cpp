@@ -0,0 +1,190 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*! 
+* \file concurrent_xml_loader.cpp
+* \ingroup Objects
+* \brief ConcurrentXMLLoader class source file.
+*/
+
+#include "util/base/include/definitions.h"
+#include <cassert>
+#include <iostream>
+#include <xercesc/dom/DOMDocument.hpp>
+#include <xercesc/dom/DOMException.hpp>
+#include <xercesc/parsers/XercesDOMParser.hpp>
+#include <xercesc/sax/HandlerBase.hpp>
+
+#if GCAM_PARALLEL_ENABLED
+#include <tbb/task_arena.h>
+#endif
+
+#include "util/base/include/concurrent_xml_loader.h"
+#include "util/base/include/xml_helper.h"
+#include "util/base/include/xml_snapshot.h"
+#include "util/base/include/iparsable.h"
+
+using namespace std;
+using namespace xercesc;
+
+/*!
+ * \brief Constructor which starts reading the first files.
+ * \param aXMLFiles The files to parse, in the order they are to be applied.
+ * \param aStreamDepth The depth to stream files at, or zero to read whole
+ *        documents.
+ * \param aMaxReadAhead The maximum number of documents to read ahead, zero to
+ *        read each document on the calling thread when it is applied, or
+ *        negative to use the number of available threads.
+ */
+ConcurrentXMLLoader::ConcurrentXMLLoader( const list<string>& aXMLFiles,
+                                          const int aStreamDepth,
+                                          const int aMaxReadAhead ):
+mNextToApply( 0 ),
+mStreamDepth( aStreamDepth )
+{
+    for( list<string>::const_iterator currFile = aXMLFiles.begin(); currFile != aXMLFiles.end(); ++currFile ) {
+        PendingDocument newDocument;
+        newDocument.mFileName = *currFile;
+        newDocument.mDocument = 0;
+        mDocuments.push_back( newDocument );
+    }
+
+    // Make sure the XML platform is initialized before any worker uses it.
+    XMLHelper<void>::getParser();
+
+#if GCAM_PARALLEL_ENABLED
+    mNextToRead = 0;
+    mMaxReadAhead = aMaxReadAhead < 0 ? static_cast<size_t>( tbb::this_task_arena::max_concurrency() )
+                                      : static_cast<size_t>( aMaxReadAhead );
+    if( mStreamDepth <= 0 && mMaxReadAhead > 0 ) {
+        mReadGroups.reset( new tbb::task_group[ mDocuments.size() ] );
+        startReading();
+    }
+#endif
+}
+
+//! Destructor which waits for any outstanding reads and frees their documents.
+ConcurrentXMLLoader::~ConcurrentXMLLoader() {
+    for( size_t i = mNextToApply; i < mDocuments.size(); ++i ) {
+#if GCAM_PARALLEL_ENABLED
+        if( mReadGroups ) {
+            mReadGroups[ i ].wait();
+        }
+#endif
+        if( mDocuments[ i ].mDocument ) {
+            mDocuments[ i ].mDocument->release();
+        }
+    }
+}
+
+/*!
+ * \brief Apply the next file to the given model element.
+ * \details Waits for the file to be read if it is not ready yet.
+ * \param aModelElement Element to call XMLParse on.
+ * \return Whether reading and parsing the file was successful.
+ */
+bool ConcurrentXMLLoader::parseNext( IParsable* aModelElement ) {
+    assert( mNextToApply < mDocuments.size() );
+    PendingDocument& document = mDocuments[ mNextToApply ];
+#if GCAM_PARALLEL_ENABLED
+    if( mReadGroups ) {
+        mReadGroups[ mNextToApply ].wait();
+        ++mNextToApply;
+        startReading();
+
+        if( !document.mDocument ) {
+            cout << "ERROR: XML Read Exception message is:" << endl << document.mError << endl;
+            return false;
+        }
+        const bool success = aModelElement->XMLParse( document.mDocument->getDocumentElement() );
+        document.mDocument->release();
+        document.mDocument = 0;
+        return success;
+    }
+#endif
+    ++mNextToApply;
+    return XMLHelper<void>::parseXML( document.mFileName, aModelElement, mStreamDepth );
+}
+
+#if GCAM_PARALLEL_ENABLED
+/*!
+ * \brief Start reading files until the maximum number of documents are being
+ *        read or waiting to be applied.
+ */
+void ConcurrentXMLLoader::startReading() {
+    while( mNextToRead < mDocuments.size() && mNextToRead < mNextToApply + mMaxReadAhead ) {
+        PendingDocument* document = &mDocuments[ mNextToRead ];
+        mReadGroups[ mNextToRead ].run( [document] () {
+            readDocument( *document );
+        } );
+        ++mNextToRead;
+    }
+}
+#endif
+
+/*!
+ * \brief Read a file into a DOM document with a parser owned by this call.
+ * \details A snapshot of the file is used instead if one is up to date,
+ *          otherwise a snapshot is saved after the file is parsed.
+ * \param aDocument The file to read, the document or an error message is set
+ *        in it.
+ */
+void ConcurrentXMLLoader::readDocument( PendingDocument& aDocument ) {
+    aDocument.mDocument = XMLSnapshot::loadSnapshot( aDocument.mFileName );
+    if( aDocument.mDocument ) {
+        return;
+    }
+
+    XercesDOMParser parser;
+    XMLHelper<void>::configureParser( &parser );
+    HandlerBase errorHandler;
+    parser.setErrorHandler( &errorHandler );
+    try {
+        parser.parse( aDocument.mFileName.c_str() );
+    } catch ( const XMLException& toCatch ) {
+        aDocument.mError = XMLHelper<string>::safeTranscode( toCatch.getMessage() );
+        return;
+    } catch ( const DOMException& toCatch ) {
+        aDocument.mError = XMLHelper<string>::safeTranscode( toCatch.msg );
+        return;
+    } catch ( const SAXException& toCatch ){
+        aDocument.mError = XMLHelper<string>::safeTranscode( toCatch.getMessage() );
+        return;
+    } catch (...) {
+        aDocument.mError = "Unexpected XML Read Exception.";
+        return;
+    }
+
+    // Take ownership of the document so that it outlives the parser.
+    aDocument.mDocument = parser.adoptDocument();
+    XMLSnapshot::saveSnapshot( aDocument.mFileName, aDocument.mDocument );
+}
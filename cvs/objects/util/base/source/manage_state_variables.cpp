@@ -39,6 +39,7 @@
  */
 
 #include <cstring>
+#include <cassert>
 #include <fstream>
 
 #include "util/base/include/manage_state_variables.hpp"
@@ -50,7 +51,6 @@
 #include "util/base/include/gcam_data_containers.h"
 
 #if GCAM_PARALLEL_ENABLED
-#include <tbb/concurrent_queue.h>
 #include <tbb/task_scheduler_init.h>
 #endif
 
@@ -61,7 +61,12 @@ extern Scenario* scenario;
 // Note we must static initialize static class member variables in a cpp file and
 // since Value is header only and these particular fields are just as related to
 // ManageStateVariables it seems appropriate to initialize them to NULL here.
-Value::CentralValueType Value::sCentralValue( (double*)0 );
+#if !GCAM_PARALLEL_ENABLED
+Value::CentralValueType Value::sCentralValue( 0 );
+DirtyStateBlocks* Value::sCentralDirty( 0 );
+#else
+Value::CentralValueType Value::sCentralValue = Value::CentralValueType( Value::CentralState() );
+#endif
 double* Value::sBaseCentralValue( 0 );
 
 #if GCAM_PARALLEL_ENABLED
@@ -79,24 +84,11 @@ double* Value::sBaseCentralValue( 0 );
  *        from with in the Value class.
  */
 struct AssignThreadStateFun {
-    //! A reference to ManageStateVariables::mStateData.
-    double** mArr;
-    
-    //! The maximum number of states that have been allocated in mStateData.
-    const int mMaxStates;
-    
-    //! A thread safe queue that will have as values each index into mStateData
-    //! and as each new thread consumes it's next value implies that thread gets
-    //! assigned that state slot.
-    tbb::concurrent_queue<int> mThreadStateIndex;
+    //! The ManageStateVariables which owns the state slots.
+    ManageStateVariables* mParent;
     
     //! Constructor
-    AssignThreadStateFun( double** aArr, const int aMaxStates ):mArr( aArr ), mMaxStates( aMaxStates ) {
-        // initialize the state index slots starting from 1 as 0 is always the
-        // "base" state.
-        for( int i = 1; i < mMaxStates; ++i ) {
-            mThreadStateIndex.push( i );
-        }
+    AssignThreadStateFun( ManageStateVariables* aParent ):mParent( aParent ) {
     }
     
     /*!
@@ -104,26 +96,26 @@ struct AssignThreadStateFun {
      *        storage Value::sCentralValue for the first time.  It will assign a unique
      *        slot into ManageStateVariables::sCentralValue for this thread to use
      *        for the duration of it's calculations.
-     * \return The unique slot of state that this thread can be guaranteed to use
-     *         free from interference from any other thread.
+     * \return The unique slot of state, and the write tracking that belongs to it,
+     *         that this thread can be guaranteed to use free from interference
+     *         from any other thread.
      */
-    double* operator()() {
-        int nextState;
-        bool gotState = mThreadStateIndex.try_pop( nextState );
-        if( !gotState ) {
-            ILogger& mainLog = ILogger::getLogger( "main_log" );
-            mainLog.setLevel( ILogger::SEVERE );
-            mainLog << "Failed to get an unused state to assign to a worker thread." << endl;
-            abort();
-        }
-        
-        return mArr[ nextState ];
+    Value::CentralState operator()() const {
+        const size_t slot = mParent->assignThreadSlot();
+        Value::CentralState state;
+#if !GCAM_SPARSE_SCRATCH
+        state.mValues = mParent->mStateData[ slot ];
+#else
+        state.mValues = mParent->mBlockTables[ slot ];
+#endif
+        state.mDirty = &mParent->mDirtyBlocks[ slot ];
+        return state;
     }
 };
 #endif
 
 /*!
- * \brief Constructor which calls collectState() to begin the process to find all
+ * \brief Constructor which calls beginPeriod() to begin the process to find all
  *        state data during the given model period and allocate memory to hold
  *        it in a "base" and "scratch" spaces.
  * \param aPeriod The model period to manage state in.
@@ -135,12 +127,29 @@ mStateData( new double*[ NUM_STATES ] ),
 mThreadPool(),
 mStateData( new double*[ NUM_STATES ] ),
 #endif
+#if GCAM_SPARSE_SCRATCH
+mBlockTables( new double**[ NUM_STATES ] ),
+#endif
+#if GCAM_PARALLEL_ENABLED
+mSlotOwner( NUM_STATES ),
+mSlotInUse( NUM_STATES, 0 ),
+#endif
+mDirtyBlocks( new DirtyStateBlocks[ NUM_STATES ] ),
+mLayoutRecorder( 0 ),
+mStateCapacity( 0 ),
+mIsPeriodActive( false ),
 mPeriodToCollect( aPeriod ),
-mYearToCollect( scenario->getModeltime()->getper_to_yr( aPeriod ) ),
-mCCStartYear( mYearToCollect - scenario->getModeltime()->gettimestep( aPeriod ) + 1 ),
+mYearToCollect( 0 ),
+mCCStartYear( 0 ),
 mNumCollected( 0 )
 {
-    collectState();
+    for( size_t stateInd = 0; stateInd < NUM_STATES; ++stateInd ) {
+        mStateData[ stateInd ] = 0;
+#if GCAM_SPARSE_SCRATCH
+        mBlockTables[ stateInd ] = 0;
+#endif
+    }
+    beginPeriod( aPeriod );
 }
 
 /*!
@@ -148,13 +157,64 @@ mNumCollected( 0 )
  *        "base" state back into the Value objects before we deallocate that memory.
  */
 ManageStateVariables::~ManageStateVariables() {
-    resetState();
+    if( mIsPeriodActive ) {
+        endPeriod();
+    }
     for( size_t stateInd = 0; stateInd < NUM_STATES; ++stateInd ) {
         delete[] mStateData[ stateInd ];
+#if GCAM_SPARSE_SCRATCH
+        delete[] mBlockTables[ stateInd ];
+#endif
     }
     delete[] mStateData;
+#if GCAM_SPARSE_SCRATCH
+    delete[] mBlockTables;
+#endif
+    delete[] mDirtyBlocks;
+    delete mLayoutRecorder;
+}
+
+/*!
+ * \brief Start managing the state for the given model period.
+ * \details By default the model is searched for STATE data every period
+ *          since objects with STATE data, such as new technology vintages, may
+ *          be created or destroyed between periods.  When the Configuration
+ *          flag reuse-state-collection is set the search is only done the
+ *          first time and subsequent periods only check which of the data
+ *          found is active.  The state arrays which were already allocated
+ *          are reused either way.
+ * \param aPeriod The model period to manage state in.
+ */
+void ManageStateVariables::beginPeriod( const int aPeriod ) {
+    if( mIsPeriodActive ) {
+        endPeriod();
+    }
+    mPeriodToCollect = aPeriod;
+    mYearToCollect = scenario->getModeltime()->getper_to_yr( aPeriod );
+    mCCStartYear = mYearToCollect - scenario->getModeltime()->gettimestep( aPeriod ) + 1;
+    mLayout.clear();
+    
+    const bool reuseCollection = Configuration::getInstance()->getBool( "reuse-state-collection", false, false );
+    if( mCollection.empty() || !reuseCollection ) {
+        searchForState();
+    }
+    collectState();
+    mIsPeriodActive = true;
+}
+
+/*!
+ * \brief Stop managing state for the current period.
+ * \details The "base" state is copied back into each Value so that they may be
+ *          used normally between periods.  The state arrays are kept to be
+ *          reused by the next call to beginPeriod.
+ */
+void ManageStateVariables::endPeriod() {
+    logCacheLineTouches();
+    resetState();
+    mIsPeriodActive = false;
 #if !GCAM_PARALLEL_ENABLED
     Value::sCentralValue = 0;
+    Value::sCentralDirty = 0;
 #else
     Value::sCentralValue.clear();
 #endif
@@ -162,11 +222,12 @@ ManageStateVariables::~ManageStateVariables() {
 }
 
 /*!
- * \brief Search for all relevant STATE Values and allocate space for them in the
- *        central state data arrays.  The "base" state will get initialized as the
- *        actual value set in the individual Value objects before being collected.
+ * \brief Search the entire model with GCAMFusion for data flagged as STATE and
+ *        keep the results in mCollection.
  */
-void ManageStateVariables::collectState() {
+void ManageStateVariables::searchForState() {
+    mCollection.clear();
+    
     // Set up the GCAM Fusion steps as well as the callback struct that will handle
     // the results from the search.
     DoCollect doCollectProc;
@@ -183,14 +244,118 @@ void ManageStateVariables::collectState() {
     GCAMFusion<DoCollect, true, true, true> gatherState( doCollectProc, collectStateSteps );
     gatherState.startFilter( scenario );
     
-    // DoCollect has now gathered all active state into the mStateValues list to
+    // clean up GCAMFusion related memory
+    for( auto filterStep : collectStateSteps ) {
+        delete filterStep;
+    }
+    
+    ILogger& mainLog = ILogger::getLogger( "main_log" );
+    mainLog.setLevel( ILogger::DEBUG );
+    mainLog << "Number of state containers found: " << mCollection.size() << endl;
+}
+
+/*!
+ * \brief Gather the STATE Values from mCollection that are active in the current
+ *        period and allocate space for them in the central state data arrays.
+ *        The "base" state will get initialized as the actual value set in the
+ *        individual Value objects before being collected.
+ */
+void ManageStateVariables::collectState() {
+    mStateValues.clear();
+    mNumCollected = 0;
+    
+    // Data from the same Technology is found consecutively so we only need to
+    // check if it is operating when the Technology changes.
+    const ITechnology* currTechnology = 0;
+    bool isTechnologyOperating = false;
+    for( const auto& currState : mCollection ) {
+        // Ignore any data set within a Technology that is not operating in the
+        // current model period.
+        if( currState.mTechnology ) {
+            if( currState.mTechnology != currTechnology ) {
+                currTechnology = currState.mTechnology;
+                isTechnologyOperating = currTechnology->isOperating( mPeriodToCollect );
+            }
+            if( !isTechnologyOperating ) {
+                continue;
+            }
+        }
+        // Ignore any data set within a Market which is not for the current model year.
+        if( currState.mMarket && currState.mMarket->getYear() != mYearToCollect ) {
+            continue;
+        }
+        
+        switch( currState.mType ) {
+            case CollectedState::SINGLE:
+                // Any SINGLE value that is tagged is considered active.
+                mStateValues.push_front( static_cast<Value*>( currState.mData ) );
+                ++mNumCollected;
+                break;
+            case CollectedState::PERIOD_VECTOR:
+                // When an ARRAY of values are tagged only the Value in [ mPeriodToCollect] is
+                // considered active.
+                mStateValues.push_front( &( *static_cast<objects::PeriodVector<Value>*>( currState.mData ) )[ mPeriodToCollect ] );
+                ++mNumCollected;
+                break;
+            case CollectedState::TECH_VINTAGE_VECTOR:
+                // Note, the Technology operating check takes care of out of bounds here
+                mStateValues.push_front( &( *static_cast<objects::TechVintageVector<Value>*>( currState.mData ) )[ mPeriodToCollect ] );
+                ++mNumCollected;
+                break;
+            case CollectedState::YEAR_VECTOR: {
+                // When a year vector is tagged we only need to worry about values in the current
+                // timestep (already calculated the years ahead of time in the interest of speed
+                // to be from [mCCStartYear, mYearToCollect])
+                objects::YearVector<Value>& yearVector = *static_cast<objects::YearVector<Value>*>( currState.mData );
+                for( int year = std::max( mCCStartYear, yearVector.getStartYear() ); year <= mYearToCollect; ++year ) {
+                    mStateValues.push_front( &yearVector[ year ] );
+                    ++mNumCollected;
+                }
+                break;
+            }
+        }
+    }
+    
+    // We have now gathered all active state into the mStateValues list to
     // allow faster/easier processing for the remaining tasks at hand.
     ILogger& mainLog = ILogger::getLogger( "main_log" );
     mainLog.setLevel( ILogger::DEBUG );
     mainLog << "Number of active state values: " << mNumCollected << endl;
-    // Allocate space for each active state value for each state slot.
+    // Make sure there is space for each active state value for each state slot,
+    // the arrays are only reallocated if a previous period did not need as many.
+    // When GCAM_PARALLEL_ENABLED the "scratch" states are left to be allocated
+    // by the thread that will use them, see assignThreadSlot.
+    if( mNumCollected > mStateCapacity || !mStateData[ 0 ] ) {
+        for( size_t stateInd = 0; stateInd < NUM_STATES; ++stateInd ) {
+            delete[] mStateData[ stateInd ];
+            mStateData[ stateInd ] = 0;
+#if GCAM_SPARSE_SCRATCH
+            delete[] mBlockTables[ stateInd ];
+            mBlockTables[ stateInd ] = 0;
+#endif
+        }
+        mStateCapacity = mNumCollected;
+        mStateData[ 0 ] = new double[ mStateCapacity ];
+#if !GCAM_PARALLEL_ENABLED
+        mStateData[ 1 ] = new double[ mStateCapacity ];
+#endif
+#if GCAM_SPARSE_SCRATCH
+        mBlockTables[ 0 ] = new double*[ ( mStateCapacity >> DirtyStateBlocks::BLOCK_SHIFT ) + 1 ];
+#endif
+    }
+    // Writes may optionally be tracked at cache line granularity so that the
+    // number of cache lines touched per derivative can be reported exactly.
+    // The block tables used by GCAM_SPARSE_SCRATCH require the default size.
+    const unsigned int blockShift = !GCAM_SPARSE_SCRATCH &&
+        Configuration::getInstance()->getBool( "track-state-cache-lines", false, false ) ?
+        DirtyStateBlocks::CACHE_LINE_SHIFT : DirtyStateBlocks::BLOCK_SHIFT;
     for( size_t stateInd = 0; stateInd < NUM_STATES; ++stateInd ) {
-        mStateData[ stateInd ] = new double[ mNumCollected ];
+        initDirtyBlocks( mDirtyBlocks[ stateInd ], blockShift );
+#if GCAM_SPARSE_SCRATCH
+        if( mBlockTables[ stateInd ] ) {
+            resetBlockTable( stateInd );
+        }
+#endif
     }
     
     // We can now initialize the static Value references into mStateData for fast
@@ -213,11 +378,6 @@ void ManageStateVariables::collectState() {
     if(  restartPeriod != -1 && mPeriodToCollect < restartPeriod ) {
         loadRestartFile();
     }
-    
-    // clean up GCAMFusion related memory
-    for( auto filterStep : collectStateSteps ) {
-        delete filterStep;
-    }
 }
 
 /*!
@@ -251,15 +411,287 @@ void ManageStateVariables::resetState() {
  *          calculation which will make changes in the "scratch" space.  Note when
  *          GCAM_PARALLEL_ENABLED the appropriate "scratch" space to reset is identified
  *          as the one assigned to the calling thread via the thread local Value::sCentralValue.
+ *          Only the blocks written to since the last reset get copied.
  */
 void ManageStateVariables::copyState() {
+    const size_t stateInd = getThreadSlot();
+    /*!
+     * \pre We are in partial derivative mode, i.e. the calling thread has a
+     *      "scratch" state to reset.
+     */
+    assert( stateInd != 0 );
+    if( stateInd != 0 ) {
+        restoreScratch( stateInd );
+    }
+}
+
+/*!
+ * \brief Copies the calling thread's "scratch" state over the "base" state.
+ * \details This keeps the result of a partial calculation, such as one which
+ *          recalculated only the activities affected by a change in some prices,
+ *          without having to recalculate the rest of the model.  Only the blocks
+ *          written since the "scratch" state was last reset with copyState get
+ *          copied.  The other "scratch" states are marked for a full reset since
+ *          the "base" state changed under them.
+ */
+void ManageStateVariables::acceptState() {
+    const size_t stateInd = getThreadSlot();
+    /*!
+     * \pre We are in partial derivative mode, i.e. the calling thread has a
+     *      "scratch" state to keep.
+     */
+    assert( stateInd != 0 );
+    if( stateInd == 0 ) {
+        return;
+    }
+    DirtyStateBlocks& dirty = mDirtyBlocks[ stateInd ];
+    const size_t blockSize = size_t( 1 ) << dirty.mBlockShift;
+#if GCAM_SPARSE_SCRATCH
+    double** blockTable = mBlockTables[ stateInd ];
+    for( auto block : dirty.mDirtyBlocks ) {
+        const size_t start = size_t( block ) << dirty.mBlockShift;
+        const size_t count = min( blockSize, mNumCollected - start );
+        memcpy( mStateData[0] + start, blockTable[ block ], (sizeof( double)) * count );
+    }
+#else
+    // Without a reset since the last full copy the blocks written do not
+    // tell us everything that differs from the "base" state.
+    assert( !dirty.mAllDirty );
+    double* aScratch = mStateData[ stateInd ];
+    for( auto block : dirty.mDirtyBlocks ) {
+        const size_t start = size_t( block ) << dirty.mBlockShift;
+        const size_t count = min( blockSize, mNumCollected - start );
+        memcpy( mStateData[0] + start, aScratch + start, (sizeof( double)) * count );
+    }
+#endif
+    restoreScratch( stateInd );
+    const size_t numStates = NUM_STATES;
+    for( size_t otherInd = 1; otherInd < numStates; ++otherInd ) {
+        if( otherInd != stateInd ) {
+            mDirtyBlocks[ otherInd ].mAllDirty = true;
+        }
+    }
+}
+
+/*!
+ * \brief Get the "scratch" state the calling thread is currently working in.
+ * \details The slot is found from the write tracking the thread's Value::sCentralValue
+ *          refers to, which is null for the "base" state and may be the layout
+ *          recorder while that is active.
+ * \return The index into mStateData of the calling thread's "scratch" state or
+ *         zero if it is not working in one.
+ */
+size_t ManageStateVariables::getThreadSlot() const {
+#if !GCAM_PARALLEL_ENABLED
+    const DirtyStateBlocks* dirty = Value::sCentralDirty;
+#else
+    const DirtyStateBlocks* dirty = Value::sCentralValue.local().mDirty;
+#endif
+    if( dirty ) {
+        const size_t numStates = NUM_STATES;
+        for( size_t stateInd = 1; stateInd < numStates; ++stateInd ) {
+            if( dirty == &mDirtyBlocks[ stateInd ] ) {
+                return stateInd;
+            }
+        }
+    }
+    return 0;
+}
+
+/*!
+ * \brief Reset the given "scratch" state to the "base" state and clear it's
+ *        write tracking.
+ * \details If a large share of the blocks are dirty a single memcpy of the
+ *          whole array is cheaper than copying block by block.  With
+ *          GCAM_SPARSE_SCRATCH the blocks that were copied on write only need
+ *          to be pointed back to the "base" state.
+ * \param aStateInd The slot in mStateData of the "scratch" state to reset.
+ */
+void ManageStateVariables::restoreScratch( const size_t aStateInd ) {
+    DirtyStateBlocks& aDirty = mDirtyBlocks[ aStateInd ];
+    if( !aDirty.mDirtyBlocks.empty() ) {
+        // Keep statistics on the partial derivative that made these writes.
+        ++aDirty.mNumResets;
+        aDirty.mNumLinesTouched += aDirty.mDirtyBlocks.size() << ( aDirty.mBlockShift - DirtyStateBlocks::CACHE_LINE_SHIFT );
+    }
+#if GCAM_SPARSE_SCRATCH
+    // Blocks that were not written always refer to the "base" state so they
+    // are current regardless of mAllDirty.
+    double** blockTable = mBlockTables[ aStateInd ];
+    for( auto block : aDirty.mDirtyBlocks ) {
+        blockTable[ block ] = mStateData[0] + ( size_t( block ) << aDirty.mBlockShift );
+        aDirty.mIsDirty[ block ] = 0;
+    }
+#else
+    const size_t numBlocks = aDirty.mIsDirty.size();
+    double* aScratch = mStateData[ aStateInd ];
+    if( aDirty.mAllDirty || aDirty.mDirtyBlocks.size() * 2 > numBlocks ) {
+        memcpy( aScratch, mStateData[0], (sizeof( double)) * mNumCollected );
+        fill( aDirty.mIsDirty.begin(), aDirty.mIsDirty.end(), 0 );
+    }
+    else {
+        const size_t blockSize = size_t( 1 ) << aDirty.mBlockShift;
+        for( auto block : aDirty.mDirtyBlocks ) {
+            const size_t start = size_t( block ) << aDirty.mBlockShift;
+            const size_t count = min( blockSize, mNumCollected - start );
+            memcpy( aScratch + start, mStateData[0] + start, (sizeof( double)) * count );
+            aDirty.mIsDirty[ block ] = 0;
+        }
+    }
+#endif
+    aDirty.mDirtyBlocks.clear();
+    aDirty.mAllDirty = false;
+}
+
+/*!
+ * \brief Size the given write tracking for the collected state and mark it as
+ *        needing a full reset.
+ * \param aDirty The write tracking to initialize.
+ * \param aBlockShift The log2 of the number of state values to track as one block.
+ */
+void ManageStateVariables::initDirtyBlocks( DirtyStateBlocks& aDirty, const unsigned int aBlockShift ) const {
+    const size_t numBlocks = ( mNumCollected >> aBlockShift ) + 1;
+    aDirty.mBlockShift = aBlockShift;
+    // reserve enough space that marking a block never needs to allocate
+    aDirty.mIsDirty.assign( numBlocks, 0 );
+    aDirty.mDirtyBlocks.clear();
+    aDirty.mDirtyBlocks.reserve( numBlocks );
+    aDirty.mAllDirty = true;
+    aDirty.mNumResets = 0;
+    aDirty.mNumLinesTouched = 0;
+#if GCAM_SPARSE_SCRATCH
+    aDirty.mBlockTable = 0;
+    aDirty.mBlockPool = 0;
+    aDirty.mBase = 0;
+    aDirty.mNumValues = mNumCollected;
+#endif
+}
+
+/*!
+ * \brief Report the average number of cache lines of "scratch" state written by
+ *        each partial derivative this period.
+ * \details The count is exact when the Configuration flag track-state-cache-lines
+ *          is set, otherwise it counts every line in each written block and is
+ *          an upper bound.
+ */
+void ManageStateVariables::logCacheLineTouches() const {
+    unsigned long numResets = 0;
+    unsigned long numLinesTouched = 0;
+    for( size_t stateInd = 1; stateInd < NUM_STATES; ++stateInd ) {
+        numResets += mDirtyBlocks[ stateInd ].mNumResets;
+        numLinesTouched += mDirtyBlocks[ stateInd ].mNumLinesTouched;
+    }
+    if( numResets > 0 ) {
+        const size_t totalLines = ( mNumCollected >> DirtyStateBlocks::CACHE_LINE_SHIFT ) + 1;
+        ILogger& mainLog = ILogger::getLogger( "main_log" );
+        mainLog.setLevel( ILogger::DEBUG );
+        mainLog << "State cache lines touched per derivative: "
+                << static_cast<double>( numLinesTouched ) / static_cast<double>( numResets )
+                << " of " << totalLines << " over " << numResets << " derivatives" << endl;
+    }
+}
+
+/*!
+ * \brief Begin recording the order in which the "base" state gets written.
+ * \details Intended to wrap a full serial World.calc, which calculates each
+ *          activity in the MarketDependencyFinder global ordering, so that
+ *          finishLayoutRecording can place the state of each activity together.
+ *          Writes are not recorded per thread so the calculation that is being
+ *          recorded must not run in parallel.
+ * \sa ManageStateVariables::finishLayoutRecording
+ */
+void ManageStateVariables::startLayoutRecording() {
+    if( !mLayoutRecorder ) {
+        mLayoutRecorder = new DirtyStateBlocks();
+    }
+    // A block of a single value records the exact order of the writes.
+    initDirtyBlocks( *mLayoutRecorder, 0 );
+    mLayoutRecorder->mAllDirty = false;
+    setPartialDeriv( false );
 #if !GCAM_PARALLEL_ENABLED
-    memcpy( mStateData[1], mStateData[0], (sizeof( double)) * mNumCollected );
+    Value::sCentralDirty = mLayoutRecorder;
 #else
-    memcpy( Value::sCentralValue.local(), mStateData[0], (sizeof( double)) * mNumCollected );
+    Value::CentralState recordState = Value::sCentralValue.local();
+    recordState.mDirty = mLayoutRecorder;
+    Value::sCentralValue = Value::CentralValueType( recordState );
 #endif
 }
 
+/*!
+ * \brief Stop recording and renumber the state in the order it was first written.
+ * \details Values that were never written are kept after those that were, in
+ *          their existing order.  This way the state a partial derivative
+ *          touches is packed into as few cache lines as the calculation order
+ *          allows.  The "base" state is permuted to match and each "scratch"
+ *          state is marked for a full reset.
+ * \sa ManageStateVariables::startLayoutRecording
+ */
+void ManageStateVariables::finishLayoutRecording() {
+    if( !mLayoutRecorder ) {
+        return;
+    }
+    setPartialDeriv( false );
+    
+    // Assign new indices, those written first in the order they were written.
+    vector<unsigned int> newIndex( mNumCollected );
+    unsigned int nextIndex = 0;
+    for( auto index : mLayoutRecorder->mDirtyBlocks ) {
+        newIndex[ index ] = nextIndex++;
+    }
+    const unsigned int numWritten = nextIndex;
+    for( size_t index = 0; index < mNumCollected; ++index ) {
+        if( !mLayoutRecorder->mIsDirty[ index ] ) {
+            newIndex[ index ] = nextIndex++;
+        }
+    }
+    delete mLayoutRecorder;
+    mLayoutRecorder = 0;
+    
+    // Permute the "base" state into a new array, all scratch will be reset anyways.
+    double* relaidState = new double[ mStateCapacity ];
+    for( size_t index = 0; index < mNumCollected; ++index ) {
+        relaidState[ newIndex[ index ] ] = mStateData[ 0 ][ index ];
+    }
+    delete[] mStateData[ 0 ];
+    mStateData[ 0 ] = relaidState;
+    for( size_t stateInd = 1; stateInd < NUM_STATES; ++stateInd ) {
+        mDirtyBlocks[ stateInd ].mAllDirty = true;
+    }
+#if GCAM_SPARSE_SCRATCH
+    for( size_t stateInd = 0; stateInd < NUM_STATES; ++stateInd ) {
+        if( mBlockTables[ stateInd ] ) {
+            initDirtyBlocks( mDirtyBlocks[ stateInd ], DirtyStateBlocks::BLOCK_SHIFT );
+            resetBlockTable( stateInd );
+        }
+    }
+#endif
+    Value::sBaseCentralValue = mStateData[ 0 ];
+    setPartialDeriv( false );
+    
+    // Update the Values and keep mStateValues sorted by index.
+    for( auto currValue : mStateValues ) {
+        currValue->mCentralValueIndex = newIndex[ currValue->mCentralValueIndex ];
+    }
+    mStateValues.sort( []( const Value* aLHS, const Value* aRHS ) {
+        return aLHS->mCentralValueIndex < aRHS->mCentralValueIndex;
+    } );
+    
+    // Compose with any previous layout so restart files remain in collection order.
+    if( mLayout.empty() ) {
+        mLayout.swap( newIndex );
+    }
+    else {
+        for( auto& index : mLayout ) {
+            index = newIndex[ index ];
+        }
+    }
+    
+    ILogger& mainLog = ILogger::getLogger( "main_log" );
+    mainLog.setLevel( ILogger::DEBUG );
+    mainLog << "Re-laid out state in calculation order, " << numWritten << " of "
+            << mNumCollected << " state values written during World.calc" << endl;
+}
+
 /*!
  * \brief Set up the Value classes static references into mStateData to appropriately
  *        point to the "base" state if aIsPartialDeriv is false or a "scratch"
@@ -268,20 +700,118 @@ void ManageStateVariables::copyState() {
  *                        derivative or not as set from the solution algorithm.
  */
 void ManageStateVariables::setPartialDeriv( const bool aIsPartialDeriv ) {
+    if( aIsPartialDeriv ) {
+        // Writes to the "base" state are not tracked so we must assume it has
+        // changed everywhere since the scratch spaces were last reset.
+        for( size_t stateInd = 1; stateInd < NUM_STATES; ++stateInd ) {
+            mDirtyBlocks[ stateInd ].mAllDirty = true;
+        }
+    }
 #if !GCAM_PARALLEL_ENABLED
     Value::sCentralValue = mStateData[ aIsPartialDeriv ? 1 : 0 ];
+    Value::sCentralDirty = aIsPartialDeriv ? &mDirtyBlocks[ 1 ] : 0;
 #else
     if( !aIsPartialDeriv ) {
         // Initialize the thread local storage to always access the "base" state.
-        Value::sCentralValue = Value::CentralValueType( mStateData[0] );
+        Value::CentralState baseState;
+#if !GCAM_SPARSE_SCRATCH
+        baseState.mValues = mStateData[0];
+#else
+        baseState.mValues = mBlockTables[0];
+#endif
+        // Writes to the "base" state are not tracked.
+        baseState.mDirty = 0;
+        Value::sCentralValue = Value::CentralValueType( baseState );
     }
     else {
         // Use the AssignThreadStateFun helper functor to uniquely assign a state
         // slot to each worker thread.
-        Value::sCentralValue = Value::CentralValueType( AssignThreadStateFun( mStateData, NUM_STATES ) );
+        fill( mSlotInUse.begin(), mSlotInUse.end(), 0 );
+        Value::sCentralValue = Value::CentralValueType( AssignThreadStateFun( this ) );
+    }
+#endif
+}
+
+#if GCAM_PARALLEL_ENABLED
+/*!
+ * \brief Get the state slot for the calling thread to use for partial derivatives,
+ *        allocating the "scratch" state if it has not yet been.
+ * \details A thread is given the same slot it had the last time if possible.
+ *          The "scratch" state is allocated, and first written when it gets
+ *          reset, by the thread that uses it so that with a first touch memory
+ *          policy it is placed on that thread's NUMA node and stays there.
+ *          Calling this again from the same thread before the next call to
+ *          setPartialDeriv( true ) gives the same slot.
+ * \return The index into mStateData assigned to the calling thread.
+ */
+size_t ManageStateVariables::assignThreadSlot() {
+    tbb::spin_mutex::scoped_lock lock( mSlotMutex );
+    const thread::id currThread = this_thread::get_id();
+    const size_t numStates = NUM_STATES;
+    size_t slot = 0;
+    for( size_t stateInd = 1; stateInd < numStates && slot == 0; ++stateInd ) {
+        if( mSlotOwner[ stateInd ] == currThread ) {
+            slot = stateInd;
+        }
+    }
+    // A thread we have not seen before takes a slot that no thread has used,
+    // otherwise any slot not in use by another thread.
+    for( size_t stateInd = 1; stateInd < numStates && slot == 0; ++stateInd ) {
+        if( mSlotOwner[ stateInd ] == thread::id() ) {
+            slot = stateInd;
+        }
+    }
+    for( size_t stateInd = 1; stateInd < numStates && slot == 0; ++stateInd ) {
+        if( !mSlotInUse[ stateInd ] ) {
+            slot = stateInd;
+        }
+    }
+    if( slot == 0 ) {
+        ILogger& mainLog = ILogger::getLogger( "main_log" );
+        mainLog.setLevel( ILogger::SEVERE );
+        mainLog << "Failed to get an unused state to assign to a worker thread." << endl;
+        abort();
+    }
+    mSlotOwner[ slot ] = currThread;
+    mSlotInUse[ slot ] = 1;
+    
+    if( !mStateData[ slot ] ) {
+#if !GCAM_SPARSE_SCRATCH
+        mStateData[ slot ] = new double[ mStateCapacity ];
+#else
+        // The pool must hold every block, though only those actually written
+        // will be touched.
+        const size_t numBlocks = ( mStateCapacity >> DirtyStateBlocks::BLOCK_SHIFT ) + 1;
+        mStateData[ slot ] = new double[ numBlocks << DirtyStateBlocks::BLOCK_SHIFT ];
+        mBlockTables[ slot ] = new double*[ numBlocks ];
+        resetBlockTable( slot );
+#endif
+        mDirtyBlocks[ slot ].mAllDirty = true;
     }
+    return slot;
+}
 #endif
+
+#if GCAM_SPARSE_SCRATCH
+/*!
+ * \brief Point every block in the block table of the given state slot to the
+ *        "base" state and set up its write tracking to copy on write.
+ * \param aStateInd The state slot to reset.
+ */
+void ManageStateVariables::resetBlockTable( const size_t aStateInd ) {
+    double** blockTable = mBlockTables[ aStateInd ];
+    const size_t numBlocks = ( mNumCollected >> DirtyStateBlocks::BLOCK_SHIFT ) + 1;
+    for( size_t block = 0; block < numBlocks; ++block ) {
+        blockTable[ block ] = mStateData[ 0 ] + ( block << DirtyStateBlocks::BLOCK_SHIFT );
+    }
+    DirtyStateBlocks& dirty = mDirtyBlocks[ aStateInd ];
+    // Writes to the "base" state go directly into it.
+    dirty.mBlockTable = aStateInd == 0 ? 0 : blockTable;
+    dirty.mBlockPool = mStateData[ aStateInd ];
+    dirty.mBase = mStateData[ 0 ];
+    dirty.mNumValues = mNumCollected;
 }
+#endif
 
 /*!
  * \brief Generate the appropriate restart file name to use.
@@ -373,8 +903,18 @@ void ManageStateVariables::saveRestartFile() {
     // checking on read in
     restartFile.write( reinterpret_cast<char*>( &mNumCollected ), sizeof( size_t ) );
     
-    // write the entire contents of the "base" state
-    restartFile.write( reinterpret_cast<char*>( mStateData[0] ), sizeof( double ) * mNumCollected );
+    // write the entire contents of the "base" state, always in collection order
+    // so that it can be read back before any re-layout
+    if( mLayout.empty() ) {
+        restartFile.write( reinterpret_cast<char*>( mStateData[0] ), sizeof( double ) * mNumCollected );
+    }
+    else {
+        vector<double> collectionOrder( mNumCollected );
+        for( size_t index = 0; index < mNumCollected; ++index ) {
+            collectionOrder[ index ] = mStateData[0][ mLayout[ index ] ];
+        }
+        restartFile.write( reinterpret_cast<char*>( &collectionOrder[0] ), sizeof( double ) * mNumCollected );
+    }
     
     restartFile.close();
     
@@ -393,6 +933,21 @@ void Value::doStateCheck() const {
 }
 #endif
 
+/*!
+ * \brief Record a container of STATE data along with the Technology or Market
+ *        that it is contained in.
+ * \param aType The type of container.
+ * \param aData The container.
+ */
+void ManageStateVariables::DoCollect::addState( const CollectedState::ContainerType aType, void* aData ) {
+    CollectedState state;
+    state.mType = aType;
+    state.mData = aData;
+    state.mTechnology = mCurrTechnology;
+    state.mMarket = mCurrMarket;
+    mParentClass->mCollection.push_back( state );
+}
+
 template<typename DataType>
 void ManageStateVariables::DoCollect::processData( DataType& aData ) {
 #if DEBUG_STATE
@@ -404,47 +959,22 @@ void ManageStateVariables::DoCollect::processData( DataType& aData ) {
 
 template<>
 void ManageStateVariables::DoCollect::processData<Value>( Value& aData ) {
-    // Any SINGLE value that is tagged is considered active so long as it is not
-    // contained in a retired technology for instance.
-    if( !mIgnoreCurrValue ) {
-        mParentClass->mStateValues.push_front( &aData );
-        ++mParentClass->mNumCollected;
-    }
+    addState( CollectedState::SINGLE, &aData );
 }
 
 template<>
 void ManageStateVariables::DoCollect::processData<objects::PeriodVector<Value> >( objects::PeriodVector<Value>& aData ) {
-    // When an ARRAY of values are tagged only the Value in [ mPeriodToCollect] is
-    // considered active.
-    if( !mIgnoreCurrValue ) {
-        mParentClass->mStateValues.push_front( &aData[ mParentClass->mPeriodToCollect ] );
-        ++mParentClass->mNumCollected;
-    }
+    addState( CollectedState::PERIOD_VECTOR, &aData );
 }
 
 template<>
 void ManageStateVariables::DoCollect::processData<objects::TechVintageVector<Value> >( objects::TechVintageVector<Value>& aData ) {
-    // When an ARRAY of values are tagged only the Value in [ mPeriodToCollect] is
-    // considered active.
-    
-    // Note, mIgnoreCurrValue should take care of out of bounds here
-    if( !mIgnoreCurrValue ) {
-        mParentClass->mStateValues.push_front( &aData[ mParentClass->mPeriodToCollect ] );
-        ++mParentClass->mNumCollected;
-    }
+    addState( CollectedState::TECH_VINTAGE_VECTOR, &aData );
 }
 
 template<>
 void ManageStateVariables::DoCollect::processData<objects::YearVector<Value> >( objects::YearVector<Value>& aData ) {
-    // When a year vector is tagged we only need to worry about values in the current
-    // timestep (already calculated the years ahead of time in the interest of speed
-    // to be from [mCCStartYear, mYearToCollect])
-    if( !mIgnoreCurrValue ) {
-        for( int year = std::max( mParentClass->mCCStartYear, aData.getStartYear() ); year <= mParentClass->mYearToCollect; ++year ) {
-            mParentClass->mStateValues.push_front( &aData[ year ] );
-            ++mParentClass->mNumCollected;
-        }
-    }
+    addState( CollectedState::YEAR_VECTOR, &aData );
 }
 
 template<typename DataType>
@@ -460,30 +990,24 @@ void ManageStateVariables::DoCollect::popFilterStep( const DataType& aData ) {
 
 template<>
 void ManageStateVariables::DoCollect::pushFilterStep<ITechnology*>( ITechnology* const& aData ) {
-    // Ignore any data set within a Technology that is not operating in the current
-    // model period.
-    if( !aData->isOperating( mParentClass->mPeriodToCollect ) ) {
-        mIgnoreCurrValue = true;
-    }
+    // Data set within a Technology is only active in periods it is operating.
+    mCurrTechnology = aData;
 }
 
 template<>
 void ManageStateVariables::DoCollect::popFilterStep<ITechnology*>( ITechnology* const& aData ) {
-    // Moving out of the current Technology so reset the ignore flag.
-    mIgnoreCurrValue = false;
+    // Moving out of the current Technology.
+    mCurrTechnology = 0;
 }
 
 template<>
 void ManageStateVariables::DoCollect::pushFilterStep<Market*>( Market* const& aData ) {
-    // Ignore any data set within a Market which is not for the current model year.
-    if( aData->getYear() != mParentClass->mYearToCollect ) {
-        mIgnoreCurrValue = true;
-    }
+    // Data set within a Market is only active in the year of that Market.
+    mCurrMarket = aData;
 }
 
 template<>
 void ManageStateVariables::DoCollect::popFilterStep<Market*>( Market* const& aData ) {
-    // Moving out of the current Market so reset the ignore flag.
-    mIgnoreCurrValue = false;
+    // Moving out of the current Market.
+    mCurrMarket = 0;
 }
-
@@ -0,0 +1,589 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*! 
+* \file xml_snapshot.cpp
+* \ingroup Objects
+* \brief XMLSnapshot class source file.
+*/
+
+#include "util/base/include/definitions.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <xercesc/dom/DOMDocument.hpp>
+#include <xercesc/dom/DOMElement.hpp>
+#include <xercesc/dom/DOMException.hpp>
+#include <xercesc/dom/DOMImplementation.hpp>
+#include <xercesc/dom/DOMNamedNodeMap.hpp>
+#include <xercesc/dom/DOMText.hpp>
+#include <xercesc/util/XMLString.hpp>
+#include <xercesc/util/XercesVersion.hpp>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if defined( _WIN32 )
+#include <process.h>
+#define getpid _getpid
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include "util/base/include/xml_snapshot.h"
+#include "util/base/include/configuration.h"
+#include "util/base/include/util.h"
+#include "util/logger/include/ilogger.h"
+
+using namespace std;
+using namespace xercesc;
+using boost::uint16_t;
+using boost::uint32_t;
+using boost::uint64_t;
+
+namespace {
+    //! The version of the snapshot format, increment when it changes.
+    const uint32_t SNAPSHOT_VERSION = 2;
+
+    /*!
+     * \brief Identifies the builds which may share snapshots.
+     * \details Snapshots hold XMLCh strings in the native byte order for the
+     *          DOM of the xerces version the model was built with, so builds
+     *          which differ in any of those write snapshots the other can not
+     *          use.
+     */
+    const char SNAPSHOT_BUILD[] = "xerces " XERCES_FULLVERSIONDOT;
+
+    //! The tokens which make up the node stream of a snapshot.
+    enum SnapshotToken {
+        END_ELEMENT = 0,
+        ELEMENT = 1,
+        TEXT = 2
+    };
+
+    //! The header at the start of every snapshot file.
+    struct SnapshotHeader {
+        //! Identifies the file as a snapshot.
+        char mMagic[ 8 ];
+
+        //! The version of the snapshot format.
+        uint32_t mVersion;
+
+        //! The number of strings in the name table.
+        uint32_t mNumNames;
+
+        //! The hash of SNAPSHOT_BUILD.
+        uint64_t mBuildHash;
+
+        //! The size of an XMLCh followed by a value which shows the byte order.
+        uint32_t mCharSize;
+        uint32_t mByteOrder;
+
+        //! The content hash of the XML file the snapshot was made from.
+        uint64_t mSourceHash;
+
+        //! The size in bytes of the XML file the snapshot was made from.
+        uint64_t mSourceSize;
+
+        //! The modification time in nanoseconds of the XML file the snapshot
+        //! was made from.
+        uint64_t mSourceModTime;
+    };
+
+    //! A value whose bytes differ in each byte order.
+    const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    const char SNAPSHOT_MAGIC[ 8 ] = { 'G', 'C', 'A', 'M', 'X', 'S', 'N', 'P' };
+
+    typedef basic_string<XMLCh> XMLChString;
+
+    //! Add bytes to a 64 bit FNV-1a hash.
+    void hashBytes( const char* aBytes, const size_t aCount, unsigned long long& aHash ) {
+        for( size_t i = 0; i < aCount; ++i ) {
+            aHash ^= static_cast<unsigned char>( aBytes[ i ] );
+            aHash *= 1099511628211ULL;
+        }
+    }
+
+    //! The starting value of a 64 bit FNV-1a hash.
+    const unsigned long long FNV_OFFSET_BASIS = 14695981039346656037ULL;
+
+    /*!
+     * \brief Get the size and modification time of a file without reading it.
+     * \param aFileName The name of the file.
+     * \param aSize The size of the file in bytes.
+     * \param aModTime The modification time of the file in nanoseconds, only
+     *        to the second where the platform does not provide more.
+     * \return Whether the file exists.
+     */
+    bool getFileStat( const string& aFileName, uint64_t& aSize, uint64_t& aModTime ) {
+#if defined( _WIN32 )
+        struct _stat64 fileStat;
+        if( _stat64( aFileName.c_str(), &fileStat ) != 0 ) {
+            return false;
+        }
+        aModTime = static_cast<uint64_t>( fileStat.st_mtime ) * 1000000000ULL;
+#else
+        struct stat fileStat;
+        if( stat( aFileName.c_str(), &fileStat ) != 0 ) {
+            return false;
+        }
+#if defined( __APPLE__ )
+        aModTime = static_cast<uint64_t>( fileStat.st_mtimespec.tv_sec ) * 1000000000ULL + fileStat.st_mtimespec.tv_nsec;
+#else
+        aModTime = static_cast<uint64_t>( fileStat.st_mtim.tv_sec ) * 1000000000ULL + fileStat.st_mtim.tv_nsec;
+#endif
+#endif
+        aSize = static_cast<uint64_t>( fileStat.st_size );
+        return true;
+    }
+
+    //! Get the hash of SNAPSHOT_BUILD.
+    uint64_t getBuildHash() {
+        unsigned long long hash = FNV_OFFSET_BASIS;
+        hashBytes( SNAPSHOT_BUILD, sizeof( SNAPSHOT_BUILD ), hash );
+        return hash;
+    }
+
+    /*!
+     * \brief A read only view of a whole file which is memory mapped where
+     *        possible and read into a buffer otherwise.
+     */
+    class MappedFile {
+    public:
+        explicit MappedFile( const string& aFileName ):mData( 0 ), mSize( 0 ) {
+#if defined( _WIN32 )
+            ifstream inFile( aFileName.c_str(), ios_base::in | ios_base::binary );
+            if( inFile.is_open() ) {
+                inFile.seekg( 0, ios_base::end );
+                mBuffer.resize( static_cast<size_t>( inFile.tellg() ) );
+                inFile.seekg( 0, ios_base::beg );
+                if( !mBuffer.empty() && inFile.read( &mBuffer[ 0 ], mBuffer.size() ) ) {
+                    mData = &mBuffer[ 0 ];
+                    mSize = mBuffer.size();
+                }
+            }
+#else
+            const int fd = open( aFileName.c_str(), O_RDONLY );
+            if( fd >= 0 ) {
+                struct stat fileStat;
+                if( fstat( fd, &fileStat ) == 0 && fileStat.st_size > 0 ) {
+                    void* data = mmap( 0, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+                    if( data != MAP_FAILED ) {
+                        mData = static_cast<const char*>( data );
+                        mSize = fileStat.st_size;
+                    }
+                }
+                // The mapping remains valid after the descriptor is closed.
+                close( fd );
+            }
+#endif
+        }
+
+        ~MappedFile() {
+#if !defined( _WIN32 )
+            if( mData ) {
+                munmap( const_cast<char*>( mData ), mSize );
+            }
+#endif
+        }
+
+        const char* getData() const {
+            return mData;
+        }
+
+        size_t getSize() const {
+            return mSize;
+        }
+    private:
+        //! The start of the file contents or null if it could not be read.
+        const char* mData;
+
+        //! The size of the file contents.
+        size_t mSize;
+
+#if defined( _WIN32 )
+        //! The file contents when they could not be mapped.
+        vector<char> mBuffer;
+#endif
+    };
+
+    /*!
+     * \brief Reads values from the node stream of a snapshot while checking
+     *        that no read goes past the end of the data.
+     */
+    class SnapshotReader {
+    public:
+        SnapshotReader( const char* aBegin, const char* aEnd ):mPos( aBegin ), mEnd( aEnd ) {}
+
+        template<typename T>
+        bool read( T& aValue ) {
+            if( static_cast<size_t>( mEnd - mPos ) < sizeof( T ) ) {
+                return false;
+            }
+            memcpy( &aValue, mPos, sizeof( T ) );
+            mPos += sizeof( T );
+            return true;
+        }
+
+        /*!
+         * \brief Read a null terminated string in place.
+         * \return A pointer to the string in the snapshot data or null if the
+         *         string is malformed.
+         */
+        const XMLCh* readString() {
+            uint32_t length;
+            if( !read( length ) || length == 0 ||
+                static_cast<size_t>( mEnd - mPos ) / sizeof( XMLCh ) < length )
+            {
+                return 0;
+            }
+            const XMLCh* str = reinterpret_cast<const XMLCh*>( mPos );
+            mPos += length * sizeof( XMLCh );
+            return str[ length - 1 ] == 0 ? str : 0;
+        }
+
+        bool isAtEnd() const {
+            return mPos == mEnd;
+        }
+    private:
+        //! The current read position.
+        const char* mPos;
+
+        //! The end of the data.
+        const char* mEnd;
+    };
+
+    template<typename T>
+    void writeValue( string& aBuffer, const T aValue ) {
+        aBuffer.append( reinterpret_cast<const char*>( &aValue ), sizeof( T ) );
+    }
+
+    void writeString( string& aBuffer, const XMLCh* aString ) {
+        // Include the null terminator so the string may be used in place.
+        const uint32_t length = static_cast<uint32_t>( XMLString::stringLen( aString ) + 1 );
+        writeValue( aBuffer, length );
+        aBuffer.append( reinterpret_cast<const char*>( aString ), length * sizeof( XMLCh ) );
+    }
+
+    /*!
+     * \brief A table of the distinct element and attribute names in a document.
+     */
+    class NameTable {
+    public:
+        uint32_t getIndex( const XMLCh* aName ) {
+            map<XMLChString, uint32_t>::const_iterator iter = mIndices.find( aName );
+            if( iter != mIndices.end() ) {
+                return iter->second;
+            }
+            const uint32_t index = static_cast<uint32_t>( mNames.size() );
+            mIndices[ aName ] = index;
+            mNames.push_back( aName );
+            return index;
+        }
+
+        //! The names in the order they were added.
+        vector<const XMLCh*> mNames;
+    private:
+        //! Map of name to index in mNames.
+        map<XMLChString, uint32_t> mIndices;
+    };
+
+    /*!
+     * \brief Write a node and all of its children to the node stream.
+     * \details Only element and text nodes are written as the parser does not
+     *          create any other kind of node which the model would read.
+     * \param aNode The node to write.
+     * \param aNames The table of names to add element and attribute names to.
+     * \param aBuffer The node stream to write to.
+     */
+    void writeNode( const DOMNode* aNode, NameTable& aNames, string& aBuffer ) {
+        const short nodeType = aNode->getNodeType();
+        if( nodeType == DOMNode::ELEMENT_NODE ) {
+            writeValue( aBuffer, static_cast<uint16_t>( ELEMENT ) );
+            writeValue( aBuffer, aNames.getIndex( aNode->getNodeName() ) );
+            const DOMNamedNodeMap* attrs = aNode->getAttributes();
+            const uint32_t numAttrs = static_cast<uint32_t>( attrs->getLength() );
+            writeValue( aBuffer, numAttrs );
+            for( uint32_t i = 0; i < numAttrs; ++i ) {
+                const DOMNode* attr = attrs->item( i );
+                writeValue( aBuffer, aNames.getIndex( attr->getNodeName() ) );
+                writeString( aBuffer, attr->getNodeValue() );
+            }
+            for( const DOMNode* child = aNode->getFirstChild(); child; child = child->getNextSibling() ) {
+                writeNode( child, aNames, aBuffer );
+            }
+            writeValue( aBuffer, static_cast<uint16_t>( END_ELEMENT ) );
+        }
+        else if( nodeType == DOMNode::TEXT_NODE || nodeType == DOMNode::CDATA_SECTION_NODE ) {
+            writeValue( aBuffer, static_cast<uint16_t>( TEXT ) );
+            writeString( aBuffer, aNode->getNodeValue() );
+        }
+    }
+}
+
+/*!
+ * \brief Rebuild the DOM document for an XML file from its snapshot.
+ * \details The snapshot is only used if snapshots are enabled, it was written
+ *          by a compatible build, and the XML file has not changed since.  The
+ *          XML file is assumed unchanged without reading it if its size and
+ *          modification time match those recorded in the snapshot.  If only
+ *          the modification time differs, for instance because the file was
+ *          copied, the content hash is compared instead.
+ * \param aXMLFile The name of the XML file.
+ * \return A new document which the caller must release, or null if no up to
+ *         date snapshot was found.
+ */
+DOMDocument* XMLSnapshot::loadSnapshot( const string& aXMLFile ) {
+    if( !isEnabled() ) {
+        return 0;
+    }
+
+    const string snapshotFileName = getSnapshotFileName( aXMLFile );
+    MappedFile snapshot( snapshotFileName );
+    if( snapshot.getSize() < sizeof( SnapshotHeader ) ) {
+        return 0;
+    }
+
+    SnapshotHeader header;
+    memcpy( &header, snapshot.getData(), sizeof( SnapshotHeader ) );
+    uint64_t sourceSize;
+    uint64_t sourceModTime;
+    if( memcmp( header.mMagic, SNAPSHOT_MAGIC, sizeof( SNAPSHOT_MAGIC ) ) != 0 ||
+        header.mVersion != SNAPSHOT_VERSION || header.mBuildHash != getBuildHash() ||
+        header.mCharSize != sizeof( XMLCh ) || header.mByteOrder != BYTE_ORDER_MARK ||
+        !getFileStat( aXMLFile, sourceSize, sourceModTime ) || header.mSourceSize != sourceSize )
+    {
+        return 0;
+    }
+    if( header.mSourceModTime != sourceModTime ) {
+        unsigned long long sourceHash;
+        unsigned long long hashedSize;
+        if( !hashFile( aXMLFile, sourceHash, hashedSize ) ||
+            header.mSourceHash != sourceHash || header.mSourceSize != hashedSize )
+        {
+            return 0;
+        }
+    }
+
+    SnapshotReader reader( snapshot.getData() + sizeof( SnapshotHeader ),
+                           snapshot.getData() + snapshot.getSize() );
+    bool isValid = true;
+    vector<const XMLCh*> names( header.mNumNames );
+    for( uint32_t i = 0; isValid && i < header.mNumNames; ++i ) {
+        names[ i ] = reader.readString();
+        isValid = names[ i ] != 0;
+    }
+
+    DOMDocument* doc = DOMImplementation::getImplementation()->createDocument();
+    XMLCh* documentURI = XMLString::transcode( aXMLFile.c_str() );
+    doc->setDocumentURI( documentURI );
+    XMLString::release( &documentURI );
+
+    try {
+        DOMNode* parent = doc;
+        uint16_t token;
+        while( isValid && reader.read( token ) ) {
+            if( token == ELEMENT ) {
+                uint32_t nameIndex;
+                uint32_t numAttrs;
+                isValid = reader.read( nameIndex ) && nameIndex < names.size() && reader.read( numAttrs );
+                if( isValid ) {
+                    DOMElement* element = doc->createElement( names[ nameIndex ] );
+                    for( uint32_t i = 0; isValid && i < numAttrs; ++i ) {
+                        uint32_t attrIndex;
+                        const XMLCh* attrValue;
+                        isValid = reader.read( attrIndex ) && attrIndex < names.size() &&
+                                  ( attrValue = reader.readString() ) != 0;
+                        if( isValid ) {
+                            element->setAttribute( names[ attrIndex ], attrValue );
+                        }
+                    }
+                    parent->appendChild( element );
+                    parent = element;
+                }
+            }
+            else if( token == TEXT ) {
+                const XMLCh* text = reader.readString();
+                isValid = text && parent != doc;
+                if( isValid ) {
+                    parent->appendChild( doc->createTextNode( text ) );
+                }
+            }
+            else if( token == END_ELEMENT && parent != doc ) {
+                parent = parent->getParentNode();
+            }
+            else {
+                isValid = false;
+            }
+        }
+        isValid = isValid && parent == doc && reader.isAtEnd() && doc->getDocumentElement();
+    }
+    catch( const DOMException& ) {
+        isValid = false;
+    }
+
+    if( !isValid ) {
+        doc->release();
+        ILogger& mainLog = ILogger::getLogger( "main_log" );
+        mainLog.setLevel( ILogger::WARNING );
+        mainLog << "Ignoring malformed XML snapshot " << snapshotFileName << "." << endl;
+        return 0;
+    }
+    return doc;
+}
+
+/*!
+ * \brief Write a snapshot of a parsed XML file.
+ * \details The snapshot is written to a temporary file first and then renamed
+ *          so that other processes never read a partially written snapshot.
+ * \param aXMLFile The name of the XML file which was parsed.
+ * \param aDocument The document the parser created from the XML file.
+ */
+void XMLSnapshot::saveSnapshot( const string& aXMLFile, const DOMDocument* aDocument ) {
+    if( !isEnabled() || !aDocument || !aDocument->getDocumentElement() ) {
+        return;
+    }
+
+    SnapshotHeader header;
+    unsigned long long sourceHash;
+    unsigned long long sourceSize;
+    uint64_t statSize;
+    uint64_t sourceModTime;
+    // The modification time is taken first so that a change while the file
+    // is being hashed makes the snapshot look out of date rather than current.
+    if( !getFileStat( aXMLFile, statSize, sourceModTime ) ||
+        !hashFile( aXMLFile, sourceHash, sourceSize ) )
+    {
+        return;
+    }
+
+    NameTable names;
+    string nodes;
+    writeNode( aDocument->getDocumentElement(), names, nodes );
+
+    memcpy( header.mMagic, SNAPSHOT_MAGIC, sizeof( SNAPSHOT_MAGIC ) );
+    header.mVersion = SNAPSHOT_VERSION;
+    header.mNumNames = static_cast<uint32_t>( names.mNames.size() );
+    header.mBuildHash = getBuildHash();
+    header.mCharSize = sizeof( XMLCh );
+    header.mByteOrder = BYTE_ORDER_MARK;
+    header.mSourceHash = sourceHash;
+    header.mSourceSize = sourceSize;
+    header.mSourceModTime = sourceModTime;
+
+    string nameTable;
+    for( vector<const XMLCh*>::const_iterator name = names.mNames.begin(); name != names.mNames.end(); ++name ) {
+        writeString( nameTable, *name );
+    }
+
+    const string snapshotFileName = getSnapshotFileName( aXMLFile );
+    const string tempFileName = snapshotFileName + "." + util::toString( getpid() ) + ".tmp";
+    ofstream snapshotFile( tempFileName.c_str(), ios_base::out | ios_base::binary );
+    if( !snapshotFile.is_open() ) {
+        ILogger& mainLog = ILogger::getLogger( "main_log" );
+        mainLog.setLevel( ILogger::WARNING );
+        mainLog << "Could not open XML snapshot " << tempFileName << " for write." << endl;
+        return;
+    }
+    snapshotFile.write( reinterpret_cast<const char*>( &header ), sizeof( SnapshotHeader ) );
+    snapshotFile.write( nameTable.data(), nameTable.size() );
+    snapshotFile.write( nodes.data(), nodes.size() );
+    snapshotFile.close();
+    if( !snapshotFile ) {
+        remove( tempFileName.c_str() );
+        return;
+    }
+
+    remove( snapshotFileName.c_str() );
+    if( rename( tempFileName.c_str(), snapshotFileName.c_str() ) != 0 ) {
+        remove( tempFileName.c_str() );
+    }
+}
+
+/*!
+ * \brief Check the configuration for whether snapshots should be used.
+ * \return True if snapshots should be loaded and saved.
+ */
+bool XMLSnapshot::isEnabled() {
+    return Configuration::getInstance()->shouldWriteFile( "xml-snapshot-dir", false, false );
+}
+
+/*!
+ * \brief Get the name of the snapshot file for an XML file.
+ * \details The path of the XML file is flattened into a single file name
+ *          within the configured snapshot directory.
+ * \param aXMLFile The name of the XML file.
+ * \return The name of the snapshot file.
+ */
+string XMLSnapshot::getSnapshotFileName( const string& aXMLFile ) {
+    string flatName = aXMLFile;
+    for( string::iterator currChar = flatName.begin(); currChar != flatName.end(); ++currChar ) {
+        if( *currChar == '/' || *currChar == '\\' || *currChar == ':' ) {
+            *currChar = '_';
+        }
+    }
+    const string snapshotDir = Configuration::getInstance()->getFile( "xml-snapshot-dir", "xml-snapshots" );
+    return snapshotDir + "/" + flatName + ".snap";
+}
+
+/*!
+ * \brief Compute the 64 bit FNV-1a hash of the contents of a file.
+ * \param aFileName The name of the file to hash.
+ * \param aHash The hash of the contents.
+ * \param aSize The size of the file in bytes.
+ * \return Whether the file could be read.
+ */
+bool XMLSnapshot::hashFile( const string& aFileName,
+                            unsigned long long& aHash,
+                            unsigned long long& aSize )
+{
+    ifstream inFile( aFileName.c_str(), ios_base::in | ios_base::binary );
+    if( !inFile.is_open() ) {
+        return false;
+    }
+
+    aHash = FNV_OFFSET_BASIS;
+    aSize = 0;
+    vector<char> buffer( 1 << 16 );
+    while( inFile ) {
+        inFile.read( &buffer[ 0 ], buffer.size() );
+        const streamsize numRead = inFile.gcount();
+        hashBytes( &buffer[ 0 ], static_cast<size_t>( numRead ), aHash );
+        aSize += numRead;
+    }
+    return true;
+}
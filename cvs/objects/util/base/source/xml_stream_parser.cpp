@@ -0,0 +1,351 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*! 
+* \file xml_stream_parser.cpp
+* \ingroup Objects
+* \brief XMLStreamParser class source file.
+*/
+
+#include "util/base/include/definitions.h"
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/lexical_cast.hpp>
+#include <xercesc/dom/DOMDocument.hpp>
+#include <xercesc/dom/DOMElement.hpp>
+#include <xercesc/dom/DOMException.hpp>
+#include <xercesc/dom/DOMImplementation.hpp>
+#include <xercesc/dom/DOMText.hpp>
+#include <xercesc/sax/SAXParseException.hpp>
+#include <xercesc/sax2/Attributes.hpp>
+#include <xercesc/sax2/DefaultHandler.hpp>
+#include <xercesc/sax2/SAX2XMLReader.hpp>
+#include <xercesc/sax2/XMLReaderFactory.hpp>
+#include <xercesc/util/XMLString.hpp>
+#include <xercesc/util/XMLUni.hpp>
+
+#include "util/base/include/xml_stream_parser.h"
+#include "util/base/include/iparsable.h"
+#include "util/base/include/xml_helper.h"
+
+using namespace std;
+using namespace xercesc;
+
+namespace {
+    typedef basic_string<XMLCh> XMLChString;
+
+    //! An element above the chunk depth which is still open.
+    struct OpenElement {
+        //! The element name.
+        XMLChString mName;
+
+        //! The names and values of all of the attributes of the element.
+        vector<pair<XMLChString, XMLChString> > mAttributes;
+
+        //! The text of the element, only kept while it has no child elements.
+        XMLChString mText;
+
+        //! Whether a child element has been started.
+        bool mHasChildElements;
+    };
+
+    //! Transcode a name into an XMLChString.
+    XMLChString transcodeName( const char* aName ) {
+        XMLCh* transcoded = XMLString::transcode( aName );
+        XMLChString name( transcoded );
+        XMLString::release( &transcoded );
+        return name;
+    }
+
+    /*!
+     * \brief SAX handler which builds and dispatches one chunk at a time.
+     * \details An element above the chunk depth with the delete attribute set is
+     *          passed on whole as a single chunk so that it is deleted once
+     *          rather than once for each of its children.
+     */
+    class ChunkHandler : public DefaultHandler {
+    public:
+        ChunkHandler( const string& aXMLFile, IParsable* aModelElement, const size_t aChunkDepth ):
+        mXMLFile( aXMLFile ),
+        mModelElement( aModelElement ),
+        mChunkDepth( aChunkDepth ),
+        mDepth( 0 ),
+        mChunkDocument( 0 ),
+        mCurrNode( 0 ),
+        mChunkStart( 0 ),
+        mSuccess( true ),
+        mDeleteAttr( transcodeName( "delete" ) )
+        {
+            // The attributes by which XMLParse finds an existing object, or
+            // decides whether to create it, which are safe to apply repeatedly.
+            mCopiedAttrs.push_back( transcodeName( "name" ) );
+            mCopiedAttrs.push_back( transcodeName( "type" ) );
+            mCopiedAttrs.push_back( transcodeName( "year" ) );
+            mCopiedAttrs.push_back( transcodeName( "nocreate" ) );
+        }
+
+        ~ChunkHandler() {
+            if( mChunkDocument ) {
+                mChunkDocument->release();
+            }
+        }
+
+        virtual void startElement( const XMLCh* const aURI,
+                                   const XMLCh* const aLocalName,
+                                   const XMLCh* const aQName,
+                                   const Attributes& aAttributes )
+        {
+            if( !mChunkDocument && mDepth < mChunkDepth && !isDeleted( aAttributes ) ) {
+                markHasChildElements();
+                OpenElement newElement;
+                newElement.mName = aQName;
+                for( XMLSize_t i = 0; i < aAttributes.getLength(); ++i ) {
+                    newElement.mAttributes.push_back( make_pair( XMLChString( aAttributes.getQName( i ) ),
+                                                                 XMLChString( aAttributes.getValue( i ) ) ) );
+                }
+                newElement.mHasChildElements = false;
+                mOpenElements.push_back( newElement );
+            }
+            else {
+                if( !mChunkDocument ) {
+                    markHasChildElements();
+                    startChunk( false );
+                    mChunkStart = mDepth;
+                }
+                else {
+                    flushText();
+                }
+                DOMElement* element = mChunkDocument->createElement( aQName );
+                for( XMLSize_t i = 0; i < aAttributes.getLength(); ++i ) {
+                    element->setAttribute( aAttributes.getQName( i ), aAttributes.getValue( i ) );
+                }
+                mCurrNode->appendChild( element );
+                mCurrNode = element;
+            }
+            ++mDepth;
+        }
+
+        virtual void endElement( const XMLCh* const aURI,
+                                 const XMLCh* const aLocalName,
+                                 const XMLCh* const aQName )
+        {
+            --mDepth;
+            if( mChunkDocument ) {
+                flushText();
+                mCurrNode = mCurrNode->getParentNode();
+                if( mDepth == mChunkStart ) {
+                    finishChunk();
+                }
+            }
+            else {
+                // Elements above the chunk depth are only passed on through
+                // their children unless they do not have any, in which case
+                // the element is passed on whole as a chunk.
+                if( !mOpenElements.back().mHasChildElements ) {
+                    startChunk( true );
+                    mText.swap( mOpenElements.back().mText );
+                    flushText();
+                    finishChunk();
+                }
+                mOpenElements.pop_back();
+            }
+        }
+
+        virtual void characters( const XMLCh* const aChars, const XMLSize_t aLength ) {
+            if( mChunkDocument ) {
+                mText.append( aChars, aLength );
+            }
+            else if( !mOpenElements.empty() && !mOpenElements.back().mHasChildElements ) {
+                mOpenElements.back().mText.append( aChars, aLength );
+            }
+        }
+
+        bool isSuccessful() const {
+            return mSuccess;
+        }
+    private:
+        //! The name of the file being parsed.
+        const string mXMLFile;
+
+        //! The object to pass each chunk to.
+        IParsable* mModelElement;
+
+        //! The depth of the elements which are parsed as separate chunks.
+        const size_t mChunkDepth;
+
+        //! The number of currently open elements.
+        size_t mDepth;
+
+        //! The elements above the chunk depth which are currently open.
+        vector<OpenElement> mOpenElements;
+
+        //! The document holding the current chunk.
+        DOMDocument* mChunkDocument;
+
+        //! The node in the current chunk new nodes are added to.
+        DOMNode* mCurrNode;
+
+        //! The depth of the element the current chunk was started for.
+        size_t mChunkStart;
+
+        //! Text in the current chunk which has not been added as a node yet.
+        XMLChString mText;
+
+        //! Whether parsing all chunks so far succeeded.
+        bool mSuccess;
+
+        //! The name of the delete attribute.
+        const XMLChString mDeleteAttr;
+
+        //! The names of the attributes copied to the ancestors in each chunk.
+        vector<XMLChString> mCopiedAttrs;
+
+        //! Whether an element has the delete attribute set.
+        bool isDeleted( const Attributes& aAttributes ) const {
+            const XMLCh* value = aAttributes.getValue( mDeleteAttr.c_str() );
+            if( !value ) {
+                return false;
+            }
+            // Interpret the value the same way XMLHelper<bool>::getAttr does.
+            try {
+                return boost::lexical_cast<bool>( XMLHelper<string>::safeTranscode( value ) );
+            }
+            catch( boost::bad_lexical_cast& ) {
+                return false;
+            }
+        }
+
+        void markHasChildElements() {
+            if( !mOpenElements.empty() && !mOpenElements.back().mHasChildElements ) {
+                mOpenElements.back().mHasChildElements = true;
+                mOpenElements.back().mText.clear();
+            }
+        }
+
+        /*!
+         * \brief Create a new chunk document containing copies of the open
+         *        elements above the chunk depth.
+         * \details Ancestors of the chunk only get the attributes in
+         *          mCopiedAttrs since they are applied once for each chunk.
+         * \param aLastIsLeaf Whether the innermost open element is itself the
+         *        chunk, in which case all of its attributes are copied.
+         */
+        void startChunk( const bool aLastIsLeaf ) {
+            mChunkDocument = DOMImplementation::getImplementation()->createDocument();
+            XMLCh* documentURI = XMLString::transcode( mXMLFile.c_str() );
+            mChunkDocument->setDocumentURI( documentURI );
+            XMLString::release( &documentURI );
+
+            mCurrNode = mChunkDocument;
+            for( vector<OpenElement>::const_iterator ancestor = mOpenElements.begin(); ancestor != mOpenElements.end(); ++ancestor ) {
+                const bool isLeaf = aLastIsLeaf && ancestor + 1 == mOpenElements.end();
+                DOMElement* element = mChunkDocument->createElement( ancestor->mName.c_str() );
+                for( vector<pair<XMLChString, XMLChString> >::const_iterator attr = ancestor->mAttributes.begin();
+                     attr != ancestor->mAttributes.end(); ++attr )
+                {
+                    if( isLeaf || find( mCopiedAttrs.begin(), mCopiedAttrs.end(), attr->first ) != mCopiedAttrs.end() ) {
+                        element->setAttribute( attr->first.c_str(), attr->second.c_str() );
+                    }
+                }
+                mCurrNode->appendChild( element );
+                mCurrNode = element;
+            }
+        }
+
+        /*!
+         * \brief Pass the current chunk to the model and release it.
+         */
+        void finishChunk() {
+            mSuccess &= mModelElement->XMLParse( mChunkDocument->getDocumentElement() );
+            mChunkDocument->release();
+            mChunkDocument = 0;
+            mCurrNode = 0;
+        }
+
+        /*!
+         * \brief Add any pending text to the current node of the chunk.
+         */
+        void flushText() {
+            if( !mText.empty() ) {
+                mCurrNode->appendChild( mChunkDocument->createTextNode( mText.c_str() ) );
+                mText.clear();
+            }
+        }
+    };
+}
+
+/*!
+ * \brief Parse an XML file in chunks with a streaming parser.
+ * \details The parser is configured with the same validation settings as the
+ *          DOM parser used by XMLHelper.
+ * \param aXMLFile The name of the file to parse.
+ * \param aModelElement Element to call XMLParse on for each chunk.
+ * \param aChunkDepth The depth of the elements to parse as separate chunks,
+ *        where the root element is at depth zero.
+ * \return Whether parsing was successful.
+ */
+bool XMLStreamParser::parseXML( const string& aXMLFile,
+                                IParsable* aModelElement,
+                                const int aChunkDepth )
+{
+    auto_ptr<SAX2XMLReader> reader( XMLReaderFactory::createXMLReader() );
+    reader->setFeature( XMLUni::fgSAX2CoreNameSpaces, false );
+    reader->setFeature( XMLUni::fgSAX2CoreValidation, true );
+    reader->setFeature( XMLUni::fgXercesDynamic, false );
+    reader->setFeature( XMLUni::fgXercesSchema, true );
+
+    ChunkHandler handler( aXMLFile, aModelElement, aChunkDepth );
+    reader->setContentHandler( &handler );
+    reader->setErrorHandler( &handler );
+    try {
+        reader->parse( aXMLFile.c_str() );
+    } catch ( const XMLException& toCatch ) {
+        string message = XMLHelper<string>::safeTranscode( toCatch.getMessage() );
+        cout << "ERROR: XML Read Exception message is:" << endl << message << endl;
+        return false;
+    } catch ( const DOMException& toCatch ) {
+        string message = XMLHelper<string>::safeTranscode( toCatch.msg );
+        cout << "ERROR: XML Read Exception message is:" << endl << message << endl;
+        return false;
+    } catch ( const SAXException& toCatch ){
+        string message = XMLHelper<string>::safeTranscode( toCatch.getMessage() );
+        cout << "ERROR: XML Read Exception message is:" << endl << message << endl;
+        return false;
+    } catch (...) {
+        cout << "ERROR:Unexpected XML Read Exception." << endl;
+        return false;
+    }
+    return handler.isSuccessful();
+}
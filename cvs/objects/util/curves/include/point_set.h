@@ -60,6 +60,7 @@ class DataPoint;
 
 // Need to forward declare the subclasses as well.
 class ExplicitPointSet;
+class SortedPointSet;
 
 /*!
 * \ingroup Util
@@ -108,7 +109,7 @@ protected:
         /* Declare all subclasses of PointSet to allow automatic traversal of the
          * hierarchy under introspection.
          */
-        DEFINE_SUBCLASS_FAMILY( PointSet, ExplicitPointSet )
+        DEFINE_SUBCLASS_FAMILY( PointSet, ExplicitPointSet, SortedPointSet )
     )
 
     virtual void print( std::ostream& out, const double lowDomain = -DBL_MAX, const double highDomain = DBL_MAX,
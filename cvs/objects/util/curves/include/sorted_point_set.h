@@ -0,0 +1,127 @@
+#ifndef _SORTED_POINT_SET_H_
+#define _SORTED_POINT_SET_H_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*! 
+* \file sorted_point_set.h
+* \ingroup Util
+* \brief The SortedPointSet class header file.
+*/
+
+#include <vector>
+#include <iosfwd>
+#include <string>
+#include <cfloat>
+#include <xercesc/dom/DOMNode.hpp>
+#include "util/curves/include/point_set.h"
+
+class Tabs;
+class DataPoint;
+
+/*!
+* \ingroup Util
+* \brief A PointSet subclass which stores its points as contiguous arrays of x
+*        and y values kept sorted by x.
+* \details Lookups by x are binary searches rather than the linear scans
+*          ExplicitPointSet performs over individually allocated DataPoints
+*          which makes this the better choice for curves which are evaluated
+*          during World.calc such as MAC curves.  Only a single point is kept
+*          for each x value, matching the behavior of ExplicitPointSet where a
+*          later point with the same x could never be found.  Lookups by y are
+*          still linear as the y values are not necessarily monotonic.
+*/
+class SortedPointSet: public PointSet {
+    friend std::ostream& operator<<( std::ostream& os, const SortedPointSet& pointSet ) {
+        pointSet.print( os );
+        return os;
+    }
+public:
+    SortedPointSet();
+    ~SortedPointSet();
+    bool operator==( const SortedPointSet& rhs ) const;
+    bool operator!=( const SortedPointSet& rhs ) const;
+    SortedPointSet* clone() const;
+    static const std::string& getXMLNameStatic();
+    bool addPoint( DataPoint* dataPoint );
+    double getY( const double xValue ) const;
+    double getX( const double yValue ) const;
+    bool setY( const double xValue, const double yValue );
+    bool setX( const double yValue, const double xValue );
+    bool removePointFindX( const double xValue );
+    bool removePointFindY( const double yValue );
+    double getMaxX() const;
+    double getMaxY() const;
+    double getMinX() const;
+    double getMinY() const;
+    std::vector<std::pair<double,double> > getSortedPairs( const double lowDomain = -DBL_MAX, const double highDomain = DBL_MAX, const int minPoints = 0 ) const;
+    bool containsX( const double x ) const;
+    bool containsY( const double y ) const;
+    double getNearestXBelow( const double x ) const;
+    double getNearestXAbove( const double x ) const;
+    double getNearestYBelow( const double x ) const;
+    double getNearestYAbove( const double x ) const;
+    void outputAsXML( std::ostream& aOut, Tabs* aTabs ) const;
+    void XMLParse( const xercesc::DOMNode* node );
+    void invertAxises();
+    
+    double interpolateY( const double aX ) const;
+    void interpolateY( const double* aX, double* aY, const size_t aNumValues ) const;
+protected:
+    
+    // Define data such that introspection utilities can process the data from this
+    // subclass together with the data members of the parent classes.
+    DEFINE_DATA_WITH_PARENT(
+        PointSet,
+        
+        //! The x values in increasing order.
+        DEFINE_VARIABLE( ARRAY, "x", mX, std::vector<double> ),
+        
+        //! The y value for each x value.
+        DEFINE_VARIABLE( ARRAY, "y", mY, std::vector<double> )
+    )
+    
+    const std::string& getXMLName() const;
+    size_t findX( const double xValue ) const;
+    size_t findY( const double yValue ) const;
+    void insert( const double xValue, const double yValue );
+    void erase( const size_t aIndex );
+    void sortByX();
+    void print( std::ostream& out, const double lowDomain = -DBL_MAX, const double highDomain = DBL_MAX,
+        const double lowRange = -DBL_MAX, const double highRange = DBL_MAX, const int minPoints = 0 ) const;
+};
+#endif // _SORTED_POINT_SET_H_
@@ -42,6 +42,7 @@
 #include <iostream>
 #include "util/curves/include/point_set.h"
 #include "util/curves/include/explicit_point_set.h"
+#include "util/curves/include/sorted_point_set.h"
 
 using namespace std;
 
@@ -71,6 +72,9 @@ PointSet* PointSet::getPointSet( const string& type ) {
     if( type == ExplicitPointSet::getXMLNameStatic() ){
         pointSet = new ExplicitPointSet();
     } 
+    else if( type == SortedPointSet::getXMLNameStatic() ){
+        pointSet = new SortedPointSet();
+    }
     else {
         cout << "Invalid type of " << getXMLNameStatic() << " requested: " << type << "." << endl;
         pointSet = 0;
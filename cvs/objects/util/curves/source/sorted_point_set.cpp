@@ -0,0 +1,430 @@
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+* \file sorted_point_set.cpp
+* \ingroup Util
+* \brief SortedPointSet class source file.
+*/
+
+#include "util/base/include/definitions.h"
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <xercesc/dom/DOMNode.hpp>
+#include <xercesc/dom/DOMNodeList.hpp>
+#include "util/base/include/xml_helper.h"
+#include "util/curves/include/sorted_point_set.h"
+#include "util/curves/include/data_point.h"
+#include "util/curves/include/xy_data_point.h"
+#include "util/base/include/util.h"
+
+using namespace std;
+
+//! Constructor
+SortedPointSet::SortedPointSet() {
+}
+
+//! Destructor
+SortedPointSet::~SortedPointSet(){
+}
+
+//! Equals operator
+bool SortedPointSet::operator==( const SortedPointSet& rhs ) const {
+    return( getSortedPairs() == rhs.getSortedPairs() );
+}
+
+//! Inequality operator
+bool SortedPointSet::operator!=( const SortedPointSet& rhs ) const {
+    return !( *this == rhs );
+}
+
+//! Return a copy of the PointSet
+SortedPointSet* SortedPointSet::clone() const {
+    SortedPointSet* clone = new SortedPointSet();
+    clone->mX = mX;
+    clone->mY = mY;
+    return clone;
+}
+
+//! Static function to return the name of the XML element associated with this object.
+const string& SortedPointSet::getXMLNameStatic() {
+    static const string XML_NAME = "SortedPointSet";
+    return XML_NAME;
+}
+
+//! Return the name of the XML element associated with this object.
+const string& SortedPointSet::getXMLName() const {
+    return getXMLNameStatic();
+}
+
+/*!
+ * \brief Add a new data point to the point set.
+ * \details Only the coordinates of the point are kept so the point set takes
+ *          ownership of the point and deletes it.
+ * \param pointIn The point to add.
+ * \return True if the point was added, false if a point with the same x
+ *         value already exists.
+ */
+bool SortedPointSet::addPoint( DataPoint* pointIn ) {
+    const double xValue = pointIn->getX();
+    const double yValue = pointIn->getY();
+    delete pointIn;
+
+    vector<double>::const_iterator pos = lower_bound( mX.begin(), mX.end(), xValue );
+    if( pos != mX.end() && *pos == xValue ){
+        return false;
+    }
+    insert( xValue, yValue );
+    return true;
+}
+
+//! Return the y coordinate associated with this xValue, DBL_MAX if the point is not found.
+double SortedPointSet::getY( const double xValue ) const {
+    const size_t pos = findX( xValue );
+    return pos != mX.size() ? mY[ pos ] : DBL_MAX;
+}
+
+//! Return the x coordinate associated with this yValue, DBL_MAX if the point is not found.
+double SortedPointSet::getX( const double yValue ) const {
+    const size_t pos = findY( yValue );
+    return pos != mY.size() ? mX[ pos ] : DBL_MAX;
+}
+
+//! Set the y value for the point associated with the xValue. Return true if successful
+bool SortedPointSet::setY( const double xValue, const double yValue ){
+    const size_t pos = findX( xValue );
+    if( pos != mX.size() ){
+        mY[ pos ] = yValue;
+    }
+    return pos != mX.size();
+}
+
+//! Set the x value for the point associated with the yValue. Return true if successful
+bool SortedPointSet::setX( const double yValue, const double xValue ){
+    const size_t pos = findY( yValue );
+    if( pos != mY.size() ){
+        mX[ pos ] = xValue;
+        sortByX();
+    }
+    return pos != mY.size();
+}
+
+//! Remove a data point from the point set based on an x value.
+bool SortedPointSet::removePointFindX( const double xValue ){
+    const size_t pos = findX( xValue );
+    if( pos != mX.size() ){
+        erase( pos );
+        return true;
+    }
+    return false;
+}
+
+//! Remove a data point from the point set based on a y value.
+bool SortedPointSet::removePointFindY( const double yValue ){
+    const size_t pos = findY( yValue );
+    if( pos != mY.size() ){
+        erase( pos );
+        return true;
+    }
+    return false;
+}
+
+/*! \brief Return the maximum X value in this point set.
+*  Returns -DBL_MAX as an error code if there are no points in this curve
+*/
+double SortedPointSet::getMaxX() const {
+    return !mX.empty() ? mX.back() : -DBL_MAX;
+}
+
+/*! \brief Return the Y value of the point with the maximum X value.
+*  Returns -DBL_MAX as an error code if there are no points in this curve
+* \note This matches ExplicitPointSet which also returns the Y value at the
+*       maximum X.
+*/
+double SortedPointSet::getMaxY() const {
+    return !mY.empty() ? mY.back() : -DBL_MAX;
+}
+
+/*! \brief Return the minimum X value in this point set.
+*  Returns DBL_MAX as an error code if there are no points in this curve
+*/
+double SortedPointSet::getMinX() const {
+    return !mX.empty() ? mX.front() : DBL_MAX;
+}
+
+/*! \brief Return the Y value of the point with the minimum X value.
+*  Returns DBL_MAX as an error code if there are no points in this curve
+* \note This matches ExplicitPointSet which also returns the Y value at the
+*       minimum X.
+*/
+double SortedPointSet::getMinY() const {
+    return !mY.empty() ? mY.front() : DBL_MAX;
+}
+
+//! Return a vector of pairs of x y coordinates sorted in increasing x order.
+SortedPointSet::SortedPairVector SortedPointSet::getSortedPairs( const double lowDomain, const double highDomain, const int minPoints ) const {
+    vector<pair<double,double> > sortedPoints;
+    sortedPoints.reserve( mX.size() );
+    for( size_t i = 0; i < mX.size(); ++i ){
+        // Check if it is within the requested domain.
+        if( ( mX[ i ] >= lowDomain ) && ( mX[ i ] <= highDomain ) ){
+            sortedPoints.push_back( pair<double,double>( mX[ i ], mY[ i ] ) );
+        }
+    }
+    return sortedPoints;
+}
+
+//! Returns whether the point set contains a point with the given x value.
+bool SortedPointSet::containsX( const double x ) const {
+    return findX( x ) != mX.size();
+}
+
+//! Returns whether the point set contains a point with the given y value.
+bool SortedPointSet::containsY( const double y ) const {
+    return findY( y ) != mY.size();
+}
+
+//! Determines the x coordinate of the nearest point below x.
+double SortedPointSet::getNearestXBelow( const double x ) const {
+    vector<double>::const_iterator pos = lower_bound( mX.begin(), mX.end(), x );
+    return pos != mX.begin() ? *( pos - 1 ) : -DBL_MAX;
+}
+
+//! Determines the x coordinate of the nearest point above x.
+double SortedPointSet::getNearestXAbove( const double x ) const {
+    vector<double>::const_iterator pos = upper_bound( mX.begin(), mX.end(), x );
+    return pos != mX.end() ? *pos : DBL_MAX;
+}
+
+//! Determines the y coordinate of the nearest point below y.
+double SortedPointSet::getNearestYBelow( const double y ) const {
+    double closestY = -DBL_MAX;
+    for( size_t i = 0; i < mY.size(); ++i ){
+        if( ( mY[ i ] < y ) && ( fabs( y - mY[ i ] ) < fabs( y - closestY ) ) ){
+            closestY = mY[ i ];
+        }
+    }
+    return closestY;
+}
+
+//! Determines the y coordinate of the nearest point above y.
+double SortedPointSet::getNearestYAbove( const double y ) const {
+    double closestY = DBL_MAX;
+    for( size_t i = 0; i < mY.size(); ++i ){
+        if( ( mY[ i ] > y ) && ( fabs( mY[ i ] - y ) < fabs( closestY - y ) ) ){
+            closestY = mY[ i ];
+        }
+    }
+    return closestY;
+}
+
+/*!
+ * \brief Evaluate the piecewise linear curve through the points at the given x.
+ * \details The result is the same as PointSetCurve::getY would calculate
+ *          through the PointSet interface, including linear extrapolation
+ *          from the first or last segment, but only requires a single binary
+ *          search.
+ * \param aX The x value at which to evaluate.
+ * \return The interpolated y value, -DBL_MAX if there are no points.
+ */
+double SortedPointSet::interpolateY( const double aX ) const {
+    const size_t numPoints = mX.size();
+    const size_t match = findX( aX );
+    if( match != numPoints ){
+        return mY[ match ];
+    }
+    if( numPoints < 2 ){
+        // We can not compute a slope so just return the one value we have.
+        return numPoints == 0 ? -DBL_MAX : mY[ 0 ];
+    }
+
+    // Find the segment to interpolate along, keeping the end points in the
+    // order PointSetCurve uses when extrapolating.
+    const size_t above = lower_bound( mX.begin(), mX.end(), aX ) - mX.begin();
+    size_t pos1;
+    size_t pos2;
+    if( above == 0 ){
+        pos1 = 1;
+        pos2 = 0;
+    }
+    else if( above == numPoints ){
+        pos1 = numPoints - 1;
+        pos2 = numPoints - 2;
+    }
+    else {
+        pos1 = above - 1;
+        pos2 = above;
+    }
+    return ( aX - mX[ pos1 ] ) * ( mY[ pos2 ] - mY[ pos1 ] ) / ( mX[ pos2 ] - mX[ pos1 ] ) + mY[ pos1 ];
+}
+
+/*!
+ * \brief Evaluate the piecewise linear curve at each of the given x values.
+ * \param aX Array of x values at which to evaluate.
+ * \param aY Array into which to write the y values.
+ * \param aNumValues The number of values in each array.
+ * \sa interpolateY( const double )
+ */
+void SortedPointSet::interpolateY( const double* aX, double* aY, const size_t aNumValues ) const {
+    for( size_t i = 0; i < aNumValues; ++i ){
+        aY[ i ] = interpolateY( aX[ i ] );
+    }
+}
+
+//! Print out the SortedPointSet to an XML file.
+void SortedPointSet::outputAsXML( ostream& aOut, Tabs* aTabs ) const {
+    XMLWriteOpeningTag( PointSet::getXMLNameStatic(), aOut, aTabs, "", 0, getXMLName() );
+    for( size_t i = 0; i < mX.size(); ++i ){
+        XYDataPoint( mX[ i ], mY[ i ] ).outputAsXML( aOut, aTabs );
+    }
+    XMLWriteClosingTag( PointSet::getXMLNameStatic(), aOut, aTabs );
+}
+
+//! Parse a SortedPointSet from a DOM tree.
+void SortedPointSet::XMLParse( const xercesc::DOMNode* node ) {
+    // First clear the existing points.
+    mX.clear();
+    mY.clear();
+
+    // assume node is valid.
+    assert( node );
+
+    // get all children of the node.
+    xercesc::DOMNodeList* nodeList = node->getChildNodes();
+
+    // loop through the children
+    for ( int i = 0; i < static_cast<int>( nodeList->getLength() ); i++ ){
+        xercesc::DOMNode* curr = nodeList->item( i );
+        string nodeName = XMLHelper<void>::safeTranscode( curr->getNodeName() );
+
+        // select the type of node.
+        if( nodeName == "#text" ) {
+            continue;
+        }
+        else if ( nodeName == DataPoint::getXMLNameStatic() ){
+            DataPoint* currPoint = DataPoint::getDataPoint( XMLHelper<string>::getAttr( curr, "type" ) );
+            currPoint->XMLParse( curr );
+            addPoint( currPoint );
+        } 
+        else {
+            ILogger& mainLog = ILogger::getLogger( "main_log" );
+            mainLog.setLevel( ILogger::WARNING );
+            mainLog << "Unrecognized text string: " << nodeName << " found while parsing SortedPointSet." << endl;
+        }
+    }
+}
+
+//! Switch the X and Y values of each point.
+void SortedPointSet::invertAxises(){
+    mX.swap( mY );
+    sortByX();
+}
+
+/*!
+ * \brief Helper function which finds the point with a given x value.
+ * \details The comparison uses the same tolerance as util::isEqual.
+ * \param xValue The x value to search for.
+ * \return The index of the point, or the number of points if it was not found.
+ */
+size_t SortedPointSet::findX( const double xValue ) const {
+    const double TOLERANCE = 1E-10;
+    const size_t pos = upper_bound( mX.begin(), mX.end(), xValue - TOLERANCE ) - mX.begin();
+    return ( pos != mX.size() && util::isEqual( xValue, mX[ pos ], TOLERANCE ) ) ? pos : mX.size();
+}
+
+/*!
+ * \brief Helper function which finds the point with a given y value.
+ * \param yValue The y value to search for.
+ * \return The index of the first such point, or the number of points if it
+ *         was not found.
+ */
+size_t SortedPointSet::findY( const double yValue ) const {
+    for( size_t i = 0; i < mY.size(); ++i ){
+        if( util::isEqual( yValue, mY[ i ] ) ){
+            return i;
+        }
+    }
+    return mY.size();
+}
+
+//! Helper function which inserts a point keeping the x values sorted.
+void SortedPointSet::insert( const double xValue, const double yValue ){
+    const size_t pos = upper_bound( mX.begin(), mX.end(), xValue ) - mX.begin();
+    mX.insert( mX.begin() + pos, xValue );
+    mY.insert( mY.begin() + pos, yValue );
+}
+
+//! Helper function which removes the point at the given index.
+void SortedPointSet::erase( const size_t aIndex ){
+    mX.erase( mX.begin() + aIndex );
+    mY.erase( mY.begin() + aIndex );
+}
+
+//! Helper function which restores the x order after the x values have changed.
+void SortedPointSet::sortByX(){
+    vector<pair<double,double> > pairs( mX.size() );
+    for( size_t i = 0; i < mX.size(); ++i ){
+        pairs[ i ] = make_pair( mX[ i ], mY[ i ] );
+    }
+    stable_sort( pairs.begin(), pairs.end(), []( const pair<double,double>& aLHS, const pair<double,double>& aRHS ) {
+        return aLHS.first < aRHS.first;
+    } );
+    for( size_t i = 0; i < pairs.size(); ++i ){
+        mX[ i ] = pairs[ i ].first;
+        mY[ i ] = pairs[ i ].second;
+    }
+}
+
+/*! \brief Print function to print the PointSet in a csv format.
+* \param out Stream to write to.
+* \param lowDomain The lowest x value to write out.
+* \param highDomain The highest x value to write out.
+* \param lowRange The lowest y value to write out.
+* \param highRange The highest y value to write out.
+* \param minPoints Minimum number of points to print.
+*/
+void SortedPointSet::print( ostream& out, const double lowDomain, const double highDomain,
+                            const double lowRange, const double highRange, const int minPoints ) const {
+    out << "x,y" << endl;
+    for( size_t i = 0; i < mX.size(); ++i ){
+        // Check if the point meets the printing conditions.
+        if( ( mX[ i ] <= highDomain ) && ( mX[ i ] >= lowDomain ) &&
+            ( mY[ i ] <= highRange ) && ( mY[ i ] >= lowRange ) ){
+            out << mX[ i ] << "," << mY[ i ] << endl;
+        }
+    }
+    out << endl;
+}
@@ -53,7 +53,10 @@
 #include "util/logger/include/ilogger.h"
 
 #if GCAM_PARALLEL_ENABLED
+#include <thread>
 #include <tbb/spin_mutex.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/concurrent_queue.h>
 #endif
 
 // Forward definition of the Logger class.
@@ -66,6 +69,8 @@ class Tabs;
 * 
 * This is a very simple class which contains a pointer to its parent Logger.
 * When the streambuf receives a character it passes it to its parent stream for processing.
+* Strings written in a single operation, which is how formatted output of strings
+* and string literals arrives, are passed to the parent whole.
 *
 * \author Josh Lurz
 * \warning Overriding the iostream class is somewhat difficult so this class may be somewhat esoteric.
@@ -78,6 +83,7 @@ class PassToParentStreamBuf: std::streambuf {
 public:
     PassToParentStreamBuf();
     int overflow( int ch );
+    std::streamsize xsputn( const char* aString, std::streamsize aCount );
     int underflow( int ch );
     void setParent( Logger* parentIn );
     void toDebugXML( std::ostream& out ) const;
@@ -96,6 +102,14 @@ class LoggerFactory;
 *          interface. Each error message is given a priority, and the user may
 *          set the level of log messages they wish to print. Loggers are
 *          singletons and can only be instantiated by the LoggerFactory class.
+*          Each thread has its own warning level and collects printed
+*          characters into its own line buffer, so a level set by one thread
+*          does not affect a line being written by another. A line is written
+*          at the level that was in effect when it was started. When no thread
+*          has a level at which messages would be printed the stream is put
+*          into a bad state so that formatting is skipped. Complete lines are
+*          written under a lock, or when asyncWrite is configured in a parallel
+*          build, handed to a writer thread.
 *
 * \author Josh Lurz
 * \date $Date: 2007/01/11 23:52:34 $
@@ -112,6 +126,7 @@ public:
     virtual ~Logger(); //!< Virtual destructor.
     virtual void open( const char[] = 0 ) = 0; //!< Pure virtual function called to begin logging.
     int receiveCharFromUnderStream( int ch ); //!< Pure virtual function called to complete the log and clean up.
+    void receiveStringFromUnderStream( const char* aString, std::streamsize aCount );
     virtual void close() = 0;
     ILogger::WarningLevel setLevel( const ILogger::WarningLevel newLevel );
     bool wouldPrint(ILogger::WarningLevel aLevel) const;
@@ -135,28 +150,87 @@ protected:
 	//! Defines the minimum level of warnings to print to the console.
 	ILogger::WarningLevel mMinToScreenWarningLevel;
 
-	//! Defines the current warning level.
+	//! The warning level most recently set by any thread, which threads
+	//! that have not set one start at.
     ILogger::WarningLevel mCurrentWarningLevel;
 
 	//! Defines whether to print the warning level.
     bool mPrintLogWarningLevel;
+
+	//! Defines whether complete lines are written by a separate thread.
+    bool mAsyncWrite;
     Logger( const std::string& aFileName = "" );
     
 	//! Log a message with the given warning level.
-    virtual void logCompleteMessage( const std::string& aMessage ) = 0;
-    void printToScreenIfConfigured( const std::string& aMessage );
+    virtual void logCompleteMessage( const ILogger::WarningLevel aLevel, const std::string& aMessage ) = 0;
+    void printToScreenIfConfigured( const ILogger::WarningLevel aLevel, const std::string& aMessage );
+    void startAsyncWriter();
+    void stopAsyncWriter();
     static void parseHeader( std::string& aHeader );
     static const std::string& convertLevelToString( ILogger::WarningLevel aLevel );
 private:
-	 //! Buffer which contains characters waiting to be printed.
-    std::stringstream mBuf;
+    //! The line a thread is collecting and the warning level it is logging at.
+    struct LineBuffer {
+        LineBuffer( const ILogger::WarningLevel aLevel );
+
+        //! Characters waiting to be printed, without a newline.
+        std::string mLine;
+
+        //! The warning level most recently set by this thread.
+        ILogger::WarningLevel mLevel;
+
+        //! The warning level in effect when mLine was started.
+        ILogger::WarningLevel mLineLevel;
+
+        //! Whether this buffer is counted in mNumPrinting.
+        bool mIsPrinting;
+    };
+
+    //! The number of line buffers whose level would print, the stream is in a
+    //! bad state when there are none.
+    int mNumPrinting;
+
 #if GCAM_PARALLEL_ENABLED
-    tbb::spin_mutex mMutex;  //<! mutex protecting mBuf
+	 //! Buffers for each thread which contain characters waiting to be printed.
+    tbb::enumerable_thread_specific<LineBuffer> mLineBuffers;
+
+    tbb::spin_mutex mMutex;  //<! mutex protecting writing complete lines
+
+    tbb::spin_mutex mLevelMutex;  //<! mutex protecting mNumPrinting and the stream state
+
+    /*! \brief A complete line waiting to be written by the writer thread.
+    * \details A message with mIsLast set tells the writer thread to stop.
+    */
+    struct QueuedMessage {
+        //! The warning level at which the line was logged.
+        ILogger::WarningLevel mLevel;
+
+        //! The line without its newline.
+        std::string mMessage;
+
+        //! Whether this is the last message.
+        bool mIsLast;
+    };
+
+    //! Lines waiting to be written by the writer thread.
+    tbb::concurrent_bounded_queue<QueuedMessage> mAsyncQueue;
+
+    //! The writer thread if one has been started.
+    std::thread mAsyncWriter;
+
+    void runAsyncWriter();
+#else
+	 //! Buffer which contains characters waiting to be printed.
+    LineBuffer mLineBuffer;
 #endif
 
 	 //! Underlying ofstream
     PassToParentStreamBuf mUnderStream;
 
+    LineBuffer& getLineBuffer();
+    void updateStreamState( LineBuffer& aBuffer );
+    void completeLine( LineBuffer& aBuffer );
+    void writeLine( const ILogger::WarningLevel aLevel, const std::string& aLine );
     void XMLParse( const xercesc::DOMNode* node );
     static const std::string getTimeString();
     static const std::string getDateString();
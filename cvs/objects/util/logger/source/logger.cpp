@@ -46,6 +46,7 @@
 #include <sstream>
 #include <cassert>
 #include <ctime>
+#include <algorithm>
 #include <xercesc/dom/DOMNode.hpp>
 #include <xercesc/dom/DOMNodeList.hpp>
 #include "util/logger/include/logger.h"
@@ -66,6 +67,18 @@ int PassToParentStreamBuf::overflow( int aChar ){
 	return mParent->receiveCharFromUnderStream( aChar );
 }
 
+/*! \brief Overriding xsputn function which passes a whole string to its parent.
+* \param aString The characters to write.
+* \param aCount The number of characters to write.
+* \return The number of characters written.
+*/
+streamsize PassToParentStreamBuf::xsputn( const char* aString, streamsize aCount ){
+	/*! \pre Make sure the parent is not null. */
+	assert( mParent );
+	mParent->receiveStringFromUnderStream( aString, aCount );
+	return aCount;
+}
+
 //! Overriding underflow function which should not be reached because this is a write-only stream.
 int PassToParentStreamBuf::underflow( int aChar ){
 	/*! \pre This function should never be called. */
@@ -88,24 +101,69 @@ mCurrentWarningLevel( ILogger::DEBUG ),
 mFileName( aFileName ),
 mMinLogWarningLevel( ILogger::DEBUG ),
 mMinToScreenWarningLevel( ILogger::SEVERE ),
-mPrintLogWarningLevel( false ){
+mPrintLogWarningLevel( false ),
+mAsyncWrite( false ),
+mNumPrinting( 0 ),
+#if GCAM_PARALLEL_ENABLED
+mLineBuffers( [this] () { return LineBuffer( mCurrentWarningLevel ); } )
+#else
+mLineBuffer( ILogger::DEBUG )
+#endif
+{
     // Set the understream's parent to this Logger.
 	mUnderStream.setParent( this );
 }
 
 //! Virtual destructor
 Logger::~Logger() {
+    // The writer thread should have been stopped by close, but it must not
+    // outlive the logger.
+    stopAsyncWriter();
 }
 
-//! Set the current warning level.
+/*! \brief Constructor
+* \param aLevel The warning level to start at.
+*/
+Logger::LineBuffer::LineBuffer( const ILogger::WarningLevel aLevel ):
+mLevel( aLevel ),
+mLineLevel( aLevel ),
+mIsPrinting( false ){
+}
+
+//! Set the current warning level for the calling thread.
 ILogger::WarningLevel Logger::setLevel( const ILogger::WarningLevel aLevel ){
-    // Haven't bothered to protect this with a mutex, since doing so
-    // doesn't actually solve the race condition.
-    ILogger::WarningLevel oldLevel = mCurrentWarningLevel;
+    LineBuffer& buffer = getLineBuffer();
+    ILogger::WarningLevel oldLevel = buffer.mLevel;
+    buffer.mLevel = aLevel;
     mCurrentWarningLevel = aLevel;
+    updateStreamState( buffer );
     return oldLevel;
 }
 
+/*! \brief Update the stream state after the level of a line buffer changed.
+* \details The stream is put into a bad state when no thread has a level at
+*          which messages would be printed so that the stream operators return
+*          before formatting anything. The stream state is shared by all threads
+*          so it may not be set while any thread could print.
+* \param aBuffer The line buffer whose level changed.
+*/
+void Logger::updateStreamState( LineBuffer& aBuffer ){
+#if GCAM_PARALLEL_ENABLED
+    tbb::spin_mutex::scoped_lock lck( mLevelMutex );
+#endif
+    const bool isPrinting = wouldPrint( aBuffer.mLevel );
+    if( isPrinting != aBuffer.mIsPrinting ){
+        mNumPrinting += isPrinting ? 1 : -1;
+        aBuffer.mIsPrinting = isPrinting;
+    }
+    if( mNumPrinting > 0 ){
+        clear();
+    }
+    else {
+        setstate( ios_base::badbit );
+    }
+}
+
 /*! \brief Test whether the logger will produce output at a specified logging level
  *  \details This function allows us to skip preparing expensive
  *           logging output if we know it won't even be printed.
@@ -117,38 +175,138 @@ bool Logger::wouldPrint(ILogger::WarningLevel aLevel) const
 
 //! Receive a single character from the underlying stream and buffer it, printing the buffer it is a newline.
 int Logger::receiveCharFromUnderStream( int ch ) {
+    LineBuffer& buffer = getLineBuffer();
+    if( buffer.mLine.empty() ){
+        buffer.mLineLevel = buffer.mLevel;
+    }
     // Only receive the character or print to the screen if it needed.
-    if( mCurrentWarningLevel >= mMinLogWarningLevel || mCurrentWarningLevel >= mMinToScreenWarningLevel ){
-        // only really need to lock the mutex if we're going to do something.
-#if GCAM_PARALLEL_ENABLED
-        tbb::spin_mutex::scoped_lock lck( mMutex );
-#endif
+    if( wouldPrint( buffer.mLineLevel ) ){
         if( ch == '\n' ){
-            string tempString( mBuf.str() );
-            logCompleteMessage( tempString );
-            printToScreenIfConfigured( tempString );
-
-            // reset the stringstream buffer
-            mBuf.clear();       // Clear error flags, if any.
-            mBuf.str(std::string()); // clear out the data in the buffer.
-       }
+            completeLine( buffer );
+        }
         else {
             // The functions that perform the output will add the
             // newline, so we only want to insert non-newline
             // characters.
-            mBuf << ( char )ch;
+            buffer.mLine += static_cast<char>( ch );
         }
     }
     return ch;
 }
 
+/*! \brief Receive a string from the underlying stream and buffer it, printing
+*          each complete line.
+* \param aString The characters to receive.
+* \param aCount The number of characters to receive.
+*/
+void Logger::receiveStringFromUnderStream( const char* aString, streamsize aCount ) {
+    LineBuffer& buffer = getLineBuffer();
+    const char* const end = aString + aCount;
+    while( aString != end ){
+        if( buffer.mLine.empty() ){
+            buffer.mLineLevel = buffer.mLevel;
+        }
+        const char* newLine = find( aString, end, '\n' );
+        // Only receive the string or print to the screen if it needed.
+        if( wouldPrint( buffer.mLineLevel ) ){
+            buffer.mLine.append( aString, newLine );
+            if( newLine != end ){
+                completeLine( buffer );
+            }
+        }
+        aString = newLine == end ? end : newLine + 1;
+    }
+}
+
+/*! \brief Get the line buffer for the calling thread.
+* \details Each thread collects its own characters so that lines logged from
+*          different threads are not interleaved and no lock is needed until a
+*          line is complete.
+* \return The line buffer for the calling thread.
+*/
+Logger::LineBuffer& Logger::getLineBuffer() {
+#if GCAM_PARALLEL_ENABLED
+    return mLineBuffers.local();
+#else
+    return mLineBuffer;
+#endif
+}
+
+/*! \brief Write a complete line and clear the line buffer.
+* \details The line is handed to the writer thread if one is running, otherwise
+*          it is written immediately.
+* \param aBuffer The line buffer holding the complete line without its newline.
+*/
+void Logger::completeLine( LineBuffer& aBuffer ) {
+#if GCAM_PARALLEL_ENABLED
+    if( mAsyncWriter.joinable() ){
+        QueuedMessage message = { aBuffer.mLineLevel, aBuffer.mLine, false };
+        mAsyncQueue.push( message );
+    }
+    else {
+        tbb::spin_mutex::scoped_lock lck( mMutex );
+        writeLine( aBuffer.mLineLevel, aBuffer.mLine );
+    }
+#else
+    writeLine( aBuffer.mLineLevel, aBuffer.mLine );
+#endif
+    aBuffer.mLine.clear();
+}
+
+/*! \brief Write a complete line to the log and the screen if configured.
+* \param aLevel The warning level at which the line was logged.
+* \param aLine The complete line without its newline.
+*/
+void Logger::writeLine( const ILogger::WarningLevel aLevel, const string& aLine ) {
+    logCompleteMessage( aLevel, aLine );
+    printToScreenIfConfigured( aLevel, aLine );
+}
+
+/*! \brief Start the writer thread if asyncWrite is configured.
+* \details Subclasses should call this once their output is open. The writer
+*          thread is only available in parallel builds, otherwise lines are
+*          always written immediately.
+*/
+void Logger::startAsyncWriter() {
+#if GCAM_PARALLEL_ENABLED
+    if( mAsyncWrite && !mAsyncWriter.joinable() ){
+        mAsyncWriter = std::thread( &Logger::runAsyncWriter, this );
+    }
+#endif
+}
+
+/*! \brief Stop the writer thread after it has written all queued lines.
+* \details Subclasses should call this before closing their output.
+*/
+void Logger::stopAsyncWriter() {
+#if GCAM_PARALLEL_ENABLED
+    if( mAsyncWriter.joinable() ){
+        QueuedMessage lastMessage = { mCurrentWarningLevel, string(), true };
+        mAsyncQueue.push( lastMessage );
+        mAsyncWriter.join();
+    }
+#endif
+}
+
+#if GCAM_PARALLEL_ENABLED
+//! Write queued lines in the order they were completed until told to stop.
+void Logger::runAsyncWriter() {
+    QueuedMessage message;
+    mAsyncQueue.pop( message );
+    while( !message.mIsLast ){
+        writeLine( message.mLevel, message.mMessage );
+        mAsyncQueue.pop( message );
+    }
+}
+#endif
+
 //! Print the message to the screen if the Logger is configured to.
-void Logger::printToScreenIfConfigured( const string& aMessage ){
+void Logger::printToScreenIfConfigured( const ILogger::WarningLevel aLevel, const string& aMessage ){
 	// Decide whether to print the message
-	if ( mCurrentWarningLevel >= mMinToScreenWarningLevel ) {
+	if ( aLevel >= mMinToScreenWarningLevel ) {
 		// Print the warning level
-		if ( mPrintLogWarningLevel || mCurrentWarningLevel >= ILogger::ERROR ) {
-            cout << convertLevelToString( mCurrentWarningLevel ) << ":";
+		if ( mPrintLogWarningLevel || aLevel >= ILogger::ERROR ) {
+            cout << convertLevelToString( aLevel ) << ":";
 		}
 		cout << aMessage << endl;
 	}
@@ -184,7 +342,13 @@ void Logger::XMLParse( const DOMNode* aNode ){
 		else if ( nodeName == "headerMessage" ) {
 			mHeaderMessage = XMLHelper<string>::getValue( curr );
 		}
+		else if ( nodeName == "asyncWrite" ) {
+			mAsyncWrite = XMLHelper<bool>::getValue( curr );
+		}
 	}
+
+	// Update the stream state for the configured levels.
+	setLevel( mCurrentWarningLevel );
 }
 
 void Logger::toDebugXML( ostream& out, Tabs* tabs ) const {
@@ -194,6 +358,7 @@ void Logger::toDebugXML( ostream& out, Tabs* tabs ) const {
 	XMLWriteElement( mMinLogWarningLevel, "minLogWarningLevel", out, tabs );
 	XMLWriteElement( mMinToScreenWarningLevel, "minToScreenWarningLevel", out, tabs );
 	XMLWriteElement( mPrintLogWarningLevel, "printLogWarningLevel", out, tabs );
+	XMLWriteElement( mAsyncWrite, "asyncWrite", out, tabs );
 	XMLWriteClosingTag( "Logger", out, tabs );
 }
 
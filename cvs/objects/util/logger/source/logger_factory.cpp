@@ -117,12 +117,16 @@ Logger& LoggerFactory::getLogger( const string& aLoggerName ) {
 	}
 }
 
-//! Cleans up the logger.
+/*! \brief Cleans up the logger.
+* \details This is called by the LoggerFactoryWrapper but may also be called
+*          directly by a process which exits without running static destructors.
+*/
 void LoggerFactory::cleanUp() {
 	for( map<string,Logger*>::iterator logIter = mLoggers.begin(); logIter != mLoggers.end(); logIter++ ){
 		logIter->second->close();
 		delete logIter->second;
 	}
+	mLoggers.clear();
 }
 
 /*! \brief Writes out the LoggerFactory to an XML file. 
@@ -152,3 +156,44 @@ void LoggerFactory::logNewScenarioStarting( const string& aScenarioName ) {
     }
 }
 
+/*!
+ * \brief Get all loggers ready for the process to be forked.
+ * \details Any writer threads are stopped once they have written all queued
+ *          lines since threads do not survive a fork.  Each line is flushed to
+ *          the log file as it is written so nothing is left buffered.  The calling thread
+ *          should be the only one logging until resumeAfterFork is called.
+ */
+void LoggerFactory::prepareFork() {
+	for( map<string,Logger*>::const_iterator logIter = mLoggers.begin(); logIter != mLoggers.end(); ++logIter ){
+        logIter->second->stopAsyncWriter();
+    }
+}
+
+/*!
+ * \brief Resume logging in either process after a fork.
+ * \details In the forked process each logger is reopened on its own file,
+ *          named by inserting the given suffix before the file extension, so
+ *          that lines from different processes are not interleaved.  Writer
+ *          threads are then restarted in both processes.
+ * \param aFileSuffix The suffix to add to log file names in the forked
+ *        process, or empty in the parent process.
+ */
+void LoggerFactory::resumeAfterFork( const string& aFileSuffix ) {
+	for( map<string,Logger*>::const_iterator logIter = mLoggers.begin(); logIter != mLoggers.end(); ++logIter ){
+        Logger* logger = logIter->second;
+        if( aFileSuffix.empty() ){
+            logger->startAsyncWriter();
+            continue;
+        }
+        const string::size_type dirEnd = logger->mFileName.find_last_of( "/\\" );
+        string::size_type extStart = logger->mFileName.find_last_of( '.' );
+        if( extStart == string::npos || ( dirEnd != string::npos && extStart < dirEnd ) ){
+            extStart = logger->mFileName.size();
+        }
+        logger->mFileName.insert( extStart, "." + aFileSuffix );
+        // Opening the logger again closes the file shared with the parent
+        // process and starts the writer thread.
+        logger->open();
+    }
+}
+
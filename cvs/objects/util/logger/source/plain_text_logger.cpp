@@ -59,6 +59,10 @@ void PlainTextLogger::open( const char[] ){
         mFileName = "log.txt";
     }
 
+    // The logger may be reopened on a new file after the process is forked.
+    if( mLogFile.is_open() ) {
+        mLogFile.close();
+    }
     mLogFile.open( mFileName.c_str(), ios::out );
 
     // Print the header message
@@ -66,20 +70,22 @@ void PlainTextLogger::open( const char[] ){
         parseHeader( mHeaderMessage );
         mLogFile << mHeaderMessage << endl << endl;
     }
+    startAsyncWriter();
 }
 
 //! Tells the logger to finish logging.
 void PlainTextLogger::close(){
+    stopAsyncWriter();
     mLogFile.close();
 }
 
 //! Logs a single message.
-void PlainTextLogger::logCompleteMessage( const string& aMessage ){
+void PlainTextLogger::logCompleteMessage( const ILogger::WarningLevel aLevel, const string& aMessage ){
     // Decide whether to print the message
-    if ( mCurrentWarningLevel >= mMinLogWarningLevel ){
+    if ( aLevel >= mMinLogWarningLevel ){
         // Print the warning level
-        if ( mPrintLogWarningLevel || mCurrentWarningLevel >= ILogger::ERROR ) {
-            mLogFile << convertLevelToString( mCurrentWarningLevel ) << ":";
+        if ( mPrintLogWarningLevel || aLevel >= ILogger::ERROR ) {
+            mLogFile << convertLevelToString( aLevel ) << ":";
         }
         mLogFile << aMessage << endl;
     }
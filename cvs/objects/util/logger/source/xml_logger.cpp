@@ -62,6 +62,10 @@ void XMLLogger::open( const char[] ){
 		mFileName = "log.xml";
 	}
 
+    // The logger may be reopened on a new file after the process is forked.
+    if( mLogFile.is_open() ) {
+        mLogFile.close();
+    }
     mLogFile.open( mFileName.c_str(), ios::out );
 
 	// Print the header message
@@ -69,24 +73,27 @@ void XMLLogger::open( const char[] ){
 	time(&localTime);
 	string dateString = util::XMLCreateDate( localTime );
 	mLogFile << "<XMLLogger name=\"" << mName << "\" date=\"" << dateString << "\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" xsi:noNamespaceSchemaLocation=\"D:\\cvs\\Code\\EXE\\XMLLog.xsd\">" << endl;
+    startAsyncWriter();
 }
 
 //! Tells the logger to finish logging.
 void XMLLogger::close(){
+    stopAsyncWriter();
+
 	// Print the closing tag
 	mLogFile << "</XMLLogger>" << endl;
 	mLogFile.close();
 }
 
 //! Logs a single message.
-void XMLLogger::logCompleteMessage( const string& aMessage ){
+void XMLLogger::logCompleteMessage( const ILogger::WarningLevel aLevel, const string& aMessage ){
 	// Decide whether to print the message
-	if ( mCurrentWarningLevel >= mMinLogWarningLevel ){
+	if ( aLevel >= mMinLogWarningLevel ){
 		// Print the opening log tag.
 		mLogFile << "\t<LogEntry>" << endl;
 		
 		// Print the warning level
-		mLogFile << "\t\t<WarningLevel>" << convertLevelToString( mCurrentWarningLevel ) << "</WarningLevel>" << endl;
+		mLogFile << "\t\t<WarningLevel>" << convertLevelToString( aLevel ) << "</WarningLevel>" << endl;
 
 		// Print the message
 		mLogFile << "\t\t<Message>" << aMessage << "</Message>" << endl;